@@ -0,0 +1,241 @@
+#pragma once
+/**
+ * @file async_queue.hpp
+ * @brief Bounded, closable queue whose push and pop are awaited by Stages.
+ *
+ * The coroutine counterpart of Buffer: a stage that finds the queue full
+ * (push) or empty (pop) suspends instead of blocking its thread, and is
+ * handed back to the Scheduler when another stage makes room or delivers
+ * an item. Plain threads, such as a capture thread, use tryPush()/tryPop(),
+ * which never wait but still wake suspended stages.
+ *
+ * close() resumes every waiter; items already queued can still be popped.
+ */
+
+#include <algorithm>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include "stage_scheduler.hpp"
+
+namespace pcs {
+
+template <typename T>
+class AsyncQueue {
+public:
+    /**
+     * @brief co_await queue.push(item): true once queued, false if closed.
+     */
+    class PushAwaiter {
+    public:
+        PushAwaiter(AsyncQueue& queue, T item) : queue_(queue), item_(std::move(item)) {}
+        PushAwaiter(const PushAwaiter&) = delete;
+        PushAwaiter& operator=(const PushAwaiter&) = delete;
+        ~PushAwaiter()
+        {
+            if (handle_) {
+                queue_.forget(this); // no-op unless the stage is destroyed while waiting
+            }
+        }
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::lock_guard<std::mutex> lock(queue_.mtx_);
+            if (queue_.closed_) {
+                return false;
+            }
+            if (queue_.deliver(item_)) {
+                accepted_ = true;
+                return false;
+            }
+            handle_ = handle;
+            waiting_ = true;
+            queue_.pushers_.push_back(this);
+            return true;
+        }
+        bool await_resume() const noexcept { return accepted_; }
+
+    private:
+        friend class AsyncQueue;
+
+        AsyncQueue& queue_;
+        T item_;
+        std::coroutine_handle<> handle_;
+        bool accepted_{false};
+        bool waiting_{false};
+    };
+
+    /**
+     * @brief co_await queue.pop(): the next item, or std::nullopt once the
+     *        queue is closed and drained.
+     */
+    class PopAwaiter {
+    public:
+        explicit PopAwaiter(AsyncQueue& queue) : queue_(queue) {}
+        PopAwaiter(const PopAwaiter&) = delete;
+        PopAwaiter& operator=(const PopAwaiter&) = delete;
+        ~PopAwaiter()
+        {
+            if (handle_) {
+                queue_.forget(this);
+            }
+        }
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle)
+        {
+            std::lock_guard<std::mutex> lock(queue_.mtx_);
+            if (auto item = queue_.take()) {
+                result_ = std::move(item);
+                return false;
+            }
+            if (queue_.closed_) {
+                return false;
+            }
+            handle_ = handle;
+            waiting_ = true;
+            queue_.poppers_.push_back(this);
+            return true;
+        }
+        std::optional<T> await_resume() { return std::move(result_); }
+
+    private:
+        friend class AsyncQueue;
+
+        AsyncQueue& queue_;
+        std::optional<T> result_;
+        std::coroutine_handle<> handle_;
+        bool waiting_{false};
+    };
+
+    AsyncQueue(Scheduler& scheduler, size_t capacity)
+        : scheduler_(scheduler), capacity_(capacity == 0 ? 1 : capacity) {}
+
+    AsyncQueue(const AsyncQueue&) = delete;
+    AsyncQueue& operator=(const AsyncQueue&) = delete;
+
+    PushAwaiter push(T item) { return PushAwaiter(*this, std::move(item)); }
+    PopAwaiter pop() { return PopAwaiter(*this); }
+
+    /**
+     * @brief Append without waiting, from any thread.
+     * @return false if the queue is full or closed; `item` is left untouched.
+     */
+    bool tryPush(T& item)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return !closed_ && deliver(item);
+    }
+
+    /**
+     * @brief Take the next item without waiting, from any thread.
+     */
+    std::optional<T> tryPop()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return take();
+    }
+
+    void close()
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        closed_ = true;
+        for (PopAwaiter* popper : poppers_) {
+            popper->waiting_ = false;
+            scheduler_.post(popper->handle_);
+        }
+        poppers_.clear();
+        for (PushAwaiter* pusher : pushers_) {
+            pusher->waiting_ = false;
+            scheduler_.post(pusher->handle_);
+        }
+        pushers_.clear();
+    }
+
+    bool closed() const
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return closed_;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return items_.size();
+    }
+
+    size_t capacity() const noexcept { return capacity_; }
+
+private:
+    Scheduler& scheduler_;
+    const size_t capacity_;
+
+    mutable std::mutex mtx_;
+    std::deque<T> items_;
+    std::deque<PushAwaiter*> pushers_; // suspended on a full queue
+    std::deque<PopAwaiter*> poppers_;  // suspended on an empty queue
+    bool closed_{false};
+
+    // Called with mtx_ held. Hands the item straight to a waiting popper, or
+    // queues it if there is room; moves from `item` only on success.
+    bool deliver(T& item)
+    {
+        if (!poppers_.empty()) {
+            PopAwaiter* popper = poppers_.front();
+            poppers_.pop_front();
+            popper->result_ = std::move(item);
+            popper->waiting_ = false;
+            scheduler_.post(popper->handle_);
+            return true;
+        }
+        if (items_.size() < capacity_) {
+            items_.push_back(std::move(item));
+            return true;
+        }
+        return false;
+    }
+
+    // Called with mtx_ held. The freed slot goes to the oldest waiting pusher.
+    std::optional<T> take()
+    {
+        if (items_.empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(items_.front()));
+        items_.pop_front();
+
+        if (!pushers_.empty()) {
+            PushAwaiter* pusher = pushers_.front();
+            pushers_.pop_front();
+            items_.push_back(std::move(pusher->item_));
+            pusher->accepted_ = true;
+            pusher->waiting_ = false;
+            scheduler_.post(pusher->handle_);
+        }
+        return item;
+    }
+
+    template <typename Awaiter>
+    void forget(Awaiter* awaiter)
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!awaiter->waiting_) {
+            return;
+        }
+        auto erase = [awaiter](auto& waiters) {
+            waiters.erase(std::remove(waiters.begin(), waiters.end(), awaiter), waiters.end());
+        };
+        if constexpr (std::is_same_v<Awaiter, PushAwaiter>) {
+            erase(pushers_);
+        } else {
+            erase(poppers_);
+        }
+        awaiter->waiting_ = false;
+    }
+};
+
+} // namespace pcs
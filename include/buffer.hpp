@@ -1,24 +1,171 @@
 #pragma once
+/**
+ * @file buffer.hpp
+ * @brief Bounded, closable blocking queue connecting pipeline stages.
+ *
+ * Producers either wait for room (push) or give up immediately (tryPush),
+ * which is what a live capture thread wants: a frame that can't be queued
+ * is dropped rather than delaying the next one. close() wakes every waiter
+ * so stages can shut down; items already queued can still be popped.
+ */
 
-#include <queue>
-#include <mutex>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
 #include <optional>
 
 template <typename T>
 class Buffer
 {
 public:
-    explicit Buffer(size_t maxSize);
+    explicit Buffer(size_t maxSize) : maxSize_(maxSize == 0 ? 1 : maxSize) {}
+
+    Buffer(const Buffer&) = delete;
+    Buffer& operator=(const Buffer&) = delete;
+
+    /**
+     * @brief Wait for room, then append.
+     * @return false if the buffer was closed (the item is discarded).
+     */
+    bool push(T item)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condFull_.wait(lock, [this] { return closed_ || queue_.size() < maxSize_; });
+        if (closed_) {
+            return false;
+        }
+        queue_.push_back(std::move(item));
+        lock.unlock();
+        condEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Append without waiting.
+     * @return false if the buffer is full or closed; `item` is left untouched.
+     */
+    bool tryPush(T& item)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_ || queue_.size() >= maxSize_) {
+                return false;
+            }
+            queue_.push_back(std::move(item));
+        }
+        condEmpty_.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief Append without waiting, making room by evicting the oldest items.
+     * @return How many items were dropped: those evicted, which can be
+     *         several after setCapacity() shrank the buffer, or 1 for
+     *         `item` itself if the buffer is closed.
+     */
+    size_t pushEvictOldest(T item)
+    {
+        size_t dropped = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (closed_) {
+                return 1;
+            }
+            while (queue_.size() >= maxSize_) {
+                queue_.pop_front();
+                ++dropped;
+            }
+            queue_.push_back(std::move(item));
+        }
+        condEmpty_.notify_one();
+        return dropped;
+    }
+
+    /**
+     * @brief Wait for an item.
+     * @return std::nullopt once the buffer is closed and drained.
+     */
+    std::optional<T> pop()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condEmpty_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+        return take(lock);
+    }
 
-    void push(const T &item);
-    std::optional<T> pop();
-    size_t size() const;
+    /**
+     * @brief Wait up to `timeout` for an item.
+     * @return std::nullopt on timeout, or once closed and drained.
+     */
+    std::optional<T> pop(std::chrono::milliseconds timeout)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condEmpty_.wait_for(lock, timeout, [this] { return closed_ || !queue_.empty(); });
+        return take(lock);
+    }
+
+    /**
+     * @brief Reject further pushes and wake all waiters.
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        condFull_.notify_all();
+        condEmpty_.notify_all();
+    }
+
+    bool closed() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return closed_;
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    size_t capacity() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return maxSize_;
+    }
+
+    /**
+     * @brief Change the limit while in use. Shrinking drops nothing: items
+     *        beyond the new limit stay queued and pushes wait until they drain.
+     */
+    void setCapacity(size_t maxSize)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            maxSize_ = maxSize == 0 ? 1 : maxSize;
+        }
+        condFull_.notify_all();
+    }
 
 private:
     size_t maxSize_;
-    std::queue<T> queue_;
+    std::deque<T> queue_;
+    bool closed_{false};
     mutable std::mutex mutex_;
     std::condition_variable condFull_;
     std::condition_variable condEmpty_;
+
+    std::optional<T> take(std::unique_lock<std::mutex>& lock)
+    {
+        if (queue_.empty()) {
+            return std::nullopt;
+        }
+        std::optional<T> item(std::move(queue_.front()));
+        queue_.pop_front();
+        lock.unlock();
+        condFull_.notify_one();
+        return item;
+    }
 };
@@ -0,0 +1,94 @@
+#pragma once
+/**
+ * @file capture_scheduler.hpp
+ * @brief Deadline-based pacing and timing accounting on top of a CaptureSource.
+ *
+ * Frame k of the stream is ideally due at anchor + k / fps. The scheduler
+ * compares every frame's capture timestamp against that schedule:
+ *
+ * - frames well ahead of their deadline (the source runs faster than the
+ *   configured rate) are decimated;
+ * - frames whose age on arrival already exceeds the latency budget are
+ *   dropped deliberately, so a backlog is shed at once instead of delaying
+ *   every later frame;
+ * - a source slower than the rate re-anchors the schedule and counts the
+ *   deadlines it missed.
+ *
+ * Inter-frame jitter (|interval - period|) and driver-to-userspace latency
+ * (frame age when read) are recorded in microsecond histograms. read() is
+ * for one thread; the statistics may be read from any other.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include "capture_source.hpp"
+#include "histogram.hpp"
+
+namespace pcs {
+
+struct PacingConfig {
+    double fps{0.0};                                  // 0: the source's nominal rate
+    std::chrono::microseconds latency_budget{100000}; // 0 disables late drops
+    bool decimate{true};                              // drop frames arriving ahead of schedule
+};
+
+class CaptureScheduler {
+public:
+    CaptureScheduler(CaptureSource& source, const PacingConfig& config = {});
+
+    /**
+     * @brief Read from the source until a frame meets the schedule and budget.
+     * @return false when the source returns no frame.
+     */
+    bool read(Frame& frame);
+
+    /**
+     * @brief Change the pacing between reads, from the reading thread.
+     *        A new rate takes over from the last delivered frame, so a
+     *        raised rate shortens the current wait at once.
+     */
+    void setPacing(const PacingConfig& config);
+
+    const Histogram& jitter() const noexcept { return jitterUs_; }
+    const Histogram& latency() const noexcept { return latencyUs_; }
+
+    uint64_t delivered() const noexcept { return delivered_.load(std::memory_order_relaxed); }
+    uint64_t droppedLate() const noexcept { return droppedLate_.load(std::memory_order_relaxed); }
+    uint64_t droppedEarly() const noexcept { return droppedEarly_.load(std::memory_order_relaxed); }
+    uint64_t missedDeadlines() const noexcept { return missedDeadlines_.load(std::memory_order_relaxed); }
+
+    std::chrono::nanoseconds period() const noexcept { return period_; }
+
+    /**
+     * @brief Forget the schedule and the statistics (e.g. after a restart).
+     */
+    void reset() noexcept;
+
+    /**
+     * @brief Clear the jitter and latency histograms to start a new
+     *        reporting window; the schedule and counters carry on.
+     */
+    void resetHistograms() noexcept;
+
+private:
+    CaptureSource& source_;
+    PacingConfig config_;
+    std::chrono::nanoseconds period_{0};
+
+    std::optional<Frame::Timestamp> deadline_;      // next frame's ideal time
+    std::optional<Frame::Timestamp> lastDelivered_; // capture time of the previous frame
+
+    Histogram jitterUs_;
+    Histogram latencyUs_;
+    std::atomic<uint64_t> delivered_{0};
+    std::atomic<uint64_t> droppedLate_{0};
+    std::atomic<uint64_t> droppedEarly_{0};
+    std::atomic<uint64_t> missedDeadlines_{0};
+
+    bool accept(const Frame& frame);
+    void resolve_period();
+};
+
+} // namespace pcs
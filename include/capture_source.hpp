@@ -0,0 +1,62 @@
+#pragma once
+/**
+ * @file capture_source.hpp
+ * @brief Common interface for anything that produces raw frames.
+ *
+ * The pipeline reads from a CaptureSource without knowing whether frames
+ * come from a V4L2 device, a synthetic generator or a recording, so
+ * benchmarks and tests can run the full path without a camera.
+ */
+
+#include <cstdint>
+#include <string>
+#include "frame.hpp"
+
+namespace pcs {
+
+/**
+ * @brief How a non-camera source schedules frames.
+ */
+enum class Pacing {
+    RealTime, // one frame per 1/fps, like a camera
+    MaxSpeed  // as fast as the reader pulls
+};
+
+/**
+ * @brief Geometry, layout and nominal rate of a source's frames.
+ */
+struct CaptureFormat {
+    uint32_t width{0};
+    uint32_t height{0};
+    uint32_t fps{0};
+    PixelFormat pixel_format{PixelFormat::Unknown};
+};
+
+class CaptureSource {
+public:
+    virtual ~CaptureSource() = default;
+
+    /**
+     * @brief Begin producing frames (opening the device if needed).
+     */
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    /**
+     * @brief Next frame, blocking according to the source's pacing.
+     * @return false if no frame is available (timeout, error, end of input).
+     */
+    virtual bool read(Frame& frame) = 0;
+
+    /**
+     * @brief Negotiated format; valid once start() succeeded.
+     */
+    virtual CaptureFormat captureFormat() const = 0;
+
+    /**
+     * @brief Short human-readable identifier for logs and stats.
+     */
+    virtual std::string name() const = 0;
+};
+
+} // namespace pcs
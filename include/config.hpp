@@ -1,6 +1,8 @@
 #pragma once
 
+#include <optional>
 #include <string>
+#include <vector>
 
 namespace config {
 
@@ -11,9 +13,191 @@ struct CameraConfig {
     int fps = 30;
     std::string device = "/dev/video0";
     std::string stream_url = "rtmp://localhost/live/stream";
+    int capture_cpu = -1; // pin this camera's capture thread, -1 = no pinning
 };
 
+// Keys marked "hot" are applied to a running stream when the file changes;
+// the others take effect on the next start.
+
+struct EncoderSettings {
+    std::string codec = "h264";      // h264 | mjpeg
+    int bitrate = 4000000;           // hot; bits per second
+    int keyframe_interval = 60;      // frames between IDR frames
+    std::string preset = "veryfast"; // libx264 speed preset
+    std::string hw_accel = "auto";   // auto | software | v4l2m2m | omx
+    int threads = 0;                 // 0 = one per core
+};
+
+struct SenderSettings {
+    std::string dest_ip = "127.0.0.1";
+    int port = 5000;
+    int queue_kb = 4096; // frames queued for the link past this are dropped, a GOP at a time
+};
+
+struct PipelineSettings {
+    int capture_queue = 4;              // hot; frames waiting for the encoder
+    int send_queue = 8;                 // hot; encoded frames waiting for the sender
+    double fps_cap = 0.0;               // hot; drop captured frames above this rate, 0 = camera rate
+    int capture_budget_ms = 100;        // drop frames already older than this when read, 0 = keep all
+    std::string drop_policy = "newest"; // hot; newest | oldest, which frame goes when the encoder lags
+    int stats_interval_ms = 5000;       // 0 = no periodic stats
+    std::string capture_cpus;           // CPU lists such as "0,2-3"; empty = any
+    std::string encode_cpus;
+    std::string send_cpus;
+    bool realtime = false;              // SCHED_FIFO stage threads and locked memory
+    bool lock_memory = false;
+};
+
+// Static-scene skipping before the encoder (see scene_filter.hpp); frames
+// passed through as the camera's JPEGs are never skipped
+struct SceneSettings {
+    bool enabled = false;
+    double threshold = 1.5;    // mean absolute difference per sampled byte that counts as a change
+    std::string mode = "drop"; // drop | repeat (re-send the last picture, timestamps stay continuous)
+    int refresh_ms = 10000;    // encode a full frame at least this often
+};
+
+// Per-macroblock quality for H.264 (see roi.hpp): more bits where things
+// move, fewer where the scene is still, almost none in privacy zones
+struct RoiSettings {
+    bool motion = false;           // motion map from the difference to the previous frame
+    double motion_threshold = 6.0; // mean absolute difference per sampled byte that counts as motion
+    int motion_offset = -6;        // QP offset of moving blocks; negative = better quality
+    int static_offset = 4;         // QP offset of still blocks
+    std::string privacy_zones;     // WxH+X+Y in capture pixels, comma-separated; empty = none
+};
+
+// Shared workers for work within a frame (see thread_pool.hpp): same-size
+// colour conversion in the encoder, in row bands, and [roi] motion analysis
+struct PoolSettings {
+    int workers = 0;  // 0 = no pool, each stage works alone
+    std::string cpus; // CPU list; worker i is pinned to its i-th CPU, wrapping; empty = any
+};
+
+// Local recording as MPEG-TS segments (H.264 only); empty directory = off
+struct RecorderSettings {
+    std::string directory;
+    int segment_seconds = 60;   // rotate at the first keyframe after this long
+    int queue_kb = 16384;       // encoded data waiting for the disk; whole GOPs drop beyond it
+    int write_kb = 1024;        // bytes per write
+    int preallocate_mb = 64;    // fallocate() per segment; 0 = none
+    int sync_ms = 2000;         // fdatasync() this often; 0 = only when a segment closes
+    bool direct_io = false;     // O_DIRECT, bypassing the page cache
+};
+
+// Pre-event clips (H.264 only): SIGUSR1 saves the last pre_event_seconds
+// to directory as MPEG-TS; empty directory = off
+struct EventSettings {
+    std::string directory;
+    int pre_event_seconds = 10; // from the keyframe before this
+    int buffer_kb = 32768;      // encoded packets held; bounds how far back a clip can reach
+};
+
+// Stills on demand: SIGUSR2 writes a JPEG of the latest frame to path;
+// empty path = off. 0 takes the capture size (width or height alone keeps
+// the aspect ratio)
+struct SnapshotSettings {
+    std::string path;
+    int width = 0;
+    int height = 0;
+};
+
+// Latency-SLO control loop (see slo_controller.hpp). The step lists are
+// comma-separated scale factors of the configured value, full quality first.
+struct SloSettings {
+    bool enabled = false;
+    int latency_ms = 250;          // capture-to-send p99 target
+    double queue_fill = 0.75;      // fullest stage queue, fraction of its limit
+    double cpu_load = 0.90;        // process CPU, fraction of all cores
+    int sender_backlog_kb = 2048;  // queued in the sender and unsent in the socket
+    int interval_ms = 1000;        // one sample per interval
+    int degrade_after = 2;         // samples over a target before stepping down
+    int recover_after = 10;        // samples with headroom before stepping up
+    double headroom = 0.6;         // step up only with every signal under this fraction of its target
+    std::vector<double> bitrate_steps{1.0, 0.75, 0.5, 0.35};
+    std::vector<double> fps_steps{1.0, 0.67, 0.5};
+    std::vector<double> resolution_steps{1.0, 0.75, 0.5};
+};
+
+// A box with several cameras: each listed device is captured at the
+// [camera] size and rate on its own thread, the encode workers are shared,
+// and camera i streams to sender.port + i
+struct CamerasSettings {
+    std::string devices;      // comma-separated; empty = the [camera] device alone
+    std::string capture_cpus; // CPU list, one CPU per device in order; empty = no pinning
+    int encode_workers = 0;   // 0 = one per camera, at most one per core
+    int queue_depth = 8;      // frames between capture and encode, all cameras together
+};
+
+// One byte budget for every frame queue and pool (see memory_budget.hpp)
+struct MemorySettings {
+    int limit_mb = 256;     // 0 = count only, no limit
+    double defer_at = 0.70; // recording gives way past this fraction
+    double shed_at = 0.85;  // capture drops frames past this fraction
+};
+
+struct LogSettings {
+    std::string level = "info";     // hot; trace | debug | info | warn | error | critical | off
+    bool async = false;             // write from a background thread (see logger.hpp)
+    int queue_size = 8192;          // async: messages queued before overflow applies
+    std::string overflow = "block"; // async, when full: block | overrun (drop the oldest)
+};
+
+// Everything the config file can set, one struct per [section]
+struct Config {
+    CameraConfig camera;
+    CamerasSettings cameras;
+    EncoderSettings encoder;
+    SenderSettings sender;
+    PipelineSettings pipeline;
+    SceneSettings scene;
+    RoiSettings roi;
+    PoolSettings pool;
+    RecorderSettings recorder;
+    EventSettings events;
+    SnapshotSettings snapshot;
+    MemorySettings memory;
+    SloSettings slo;
+    LogSettings log;
+};
+
+// One key whose value differs between two configs, e.g. "encoder.bitrate"
+struct ConfigChange {
+    std::string key;
+    std::string before;
+    std::string after;
+    bool hot = false; // can be applied without a restart
+};
+
+// Parses INI-style text:
+//
+//   # comment
+//   [encoder]
+//   bitrate = 2000000   ; trailing comments too
+//
+// Keys not given keep their defaults. Returns std::nullopt, with the
+// offending line logged, on a syntax error, an unknown section or key,
+// or a value out of range; `origin` names the text in those messages.
+std::optional<Config> parse_config(const std::string& text, const std::string& origin = "config");
+
+// Reads and parses a file; std::nullopt if it can't be read or parsed
+std::optional<Config> read_config(const std::string& path);
+
 // Loads configuration from a file (returns default if not found)
-CameraConfig load_config(const std::string& path);
+Config load_config(const std::string& path);
+
+// Keys that differ between `before` and `after`, in file order
+std::vector<ConfigChange> diff_config(const Config& before, const Config& after);
+
+// `current` with the hot keys taken from `next`; restart-only keys keep
+// their current values
+Config merge_hot(const Config& current, const Config& next);
+
+// One CameraConfig per [cameras] device, each a copy of [camera] with its
+// device and capture CPU; just [camera] when no devices are listed
+std::vector<CameraConfig> camera_list(const Config& config);
+
+// The whole config as file text, every key present
+std::string format_config(const Config& config);
 
-} // namespace config
\ No newline at end of file
+} // namespace config
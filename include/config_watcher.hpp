@@ -0,0 +1,79 @@
+#pragma once
+/**
+ * @file config_watcher.hpp
+ * @brief Re-reads the config file when it changes and applies hot keys live.
+ *
+ * The file's directory is watched with inotify rather than the file itself,
+ * so editors that save by writing a new file and renaming it over the old
+ * one are seen too. Each change is parsed in full first: a file with any
+ * error is ignored (and logged) and the running settings stay as they are.
+ * Hot keys (see config.hpp) are handed to the apply callback; changes to
+ * restart-only keys are logged as pending until the next start.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "config.hpp"
+
+namespace pcs {
+
+class ConfigWatcher {
+public:
+    /**
+     * @brief Called on the watcher thread with the running config updated
+     *        by the new hot values; restart-only keys keep their old values.
+     *        Must not call back into the watcher.
+     */
+    using ApplyFn = std::function<void(const config::Config& config)>;
+
+    ConfigWatcher(std::string path, const config::Config& current, ApplyFn apply);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * @brief Start watching on a background thread.
+     * @return false if inotify is unavailable or the directory can't be watched.
+     */
+    bool start();
+
+    void stop();
+
+    /**
+     * @brief Re-read the file now (the watcher thread calls this on change).
+     * @return true if hot changes were applied.
+     */
+    bool reload();
+
+    config::Config current() const;
+
+    /**
+     * @brief Number of reloads that applied changes.
+     */
+    uint64_t reloads() const noexcept { return reloads_.load(); }
+
+private:
+    std::string path_;
+    std::string directory_;
+    std::string filename_;
+    ApplyFn apply_;
+
+    mutable std::mutex mtx_; // guards current_ and serialises reload()
+    config::Config current_;
+
+    int inotifyFd_{-1};
+    int wakeFd_{-1};
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> reloads_{0};
+
+    void watch_loop();
+    bool file_event_pending(int timeoutMs);
+};
+
+} // namespace pcs
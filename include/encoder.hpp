@@ -12,18 +12,22 @@
 #include <vector>
 #include <memory>
 #include <mutex>
-#include <condition_variable>
-#include "buffer.hpp"  // SharedFrameBuffer, FrameData
+#include <optional>
+#include "frame.hpp"
+#include "roi.hpp"
 
-extern "C" {
-#include <libavcodec/avcodec.h>
-#include <libavutil/opt.h>
-#include <libavutil/imgutils.h>
-#include <libswscale/swscale.h>
-}
+// libav types are only used through pointers here; the FFmpeg headers are
+// included by encoder.cpp so that users of this header do not need them.
+struct AVCodec;
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
 
 namespace pcs { // pi-camera-streamer namespace
 
+class ThreadPool;
+
 enum class CodecType {
     MJPEG,
     H264
@@ -35,7 +39,16 @@ struct EncoderConfig {
     int height{720};
     int fps{30};
     int bitrate{4000000}; // bits per second
-    std::string hw_accel{"auto"}; // "v4l2m2m", "omx", or "auto"
+    int keyframe_interval{60}; // frames between IDR frames
+    int threads{0}; // encoder threads, 0 = one per core
+    std::string preset{"veryfast"}; // libx264 speed preset
+    std::string hw_accel{"auto"}; // "v4l2m2m", "omx", "software" or "auto"
+    // Layout frames will arrive in; the codec is opened with it when it
+    // accepts it natively, so frames are copied instead of converted
+    PixelFormat input_format{PixelFormat::Unknown};
+    // Conversions that keep the frame size run in row bands across this
+    // pool; null = on the encoding thread. Not owned, must outlive the encoder
+    ThreadPool* pool{nullptr};
 };
 
 /**
@@ -43,11 +56,33 @@ struct EncoderConfig {
  */
 struct EncodedFrame {
     std::vector<uint8_t> data;
-    int64_t pts{0};
+    int64_t pts{0}; // 90 kHz units
     int64_t dts{0};
     bool keyframe{false};
 };
 
+/**
+ * @brief Outcome of one pipeline encode step: an encoded frame, a failure
+ *        (no frame), or a frame left out on purpose, e.g. an unchanged
+ *        scene, which stats count apart from failures.
+ */
+struct EncodeResult {
+    std::optional<EncodedFrame> frame;
+    bool skipped{false};
+
+    EncodeResult() = default;
+    EncodeResult(std::nullopt_t) {}
+    EncodeResult(EncodedFrame encoded) : frame(std::move(encoded)) {}
+    EncodeResult(std::optional<EncodedFrame> encoded) : frame(std::move(encoded)) {}
+
+    static EncodeResult skip()
+    {
+        EncodeResult result;
+        result.skipped = true;
+        return result;
+    }
+};
+
 /**
  * @class Encoder
  * @brief Wraps FFmpeg/libav encoder setup and frame compression pipeline.
@@ -59,17 +94,93 @@ public:
     explicit Encoder(const EncoderConfig& config);
     ~Encoder();
 
+    Encoder(const Encoder&) = delete;
+    Encoder& operator=(const Encoder&) = delete;
+
+    /**
+     * @brief Check whether an encoder for this codec/backend is built into libav.
+     */
+    static bool isAvailable(const EncoderConfig& config);
+
+    /**
+     * @brief Short synthetic encode used to rank backends.
+     * @param config Settings to measure; hw_accel must name a concrete backend.
+     * @param frames Number of frames to encode.
+     * @return Encoded frames per second, or std::nullopt if the backend can't open.
+     */
+    static std::optional<double> calibrate(const EncoderConfig& config, int frames = 30);
+
+    /**
+     * @brief Pixel formats the codec selected by this config takes without
+     *        conversion, best first. Empty if no such codec is available
+     *        or it only takes full-range YUVJ formats (MJPEG), which every
+     *        input is converted to.
+     *
+     * hw_accel "auto" is resolved (and calibrated if needed) first.
+     */
+    static std::vector<PixelFormat> inputFormats(const EncoderConfig& config);
+
     /**
      * @brief Initialize the encoder (select codec, allocate context, etc.).
+     *
+     * hw_accel "auto" is resolved through the process-wide EncoderRegistry.
+     * If the selected hardware backend fails to open, the software encoder
+     * is used instead.
      */
     bool init();
 
     /**
      * @brief Encode a raw frame to the chosen codec.
-     * @param frame Input frame (YUV420, RGB24, etc.)
+     * @param frame Input frame (GRAY8, BGR24, BGRA, YUYV, NV12 or I420, any
+     *        resolution). A frame already in the codec's pixel format and
+     *        size is copied into the codec picture without conversion.
+     * @param quality Optional per-macroblock QP offsets in frame coordinates;
+     *        passed to libx264 as region-of-interest side data (needs an
+     *        x264 preset with adaptive quantization, i.e. not "ultrafast").
+     *        Ignored by codecs without ROI support.
      * @return EncodedFrame if successful, std::nullopt otherwise.
      */
-    std::optional<EncodedFrame> encode(const FrameData& frame);
+    std::optional<EncodedFrame> encode(const Frame& frame, const QualityMap* quality = nullptr);
+
+    /**
+     * @brief Re-encode the previous picture with a new timestamp.
+     *
+     * Used for static scenes: no colour conversion is done, and for H.264
+     * the result is a tiny all-skip P-frame that keeps the stream's
+     * timestamps continuous.
+     * @param captured Capture time the repeated frame should carry.
+     */
+    std::optional<EncodedFrame> encodeRepeat(Frame::Timestamp captured);
+
+    /**
+     * @brief Change encoder settings while the stream is running.
+     *
+     * Bitrate, fps and keyframe interval are applied in place on the open
+     * codec context when the codec supports live rate control (libx264).
+     * Any other change (resolution, codec, backend) pre-warms a standby
+     * encoder with the new settings on the calling thread; encode() keeps
+     * using the current one and switches over on the next frame, which the
+     * standby emits as an IDR.
+     *
+     * @return false if the standby encoder could not be opened.
+     */
+    bool reconfigure(const EncoderConfig& config);
+
+    /**
+     * @brief Make the next encoded frame an IDR, e.g. after a frame was
+     *        dropped downstream and the receiver can't decode until one.
+     */
+    void requestKeyframe();
+
+    /**
+     * @brief Settings of the encoder currently producing output.
+     */
+    EncoderConfig config() const;
+
+    /**
+     * @brief Backend actually in use ("v4l2m2m", "omx" or "software").
+     */
+    std::string backend() const;
 
     /**
      * @brief Flush any remaining frames (for H.264 GOP completion).
@@ -83,18 +194,41 @@ public:
 
 private:
     EncoderConfig config_;
+    std::string backend_; // resolved from config_.hw_accel
     const AVCodec* codec_{nullptr};
     AVCodecContext* ctx_{nullptr};
     AVFrame* avFrame_{nullptr};
     AVPacket* avPacket_{nullptr};
     SwsContext* swsCtx_{nullptr};
+    std::vector<SwsContext*> bandCtx_; // one per row band when converting on config_.pool
+    std::string inputPath_; // last logged input conversion, e.g. "YUYV -> yuv420p"
 
-    int frameIndex_{0};
-    std::mutex mtx_;
+    bool havePicture_{false}; // avFrame_ holds a converted picture
+    int framesSinceKeyframe_{0};
+    bool forceKeyframe_{false};
+    std::optional<Frame::Timestamp> epoch_; // capture time of pts 0
+    int64_t lastPts_{-1};
 
+    // Pre-warmed encoder waiting to take over at the next frame
+    std::unique_ptr<Encoder> standby_;
+    mutable std::mutex mtx_;
+
+    bool open_backend(const std::string& backend);
     bool configure_codec();
     void setup_frame_buffer();
-    bool convert_to_yuv(const FrameData& src);
+    bool convert_to_yuv(const Frame& src);
+    bool convert_in_bands(const uint8_t* const src[4], const int strides[4], int srcFormat, int width, int height);
+    void attach_quality_map(const QualityMap* quality);
+    std::optional<EncodedFrame> submit_frame(Frame::Timestamp captured);
+    std::optional<EncodedFrame> receive_packet();
+    int64_t next_pts(Frame::Timestamp captured);
+
+    bool supports_live_rate_control() const;
+    bool supports_roi() const;
+    bool requires_restart(const EncoderConfig& next) const;
+    void apply_rate_control(const EncoderConfig& next);
+    void swap_codec_state(Encoder& other) noexcept;
+    void release_codec_state();
 };
 
 } // namespace pcs
@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * @file encoder_registry.hpp
+ * @brief Resolves EncoderConfig::hw_accel "auto" to a concrete encoder backend.
+ *
+ * Candidate backends are calibrated with a short synthetic encode; the fastest
+ * one that sustains the configured resolution and frame rate wins. Results
+ * are cached on disk so later starts skip calibration.
+ */
+
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+#include "encoder.hpp"
+
+namespace pcs {
+
+class EncoderRegistry {
+public:
+    /**
+     * @brief Measures a backend: encoded frames per second, or nullopt if it
+     *        is not available or fails to open. config.hw_accel names the backend.
+     */
+    using CalibrateFn = std::function<std::optional<double>(const EncoderConfig&)>;
+
+    static constexpr const char* kSoftwareBackend = "software";
+
+    /**
+     * @param calibrate   Calibration routine (Encoder::calibrate in production).
+     * @param cachePath   File used to persist decisions; empty disables the cache.
+     * @param fingerprint Identifies the libav build; cached entries from a
+     *                    different build are recalibrated.
+     */
+    explicit EncoderRegistry(CalibrateFn calibrate,
+                             std::string cachePath = {},
+                             std::string fingerprint = {});
+
+    /**
+     * @brief Register a candidate backend. Candidates are calibrated in
+     *        registration order; the software backend is always implied.
+     */
+    void addBackend(CodecType codec, const std::string& name);
+
+    /**
+     * @brief Backend to use for this config. Explicit hw_accel values are
+     *        returned unchanged; "auto" is resolved via cache or calibration.
+     */
+    std::string resolve(const EncoderConfig& config);
+
+    /**
+     * @brief Drop the cached decision for this config (e.g. the chosen backend
+     *        failed to open), so the next resolve() recalibrates.
+     */
+    void invalidate(const EncoderConfig& config);
+
+    /**
+     * @brief $XDG_CACHE_HOME (or ~/.cache) /pi-camera-streamer/encoder-backends.cache
+     */
+    static std::string defaultCachePath();
+
+private:
+    struct Entry {
+        std::string backend;
+        double fps{0.0};
+        std::string fingerprint;
+    };
+
+    CalibrateFn calibrate_;
+    std::string cachePath_;
+    std::string fingerprint_;
+    std::map<CodecType, std::vector<std::string>> candidates_;
+    std::map<std::string, Entry> cache_; // keyed by codec/resolution/fps
+    std::mutex mtx_;
+
+    static std::string cache_key(const EncoderConfig& config);
+    Entry calibrate_all(const EncoderConfig& config);
+    void load_cache();
+    void save_cache() const;
+};
+
+} // namespace pcs
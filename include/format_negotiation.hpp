@@ -0,0 +1,54 @@
+#pragma once
+/**
+ * @file format_negotiation.hpp
+ * @brief Picks the capture format that minimises per-frame conversions.
+ *
+ * The encoder states which pixel layouts it takes natively; the capture
+ * side is asked for those first, then for the formats that are cheapest to
+ * convert. When the output codec is MJPEG and the camera produces MJPEG,
+ * the compressed frames bypass the encoder entirely.
+ */
+
+#include <string>
+#include <vector>
+#include "encoder.hpp"
+#include "frame.hpp"
+
+namespace pcs {
+
+enum class FormatPath {
+    Passthrough, // camera MJPEG straight to the sender
+    Direct,      // encoder consumes the captured layout as-is
+    Convert,     // one colour conversion inside the encoder
+    Decode       // MJPEG decode, then conversion
+};
+
+struct FormatPlan {
+    PixelFormat capture{PixelFormat::Unknown};
+    PixelFormat encoder_input{PixelFormat::Unknown}; // Unknown for passthrough
+    FormatPath path{FormatPath::Convert};
+};
+
+/**
+ * @brief Capture formats to request, best first.
+ * @param encoderFormats Layouts the encoder accepts natively, best first
+ *        (Encoder::inputFormats()).
+ */
+std::vector<PixelFormat> capturePreferences(CodecType codec,
+                                            const std::vector<PixelFormat>& encoderFormats);
+
+/**
+ * @brief Classify the path once the source settled on `captured`.
+ */
+FormatPlan planFormatPath(PixelFormat captured, CodecType codec,
+                          const std::vector<PixelFormat>& encoderFormats);
+
+const char* formatPathName(FormatPath path) noexcept;
+
+/**
+ * @brief One-line description for the startup log, e.g.
+ *        "YUYV -> I420 (one conversion in the encoder)".
+ */
+std::string describeFormatPlan(const FormatPlan& plan);
+
+} // namespace pcs
@@ -5,6 +5,27 @@
 #include <chrono>
 #include <string>
 #include <memory>
+#include <span>
+
+/**
+ * @brief Pixel layout of a Frame's bytes.
+ *
+ * Unknown keeps the legacy meaning: packed, channels() bytes per pixel.
+ * Planar YUV formats report channels() == 1 (bytes per luma sample), so
+ * row-based analysis on width() * channels() sees the luma plane.
+ */
+enum class PixelFormat : uint8_t {
+    Unknown,
+    Gray8,
+    BGR24,
+    BGRA,
+    YUYV,   // packed 4:2:2
+    NV12,   // Y plane + interleaved UV, 4:2:0
+    I420,   // Y, U, V planes, 4:2:0
+    MJPEG   // compressed, variable size
+};
+
+const char* pixelFormatName(PixelFormat format) noexcept;
 
 /**
  * @brief Represents a single image frame captured from the camera.
@@ -23,6 +44,12 @@
  * - Cache-aligned metadata for efficient memory access
  * - Reserve capacity hints to avoid reallocations
  * - Inline hot-path accessors
+ *
+ * EXTERNAL STORAGE:
+ * A frame can also view memory it does not own (a V4L2 mmap buffer, a mapped
+ * file). The view is read-only and released through its shared_ptr deleter
+ * once the last frame referencing it goes away. Copies share the view;
+ * mutable access (data(), dataPtr(), detach()) copies it into owned memory.
  */
 
 class Frame
@@ -33,8 +60,13 @@ public:
     // --- Constructors (Rule of 5) ---
     Frame() noexcept;  // Empty frame
     Frame(std::vector<uint8_t> data, uint32_t width, uint32_t height, uint32_t channels) noexcept;
+    Frame(std::vector<uint8_t> data, uint32_t width, uint32_t height, PixelFormat format) noexcept;
+
+    // View external memory (zero-copy); the deleter of `data` releases it
+    Frame(std::shared_ptr<const uint8_t> data, size_t size,
+          uint32_t width, uint32_t height, PixelFormat format) noexcept;
 
-    // Copy constructor (deep copy)
+    // Copy constructor (deep copy of owned data, external views are shared)
     Frame(const Frame& other);
 
     // Move constructor (zero-copy)
@@ -50,37 +82,45 @@ public:
     ~Frame() noexcept = default;
 
     // --- Accessors ---
+    // Owned storage; empty for external frames (use bytes()/dataPtr())
     const std::vector<uint8_t>& data() const noexcept { return m_data; }
-    std::vector<uint8_t>& data() noexcept { return m_data; }  // Non-const for direct access
-    uint8_t* dataPtr() noexcept { return m_data.data(); }     // Raw pointer for C APIs
-    const uint8_t* dataPtr() const noexcept { return m_data.data(); }
+    std::vector<uint8_t>& data() { detach(); return m_data; }  // Non-const for direct access
+    uint8_t* dataPtr() { detach(); return m_data.data(); }     // Raw pointer for C APIs
+    const uint8_t* dataPtr() const noexcept { return m_external ? m_external.get() : m_data.data(); }
+    std::span<const uint8_t> bytes() const noexcept { return {dataPtr(), size()}; }
 
     uint32_t width() const noexcept { return m_width; }
     uint32_t height() const noexcept { return m_height; }
     uint32_t channels() const noexcept { return m_channels; }
+    PixelFormat format() const noexcept { return m_format; }
     Timestamp timestamp() const noexcept { return m_timestamp; }
 
     // --- Mutators ---
     void setData(std::vector<uint8_t> data) noexcept;
     void setTimestampNow() noexcept;
+    void setTimestamp(Timestamp timestamp) noexcept;  // e.g. driver capture time
     void setDimensions(uint32_t width, uint32_t height, uint32_t channels) noexcept;
+    void setDimensions(uint32_t width, uint32_t height, PixelFormat format) noexcept;
+
+    // Copy an external view into owned memory (no-op for owned frames)
+    void detach();
 
     // Pre-allocate buffer to avoid reallocations during capture
     void reserve(size_t capacity);
 
     // --- Utilities ---
-    size_t size() const noexcept { return m_data.size(); }
-    bool empty() const noexcept { return m_data.empty(); }
+    size_t size() const noexcept { return m_external ? m_externalSize : m_data.size(); }
+    bool empty() const noexcept { return size() == 0; }
     size_t capacity() const noexcept { return m_data.capacity(); }
+    bool isExternal() const noexcept { return m_external != nullptr; }
+    bool isCompressed() const noexcept { return m_format == PixelFormat::MJPEG; }
 
-    // Expected size based on dimensions
-    size_t expectedSize() const noexcept {
-        return static_cast<size_t>(m_width) * m_height * m_channels;
-    }
+    // Expected size based on dimensions and format (0 for compressed formats)
+    size_t expectedSize() const noexcept;
 
     // Validate frame data integrity
     bool isValid() const noexcept {
-        return !m_data.empty() && m_data.size() == expectedSize();
+        return !empty() && (isCompressed() || size() == expectedSize());
     }
 
     Frame clone() const;              // Deep copy
@@ -96,7 +136,10 @@ private:
     uint32_t m_width{0};
     uint32_t m_height{0};
     uint32_t m_channels{0};
+    PixelFormat m_format{PixelFormat::Unknown};
     Timestamp m_timestamp;
+    std::shared_ptr<const uint8_t> m_external;  // read-only view, see above
+    size_t m_externalSize{0};
 };
 
 // Non-member swap for ADL (Argument Dependent Lookup)
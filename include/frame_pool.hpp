@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * @file frame_pool.hpp
+ * @brief Fixed set of preallocated frame buffers.
+ *
+ * Sources render into a pooled buffer and hand it out as an external Frame;
+ * the buffer returns to the pool when the last frame viewing it is released.
+ * Buffers are allocated and prefaulted up front, so steady-state capture
+ * neither allocates nor page-faults.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include "memory_budget.hpp"
+
+namespace pcs {
+
+class FramePool {
+public:
+    static constexpr size_t kAlignment = 64; // cache line, also fine for SIMD loads
+
+    /**
+     * @param account Charged for every buffer, as Required. Buffers the
+     *        budget can't cover are not allocated, so the pool may hold
+     *        fewer than `count` (see capacity()).
+     */
+    FramePool(size_t bufferSize, size_t count, MemoryAccount* account = nullptr);
+
+    /**
+     * @brief Take a free buffer; nullptr when all are in use.
+     *        The buffer goes back to the pool when the last reference drops.
+     */
+    std::shared_ptr<uint8_t> acquire();
+
+    size_t bufferSize() const noexcept;
+    size_t capacity() const noexcept;
+    size_t available() const;
+
+    /**
+     * @brief Number of acquire() calls that found the pool empty.
+     */
+    uint64_t exhausted() const noexcept;
+
+private:
+    struct Shared; // outlives the pool while buffers are out
+
+    std::shared_ptr<Shared> shared_;
+};
+
+} // namespace pcs
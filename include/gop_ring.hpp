@@ -0,0 +1,131 @@
+#pragma once
+/**
+ * @file gop_ring.hpp
+ * @brief The last few seconds of encoded packets, kept for event clips.
+ *
+ * Packets are copied once into a single arena of budget_bytes, allocated
+ * up front, and laid out as a circular log; a new packet evicts the oldest
+ * ones until it fits. Nothing else is allocated per packet. Memory is
+ * therefore fixed and append is O(1) amortised: each packet is evicted at
+ * most once. An index of keyframe positions lets a clip start at the last
+ * IDR before the moment asked for.
+ *
+ * A clip is a list of views into the arena, not a copy. The views pin their
+ * packets: while any clip that holds them is alive, appends that would
+ * overwrite them are dropped instead. So an export running slowly costs
+ * live packets in the ring, never extra memory. Release clips promptly.
+ *
+ * When a keyframe is evicted, the rest of its GOP goes with it, since
+ * those packets can't be decoded without it.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+#include "encoder.hpp"
+
+namespace pcs {
+
+struct GopRingConfig {
+    size_t budget_bytes{32 * 1024 * 1024}; // the arena; packets larger than this are refused
+};
+
+/**
+ * @brief One packet of a clip, pointing into the ring's arena.
+ */
+struct PacketView {
+    std::span<const uint8_t> data;
+    int64_t pts{0};
+    int64_t dts{0};
+    bool keyframe{false};
+    uint64_t sequence{0}; // append order
+};
+
+/**
+ * @brief A run of packets starting at a keyframe. Keeps them pinned in the
+ *        ring (and the ring's memory alive) until destroyed.
+ */
+class GopClip {
+public:
+    GopClip() = default;
+
+    const std::vector<PacketView>& packets() const noexcept { return packets_; }
+    bool empty() const noexcept { return packets_.empty(); }
+    size_t bytes() const noexcept;
+
+    /**
+     * @brief Span of presentation time, first to last packet, 90 kHz units.
+     */
+    int64_t durationTicks() const noexcept;
+
+private:
+    friend class GopRing;
+    std::vector<PacketView> packets_;
+    std::shared_ptr<void> pin_;
+};
+
+struct GopRingStats {
+    size_t packets{0};
+    size_t keyframes{0};
+    size_t bytes{0};           // packet data held
+    size_t budget{0};
+    int64_t oldestPts{0};
+    int64_t newestPts{0};
+    uint64_t appended{0};
+    uint64_t evicted{0};
+    uint64_t droppedPinned{0}; // appends refused because a clip held the space
+    uint64_t droppedOversize{0};
+    uint64_t droppedNoKeyframe{0}; // waiting for a keyframe to start a GOP
+};
+
+/**
+ * @class GopRing
+ * @brief Byte-budgeted ring of encoded packets with a keyframe index.
+ *
+ * Thread-safe: one thread appending while others take clips.
+ */
+class GopRing {
+public:
+    explicit GopRing(const GopRingConfig& config = {});
+    ~GopRing();
+
+    GopRing(const GopRing&) = delete;
+    GopRing& operator=(const GopRing&) = delete;
+
+    /**
+     * @brief Copy `frame` into the ring, evicting the oldest GOPs to make room.
+     * @return false if it was dropped (see GopRingStats).
+     */
+    bool append(const EncodedFrame& frame);
+
+    /**
+     * @brief Packets from the last keyframe at or before `pts` (the oldest
+     *        keyframe held, if that one is gone) to the newest.
+     */
+    GopClip clipFrom(int64_t pts) const;
+
+    /**
+     * @brief The `preEvent` before the newest packet, from the keyframe before it.
+     */
+    GopClip clipLast(std::chrono::milliseconds preEvent) const;
+
+    GopRingStats stats() const;
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * @brief Write `clip` to `path` as an MPEG-TS file.
+ * @return false (with the reason logged) if it can't be written.
+ */
+bool saveClip(const GopClip& clip, const std::string& path);
+
+} // namespace pcs
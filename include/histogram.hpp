@@ -0,0 +1,59 @@
+#pragma once
+/**
+ * @file histogram.hpp
+ * @brief Fixed-size log-linear histogram for latency-style measurements.
+ *
+ * Values are bucketed by their top kSubBucketBits + 1 significant bits, so
+ * any recorded value is reported within 1/16 (6.25%) of its true value while
+ * the whole range of uint64_t fits in under a thousand counters. Recording
+ * is a couple of relaxed atomic increments: safe from several threads and
+ * cheap enough for per-frame use; readers see a consistent-enough snapshot
+ * for periodic stats.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace pcs {
+
+class Histogram {
+public:
+    static constexpr int kSubBucketBits = 4;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+    Histogram() noexcept;
+
+    void record(uint64_t value) noexcept;
+
+    uint64_t count() const noexcept { return count_.load(std::memory_order_relaxed); }
+    uint64_t min() const noexcept;   // 0 when empty
+    uint64_t max() const noexcept { return max_.load(std::memory_order_relaxed); }
+    double mean() const noexcept;
+
+    /**
+     * @brief Smallest bucket bound with at least `p` percent of the values
+     *        at or below it (p in [0, 100]); never above max(). 0 when empty.
+     */
+    uint64_t percentile(double p) const noexcept;
+
+    /**
+     * @brief Add another histogram's counts to this one.
+     */
+    void merge(const Histogram& other) noexcept;
+
+    void reset() noexcept;
+
+    static int bucketIndex(uint64_t value) noexcept;
+    static uint64_t bucketUpperBound(int index) noexcept;
+
+private:
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_;
+    std::atomic<uint64_t> max_{0};
+};
+
+} // namespace pcs
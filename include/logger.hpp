@@ -1,5 +1,9 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <mutex>
@@ -7,6 +11,33 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/rotating_file_sink.h>
 
+namespace spdlog::details {
+class thread_pool;
+}
+
+/**
+ * @brief What a full async queue does with the next message
+ */
+enum class LogOverflow {
+    Block,        // the caller waits for the writer thread; nothing is lost
+    OverrunOldest // the oldest queued message is dropped; the caller never waits
+};
+
+/**
+ * @brief How messages reach the sinks
+ *
+ * Synchronous logging writes on the calling thread, so threads logging at
+ * once queue up behind the console and file. Async logging only formats on
+ * the calling thread and hands the message to a queue, preallocated at
+ * init(), that one background thread writes out.
+ */
+struct LogOptions {
+    bool async{false};
+    size_t queue_size{8192}; // messages held while the writer catches up
+    LogOverflow overflow{LogOverflow::Block};
+    bool console{true};      // also write to stdout
+};
+
 /**
  * @brief Simple logging wrapper around spdlog
  *
@@ -20,13 +51,26 @@ public:
      * @brief Initialize the logger with console and file sinks
      * @param filename Log file name (default: "app.log")
      * @param level Logging level (default: "info")
+     * @param options Sync or async, and the async queue
+     */
+    static void init(const std::string& filename = "app.log", const std::string& level = "info",
+                     const LogOptions& options = {});
+
+    /**
+     * @brief Get the singleton logger instance, initialising it with
+     *        defaults on first use. Lock-free once initialised; the pointer
+     *        is valid until shutdown().
      */
-    static void init(const std::string& filename = "app.log", const std::string& level = "info");
+    static spdlog::logger* get();
 
     /**
-     * @brief Get the singleton logger instance
+     * @brief Whether a message at `level` would be written: one relaxed
+     *        load and a compare, for the PCS_LOG_* macros to test before
+     *        evaluating anything. Tracks init() and setLevel().
      */
-    static std::shared_ptr<spdlog::logger> get();
+    static bool enabled(spdlog::level::level_enum level) noexcept {
+        return static_cast<int>(level) >= s_level.load(std::memory_order_relaxed);
+    }
 
     /**
      * @brief Set log level dynamically
@@ -35,7 +79,8 @@ public:
     static void setLevel(const std::string& level);
 
     /**
-     * @brief Shutdown logger and flush all pending messages
+     * @brief Shutdown logger and flush all pending messages, waiting for
+     *        the async queue to drain
      */
     static void shutdown();
 
@@ -70,7 +115,118 @@ public:
         get()->critical(fmt, std::forward<Args>(args)...);
     }
 
+    /**
+     * @brief Log at `level`, noting how many similar messages a rate limit
+     *        held back since the last one, e.g. "... (12 similar suppressed)"
+     */
+    template<typename... Args>
+    static void logSuppressed(spdlog::level::level_enum level, uint64_t suppressed,
+                              spdlog::format_string_t<Args...> fmt, Args&&... args) {
+        if (suppressed == 0) {
+            get()->log(level, fmt, std::forward<Args>(args)...);
+            return;
+        }
+        get()->log(level, "{} ({} similar suppressed)", fmt::format(fmt, std::forward<Args>(args)...),
+                   suppressed);
+    }
+
 private:
     static std::shared_ptr<spdlog::logger> s_logger;
+    static std::shared_ptr<spdlog::details::thread_pool> s_threadPool; // async mode's writer
+    static std::atomic<spdlog::logger*> s_current; // s_logger, for get() without the lock
+    static std::atomic<int> s_level;                // s_logger's level, for enabled()
     static std::mutex s_mutex;
 };
+
+/**
+ * @brief Lets one message through per interval and counts the rest.
+ *        Thread-safe; one per PCS_LOG_EVERY statement.
+ */
+class LogRateLimiter
+{
+public:
+    explicit LogRateLimiter(std::chrono::steady_clock::duration interval) noexcept;
+
+    /**
+     * @brief true if a message may go out now; `suppressed` is then the
+     *        number held back since the previous one.
+     */
+    bool admit(uint64_t& suppressed) noexcept;
+
+private:
+    const int64_t intervalTicks_;
+    std::atomic<int64_t> nextDue_;
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+/**
+ * @brief Lets the first and then every Nth message through.
+ *        Thread-safe; one per PCS_LOG_EVERY_N statement.
+ */
+class LogSampler
+{
+public:
+    explicit LogSampler(uint64_t every) noexcept;
+
+    /**
+     * @brief true for 1 call in N; `suppressed` is then the number held
+     *        back since the previous one.
+     */
+    bool admit(uint64_t& suppressed) noexcept;
+
+private:
+    const uint64_t every_;
+    std::atomic<uint64_t> count_{0};
+};
+
+// ============================================================================
+// Hot-path logging macros
+// ============================================================================
+//
+// For per-frame logging. A statement below PCS_LOG_MIN_LEVEL compiles to
+// nothing; one below the runtime level costs Logger::enabled(), a single
+// well-predicted branch, and never evaluates its arguments. The rate-limited
+// forms then log at most once per interval or once per N calls, with a count
+// of what they held back:
+//
+//   PCS_LOG_DEBUG("Encode: {} bytes in {} us", size, micros);
+//   PCS_LOG_EVERY(spdlog::level::warn, std::chrono::seconds(1), "Send: queue full");
+//   PCS_LOG_EVERY_N(spdlog::level::debug, 30, "Capture: frame {}", sequence);
+//
+// `level` must be a constant. The interval and N are read once per statement.
+
+// Set from CMake's PCS_LOG_MIN_LEVEL; trace keeps every statement
+#ifndef PCS_LOG_MIN_LEVEL
+#define PCS_LOG_MIN_LEVEL SPDLOG_LEVEL_TRACE
+#endif
+
+#define PCS_LOG(level, ...)                                                    \
+    do {                                                                       \
+        if constexpr (static_cast<int>(level) >= PCS_LOG_MIN_LEVEL) {          \
+            if (Logger::enabled(level)) [[unlikely]] {                         \
+                Logger::get()->log(level, __VA_ARGS__);                        \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+#define PCS_LOG_LIMITED(level, Limiter, limit, ...)                            \
+    do {                                                                       \
+        if constexpr (static_cast<int>(level) >= PCS_LOG_MIN_LEVEL) {          \
+            if (Logger::enabled(level)) [[unlikely]] {                         \
+                static Limiter pcs_log_limiter_(limit);                        \
+                uint64_t pcs_log_suppressed_ = 0;                              \
+                if (pcs_log_limiter_.admit(pcs_log_suppressed_)) {             \
+                    Logger::logSuppressed(level, pcs_log_suppressed_, __VA_ARGS__); \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    } while (0)
+
+#define PCS_LOG_EVERY(level, interval, ...) PCS_LOG_LIMITED(level, LogRateLimiter, interval, __VA_ARGS__)
+#define PCS_LOG_EVERY_N(level, n, ...) PCS_LOG_LIMITED(level, LogSampler, n, __VA_ARGS__)
+
+#define PCS_LOG_TRACE(...) PCS_LOG(spdlog::level::trace, __VA_ARGS__)
+#define PCS_LOG_DEBUG(...) PCS_LOG(spdlog::level::debug, __VA_ARGS__)
+#define PCS_LOG_INFO(...) PCS_LOG(spdlog::level::info, __VA_ARGS__)
+#define PCS_LOG_WARN(...) PCS_LOG(spdlog::level::warn, __VA_ARGS__)
+#define PCS_LOG_ERROR(...) PCS_LOG(spdlog::level::err, __VA_ARGS__)
@@ -0,0 +1,183 @@
+#pragma once
+/**
+ * @file memory_budget.hpp
+ * @brief One byte budget shared by every queue and pool that holds frames.
+ *
+ * Queue limits count items, so what they cost depends on the frame size: a
+ * configuration that is fine at 720p can run a 1 GB Pi out of memory at 4K.
+ * Components instead charge what they hold to a named account of a shared
+ * MemoryBudget, and give it back when done.
+ *
+ * The response to a budget running low is graduated by priority:
+ *   - Deferrable charges (copies for the recorder) are refused first, at
+ *     defer_at of the limit, so archiving gives way before the live stream;
+ *   - Droppable charges (captured frames) are refused at shed_at, so the
+ *     pipeline drops frames at capture;
+ *   - Required charges (pools, encoded frames) are refused only when they
+ *     would pass the limit itself: the last resort.
+ * A zero-byte charge asks whether that priority may still allocate.
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace pcs {
+
+struct MemoryBudgetConfig {
+    size_t limit_bytes{256 * 1024 * 1024}; // 0 = no limit; charges are still counted
+    double defer_at{0.70};                 // fraction of the limit where Deferrable charges stop
+    double shed_at{0.85};                  // fraction of the limit where Droppable charges stop
+};
+
+enum class MemoryPriority : uint8_t {
+    Deferrable, // nice to have: recorder queue
+    Droppable,  // a live frame that can be skipped
+    Required    // losing it costs more than a frame
+};
+
+enum class MemoryPressure : uint8_t {
+    Normal,
+    Deferring, // past defer_at
+    Shedding,  // past shed_at
+    Exhausted  // a Required charge has been refused since the last check
+};
+
+const char* memoryPressureName(MemoryPressure pressure) noexcept;
+
+class MemoryBudget;
+
+/**
+ * @brief One component's share of a MemoryBudget.
+ *
+ * Thread-safe. Owned by the budget; valid for the budget's lifetime.
+ */
+class MemoryAccount {
+public:
+    const std::string& name() const noexcept { return name_; }
+
+    /**
+     * @brief Charge `bytes` if the budget allows it at `priority`.
+     * @return false (and counted as refused) if it doesn't; nothing is charged.
+     */
+    bool tryCharge(size_t bytes, MemoryPriority priority);
+
+    /**
+     * @brief Give back bytes charged earlier.
+     */
+    void release(size_t bytes) noexcept;
+
+    size_t used() const noexcept { return used_.load(std::memory_order_relaxed); }
+    size_t peak() const noexcept { return peak_.load(std::memory_order_relaxed); }
+    uint64_t refused() const noexcept { return refused_.load(std::memory_order_relaxed); }
+
+private:
+    friend class MemoryBudget;
+    MemoryAccount(MemoryBudget& budget, std::string name);
+
+    MemoryBudget& budget_;
+    const std::string name_;
+    std::atomic<size_t> used_{0};
+    std::atomic<size_t> peak_{0};
+    std::atomic<uint64_t> refused_{0};
+};
+
+/**
+ * @brief Bytes charged to an account, given back on destruction. Empty
+ *        (false) when the charge was refused or no account was given.
+ */
+class MemoryCharge {
+public:
+    MemoryCharge() = default;
+
+    /**
+     * @brief Charge `bytes` to `account` at `priority`; a null account
+     *        always succeeds without charging anything.
+     */
+    static MemoryCharge take(MemoryAccount* account, size_t bytes, MemoryPriority priority);
+
+    MemoryCharge(MemoryCharge&& other) noexcept;
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+    MemoryCharge(const MemoryCharge&) = delete;
+    MemoryCharge& operator=(const MemoryCharge&) = delete;
+    ~MemoryCharge() { reset(); }
+
+    explicit operator bool() const noexcept { return granted_; }
+    size_t bytes() const noexcept { return bytes_; }
+
+    /**
+     * @brief Give the bytes back now.
+     */
+    void reset() noexcept;
+
+private:
+    MemoryAccount* account_{nullptr};
+    size_t bytes_{0};
+    bool granted_{false};
+};
+
+struct MemoryUsage {
+    std::string name;
+    size_t used{0};
+    size_t peak{0};
+    uint64_t refused{0};
+};
+
+/**
+ * @class MemoryBudget
+ * @brief Byte limit shared by named accounts, with per-account usage.
+ *
+ * Thread-safe. Must outlive every component charging to it.
+ */
+class MemoryBudget {
+public:
+    explicit MemoryBudget(const MemoryBudgetConfig& config = {});
+
+    MemoryBudget(const MemoryBudget&) = delete;
+    MemoryBudget& operator=(const MemoryBudget&) = delete;
+
+    /**
+     * @brief The account called `name`, created on first use.
+     */
+    MemoryAccount& account(const std::string& name);
+
+    size_t limit() const noexcept { return config_.limit_bytes; }
+    size_t used() const noexcept { return used_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief How constrained charges are now; Exhausted if a Required charge
+     *        was refused since the previous call.
+     */
+    MemoryPressure pressure() noexcept;
+
+    /**
+     * @brief Every account, in creation order.
+     */
+    std::vector<MemoryUsage> usage() const;
+
+private:
+    friend class MemoryAccount;
+
+    MemoryBudgetConfig config_;
+    std::atomic<size_t> used_{0};
+    std::atomic<bool> exhausted_{false};
+
+    mutable std::mutex accountsMtx_;
+    std::deque<std::unique_ptr<MemoryAccount>> accounts_;
+
+    size_t ceiling(MemoryPriority priority) const noexcept;
+    bool reserve(size_t bytes, MemoryPriority priority) noexcept;
+    void unreserve(size_t bytes) noexcept;
+};
+
+/**
+ * @brief e.g. "62.0/256.0 MiB (normal): capture-queue 12.4 MiB, sender-queue 1.1 MiB"
+ */
+std::string describeMemoryUsage(const MemoryBudget& budget, MemoryPressure pressure);
+
+} // namespace pcs
@@ -0,0 +1,102 @@
+#pragma once
+/**
+ * @file mjpeg.hpp
+ * @brief MJPEG camera passthrough and on-demand decoding.
+ *
+ * When the camera already produces MJPEG and the stream is MJPEG, frames go
+ * to the sender as captured: a cheap marker check replaces the decode,
+ * colour conversion and re-encode. Pixels are only produced when a consumer
+ * (motion detection, snapshots) asks for them.
+ */
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <span>
+#include "encoder.hpp"
+#include "frame.hpp"
+
+namespace pcs {
+
+/**
+ * @brief Length of the JPEG image at the start of `data`, or 0 if it is not
+ *        a complete image.
+ *
+ * Checks the SOI marker at the start and the EOI marker at the end; zero
+ * padding after EOI (UVC drivers round bytesused up) is excluded from the
+ * length. The entropy-coded data is not parsed.
+ */
+size_t jpegImageLength(std::span<const uint8_t> data) noexcept;
+
+/**
+ * @class MjpegPassthrough
+ * @brief Turns validated camera MJPEG frames into EncodedFrames unchanged.
+ *
+ * Every JPEG is independently decodable, so every output is a keyframe.
+ * Timestamps follow the Encoder's 90 kHz convention (pts 0 at the first
+ * frame), so the sender cannot tell the two paths apart.
+ *
+ * Not thread-safe: one instance per stream.
+ */
+class MjpegPassthrough {
+public:
+    /**
+     * @param maxFrameBytes Frames larger than this are rejected as corrupt;
+     *        0 uses the uncompressed BGR24 size of the frame.
+     */
+    explicit MjpegPassthrough(size_t maxFrameBytes = 0);
+
+    /**
+     * @brief Validate `frame` and wrap its bytes for the sender.
+     * @return std::nullopt for non-MJPEG, truncated or oversized frames.
+     */
+    std::optional<EncodedFrame> process(const Frame& frame);
+
+    uint64_t framesPassed() const noexcept { return passed_; }
+    uint64_t framesRejected() const noexcept { return rejected_; }
+    uint64_t bytesPassed() const noexcept { return bytes_; }
+
+private:
+    size_t maxFrameBytes_;
+    std::optional<Frame::Timestamp> epoch_;
+    int64_t lastPts_{-1};
+    uint64_t passed_{0};
+    uint64_t rejected_{0};
+    uint64_t bytes_{0};
+};
+
+/**
+ * @class LazyFrame
+ * @brief A captured frame whose pixels are decoded on first use.
+ *
+ * Raw frames are their own pixels. Compressed frames are handed to the
+ * decoder the first time pixels() is called and the result is kept, so
+ * several consumers of the same frame pay for one decode, and a frame
+ * nobody looks at costs nothing.
+ */
+class LazyFrame {
+public:
+    using Decoder = std::function<std::optional<Frame>(const Frame&)>;
+
+    LazyFrame() = default;
+    LazyFrame(Frame captured, Decoder decoder);
+
+    // The frame as captured (compressed for MJPEG cameras)
+    const Frame& captured() const noexcept { return captured_; }
+
+    /**
+     * @brief Decoded pixels, decoding now if needed.
+     * @return nullptr if the frame could not be decoded.
+     */
+    const Frame* pixels();
+
+    bool decoded() const noexcept { return decoded_.has_value(); }
+
+private:
+    Frame captured_;
+    Decoder decoder_;
+    std::optional<Frame> decoded_;
+    bool failed_{false};
+};
+
+} // namespace pcs
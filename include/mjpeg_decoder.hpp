@@ -0,0 +1,57 @@
+#pragma once
+/**
+ * @file mjpeg_decoder.hpp
+ * @brief libav JPEG decoder producing Frames, for LazyFrame.
+ */
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "frame.hpp"
+
+struct AVCodecContext;
+struct AVFrame;
+struct AVPacket;
+struct SwsContext;
+
+namespace pcs {
+
+/**
+ * @class MjpegDecoder
+ * @brief Decodes single JPEG images into Gray8, I420 or BGR24 frames.
+ *
+ * Gray8 is the cheapest output and is all motion detection needs. The
+ * codec is opened on first use and reused for every frame.
+ *
+ * Not thread-safe: one instance per consumer thread.
+ */
+class MjpegDecoder {
+public:
+    explicit MjpegDecoder(PixelFormat output = PixelFormat::Gray8);
+    ~MjpegDecoder();
+
+    MjpegDecoder(const MjpegDecoder&) = delete;
+    MjpegDecoder& operator=(const MjpegDecoder&) = delete;
+
+    /**
+     * @brief Decode one compressed frame.
+     * @return std::nullopt if the image is corrupt or the output format is
+     *         unsupported.
+     */
+    std::optional<Frame> decode(const Frame& jpeg);
+
+    uint64_t framesDecoded() const noexcept { return decoded_; }
+
+private:
+    PixelFormat output_;
+    AVCodecContext* ctx_{nullptr};
+    AVFrame* avFrame_{nullptr};
+    AVPacket* avPacket_{nullptr};
+    SwsContext* swsCtx_{nullptr};
+    std::vector<uint8_t> packet_; // input copy with libav's required padding
+    uint64_t decoded_{0};
+
+    bool open();
+};
+
+} // namespace pcs
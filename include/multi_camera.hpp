@@ -0,0 +1,138 @@
+#pragma once
+/**
+ * @file multi_camera.hpp
+ * @brief Several capture sources feeding one shared pool of encode workers.
+ *
+ * Each camera gets a dedicated capture thread, optionally pinned to a CPU,
+ * and keeps its own buffers (V4L2 mmap buffers, a synthetic FramePool, a
+ * replay mapping), so a stalled camera never starves another of memory.
+ * Captured frames meet in one bounded queue served by a fixed number of
+ * encode workers, however many cameras there are; frames of one camera
+ * are still encoded and delivered in capture order.
+ *
+ * Every source stamps frames from the monotonic clock (steady_clock, which
+ * is CLOCK_MONOTONIC, the clock V4L2 drivers use), so timestamps from
+ * different cameras can be compared directly to align streams.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "buffer.hpp"
+#include "capture_source.hpp"
+#include "encoder.hpp"
+#include "histogram.hpp"
+
+namespace pcs {
+
+struct MultiCameraConfig {
+    size_t queue_depth{8};    // shared capture -> encode queue, in frames
+    size_t encode_workers{0}; // 0 = one per camera, at most one per core
+};
+
+struct CameraFrame {
+    uint32_t camera{0};
+    uint64_t sequence{0}; // consecutive for the frames of one camera that were queued
+    Frame frame;
+};
+
+struct CameraStats {
+    std::string name;
+    uint64_t captured{0};      // frames read from the source
+    uint64_t dropped{0};       // captured but not queued: the encoders were behind
+    uint64_t readFailures{0};  // source read() calls that returned no frame
+    uint64_t encoded{0};
+    uint64_t encodeFailures{0};
+    uint64_t skipped{0};       // left out by the encode step on purpose, e.g. an unchanged scene
+    double fps{0.0};           // captured frames per second since start()
+    uint64_t latencyP50Us{0};  // capture timestamp -> encoded, microseconds
+    uint64_t latencyP99Us{0};
+};
+
+/**
+ * @class MultiCamera
+ * @brief Runs N capture threads and a shared encode pool.
+ *
+ * The encode callback is called for one frame of a camera at a time (a
+ * per-camera Encoder needs no extra locking); the sink receives that
+ * camera's output in order, typically forwarding it to a Sender.
+ */
+class MultiCamera {
+public:
+    using EncodeFn = std::function<EncodeResult(uint32_t camera, const Frame& frame)>;
+    using SinkFn = std::function<void(uint32_t camera, EncodedFrame&& frame)>;
+
+    MultiCamera(const MultiCameraConfig& config, EncodeFn encode, SinkFn sink);
+    ~MultiCamera();
+
+    MultiCamera(const MultiCamera&) = delete;
+    MultiCamera& operator=(const MultiCamera&) = delete;
+
+    /**
+     * @brief Register a camera; only allowed before start().
+     * @param cpu CPU to pin the capture thread to, or -1 for no pinning.
+     * @return The camera index passed to the callbacks.
+     */
+    uint32_t addCamera(std::unique_ptr<CaptureSource> source, int cpu = -1);
+
+    /**
+     * @brief Start every source, then the capture and encode threads.
+     * @return false (with nothing left running) if any source fails to start.
+     */
+    bool start();
+
+    /**
+     * @brief Stop capturing, encode what is already queued, join all threads.
+     */
+    void stop();
+
+    bool running() const noexcept { return running_.load(); }
+    size_t cameraCount() const noexcept { return cameras_.size(); }
+    size_t encodeWorkers() const noexcept { return workers_.size(); }
+    Frame::Timestamp epoch() const noexcept { return epoch_; }
+
+    CameraStats stats(uint32_t camera) const;
+
+private:
+    struct Camera {
+        std::unique_ptr<CaptureSource> source;
+        int cpu{-1};
+        std::thread thread;
+
+        // Encode ordering: frames take turns by sequence number
+        std::mutex encodeMtx;
+        std::condition_variable turn;
+        uint64_t nextToEncode{0};
+
+        std::atomic<uint64_t> captured{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> readFailures{0};
+        std::atomic<uint64_t> encoded{0};
+        std::atomic<uint64_t> encodeFailures{0};
+        std::atomic<uint64_t> skipped{0};
+        Histogram latency; // microseconds
+    };
+
+    MultiCameraConfig config_;
+    EncodeFn encode_;
+    SinkFn sink_;
+    std::vector<std::unique_ptr<Camera>> cameras_;
+    std::unique_ptr<Buffer<CameraFrame>> queue_;
+    std::vector<std::thread> workers_;
+    std::atomic<bool> running_{false};
+    Frame::Timestamp epoch_{};
+    Frame::Timestamp stoppedAt_{};
+
+    void capture_loop(uint32_t index);
+    void encode_loop();
+};
+
+} // namespace pcs
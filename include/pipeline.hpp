@@ -0,0 +1,292 @@
+#pragma once
+/**
+ * @file pipeline.hpp
+ * @brief Threaded capture -> encode -> send pipeline for one camera.
+ *
+ * Each stage runs on its own thread and hands frames to the next through a
+ * bounded Buffer. Capture never waits: a frame the encoder has no room for
+ * is dropped, as a camera would overwrite it. A slow sender backs up into
+ * the encoder and from there into capture drops. Encoded frames are only
+ * dropped when memory runs out or the sender refuses them; later frames
+ * reference them, so the rest of the GOP goes too and the keyframe request
+ * hook asks the encoder for an IDR to resume from.
+ *
+ * Shutdown runs front to back: capture stops, each stage drains what is
+ * already queued, closes its output and exits.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "buffer.hpp"
+#include "capture_scheduler.hpp"
+#include "capture_source.hpp"
+#include "config.hpp"
+#include "encoder.hpp"
+#include "histogram.hpp"
+#include "memory_budget.hpp"
+#include "thread_config.hpp"
+
+namespace pcs {
+
+// Which frame capture gives up when the encoder is behind
+enum class DropPolicy {
+    Newest, // keep what is queued, drop the frame just captured
+    Oldest  // evict the stalest queued frame, so the encoder sees the latest
+};
+
+struct PipelineConfig {
+    size_t capture_queue{4};  // frames waiting for the encoder
+    size_t send_queue{8};     // encoded frames waiting for the sender
+    double fps_cap{0.0};      // drop captured frames above this rate; 0 = camera rate
+    std::chrono::milliseconds capture_budget{100}; // drop frames older than this when read; 0 = keep all
+    DropPolicy drop_policy{DropPolicy::Newest};
+    std::chrono::milliseconds stats_interval{5000}; // run() logs stats this often; 0 = never
+    std::chrono::milliseconds control_interval{1000}; // run() calls its control hook this often
+    uint64_t max_frames{0};   // stop capturing after this many frames; 0 = no limit
+    // Queued frames are charged here (accounts "capture-queue" and
+    // "encoded-queue"): capture drops once it refuses Droppable charges.
+    // Null = item limits only. Must outlive the pipeline.
+    MemoryBudget* memory{nullptr};
+
+    ThreadConfig capture_thread{.name = "pcs-capture"};
+    ThreadConfig encode_thread{.name = "pcs-encode"};
+    ThreadConfig send_thread{.name = "pcs-send"};
+};
+
+/**
+ * @brief One stage's activity over a reporting window.
+ *
+ * Latency is measured per stage: capture is the frame's age when the source
+ * hands it over (stale and decimated frames too), encode is time spent in the encoder, and send is end to
+ * end, from the capture timestamp until the sender accepted the frame.
+ */
+struct PacingStats {
+    uint64_t jitterP50Us{0}; // |interval - period| between delivered frames
+    uint64_t jitterP99Us{0};
+    uint64_t jitterMaxUs{0};
+    uint64_t late{0};        // dropped as older than capture_budget
+    uint64_t early{0};       // decimated, ahead of the schedule
+    uint64_t missed{0};      // deadlines the source itself missed
+};
+
+struct StageStats {
+    std::string name;
+    uint64_t frames{0};   // frames the stage completed in the window
+    uint64_t dropped{0};  // frames the stage lost in the window
+    uint64_t skipped{0};  // frames the encode step left out on purpose
+    double fps{0.0};
+    uint64_t latencyP50Us{0};
+    uint64_t latencyP99Us{0};
+    uint64_t latencyMaxUs{0};
+    std::optional<PacingStats> pacing; // capture only
+};
+
+/**
+ * @brief What a control loop needs to know about the pipeline's load.
+ */
+struct PipelineLoad {
+    uint64_t latencyP99Us{0}; // capture to sender, since the previous load()
+    double queueFill{0.0};    // fuller of the two queues, as a fraction of its limit
+};
+
+/**
+ * @brief When the first frame got through each stage: read from the
+ *        source, out of the encoder, accepted by the sender.
+ */
+struct FirstFrameTimes {
+    std::optional<std::chrono::steady_clock::time_point> captured;
+    std::optional<std::chrono::steady_clock::time_point> encoded;
+    std::optional<std::chrono::steady_clock::time_point> sent;
+};
+
+const char* dropPolicyName(DropPolicy policy) noexcept;
+
+/**
+ * @brief Source for a camera config: "synthetic" (or "synthetic:<pattern>",
+ *        pattern one of bars, gradient, noise, timestamp) renders test
+ *        frames, anything else is opened as a V4L2 device.
+ * @param formats Pixel formats to ask the camera for, best first
+ *        (capturePreferences()); the synthetic source uses the first raw one.
+ * @param memory Budget for the synthetic source's frame pool ("frame-pool").
+ * @return nullptr for an unknown synthetic pattern.
+ */
+std::unique_ptr<CaptureSource> makeCaptureSource(const config::CameraConfig& camera,
+                                                 const std::vector<PixelFormat>& formats,
+                                                 MemoryBudget* memory = nullptr);
+
+/**
+ * @class Pipeline
+ * @brief Runs capture, encode and send on three threads.
+ *
+ * The encode and send steps are callables so the pipeline can be driven by
+ * a real Encoder and Sender, an MJPEG passthrough, or test doubles.
+ * A pipeline runs once: it cannot be started again after stop().
+ */
+class Pipeline {
+public:
+    using EncodeFn = std::function<EncodeResult(const Frame& frame)>;
+    using SendFn = std::function<bool(EncodedFrame&& frame)>;
+    using FrameTap = std::function<void(Frame&& frame)>;
+    using KeyframeRequest = std::function<void()>;
+
+    Pipeline(std::unique_ptr<CaptureSource> source, EncodeFn encode, SendFn send,
+             const PipelineConfig& config = {});
+    ~Pipeline();
+
+    Pipeline(const Pipeline&) = delete;
+    Pipeline& operator=(const Pipeline&) = delete;
+
+    /**
+     * @brief Start the source and the stage threads, and log how each
+     *        stage thread's ThreadConfig was applied.
+     * @return false if the source failed to start or the pipeline already ran.
+     */
+    bool start();
+
+    /**
+     * @brief Hand every frame the encode stage took to `tap` once it is done
+     *        with it (encoded or not), on the encode thread. The frame is
+     *        moved, not copied: a tap that keeps it holds its capture buffer.
+     *        Set before start().
+     */
+    void setFrameTap(FrameTap tap) { tap_ = std::move(tap); }
+
+    /**
+     * @brief Call `request` when an encoded frame is dropped, from the
+     *        encode or send thread, so the encoder can start a new GOP
+     *        (Encoder::requestKeyframe()). Set before start().
+     */
+    void setKeyframeRequest(KeyframeRequest request) { keyframeRequest_ = std::move(request); }
+
+    /**
+     * @brief Stop capturing, let queued frames drain, join the threads.
+     */
+    void stop();
+
+    /**
+     * @brief Apply new tunables to the running pipeline: queue limits,
+     *        fps_cap and drop_policy. Thread settings, max_frames and
+     *        stats_interval only take effect at start().
+     */
+    void reconfigure(const PipelineConfig& config);
+
+    /**
+     * @brief Block until `stopRequested` becomes true or capture ends
+     *        (max_frames reached), logging stats every stats_interval and
+     *        calling `control` (if set) every control_interval; then stop().
+     *        Logs the time to first frame once one has been sent.
+     */
+    void run(const std::atomic<bool>& stopRequested, const std::function<void()>& control = {});
+
+    /**
+     * @brief True once the capture stage has exited on its own.
+     */
+    bool captureDone() const noexcept { return captureDone_.load(); }
+
+    /**
+     * @brief Stats for capture, encode and send since the previous call
+     *        (or since start()), then start a new window.
+     */
+    std::vector<StageStats> report();
+
+    /**
+     * @brief Log report() as one line per stage, then the memory budget's
+     *        usage if there is one.
+     */
+    void logStats();
+
+    /**
+     * @brief End-to-end latency since the previous call and current queue
+     *        fill. Has its own window, independent of report().
+     */
+    PipelineLoad load();
+
+    /**
+     * @brief Time to first frame, stage by stage; unset until it happens.
+     */
+    FirstFrameTimes firstFrame() const;
+
+    const CaptureSource& source() const noexcept { return *source_; }
+
+    /**
+     * @brief How each stage's ThreadConfig was applied (capture, encode,
+     *        send); filled in by start().
+     */
+    const std::vector<ThreadReport>& threadReports() const noexcept { return threadReports_; }
+
+private:
+    struct Stage {
+        const char* name;
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> skipped{0};
+        Histogram latency; // microseconds, current window
+        uint64_t reportedFrames{0};
+        uint64_t reportedDropped{0};
+        uint64_t reportedSkipped{0};
+
+        explicit Stage(const char* stageName) : name(stageName) {}
+    };
+
+    std::unique_ptr<CaptureSource> source_;
+    std::unique_ptr<CaptureScheduler> scheduler_; // paces source_ on the capture thread
+    EncodeFn encode_;
+    SendFn send_;
+    FrameTap tap_;
+    KeyframeRequest keyframeRequest_;
+    PipelineConfig config_;
+
+    // Each queued frame carries its charge against config_.memory
+    struct Captured {
+        Frame frame;
+        MemoryCharge charge;
+    };
+
+    // The capture time rides along for the send stage's end-to-end latency
+    struct Encoded {
+        EncodedFrame frame;
+        Frame::Timestamp captured;
+        MemoryCharge charge;
+    };
+
+    Buffer<Captured> captured_;
+    Buffer<Encoded> encoded_;
+    Stage captureStage_{"capture"};
+    Stage encodeStage_{"encode"};
+    Stage sendStage_{"send"};
+    PacingStats reportedPacing_; // scheduler counters at the previous report()
+    Histogram controlLatency_; // end to end, microseconds, load()'s window
+    // Steady clock ticks of each stage's first frame; 0 until then
+    std::atomic<int64_t> firstCaptured_{0};
+    std::atomic<int64_t> firstEncoded_{0};
+    std::atomic<int64_t> firstSent_{0};
+    MemoryAccount* captureMemory_{nullptr};
+    MemoryAccount* encodedMemory_{nullptr};
+
+    std::thread captureThread_;
+    std::thread encodeThread_;
+    std::thread sendThread_;
+    std::atomic<bool> running_{false};
+    std::atomic<bool> captureDone_{false};
+    std::atomic<double> fpsCap_{0.0};
+    std::atomic<DropPolicy> dropPolicy_{DropPolicy::Newest};
+    bool started_{false};
+    std::chrono::steady_clock::time_point windowStart_;
+    std::vector<ThreadReport> threadReports_;
+
+    void log_first_frame() const;
+    PacingConfig pacing_for(double fpsCap) const;
+    PacingStats report_pacing();
+    void capture_loop();
+    void encode_loop();
+    void send_loop();
+};
+
+} // namespace pcs
@@ -0,0 +1,151 @@
+#pragma once
+/**
+ * @file recorder.hpp
+ * @brief Records the encoded stream to disk as time-rotated MPEG-TS segments.
+ *
+ * Built for SD cards, whose writes can stall for hundreds of milliseconds
+ * while the card erases or garbage-collects:
+ *
+ *  - push() only copies the frame into a byte-bounded queue; all I/O runs
+ *    on a dedicated writer thread, so a stall never reaches the stream.
+ *  - When the queue is full the rest of the GOP is dropped, up to the next
+ *    keyframe, so the file never holds frames whose references are missing.
+ *  - Muxed data is collected in a page-aligned batch and written in large
+ *    blocks, optionally with O_DIRECT to keep it out of the page cache.
+ *  - Each segment is preallocated with fallocate() so the filesystem lays it
+ *    out contiguously, trimmed to its real size when closed, and flushed
+ *    with fdatasync() every sync_interval rather than on every write.
+ *
+ * Segments start on keyframes, so each one plays on its own.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "encoder.hpp"
+#include "memory_budget.hpp"
+#include "thread_config.hpp"
+#include "ts_muxer.hpp"
+
+namespace pcs {
+
+struct RecorderConfig {
+    std::string directory;                       // must exist
+    std::string prefix{"segment"};               // files are <prefix>-<YYYYmmdd-HHMMSS>-<n>.ts
+    std::chrono::seconds segment_duration{60};   // rotate at the first keyframe after this much stream time
+    size_t queue_bytes{16 * 1024 * 1024};        // encoded data waiting for the writer
+    size_t write_batch{1024 * 1024};             // bytes per write() call
+    size_t preallocate_bytes{64 * 1024 * 1024};  // fallocate() per segment; 0 = none
+    std::chrono::milliseconds sync_interval{2000}; // fdatasync() this often; 0 = only on close
+    bool direct_io{false};                       // O_DIRECT; falls back to buffered where unsupported
+    ThreadConfig writer_thread{.name = "pcs-record"};
+    // Charged for queued frames as Deferrable, so recording is the first
+    // thing to give way when memory runs low. Must outlive the recorder.
+    MemoryAccount* memory{nullptr};
+};
+
+struct RecorderStats {
+    uint64_t framesWritten{0};
+    uint64_t framesDropped{0};
+    uint64_t gopsDropped{0};   // GOPs cut short (or skipped) because the queue was full
+    uint64_t bytesWritten{0};  // to disk, including TS overhead
+    uint64_t segments{0};      // segments opened
+    uint64_t syncs{0};
+    uint64_t writeErrors{0};
+    uint64_t maxWriteUs{0};    // longest single write() or fdatasync()
+};
+
+/**
+ * @class Recorder
+ * @brief Writer thread and segment files for one H.264 stream.
+ */
+class Recorder {
+public:
+    explicit Recorder(const RecorderConfig& config);
+    ~Recorder();
+
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    /**
+     * @brief Start the writer thread. Frames pushed before this wait in the queue.
+     * @return false if the directory isn't writable or the recorder already ran.
+     */
+    bool start();
+
+    /**
+     * @brief Write out what is queued, close the segment and join the thread.
+     */
+    void stop();
+
+    /**
+     * @brief Queue a copy of `frame` for writing. Never blocks on I/O.
+     * @return false if the frame was dropped.
+     */
+    bool push(const EncodedFrame& frame);
+
+    RecorderStats stats() const;
+
+    /**
+     * @brief Path of the segment being written, empty between segments.
+     */
+    std::string currentSegment() const;
+
+    const ThreadReport& threadReport() const noexcept { return threadReport_; }
+
+private:
+    // A page-aligned buffer, as O_DIRECT requires
+    struct AlignedFree {
+        void operator()(uint8_t* p) const noexcept;
+    };
+    using AlignedBuffer = std::unique_ptr<uint8_t, AlignedFree>;
+
+    RecorderConfig config_;
+
+    // Queue between push() and the writer thread, bounded in bytes
+    mutable std::mutex queueMtx_;
+    std::condition_variable queueCv_;
+    std::deque<EncodedFrame> queue_;
+    size_t queuedBytes_{0};
+    bool droppingGop_{true}; // until the first keyframe, nothing can be decoded
+    bool stopping_{false};
+
+    std::thread writer_;
+    bool started_{false};
+    ThreadReport threadReport_;
+
+    // Writer thread state
+    TsMuxer muxer_;
+    std::vector<uint8_t> muxed_;
+    AlignedBuffer batch_;
+    size_t batchCapacity_{0};
+    size_t batchSize_{0};
+    int fd_{-1};
+    bool direct_{false};
+    uint64_t segmentBytes_{0}; // logical size of the open segment
+    int64_t segmentStartPts_{0};
+    uint64_t segmentIndex_{0};
+    std::chrono::steady_clock::time_point lastSync_;
+
+    mutable std::mutex statsMtx_; // guards stats_ and segmentPath_; taken after queueMtx_
+    RecorderStats stats_;
+    std::string segmentPath_;
+
+    void writer_loop();
+    void write_frame(const EncodedFrame& frame);
+    bool open_segment();
+    void close_segment();
+    bool flush_batch(bool final);
+    bool write_fully(const uint8_t* data, size_t size);
+    void sync_segment();
+    void record_io_time(std::chrono::steady_clock::time_point start);
+};
+
+} // namespace pcs
@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * @file replay_source.hpp
+ * @brief Capture source replaying a recorded raw or MJPEG file.
+ *
+ * The file is memory-mapped and frames view the mapping directly, so replay
+ * costs no copies and no read() syscalls. Raw recordings are back-to-back
+ * frames of one size; MJPEG recordings are concatenated JPEG images.
+ *
+ * Original capture times come from an optional sidecar with one timestamp
+ * in milliseconds per line (mkvmerge "timecode v2" style, '#' comments
+ * allowed). Without one, frames are spaced at the nominal fps.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "capture_source.hpp"
+
+namespace pcs {
+
+struct ReplayConfig {
+    std::string path;
+    std::string timestamps_path; // optional sidecar, see above
+    uint32_t width{640};
+    uint32_t height{480};
+    uint32_t fps{30};            // nominal rate without a sidecar
+    PixelFormat format{PixelFormat::NV12};
+    Pacing pacing{Pacing::RealTime};
+    bool loop{false};
+    uint32_t readahead_frames{8}; // MADV_WILLNEED window ahead of the reader
+};
+
+/**
+ * @class ReplaySource
+ * @brief Zero-copy, mmap-backed file replay implementing CaptureSource.
+ *
+ * RealTime pacing reproduces the recorded frame spacing (stamping frames
+ * with their due time); MaxSpeed delivers frames as fast as they are read.
+ * Frames keep the mapping alive, so they stay valid after stop().
+ *
+ * Not thread-safe: read() belongs to one capture thread.
+ */
+class ReplaySource : public CaptureSource {
+public:
+    explicit ReplaySource(const ReplayConfig& config);
+    ~ReplaySource() override;
+
+    bool start() override;
+    void stop() override;
+    bool read(Frame& frame) override;
+    CaptureFormat captureFormat() const override;
+    std::string name() const override;
+
+    /**
+     * @brief True once the last frame was delivered and looping is off.
+     */
+    bool finished() const noexcept { return finished_; }
+
+    uint64_t framesRead() const noexcept { return read_; }
+    uint64_t loops() const noexcept { return loops_; }
+
+private:
+    struct Mapping; // munmap()s when the last frame lets go
+
+    ReplayConfig config_;
+    std::shared_ptr<const Mapping> mapping_;
+    size_t frameBytes_{0}; // raw formats; 0 for MJPEG
+    std::vector<std::chrono::nanoseconds> timestamps_; // relative to the first frame
+
+    size_t offset_{0};     // next frame's position in the file
+    size_t advised_{0};    // end of the WILLNEED window already requested
+    uint64_t index_{0};    // frame number within the current pass
+    std::chrono::nanoseconds loopBase_{0};
+    std::chrono::nanoseconds period_{0};
+    std::chrono::steady_clock::time_point start_;
+    bool running_{false};
+    bool finished_{false};
+    uint64_t read_{0};
+    uint64_t loops_{0};
+
+    bool load_timestamps();
+    bool next_frame(size_t& begin, size_t& length);
+    std::chrono::nanoseconds frame_time(uint64_t index) const;
+    void advise_ahead(size_t position);
+};
+
+} // namespace pcs
@@ -0,0 +1,149 @@
+#pragma once
+/**
+ * @file roi.hpp
+ * @brief Region-of-interest quality maps for the encoder.
+ *
+ * A QualityMap holds one QP offset per 16x16 macroblock: negative values
+ * spend more bits on a block, positive values fewer. Maps are produced by
+ * simple detectors (motion, fixed zones) and handed to Encoder::encode(),
+ * which turns them into AVRegionOfInterest side data.
+ */
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "frame.hpp"
+
+namespace pcs {
+
+class ThreadPool;
+
+/**
+ * @brief Axis-aligned rectangle in frame pixels.
+ */
+struct Rect {
+    uint32_t x{0};
+    uint32_t y{0};
+    uint32_t width{0};
+    uint32_t height{0};
+};
+
+/**
+ * @brief Parse rectangles given as WxH+X+Y, comma-separated, e.g.
+ *        "320x240+0+0, 64x64+600+400". Empty text gives no rectangles.
+ * @return std::nullopt on syntax errors or an empty rectangle.
+ */
+std::optional<std::vector<Rect>> parseRectList(const std::string& text);
+
+/**
+ * @brief Rectangle of uniform QP offset, as consumed by the encoder.
+ */
+struct QualityRegion {
+    Rect area;
+    int offset{0};
+};
+
+class QualityMap {
+public:
+    static constexpr uint32_t kBlockSize = 16; // H.264 macroblock
+    static constexpr int kMaxOffset = 51;      // full H.264 QP range
+
+    QualityMap() = default;
+    QualityMap(uint32_t frameWidth, uint32_t frameHeight);
+
+    uint32_t frameWidth() const noexcept { return frameWidth_; }
+    uint32_t frameHeight() const noexcept { return frameHeight_; }
+    uint32_t cols() const noexcept { return cols_; }
+    uint32_t rows() const noexcept { return rows_; }
+
+    int at(uint32_t col, uint32_t row) const noexcept { return offsets_[row * cols_ + col]; }
+    void set(uint32_t col, uint32_t row, int offset) noexcept;
+
+    void fill(int offset) noexcept;
+
+    /**
+     * @brief Set every macroblock touched by a pixel rectangle.
+     */
+    void fillRect(const Rect& area, int offset) noexcept;
+
+    /**
+     * @brief True when no block carries an offset.
+     */
+    bool isNeutral() const noexcept;
+
+    /**
+     * @brief Merge equal-offset blocks into rectangles (pixels, clipped to the frame).
+     *
+     * Neutral blocks are omitted. Runs are merged horizontally within a
+     * block row and then vertically across rows with the same span.
+     */
+    std::vector<QualityRegion> regions() const;
+
+private:
+    uint32_t frameWidth_{0};
+    uint32_t frameHeight_{0};
+    uint32_t cols_{0};
+    uint32_t rows_{0};
+    std::vector<int8_t> offsets_;
+};
+
+struct MotionRoiConfig {
+    double threshold{6.0}; // mean absolute difference per sampled byte
+    int motion_offset{-6}; // moving blocks: better quality
+    int static_offset{4};  // still blocks: fewer bits
+    int row_step{4};       // analyse every Nth row inside a block
+};
+
+/**
+ * @class MotionRoiDetector
+ * @brief Per-macroblock motion mask from the difference to the previous frame.
+ *
+ * Not thread-safe; owned by the thread that feeds the encoder. With a
+ * pool, update() scores bands of block rows in parallel as Background work.
+ */
+class MotionRoiDetector {
+public:
+    explicit MotionRoiDetector(const MotionRoiConfig& config = {}, ThreadPool* pool = nullptr);
+
+    /**
+     * @brief Build a map for this frame and keep it as the next reference.
+     *        The first frame (or a geometry change) yields a neutral map.
+     */
+    QualityMap update(const Frame& frame);
+
+private:
+    MotionRoiConfig config_;
+    ThreadPool* pool_{nullptr};     // not owned; null = score on the calling thread
+    std::vector<uint8_t> previous_; // sampled rows of the previous frame
+    uint32_t width_{0};
+    uint32_t height_{0};
+    uint32_t channels_{0};
+
+    void store(const Frame& frame);
+};
+
+/**
+ * @class FixedZones
+ * @brief Static zones applied on top of a map, e.g. privacy areas
+ *        (starved of bits) or a doorway that should always stay sharp.
+ */
+class FixedZones {
+public:
+    static constexpr int kPrivacyOffset = QualityMap::kMaxOffset;
+
+    void addPrivacyZone(const Rect& area) { zones_.push_back({area, kPrivacyOffset}); }
+    void addZone(const Rect& area, int offset) { zones_.push_back({area, offset}); }
+    void clear() noexcept { zones_.clear(); }
+    bool empty() const noexcept { return zones_.empty(); }
+
+    /**
+     * @brief Overwrite the covered blocks; later zones win over earlier ones.
+     */
+    void apply(QualityMap& map) const noexcept;
+
+private:
+    std::vector<QualityRegion> zones_;
+};
+
+} // namespace pcs
@@ -0,0 +1,91 @@
+#pragma once
+/**
+ * @file scene_filter.hpp
+ * @brief Pre-encode static-scene detection for pi-camera-streamer.
+ *
+ * Compares each frame against the last frame that was actually encoded using
+ * a SIMD sum of absolute differences over a row-subsampled image, so idle
+ * cameras can skip most encodes (and most uplink bytes).
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+#include "frame.hpp"
+
+namespace pcs {
+
+/**
+ * @brief Sum of absolute differences of two byte ranges (SSE2/NEON when available).
+ */
+uint64_t sum_abs_diff(const uint8_t* a, const uint8_t* b, size_t length) noexcept;
+
+enum class SkipMode {
+    Drop,   // don't encode at all; the next encoded pts simply jumps ahead
+    Repeat  // ask the encoder for a minimal repeat of the last picture
+};
+
+enum class SceneDecision {
+    Encode,
+    Skip,
+    Repeat
+};
+
+struct StaticSceneConfig {
+    bool enabled{true};
+    double threshold{1.5}; // mean absolute difference per sampled byte (0-255)
+    int row_step{4}; // analyse every Nth row
+    std::chrono::milliseconds refresh_interval{10000}; // encode at least this often
+    SkipMode mode{SkipMode::Drop};
+};
+
+/**
+ * @class StaticSceneFilter
+ * @brief Decides per frame whether the scene changed enough to be worth encoding.
+ *
+ * Frames are compared against the last *encoded* frame rather than the
+ * immediately preceding one, so slow drift (lighting, a creeping shadow)
+ * still accumulates past the threshold. A sampled row is width() *
+ * channels() bytes: the luma plane alone for planar YUV (I420, NV12), every
+ * byte for packed formats. Compressed frames can't be compared and are
+ * always encoded. Not thread-safe; owned by the thread that feeds the
+ * encoder.
+ */
+class StaticSceneFilter {
+public:
+    explicit StaticSceneFilter(const StaticSceneConfig& config = {});
+
+    /**
+     * @brief Classify a frame and, if it is to be encoded, make it the new reference.
+     */
+    SceneDecision evaluate(const Frame& frame);
+
+    /**
+     * @brief Forget the reference so the next frame is always encoded.
+     */
+    void reset() noexcept;
+
+    double lastScore() const noexcept { return lastScore_; }
+    uint64_t encodedFrames() const noexcept { return encoded_; }
+    uint64_t skippedFrames() const noexcept { return skipped_; }
+    const StaticSceneConfig& config() const noexcept { return config_; }
+
+private:
+    StaticSceneConfig config_;
+    std::vector<uint8_t> reference_; // sampled rows of the last encoded frame
+    uint32_t refWidth_{0};
+    uint32_t refHeight_{0};
+    uint32_t refChannels_{0};
+    std::optional<Frame::Timestamp> lastEncoded_;
+
+    double lastScore_{0.0};
+    uint64_t encoded_{0};
+    uint64_t skipped_{0};
+
+    double score(const Frame& frame) const;
+    void store_reference(const Frame& frame);
+};
+
+} // namespace pcs
@@ -7,6 +7,7 @@
 #include <atomic>
 #include <condition_variable>
 #include <netinet/in.h> // For sockaddr_in
+#include "memory_budget.hpp"
 
 /**
  * @file sender.hpp
@@ -20,8 +21,12 @@ public:
      * @brief Construct a new Sender object.
      * @param dest_ip Destination IP address of the receiver.
      * @param dest_port Destination TCP port number.
+     * @param memory Charged (as Required) for queued frames; nullptr = unbounded.
+     * @param max_queue_bytes Queued bytes past which frames are refused, so a
+     *        stalled link can't take the whole memory budget; 0 = no cap.
      */
-    Sender(const std::string& dest_ip, int dest_port);
+    Sender(const std::string& dest_ip, int dest_port, pcs::MemoryAccount* memory = nullptr,
+           size_t max_queue_bytes = 0);
 
     /**
      * @brief Destructor – ensures threads are stopped and sockets closed.
@@ -41,9 +46,31 @@ public:
 
     /**
      * @brief Queues an encoded video frame for transmission.
+     *
+     * Once a frame is refused, the frames after it reference a picture
+     * the receiver never gets, so every frame up to the next keyframe is
+     * refused too.
      * @param frame Vector of bytes containing encoded frame data.
+     * @param keyframe Whether the frame starts a GOP (every MJPEG frame does).
+     * @return false if the frame was not queued: not running, empty, over
+     *         the queue cap or the memory budget, or in a dropped GOP.
      */
-    void enqueueFrame(const std::vector<uint8_t>& frame);
+    bool enqueueFrame(const std::vector<uint8_t>& frame, bool keyframe = true);
+
+    /**
+     * @brief Queues an encoded video frame, taking ownership of its bytes.
+     * @param frame Encoded frame data; moved into the queue without a copy.
+     * @param keyframe Whether the frame starts a GOP.
+     * @return false if the frame was not queued (see above).
+     */
+    bool enqueueFrame(std::vector<uint8_t>&& frame, bool keyframe = true);
+
+    /**
+     * @brief Bytes not yet on the wire: frames still queued plus data the
+     *        kernel holds unsent in the socket. Grows when the link can't
+     *        keep up with the encoder.
+     */
+    size_t backlogBytes() const;
 
 private:
     /**
@@ -57,6 +84,12 @@ private:
      */
     bool connectToReceiver();
 
+    /**
+     * @brief Whether a frame may join the queue; charges it if so.
+     *        Caller holds m_queueMutex.
+     */
+    bool admitFrame(size_t size, bool keyframe);
+
 private:
     std::string m_destIp;
     int m_destPort;
@@ -67,5 +100,9 @@ private:
     std::condition_variable m_cv;
 
     std::vector<std::vector<uint8_t>> m_frameQueue;
+    std::atomic<size_t> m_queuedBytes{0};
+    pcs::MemoryAccount* m_memory;
+    size_t m_maxQueueBytes;
+    bool m_droppingGop{false}; // a frame was refused; waiting for a keyframe
     std::atomic<bool> m_running;
 };
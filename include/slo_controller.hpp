@@ -0,0 +1,147 @@
+#pragma once
+/**
+ * @file slo_controller.hpp
+ * @brief Steps stream quality down under load and back up with headroom.
+ *
+ * Once per control interval the controller is fed a LoadSample: end-to-end
+ * latency, how full the stage queues are, process CPU load and the sender's
+ * backlog. When any signal stays over its target it steps down one rung of
+ * a quality ladder that lowers bitrate first, then frame rate, then
+ * resolution, the order in which viewers notice least. When every signal
+ * has stayed well under its target for a while it steps back up.
+ *
+ * Hysteresis comes from two places: stepping up needs a margin below the
+ * targets (headroom), and both directions need several consecutive samples
+ * after the previous change, so the effect of one step is seen before the
+ * next is taken.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace pcs {
+
+struct SloTargets {
+    uint64_t latency_p99_us{250000};   // capture to sender, 99th percentile
+    double queue_fill{0.75};           // fullest stage queue, fraction of its limit
+    double cpu_load{0.90};             // process CPU time per wall second, fraction of all cores
+    size_t sender_backlog_bytes{2 * 1024 * 1024}; // queued in the sender and unsent in the socket
+};
+
+struct SloConfig {
+    SloTargets targets;
+    // Scale factors of the configured value, one rung each, first = full quality
+    std::vector<double> bitrate_steps{1.0, 0.75, 0.5, 0.35};
+    std::vector<double> fps_steps{1.0, 0.67, 0.5};
+    std::vector<double> resolution_steps{1.0, 0.75, 0.5};
+    int degrade_after{2};   // consecutive samples over a target before stepping down
+    int recover_after{10};  // consecutive samples with headroom before stepping up
+    double headroom{0.6};   // headroom = every signal under this fraction of its target
+};
+
+/**
+ * @brief One control interval's view of the pipeline.
+ */
+struct LoadSample {
+    uint64_t latencyP99Us{0};
+    double queueFill{0.0};
+    double cpuLoad{0.0};
+    size_t senderBacklogBytes{0};
+};
+
+/**
+ * @brief A rung of the ladder, as scale factors of the configured settings.
+ */
+struct QualityLevel {
+    size_t step{0}; // 0 = full quality
+    double bitrate_scale{1.0};
+    double fps_scale{1.0};
+    double resolution_scale{1.0};
+
+    bool operator==(const QualityLevel&) const = default;
+};
+
+/**
+ * @class SloController
+ * @brief Decides the quality level from a stream of LoadSamples.
+ *
+ * Not thread-safe; fed from one control thread. Every change is logged
+ * with the signals that caused it.
+ */
+class SloController {
+public:
+    using ApplyFn = std::function<void(const QualityLevel& level)>;
+
+    SloController(const SloConfig& config, ApplyFn apply);
+
+    /**
+     * @brief Take one sample and step if warranted, calling apply().
+     * @return true if the level changed.
+     */
+    bool update(const LoadSample& sample);
+
+    const QualityLevel& level() const noexcept { return level_; }
+
+    /**
+     * @brief Lowest rung: every ladder at its last entry.
+     */
+    size_t maxStep() const noexcept { return maxStep_; }
+
+    /**
+     * @brief Why the last change was made, e.g.
+     *        "latency p99 312.0 ms > 250.0 ms, cpu 97% > 90%".
+     */
+    const std::string& lastCause() const noexcept { return lastCause_; }
+
+    /**
+     * @brief The rung `step` places on the ladders (clamped to maxStep()).
+     */
+    QualityLevel levelAt(size_t step) const;
+
+private:
+    SloConfig config_;
+    ApplyFn apply_;
+    QualityLevel level_;
+    size_t maxStep_{0};
+    int overCount_{0};
+    int headroomCount_{0};
+    std::string lastCause_;
+
+    std::string over_target(const LoadSample& sample) const;
+    bool has_headroom(const LoadSample& sample) const;
+    void change_to(size_t step, const std::string& cause);
+};
+
+std::string describeQualityLevel(const QualityLevel& level);
+
+/**
+ * @brief The fps cap at `level`: the rate actually delivered (the configured
+ *        cap if set, else the camera's) scaled by fps_scale. 0 = no cap.
+ */
+double scaledFpsCap(const QualityLevel& level, double cameraFps, double fpsCap);
+
+/**
+ * @class ProcessCpuMeter
+ * @brief Process CPU load between successive sample() calls.
+ */
+class ProcessCpuMeter {
+public:
+    ProcessCpuMeter();
+
+    /**
+     * @brief CPU time used since the previous call per wall-clock second,
+     *        as a fraction of all online cores (0..1).
+     */
+    double sample();
+
+private:
+    std::chrono::nanoseconds lastCpu_{0};
+    std::chrono::steady_clock::time_point lastWall_;
+    unsigned cores_{1};
+};
+
+} // namespace pcs
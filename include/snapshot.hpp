@@ -0,0 +1,123 @@
+#pragma once
+/**
+ * @file snapshot.hpp
+ * @brief Still images of the latest captured frame, encoded on demand.
+ *
+ * The capture path only swaps a reference to the newest frame in; nothing
+ * is converted or encoded until someone asks for a snapshot. The JPEG is
+ * then made on the requesting thread and cached against that frame, so
+ * every request for the same size before the next frame arrives shares it,
+ * including requests that arrive while the encode is still running.
+ *
+ * Holding the latest frame keeps its capture buffer out of the driver's
+ * queue until the next one replaces it: one buffer, plus one per encode in
+ * progress.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+#include "frame.hpp"
+
+namespace pcs {
+
+/**
+ * @brief One encoded still, shared by every request it answered.
+ */
+struct Snapshot {
+    std::shared_ptr<const std::vector<uint8_t>> jpeg;
+    uint32_t width{0};
+    uint32_t height{0};
+    uint64_t sequence{0}; // which published frame, counting from 1
+    Frame::Timestamp captured;
+};
+
+struct SnapshotStats {
+    uint64_t published{0};
+    uint64_t requests{0};
+    uint64_t encodes{0};     // encode calls made
+    uint64_t cacheHits{0};   // answered by a finished snapshot of the same frame
+    uint64_t coalesced{0};   // waited for an encode another request started
+    uint64_t passthrough{0}; // camera JPEGs used as they were
+    uint64_t failed{0};
+};
+
+/**
+ * @class SnapshotService
+ * @brief Latest-frame holder with a per-size JPEG cache.
+ *
+ * Thread-safe: one thread publishing while any number take snapshots.
+ */
+class SnapshotService {
+public:
+    /**
+     * @brief Encode `frame` (raw or compressed) as a width x height JPEG,
+     *        scaling as needed. Called on the requesting thread.
+     */
+    using EncodeFn = std::function<std::optional<std::vector<uint8_t>>(const Frame& frame, uint32_t width,
+                                                                         uint32_t height)>;
+
+    static constexpr size_t kMaxCachedSizes = 4;
+
+    explicit SnapshotService(EncodeFn encode);
+
+    SnapshotService(const SnapshotService&) = delete;
+    SnapshotService& operator=(const SnapshotService&) = delete;
+
+    /**
+     * @brief Make `frame` the latest. Never waits for an encode, and
+     *        releases the previous frame outside the lock.
+     */
+    void publish(Frame frame);
+
+    /**
+     * @brief A JPEG of the latest frame, encoding it if no request has yet.
+     *
+     * 0 takes the frame's size for that dimension, keeping the aspect ratio
+     * when the other one is given. Snapshots are never larger than the frame.
+     * A camera JPEG asked for at its own size is returned without encoding.
+     * @return std::nullopt before the first frame or if the encode failed
+     *         (the next request tries again).
+     */
+    std::optional<Snapshot> take(uint32_t width = 0, uint32_t height = 0);
+
+    SnapshotStats stats() const;
+
+private:
+    using Result = std::shared_future<std::shared_ptr<const Snapshot>>;
+
+    struct CacheEntry {
+        uint32_t width;
+        uint32_t height;
+        uint64_t sequence;
+        uint64_t id;
+        Result result;
+    };
+
+    EncodeFn encode_;
+
+    mutable std::mutex mtx_;
+    std::shared_ptr<const Frame> latest_;
+    uint64_t sequence_{0};
+    uint64_t nextId_{0};
+    std::vector<CacheEntry> cache_; // at most kMaxCachedSizes, one per size
+
+    std::atomic<uint64_t> published_{0};
+    std::atomic<uint64_t> requests_{0};
+    std::atomic<uint64_t> encodes_{0};
+    std::atomic<uint64_t> cacheHits_{0};
+    std::atomic<uint64_t> coalesced_{0};
+    std::atomic<uint64_t> passthrough_{0};
+    std::atomic<uint64_t> failed_{0};
+
+    std::shared_ptr<const Snapshot> make_snapshot(const Frame& frame, uint32_t width, uint32_t height,
+                                                  uint64_t sequence);
+    CacheEntry& cache_slot(uint32_t width, uint32_t height);
+};
+
+} // namespace pcs
@@ -0,0 +1,217 @@
+#pragma once
+/**
+ * @file stage_scheduler.hpp
+ * @brief Coroutine pipeline stages multiplexed over a fixed set of threads.
+ *
+ * A blocking stage loop (Sender::sendLoop, Pipeline::encode_loop) holds an
+ * OS thread for its whole life, even while it only waits on a queue or a
+ * socket. A Stage is a coroutine instead: it suspends at co_await and its
+ * thread goes on to run another stage, so several camera pipelines and many
+ * network clients can share a handful of threads.
+ *
+ * @code
+ *   Stage forward(AsyncQueue<Frame>& in, Scheduler& scheduler, int fd)
+ *   {
+ *       while (auto frame = co_await in.pop()) {
+ *           if (!co_await scheduler.writable(fd)) {
+ *               co_return;
+ *           }
+ *           ::send(fd, frame->dataPtr(), frame->size(), MSG_NOSIGNAL);
+ *       }
+ *   }
+ *
+ *   scheduler.spawn(forward(queue, scheduler, fd));
+ * @endcode
+ *
+ * Stages take their inputs as parameters, not lambda captures: a lambda
+ * object is gone by the time its coroutine resumes.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include "thread_config.hpp"
+
+namespace pcs {
+
+class Scheduler;
+
+/**
+ * @class Stage
+ * @brief Coroutine return type for a pipeline stage.
+ *
+ * A Stage does nothing until handed to Scheduler::spawn(); the scheduler
+ * then owns it until it returns. Stages must not throw.
+ */
+class Stage {
+public:
+    struct promise_type {
+        Scheduler* scheduler{nullptr};
+
+        Stage get_return_object() noexcept
+        {
+            return Stage(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept; // tells the scheduler, then the frame is freed
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    Stage(Stage&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Stage& operator=(Stage&&) = delete;
+    ~Stage()
+    {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+private:
+    friend class Scheduler;
+
+    explicit Stage(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+};
+
+struct SchedulerConfig {
+    size_t threads{0}; // 0 = one per online core
+    // Applied to every worker; the name gets the worker index appended
+    ThreadConfig worker_thread{.name = "pcs-stage"};
+};
+
+/**
+ * @class Scheduler
+ * @brief Runs spawned Stages on a fixed set of worker threads.
+ *
+ * Ready stages are resumed in FIFO order by whichever worker is free.
+ * Socket readiness is watched by one extra epoll thread, which only hands
+ * stages back to the workers.
+ *
+ * stop() abandons stages that have not finished: they are destroyed at
+ * their suspension point, which runs their destructors but nothing else.
+ * For an orderly shutdown close the stages' queues and wait() first. Queues
+ * and sockets the stages use must outlive stop().
+ */
+class Scheduler {
+public:
+    /**
+     * @brief co_await scheduler.readable(fd) / writable(fd).
+     *
+     * Resumes with true once the fd is ready (a readable fd may be at
+     * end-of-stream), false on a socket error, if the fd cannot be watched,
+     * or when the scheduler is stopping. One waiter per fd at a time.
+     */
+    class IoAwaiter {
+    public:
+        IoAwaiter(Scheduler& scheduler, int fd, uint32_t events) noexcept
+            : scheduler_(scheduler), fd_(fd), events_(events) {}
+        IoAwaiter(const IoAwaiter&) = delete;
+        IoAwaiter& operator=(const IoAwaiter&) = delete;
+        ~IoAwaiter();
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const noexcept { return ready_; }
+
+    private:
+        friend class Scheduler;
+
+        Scheduler& scheduler_;
+        int fd_;
+        uint32_t events_;
+        std::coroutine_handle<> handle_;
+        bool ready_{false};
+        bool armed_{false};
+    };
+
+    /**
+     * @brief co_await scheduler.yield() to let other ready stages run.
+     */
+    struct YieldAwaiter {
+        Scheduler& scheduler;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle) { scheduler.post(handle); }
+        void await_resume() const noexcept {}
+    };
+
+    explicit Scheduler(const SchedulerConfig& config = {});
+    ~Scheduler();
+
+    Scheduler(const Scheduler&) = delete;
+    Scheduler& operator=(const Scheduler&) = delete;
+
+    /**
+     * @brief Take ownership of a stage and queue it to start.
+     * @return false once stopping; the stage is destroyed without running.
+     */
+    bool spawn(Stage stage);
+
+    /**
+     * @brief Block until every spawned stage has returned.
+     */
+    void wait();
+
+    /**
+     * @return false if stages were still running after `timeout`.
+     */
+    bool wait(std::chrono::milliseconds timeout);
+
+    /**
+     * @brief Stop the workers and destroy unfinished stages. Idempotent.
+     */
+    void stop();
+
+    IoAwaiter readable(int fd) noexcept;
+    IoAwaiter writable(int fd) noexcept;
+    YieldAwaiter yield() noexcept { return {*this}; }
+
+    /**
+     * @brief Queue a suspended coroutine to be resumed on a worker. For
+     *        awaitables; dropped once stopping.
+     */
+    void post(std::coroutine_handle<> handle);
+
+    size_t threads() const noexcept { return workers_.size(); }
+    size_t activeStages() const;
+    const std::vector<ThreadReport>& threadReports() const noexcept { return threadReports_; }
+
+private:
+    friend struct Stage::promise_type;
+
+    std::vector<std::thread> workers_;
+    std::vector<ThreadReport> threadReports_;
+
+    mutable std::mutex mtx_;
+    std::condition_variable readyCv_;
+    std::condition_variable idleCv_;
+    std::deque<std::coroutine_handle<>> ready_;
+    std::unordered_set<void*> live_; // frame addresses of spawned, unfinished stages
+    bool stopping_{false};
+
+    // Socket readiness
+    std::mutex ioMtx_;
+    std::unordered_set<IoAwaiter*> armed_;
+    int epollFd_{-1};
+    int wakeFd_{-1};
+    std::thread poller_;
+
+    void worker_loop();
+    void poll_loop();
+    void retire(std::coroutine_handle<> handle);
+    bool arm(IoAwaiter& awaiter);
+    void disarm(IoAwaiter& awaiter);
+};
+
+} // namespace pcs
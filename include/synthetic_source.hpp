@@ -0,0 +1,79 @@
+#pragma once
+/**
+ * @file synthetic_source.hpp
+ * @brief Camera-free capture source rendering test patterns.
+ *
+ * Renders straight into pooled buffers in the requested pixel format, so
+ * benchmarks measure the pipeline rather than the generator's allocations.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include "capture_source.hpp"
+#include "frame_pool.hpp"
+
+namespace pcs {
+
+enum class TestPattern {
+    ColorBars, // eight SMPTE-style bars scrolling sideways
+    Gradient,  // diagonal luma ramp drifting each frame
+    Noise,     // fresh random pixels every frame (worst case for the encoder)
+    Timestamp  // frame counter and elapsed time scrolling across a dark ramp
+};
+
+struct SyntheticConfig {
+    uint32_t width{640};
+    uint32_t height{480};
+    uint32_t fps{30};
+    PixelFormat format{PixelFormat::NV12}; // any raw format; MJPEG is not generated
+    TestPattern pattern{TestPattern::ColorBars};
+    Pacing pacing{Pacing::RealTime};
+    size_t pool_size{4};
+    MemoryAccount* memory{nullptr}; // charged for the pool's buffers
+    uint64_t seed{1}; // noise is reproducible for a given seed
+};
+
+/**
+ * @class SyntheticSource
+ * @brief Test-pattern generator implementing CaptureSource.
+ *
+ * In RealTime pacing, frame n is due at start + n/fps and stamped with that
+ * deadline; a reader that falls more than a frame behind skips the missed
+ * frames, as a camera would. In MaxSpeed pacing frames are rendered on
+ * demand and stamped with the current time.
+ *
+ * Not thread-safe: read() belongs to one capture thread.
+ */
+class SyntheticSource : public CaptureSource {
+public:
+    explicit SyntheticSource(const SyntheticConfig& config = {});
+
+    bool start() override;
+    void stop() override;
+    bool read(Frame& frame) override;
+    CaptureFormat captureFormat() const override;
+    std::string name() const override;
+
+    uint64_t framesProduced() const noexcept { return produced_; }
+    // RealTime frames skipped because the reader was late, or no pooled buffer was free
+    uint64_t framesDropped() const noexcept { return dropped_; }
+
+private:
+    SyntheticConfig config_;
+    std::optional<FramePool> pool_;
+    size_t frameBytes_{0};
+    bool running_{false};
+
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::nanoseconds period_{0};
+    uint64_t index_{0}; // frame number of the next frame
+    uint64_t produced_{0};
+    uint64_t dropped_{0};
+    uint64_t rng_{0};
+
+    void render(uint8_t* out, uint64_t index);
+};
+
+} // namespace pcs
@@ -0,0 +1,89 @@
+#pragma once
+/**
+ * @file thread_config.hpp
+ * @brief Per-thread CPU affinity, scheduling class and naming.
+ *
+ * Stage threads apply their ThreadConfig to themselves when they start.
+ * Nothing here is fatal: a setting the process lacks the privilege for
+ * (real-time priority without CAP_SYS_NICE or RLIMIT_RTPRIO, say) is
+ * skipped, the thread keeps running with the default, and the returned
+ * report says what was and wasn't applied so it can be logged at startup.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace pcs {
+
+enum class SchedPolicy {
+    Other,     // default time-sharing (SCHED_OTHER)
+    Fifo,      // real-time, runs until it blocks (SCHED_FIFO)
+    RoundRobin // real-time, time-sliced among equal priorities (SCHED_RR)
+};
+
+struct ThreadConfig {
+    std::string name{};         // shown by top -H and perf; truncated to 15 characters
+    std::vector<int> cpus{};    // allowed CPUs; empty = any
+    SchedPolicy policy{SchedPolicy::Other};
+    int priority{0};            // 1..99 for Fifo/RoundRobin, ignored otherwise
+    size_t prefault_stack{0};   // bytes of stack to touch up front, so page faults don't hit mid-frame
+};
+
+/**
+ * @brief What applyThreadConfig() achieved.
+ */
+struct ThreadReport {
+    std::string name;
+    std::vector<int> cpus;      // affinity in effect; empty = any
+    SchedPolicy policy{SchedPolicy::Other};
+    int priority{0};
+    std::vector<std::string> problems; // settings that could not be applied, and why
+
+    bool ok() const noexcept { return problems.empty(); }
+};
+
+/**
+ * @brief Apply `config` to the calling thread.
+ *
+ * A real-time request refused for lack of privilege is retried at the
+ * highest priority RLIMIT_RTPRIO allows, then dropped to SCHED_OTHER.
+ */
+ThreadReport applyThreadConfig(const ThreadConfig& config);
+
+/**
+ * @brief One line for the startup log, e.g.
+ *        "capture: CPUs 1, SCHED_FIFO 50" or
+ *        "encode: any CPU, SCHED_OTHER (SCHED_FIFO 40 refused: Operation not permitted)".
+ */
+std::string describeThreadReport(const ThreadReport& report);
+
+/**
+ * @brief Lock current and future pages in RAM (mlockall) so capture and
+ *        encode never wait on a page-in.
+ * @return false (with the reason logged) if the lock was refused, e.g.
+ *         RLIMIT_MEMLOCK too low.
+ */
+bool lockProcessMemory();
+
+/**
+ * @brief When the kernel started this process, on the steady clock, so
+ *        startup metrics include loading and static initialisation.
+ *        Read once from /proc/self/stat (clock-tick resolution); the time
+ *        of the first call if that fails.
+ */
+std::chrono::steady_clock::time_point processStartTime();
+
+/**
+ * @brief Parse a CPU list such as "0,2-3".
+ * @return std::nullopt on syntax errors.
+ */
+std::optional<std::vector<int>> parseCpuList(const std::string& text);
+
+std::string formatCpuList(const std::vector<int>& cpus);
+
+const char* schedPolicyName(SchedPolicy policy) noexcept;
+
+} // namespace pcs
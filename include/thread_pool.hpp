@@ -0,0 +1,130 @@
+#pragma once
+/**
+ * @file thread_pool.hpp
+ * @brief Shared work-stealing executor for intra-frame parallel work.
+ *
+ * Colour conversion, scaling, MJPEG stripes, motion analysis and overlays
+ * all split naturally into row bands. Rather than each of them starting its
+ * own threads, they hand bands to one ThreadPool sized to the core count.
+ *
+ * Every worker owns a deque per priority. A worker pops its own newest task
+ * first (the data it just touched is still in cache) and, when it runs dry,
+ * steals the oldest task from another worker. Critical tasks anywhere in the
+ * pool are taken before any Background task, so encode-path bands are never
+ * stuck behind analytics.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "thread_config.hpp"
+
+namespace pcs {
+
+enum class TaskPriority {
+    Critical,  // on the encode path: colour conversion, scaling, stripes
+    Background // analytics: motion analysis, statistics
+};
+
+struct ThreadPoolConfig {
+    size_t workers{0}; // 0 = one per online core
+    // Applied to every worker; the name gets the worker index appended, and
+    // a non-empty cpus list pins worker i to cpus[i % cpus.size()] alone.
+    ThreadConfig worker_thread{.name = "pcs-pool"};
+};
+
+/**
+ * @brief Per-worker counters, cumulative since the pool started.
+ */
+struct WorkerStats {
+    uint64_t tasks{0};                 // tasks run by this worker
+    uint64_t stolen{0};                // of those, taken from another worker's deque
+    std::chrono::nanoseconds busy{0};  // time spent running tasks
+    double utilisation{0.0};           // busy / time since start, 0..1
+};
+
+/**
+ * @class ThreadPool
+ * @brief Fixed set of workers with per-worker deques and work stealing.
+ *
+ * Tasks must not throw. No order is guaranteed between tasks of the same
+ * priority. The destructor runs every task already submitted, then joins.
+ */
+class ThreadPool {
+public:
+    using Task = std::function<void()>;
+    using RangeFn = std::function<void(size_t begin, size_t end)>;
+
+    explicit ThreadPool(const ThreadPoolConfig& config = {});
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Queue a task. From one of this pool's workers it goes to that
+     *        worker's own deque; from any other thread, round-robin.
+     */
+    void submit(Task task, TaskPriority priority = TaskPriority::Critical);
+
+    /**
+     * @brief Run body(b, e) over [begin, end) split into bands of at least
+     *        `grain` items, and return once every band is done.
+     *
+     * The calling thread runs the first band itself and then helps with
+     * queued tasks of `priority` or higher while it waits, so nested calls
+     * from inside a task cannot deadlock, and a Critical caller is never
+     * held up by a Background task. Small ranges run inline without
+     * touching the pool.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain, const RangeFn& body,
+                     TaskPriority priority = TaskPriority::Critical);
+
+    size_t size() const noexcept { return workers_.size(); }
+
+    std::vector<WorkerStats> stats() const;
+
+    /**
+     * @brief How each worker's ThreadConfig was applied, in worker order.
+     */
+    const std::vector<ThreadReport>& threadReports() const noexcept { return threadReports_; }
+
+private:
+    static constexpr size_t kPriorities = 2;
+
+    struct Worker {
+        std::mutex mtx;
+        std::deque<Task> queues[kPriorities]; // indexed by TaskPriority
+        std::thread thread;
+
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> stolen{0};
+        std::atomic<int64_t> busyNs{0};
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<ThreadReport> threadReports_;
+    std::chrono::steady_clock::time_point startedAt_;
+
+    std::mutex sleepMtx_;
+    std::condition_variable wake_;
+    std::atomic<size_t> pending_{0}; // queued and not yet taken
+    std::atomic<bool> running_{true};
+    std::atomic<size_t> nextWorker_{0};
+
+    void worker_loop(size_t index);
+    size_t current_worker() const noexcept;
+    void push(size_t index, Task task, TaskPriority priority);
+    bool take(size_t self, Task& task, bool& stolen, TaskPriority lowest = TaskPriority::Background);
+    void run(size_t self, Task& task, bool stolen);
+};
+
+} // namespace pcs
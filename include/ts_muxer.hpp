@@ -0,0 +1,59 @@
+#pragma once
+/**
+ * @file ts_muxer.hpp
+ * @brief Minimal MPEG-TS muxer for one H.264 elementary stream.
+ *
+ * Enough of ISO/IEC 13818-1 for recorded segments to play in ffplay/VLC and
+ * to be concatenated or served as HLS: a PAT and PMT before every keyframe,
+ * one PES per access unit with PTS/DTS, a PCR on keyframes, and an access
+ * unit delimiter prepended where the encoder didn't emit one.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "encoder.hpp"
+
+namespace pcs {
+
+class TsMuxer {
+public:
+    static constexpr size_t kPacketSize = 188;
+    static constexpr uint16_t kPmtPid = 0x1000;
+    static constexpr uint16_t kVideoPid = 0x0100;
+    // Added to every timestamp so DTS before PTS never goes negative
+    static constexpr int64_t kTimestampOffset = 126000;
+
+    /**
+     * @brief Append the PAT and PMT (a new segment starts with these).
+     */
+    void writeTables(std::vector<uint8_t>& out);
+
+    /**
+     * @brief Append one encoded frame (Annex B H.264) as a PES. Keyframes
+     *        are preceded by the tables and carry a PCR.
+     */
+    void writeFrame(const EncodedFrame& frame, std::vector<uint8_t>& out);
+
+    /**
+     * @brief writeFrame() for a frame held elsewhere, e.g. in a GopRing.
+     */
+    void writePacket(std::span<const uint8_t> data, int64_t pts, int64_t dts, bool keyframe,
+                     std::vector<uint8_t>& out);
+
+private:
+    uint8_t patCounter_{0};
+    uint8_t pmtCounter_{0};
+    uint8_t videoCounter_{0};
+
+    void write_section(uint16_t pid, uint8_t& counter, const std::vector<uint8_t>& section,
+                       std::vector<uint8_t>& out);
+};
+
+/**
+ * @brief CRC-32/MPEG-2 as used by PSI sections.
+ */
+uint32_t mpegCrc32(const uint8_t* data, size_t size) noexcept;
+
+} // namespace pcs
@@ -0,0 +1,143 @@
+#pragma once
+/**
+ * @file v4l2_capture.hpp
+ * @brief Direct V4L2 streaming capture (mmap buffers, zero-copy frames).
+ *
+ * Bypasses cv::VideoCapture: buffers are exchanged with the driver through
+ * VIDIOC_QBUF/VIDIOC_DQBUF and handed out as Frames that view the mapped
+ * memory directly. A buffer goes back to the driver when the last Frame
+ * referencing it is released, so consumers must not hold frames for long;
+ * call Frame::detach() to keep one beyond the pipeline.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "capture_source.hpp"
+#include "frame.hpp"
+#include "v4l2_device.hpp"
+
+namespace pcs {
+
+struct V4l2Config {
+    std::string device{"/dev/video0"};
+    uint32_t width{640};
+    uint32_t height{480};
+    uint32_t fps{30};
+    // Native formats to try, most preferred first
+    std::vector<PixelFormat> formats{PixelFormat::NV12, PixelFormat::YUYV, PixelFormat::MJPEG};
+    uint32_t buffer_count{4};
+    bool export_dmabuf{false}; // VIDIOC_EXPBUF a dmabuf fd per buffer
+    std::chrono::milliseconds read_timeout{1000};
+};
+
+/**
+ * @brief V4L2 fourcc for a pixel format; 0 if V4L2 has no equivalent.
+ */
+uint32_t toFourcc(PixelFormat format) noexcept;
+PixelFormat fromFourcc(uint32_t fourcc) noexcept;
+
+/**
+ * @class V4l2Capture
+ * @brief Streaming-I/O capture from a V4L2 device.
+ *
+ * read() is meant for a single capture thread; frames may be released from
+ * any thread. Buffer memory stays mapped until every frame is gone, even
+ * after close().
+ */
+class V4l2Capture : public CaptureSource {
+public:
+    /**
+     * @param device Device to use; nullptr opens config.device on open().
+     */
+    explicit V4l2Capture(const V4l2Config& config, std::unique_ptr<V4l2Device> device = nullptr);
+    ~V4l2Capture() override;
+
+    V4l2Capture(const V4l2Capture&) = delete;
+    V4l2Capture& operator=(const V4l2Capture&) = delete;
+
+    /**
+     * @brief Query capabilities, negotiate format/size/rate and map buffers.
+     */
+    bool open();
+
+    /**
+     * @brief Queue all free buffers and start streaming (opening first if needed).
+     */
+    bool start() override;
+
+    /**
+     * @brief Stop streaming. Frames already handed out stay valid.
+     */
+    void stop() override;
+
+    void close();
+
+    /**
+     * @brief Dequeue the next filled buffer as a zero-copy frame.
+     *
+     * The frame carries the driver's capture timestamp when the driver
+     * stamps buffers with the monotonic clock.
+     *
+     * @return false on timeout, driver error or when not streaming.
+     */
+    bool read(Frame& frame, std::chrono::milliseconds timeout);
+    bool read(Frame& frame) override { return read(frame, config_.read_timeout); }
+
+    CaptureFormat captureFormat() const override { return {width_, height_, fps_, format_}; }
+    std::string name() const override { return "v4l2:" + config_.device; }
+
+    bool isOpened() const noexcept { return state_ != nullptr; }
+    bool isStreaming() const noexcept;
+
+    // Negotiated stream parameters (valid after open())
+    PixelFormat format() const noexcept { return format_; }
+    uint32_t width() const noexcept { return width_; }
+    uint32_t height() const noexcept { return height_; }
+    uint32_t fps() const noexcept { return fps_; }
+    size_t bufferCount() const noexcept;
+
+    /**
+     * @brief Buffers currently held by frames (not available to the driver).
+     */
+    size_t buffersInFlight() const noexcept;
+
+    /**
+     * @brief dmabuf fd of the buffer a frame views, if exported.
+     */
+    std::optional<int> dmabufFd(const Frame& frame) const;
+
+    uint64_t framesCaptured() const noexcept { return captured_.load(std::memory_order_relaxed); }
+    // Frames the driver dropped, from gaps in the buffer sequence numbers
+    uint64_t framesDropped() const noexcept { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct State; // shared with the frames' buffer releasers
+
+    V4l2Config config_;
+    std::unique_ptr<V4l2Device> pendingDevice_;
+    std::shared_ptr<State> state_;
+
+    PixelFormat format_{PixelFormat::Unknown};
+    uint32_t width_{0};
+    uint32_t height_{0};
+    uint32_t fps_{0};
+    uint32_t bytesPerLine_{0};
+    size_t frameBytes_{0};  // 0 for compressed formats
+    bool packed_{true}; // rows have no padding, frames can view buffers directly
+
+    std::optional<uint32_t> lastSequence_;
+    std::atomic<uint64_t> captured_{0};
+    std::atomic<uint64_t> dropped_{0};
+
+    bool negotiate_format(V4l2Device& device);
+    void negotiate_rate(V4l2Device& device);
+    bool map_buffers();
+    Frame repack(const uint8_t* data, size_t bytesUsed) const;
+};
+
+} // namespace pcs
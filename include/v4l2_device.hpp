@@ -0,0 +1,69 @@
+#pragma once
+/**
+ * @file v4l2_device.hpp
+ * @brief Thin seam over the V4L2 character device.
+ *
+ * V4l2Capture talks to the driver only through this interface, so tests can
+ * substitute an in-memory device that implements the same ioctl protocol.
+ */
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace pcs {
+
+class V4l2Device {
+public:
+    virtual ~V4l2Device() = default;
+
+    /**
+     * @brief ioctl(2) semantics: 0 on success, -1 with errno set on failure.
+     */
+    virtual int ioctl(unsigned long request, void* arg) = 0;
+
+    /**
+     * @brief Map a driver buffer (offset from VIDIOC_QUERYBUF); nullptr on failure.
+     */
+    virtual void* map(size_t length, uint32_t offset) = 0;
+    virtual void unmap(void* address, size_t length) = 0;
+
+    /**
+     * @brief Block until a buffer is ready to dequeue.
+     * @return false on timeout or error.
+     */
+    virtual bool waitReadable(std::chrono::milliseconds timeout) = 0;
+};
+
+/**
+ * @class SystemV4l2Device
+ * @brief A real /dev/videoN node, opened non-blocking.
+ */
+class SystemV4l2Device final : public V4l2Device {
+public:
+    /**
+     * @brief Open a device node; nullptr (with the error logged) on failure.
+     */
+    static std::unique_ptr<SystemV4l2Device> open(const std::string& path);
+
+    ~SystemV4l2Device() override;
+
+    SystemV4l2Device(const SystemV4l2Device&) = delete;
+    SystemV4l2Device& operator=(const SystemV4l2Device&) = delete;
+
+    int ioctl(unsigned long request, void* arg) override;
+    void* map(size_t length, uint32_t offset) override;
+    void unmap(void* address, size_t length) override;
+    bool waitReadable(std::chrono::milliseconds timeout) override;
+
+    int fd() const noexcept { return fd_; }
+
+private:
+    explicit SystemV4l2Device(int fd) noexcept : fd_(fd) {}
+
+    int fd_{-1};
+};
+
+} // namespace pcs
@@ -0,0 +1,116 @@
+#include "capture_scheduler.hpp"
+
+namespace pcs {
+
+namespace {
+
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::nanoseconds;
+
+uint64_t to_us(nanoseconds value)
+{
+    return static_cast<uint64_t>(duration_cast<microseconds>(value < nanoseconds(0) ? -value : value).count());
+}
+
+} // namespace
+
+CaptureScheduler::CaptureScheduler(CaptureSource& source, const PacingConfig& config)
+    : source_(source),
+      config_(config)
+{
+}
+
+bool CaptureScheduler::read(Frame& frame)
+{
+    if (period_ == nanoseconds(0)) {
+        resolve_period();
+    }
+
+    while (source_.read(frame)) {
+        if (accept(frame)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void CaptureScheduler::setPacing(const PacingConfig& config)
+{
+    const bool rateChanged = config.fps != config_.fps;
+    config_ = config;
+    if (!rateChanged) {
+        return;
+    }
+
+    resolve_period();
+    if (lastDelivered_ && period_ > nanoseconds(0)) {
+        deadline_ = *lastDelivered_ + period_;
+    } else {
+        deadline_.reset();
+    }
+}
+
+void CaptureScheduler::reset() noexcept
+{
+    period_ = nanoseconds(0);
+    deadline_.reset();
+    lastDelivered_.reset();
+    resetHistograms();
+    delivered_.store(0, std::memory_order_relaxed);
+    droppedLate_.store(0, std::memory_order_relaxed);
+    droppedEarly_.store(0, std::memory_order_relaxed);
+    missedDeadlines_.store(0, std::memory_order_relaxed);
+}
+
+void CaptureScheduler::resetHistograms() noexcept
+{
+    jitterUs_.reset();
+    latencyUs_.reset();
+}
+
+// The rate can only be known once the source has negotiated its format
+void CaptureScheduler::resolve_period()
+{
+    const double fps = config_.fps > 0.0 ? config_.fps : source_.captureFormat().fps;
+    period_ = fps > 0.0 ? duration_cast<nanoseconds>(std::chrono::duration<double>(1.0 / fps)) : nanoseconds(0);
+}
+
+bool CaptureScheduler::accept(const Frame& frame)
+{
+    const Frame::Timestamp captured = frame.timestamp();
+    const nanoseconds age = std::chrono::steady_clock::now() - captured;
+    latencyUs_.record(to_us(age));
+
+    if (config_.latency_budget.count() > 0 && age > config_.latency_budget) {
+        droppedLate_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (period_ > nanoseconds(0) && deadline_) {
+        // A quarter period of slack absorbs ordinary jitter without decimating
+        if (config_.decimate && captured < *deadline_ - period_ / 4) {
+            droppedEarly_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        *deadline_ += period_;
+        if (captured >= *deadline_) {
+            // Slower than the schedule: count what we missed and re-anchor
+            missedDeadlines_.fetch_add(static_cast<uint64_t>((captured - *deadline_) / period_) + 1,
+                                       std::memory_order_relaxed);
+            deadline_ = captured + period_;
+        }
+    } else if (period_ > nanoseconds(0)) {
+        deadline_ = captured + period_;
+    }
+
+    if (lastDelivered_ && period_ > nanoseconds(0)) {
+        jitterUs_.record(to_us((captured - *lastDelivered_) - period_));
+    }
+    lastDelivered_ = captured;
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+} // namespace pcs
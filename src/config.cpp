@@ -0,0 +1,453 @@
+#include "config.hpp"
+#include "logger.hpp"
+#include "roi.hpp"
+#include "thread_config.hpp"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <spdlog/fmt/fmt.h>
+
+namespace config {
+
+namespace {
+
+// One key of the file: where it lives, whether it's hot, and how to read
+// and write it
+struct Field {
+    const char* section;
+    const char* key;
+    bool hot;
+    std::function<bool(Config&, const std::string&)> parse;
+    std::function<std::string(const Config&)> format;
+};
+
+std::string trim(const std::string& text)
+{
+    const char* ws = " \t\r\n";
+    const size_t first = text.find_first_not_of(ws);
+    if (first == std::string::npos) {
+        return "";
+    }
+    return text.substr(first, text.find_last_not_of(ws) - first + 1);
+}
+
+std::optional<long> parse_long(const std::string& text)
+{
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const long value = std::strtol(text.c_str(), &end, 10);
+    if (errno != 0 || *end != '\0') {
+        return std::nullopt;
+    }
+    return value;
+}
+
+std::optional<double> parse_double(const std::string& text)
+{
+    if (text.empty()) {
+        return std::nullopt;
+    }
+    char* end = nullptr;
+    errno = 0;
+    const double value = std::strtod(text.c_str(), &end);
+    if (errno != 0 || *end != '\0') {
+        return std::nullopt;
+    }
+    return value;
+}
+
+template <typename Access>
+Field int_field(const char* section, const char* key, bool hot, Access access, long min, long max)
+{
+    return {section, key, hot,
+            [=](Config& config, const std::string& value) {
+                auto n = parse_long(value);
+                if (!n || *n < min || *n > max) {
+                    return false;
+                }
+                access(config) = static_cast<int>(*n);
+                return true;
+            },
+            [=](const Config& config) { return std::to_string(access(config)); }};
+}
+
+template <typename Access>
+Field double_field(const char* section, const char* key, bool hot, Access access, double min, double max)
+{
+    return {section, key, hot,
+            [=](Config& config, const std::string& value) {
+                auto n = parse_double(value);
+                if (!n || *n < min || *n > max) {
+                    return false;
+                }
+                access(config) = *n;
+                return true;
+            },
+            [=](const Config& config) { return fmt::format("{}", access(config)); }};
+}
+
+// A comma-separated list of scale factors in (0, 1], e.g. "1, 0.75, 0.5"
+template <typename Access>
+Field scales_field(const char* section, const char* key, bool hot, Access access)
+{
+    return {section, key, hot,
+            [=](Config& config, const std::string& value) {
+                std::vector<double> scales;
+                std::istringstream in(value);
+                std::string item;
+                while (std::getline(in, item, ',')) {
+                    auto n = parse_double(trim(item));
+                    if (!n || *n <= 0.0 || *n > 1.0) {
+                        return false;
+                    }
+                    scales.push_back(*n);
+                }
+                if (scales.empty()) {
+                    return false;
+                }
+                access(config) = std::move(scales);
+                return true;
+            },
+            [=](const Config& config) { return fmt::format("{}", fmt::join(access(config), ", ")); }};
+}
+
+template <typename Access>
+Field bool_field(const char* section, const char* key, bool hot, Access access)
+{
+    return {section, key, hot,
+            [=](Config& config, const std::string& value) {
+                if (value == "true" || value == "yes" || value == "on" || value == "1") {
+                    access(config) = true;
+                } else if (value == "false" || value == "no" || value == "off" || value == "0") {
+                    access(config) = false;
+                } else {
+                    return false;
+                }
+                return true;
+            },
+            [=](const Config& config) { return std::string(access(config) ? "true" : "false"); }};
+}
+
+template <typename Access>
+Field string_field(const char* section, const char* key, bool hot, Access access,
+                   std::function<bool(const std::string&)> valid)
+{
+    return {section, key, hot,
+            [=](Config& config, const std::string& value) {
+                if (!valid(value)) {
+                    return false;
+                }
+                access(config) = value;
+                return true;
+            },
+            [=](const Config& config) { return access(config); }};
+}
+
+std::function<bool(const std::string&)> one_of(std::vector<std::string> choices)
+{
+    return [choices = std::move(choices)](const std::string& value) {
+        return std::find(choices.begin(), choices.end(), value) != choices.end();
+    };
+}
+
+bool non_empty(const std::string& value)
+{
+    return !value.empty();
+}
+
+bool any_text(const std::string&)
+{
+    return true;
+}
+
+bool cpu_list(const std::string& value)
+{
+    return pcs::parseCpuList(value).has_value();
+}
+
+// Comma-separated device names, none of them empty
+std::vector<std::string> split_list(const std::string& value)
+{
+    std::vector<std::string> items;
+    std::istringstream in(value);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        items.push_back(trim(item));
+    }
+    return items;
+}
+
+bool device_list(const std::string& value)
+{
+    const std::vector<std::string> devices = split_list(value);
+    return std::none_of(devices.begin(), devices.end(), [](const std::string& d) { return d.empty(); });
+}
+
+bool rect_list(const std::string& value)
+{
+    return pcs::parseRectList(value).has_value();
+}
+
+bool ipv4_address(const std::string& value)
+{
+    in_addr addr{};
+    return inet_pton(AF_INET, value.c_str(), &addr) == 1;
+}
+
+// Every key, in the order format_config() writes them
+const std::vector<Field>& fields()
+{
+    static const std::vector<Field> table = {
+        string_field("camera", "device", false, [](auto& c) -> auto& { return c.camera.device; }, non_empty),
+        int_field("camera", "width", false, [](auto& c) -> auto& { return c.camera.width; }, 16, 8192),
+        int_field("camera", "height", false, [](auto& c) -> auto& { return c.camera.height; }, 16, 8192),
+        int_field("camera", "fps", false, [](auto& c) -> auto& { return c.camera.fps; }, 1, 240),
+        int_field("camera", "capture_cpu", false, [](auto& c) -> auto& { return c.camera.capture_cpu; }, -1, 1023),
+        string_field("camera", "stream_url", false, [](auto& c) -> auto& { return c.camera.stream_url; }, any_text),
+
+        string_field("cameras", "devices", false, [](auto& c) -> auto& { return c.cameras.devices; }, device_list),
+        string_field("cameras", "capture_cpus", false, [](auto& c) -> auto& { return c.cameras.capture_cpus; }, cpu_list),
+        int_field("cameras", "encode_workers", false, [](auto& c) -> auto& { return c.cameras.encode_workers; }, 0, 64),
+        int_field("cameras", "queue_depth", false, [](auto& c) -> auto& { return c.cameras.queue_depth; }, 1, 256),
+
+        string_field("encoder", "codec", false, [](auto& c) -> auto& { return c.encoder.codec; },
+                     one_of({"h264", "mjpeg"})),
+        int_field("encoder", "bitrate", true, [](auto& c) -> auto& { return c.encoder.bitrate; }, 10000, 100000000),
+        int_field("encoder", "keyframe_interval", false,
+                  [](auto& c) -> auto& { return c.encoder.keyframe_interval; }, 1, 1000),
+        string_field("encoder", "preset", false, [](auto& c) -> auto& { return c.encoder.preset; }, non_empty),
+        string_field("encoder", "hw_accel", false, [](auto& c) -> auto& { return c.encoder.hw_accel; },
+                     one_of({"auto", "software", "v4l2m2m", "omx"})),
+        int_field("encoder", "threads", false, [](auto& c) -> auto& { return c.encoder.threads; }, 0, 64),
+
+        string_field("sender", "dest_ip", false, [](auto& c) -> auto& { return c.sender.dest_ip; }, ipv4_address),
+        int_field("sender", "port", false, [](auto& c) -> auto& { return c.sender.port; }, 1, 65535),
+        int_field("sender", "queue_kb", false, [](auto& c) -> auto& { return c.sender.queue_kb; }, 64, 1048576),
+
+        int_field("pipeline", "capture_queue", true, [](auto& c) -> auto& { return c.pipeline.capture_queue; }, 1, 256),
+        int_field("pipeline", "send_queue", true, [](auto& c) -> auto& { return c.pipeline.send_queue; }, 1, 1024),
+        double_field("pipeline", "fps_cap", true, [](auto& c) -> auto& { return c.pipeline.fps_cap; }, 0.0, 240.0),
+        int_field("pipeline", "capture_budget_ms", false,
+                  [](auto& c) -> auto& { return c.pipeline.capture_budget_ms; }, 0, 10000),
+        string_field("pipeline", "drop_policy", true, [](auto& c) -> auto& { return c.pipeline.drop_policy; },
+                     one_of({"newest", "oldest"})),
+        int_field("pipeline", "stats_interval_ms", false,
+                  [](auto& c) -> auto& { return c.pipeline.stats_interval_ms; }, 0, 3600000),
+        string_field("pipeline", "capture_cpus", false, [](auto& c) -> auto& { return c.pipeline.capture_cpus; }, cpu_list),
+        string_field("pipeline", "encode_cpus", false, [](auto& c) -> auto& { return c.pipeline.encode_cpus; }, cpu_list),
+        string_field("pipeline", "send_cpus", false, [](auto& c) -> auto& { return c.pipeline.send_cpus; }, cpu_list),
+        bool_field("pipeline", "realtime", false, [](auto& c) -> auto& { return c.pipeline.realtime; }),
+        bool_field("pipeline", "lock_memory", false, [](auto& c) -> auto& { return c.pipeline.lock_memory; }),
+
+        bool_field("scene", "enabled", false, [](auto& c) -> auto& { return c.scene.enabled; }),
+        double_field("scene", "threshold", false, [](auto& c) -> auto& { return c.scene.threshold; }, 0.0, 255.0),
+        string_field("scene", "mode", false, [](auto& c) -> auto& { return c.scene.mode; }, one_of({"drop", "repeat"})),
+        int_field("scene", "refresh_ms", false, [](auto& c) -> auto& { return c.scene.refresh_ms; }, 100, 3600000),
+
+        bool_field("roi", "motion", false, [](auto& c) -> auto& { return c.roi.motion; }),
+        double_field("roi", "motion_threshold", false,
+                     [](auto& c) -> auto& { return c.roi.motion_threshold; }, 0.0, 255.0),
+        int_field("roi", "motion_offset", false, [](auto& c) -> auto& { return c.roi.motion_offset; }, -51, 51),
+        int_field("roi", "static_offset", false, [](auto& c) -> auto& { return c.roi.static_offset; }, -51, 51),
+        string_field("roi", "privacy_zones", false, [](auto& c) -> auto& { return c.roi.privacy_zones; }, rect_list),
+
+        int_field("pool", "workers", false, [](auto& c) -> auto& { return c.pool.workers; }, 0, 64),
+        string_field("pool", "cpus", false, [](auto& c) -> auto& { return c.pool.cpus; }, cpu_list),
+
+        string_field("recorder", "directory", false, [](auto& c) -> auto& { return c.recorder.directory; }, any_text),
+        int_field("recorder", "segment_seconds", false,
+                  [](auto& c) -> auto& { return c.recorder.segment_seconds; }, 1, 86400),
+        int_field("recorder", "queue_kb", false, [](auto& c) -> auto& { return c.recorder.queue_kb; }, 64, 1048576),
+        int_field("recorder", "write_kb", false, [](auto& c) -> auto& { return c.recorder.write_kb; }, 4, 65536),
+        int_field("recorder", "preallocate_mb", false,
+                  [](auto& c) -> auto& { return c.recorder.preallocate_mb; }, 0, 65536),
+        int_field("recorder", "sync_ms", false, [](auto& c) -> auto& { return c.recorder.sync_ms; }, 0, 600000),
+        bool_field("recorder", "direct_io", false, [](auto& c) -> auto& { return c.recorder.direct_io; }),
+        string_field("events", "directory", false, [](auto& c) -> auto& { return c.events.directory; }, any_text),
+        int_field("events", "pre_event_seconds", false,
+                  [](auto& c) -> auto& { return c.events.pre_event_seconds; }, 1, 3600),
+        int_field("events", "buffer_kb", false, [](auto& c) -> auto& { return c.events.buffer_kb; }, 256, 1048576),
+        string_field("snapshot", "path", false, [](auto& c) -> auto& { return c.snapshot.path; }, any_text),
+        int_field("snapshot", "width", false, [](auto& c) -> auto& { return c.snapshot.width; }, 0, 7680),
+        int_field("snapshot", "height", false, [](auto& c) -> auto& { return c.snapshot.height; }, 0, 4320),
+        int_field("memory", "limit_mb", false, [](auto& c) -> auto& { return c.memory.limit_mb; }, 0, 65536),
+        double_field("memory", "defer_at", false, [](auto& c) -> auto& { return c.memory.defer_at; }, 0.05, 1.0),
+        double_field("memory", "shed_at", false, [](auto& c) -> auto& { return c.memory.shed_at; }, 0.05, 1.0),
+
+        bool_field("slo", "enabled", false, [](auto& c) -> auto& { return c.slo.enabled; }),
+        int_field("slo", "latency_ms", false, [](auto& c) -> auto& { return c.slo.latency_ms; }, 1, 60000),
+        double_field("slo", "queue_fill", false, [](auto& c) -> auto& { return c.slo.queue_fill; }, 0.01, 1.0),
+        double_field("slo", "cpu_load", false, [](auto& c) -> auto& { return c.slo.cpu_load; }, 0.01, 1.0),
+        int_field("slo", "sender_backlog_kb", false,
+                  [](auto& c) -> auto& { return c.slo.sender_backlog_kb; }, 1, 1048576),
+        int_field("slo", "interval_ms", false, [](auto& c) -> auto& { return c.slo.interval_ms; }, 50, 60000),
+        int_field("slo", "degrade_after", false, [](auto& c) -> auto& { return c.slo.degrade_after; }, 1, 1000),
+        int_field("slo", "recover_after", false, [](auto& c) -> auto& { return c.slo.recover_after; }, 1, 1000),
+        double_field("slo", "headroom", false, [](auto& c) -> auto& { return c.slo.headroom; }, 0.05, 1.0),
+        scales_field("slo", "bitrate_steps", false, [](auto& c) -> auto& { return c.slo.bitrate_steps; }),
+        scales_field("slo", "fps_steps", false, [](auto& c) -> auto& { return c.slo.fps_steps; }),
+        scales_field("slo", "resolution_steps", false, [](auto& c) -> auto& { return c.slo.resolution_steps; }),
+
+        string_field("log", "level", true, [](auto& c) -> auto& { return c.log.level; },
+                     one_of({"trace", "debug", "info", "warn", "error", "critical", "off"})),
+        bool_field("log", "async", false, [](auto& c) -> auto& { return c.log.async; }),
+        int_field("log", "queue_size", false, [](auto& c) -> auto& { return c.log.queue_size; }, 16, 1048576),
+        string_field("log", "overflow", false, [](auto& c) -> auto& { return c.log.overflow; },
+                     one_of({"block", "overrun"})),
+    };
+    return table;
+}
+
+std::string full_key(const Field& field)
+{
+    return std::string(field.section) + "." + field.key;
+}
+
+} // namespace
+
+std::optional<Config> parse_config(const std::string& text, const std::string& origin)
+{
+    Config config;
+    std::istringstream in(text);
+    std::string line;
+    std::string section;
+    int number = 0;
+
+    while (std::getline(in, line)) {
+        ++number;
+        const size_t comment = line.find_first_of("#;");
+        line = trim(comment == std::string::npos ? line : line.substr(0, comment));
+        if (line.empty()) {
+            continue;
+        }
+
+        if (line.front() == '[') {
+            if (line.back() != ']') {
+                Logger::error("{}:{}: expected ']'", origin, number);
+                return std::nullopt;
+            }
+            section = trim(line.substr(1, line.size() - 2));
+            bool known = false;
+            for (const Field& field : fields()) {
+                known = known || section == field.section;
+            }
+            if (!known) {
+                Logger::error("{}:{}: unknown section [{}]", origin, number, section);
+                return std::nullopt;
+            }
+            continue;
+        }
+
+        const size_t equals = line.find('=');
+        if (equals == std::string::npos) {
+            Logger::error("{}:{}: expected 'key = value'", origin, number);
+            return std::nullopt;
+        }
+        const std::string key = trim(line.substr(0, equals));
+        const std::string value = trim(line.substr(equals + 1));
+        if (section.empty()) {
+            Logger::error("{}:{}: '{}' is outside any [section]", origin, number, key);
+            return std::nullopt;
+        }
+
+        auto field = std::find_if(fields().begin(), fields().end(), [&](const Field& f) {
+            return section == f.section && key == f.key;
+        });
+        if (field == fields().end()) {
+            Logger::error("{}:{}: unknown key '{}' in [{}]", origin, number, key, section);
+            return std::nullopt;
+        }
+        if (!field->parse(config, value)) {
+            Logger::error("{}:{}: invalid value '{}' for {}", origin, number, value, full_key(*field));
+            return std::nullopt;
+        }
+    }
+    return config;
+}
+
+std::optional<Config> read_config(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        Logger::error("Cannot read config {}: {}", path, std::strerror(errno));
+        return std::nullopt;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+    return parse_config(text.str(), path);
+}
+
+Config load_config(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) {
+        Logger::info("No config file at {}; using defaults", path);
+        return Config{};
+    }
+    return read_config(path).value_or(Config{});
+}
+
+std::vector<ConfigChange> diff_config(const Config& before, const Config& after)
+{
+    std::vector<ConfigChange> changes;
+    for (const Field& field : fields()) {
+        std::string a = field.format(before);
+        std::string b = field.format(after);
+        if (a != b) {
+            changes.push_back({full_key(field), std::move(a), std::move(b), field.hot});
+        }
+    }
+    return changes;
+}
+
+Config merge_hot(const Config& current, const Config& next)
+{
+    Config merged = current;
+    for (const Field& field : fields()) {
+        if (field.hot) {
+            field.parse(merged, field.format(next));
+        }
+    }
+    return merged;
+}
+
+std::vector<CameraConfig> camera_list(const Config& config)
+{
+    if (config.cameras.devices.empty()) {
+        return {config.camera};
+    }
+
+    const std::vector<int> cpus = pcs::parseCpuList(config.cameras.capture_cpus).value_or(std::vector<int>{});
+    std::vector<CameraConfig> cameras;
+    for (const std::string& device : split_list(config.cameras.devices)) {
+        CameraConfig camera = config.camera;
+        camera.device = device;
+        camera.capture_cpu = cameras.size() < cpus.size() ? cpus[cameras.size()] : -1;
+        cameras.push_back(std::move(camera));
+    }
+    return cameras;
+}
+
+std::string format_config(const Config& config)
+{
+    std::string text;
+    const char* section = "";
+    for (const Field& field : fields()) {
+        if (std::strcmp(section, field.section) != 0) {
+            section = field.section;
+            text += (text.empty() ? "[" : "\n[") + std::string(section) + "]\n";
+        }
+        text += std::string(field.key) + " = " + field.format(config) + "\n";
+    }
+    return text;
+}
+
+} // namespace config
@@ -0,0 +1,165 @@
+#include "config_watcher.hpp"
+#include "logger.hpp"
+#include "thread_config.hpp"
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace pcs {
+
+namespace {
+
+// Editors write a file in several steps; wait for them to settle
+constexpr int kSettleMs = 50;
+
+} // namespace
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+ConfigWatcher::ConfigWatcher(std::string path, const config::Config& current, ApplyFn apply)
+    : path_(std::move(path))
+    , apply_(std::move(apply))
+    , current_(current)
+{
+    const size_t slash = path_.rfind('/');
+    directory_ = slash == std::string::npos ? "." : path_.substr(0, slash == 0 ? 1 : slash);
+    filename_ = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+}
+
+ConfigWatcher::~ConfigWatcher()
+{
+    stop();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool ConfigWatcher::start()
+{
+    if (running_) {
+        return true;
+    }
+
+    inotifyFd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (inotifyFd_ < 0 || wakeFd_ < 0) {
+        Logger::error("Config watcher: inotify unavailable: {}", std::strerror(errno));
+        stop();
+        return false;
+    }
+    if (inotify_add_watch(inotifyFd_, directory_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+        Logger::error("Config watcher: cannot watch {}: {}", directory_, std::strerror(errno));
+        stop();
+        return false;
+    }
+
+    running_ = true;
+    thread_ = std::thread([this] {
+        applyThreadConfig({.name = "pcs-config"});
+        watch_loop();
+    });
+    Logger::info("Watching {} for changes", path_);
+    return true;
+}
+
+void ConfigWatcher::stop()
+{
+    if (running_.exchange(false)) {
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(wakeFd_, &one, sizeof(one));
+        thread_.join();
+    }
+    if (inotifyFd_ >= 0) {
+        ::close(inotifyFd_);
+        inotifyFd_ = -1;
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+        wakeFd_ = -1;
+    }
+}
+
+bool ConfigWatcher::reload()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    std::optional<config::Config> next = config::read_config(path_);
+    if (!next) {
+        Logger::warn("Config {} not applied; keeping the running settings", path_);
+        return false;
+    }
+
+    bool hot = false;
+    for (const config::ConfigChange& change : config::diff_config(current_, *next)) {
+        if (change.hot) {
+            Logger::info("Config: {} {} -> {}", change.key, change.before, change.after);
+            hot = true;
+        } else {
+            Logger::warn("Config: {} {} -> {} takes effect after a restart", change.key,
+                         change.before, change.after);
+        }
+    }
+    if (!hot) {
+        return false;
+    }
+
+    current_ = config::merge_hot(current_, *next);
+    apply_(current_);
+    reloads_.fetch_add(1);
+    return true;
+}
+
+config::Config ConfigWatcher::current() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return current_;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void ConfigWatcher::watch_loop()
+{
+    while (running_) {
+        if (!file_event_pending(-1)) {
+            continue;
+        }
+        // Swallow the rest of a multi-step save before reading
+        while (running_ && file_event_pending(kSettleMs)) {
+        }
+        if (running_) {
+            reload();
+        }
+    }
+}
+
+// Waits for inotify events; true if any of them concern our file
+bool ConfigWatcher::file_event_pending(int timeoutMs)
+{
+    pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+    if (::poll(fds, 2, timeoutMs) <= 0 || (fds[1].revents & POLLIN)) {
+        return false;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    bool ours = false;
+    ssize_t length;
+    while ((length = ::read(inotifyFd_, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && filename_ == event->name) {
+                ours = true;
+            }
+            offset += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+        }
+    }
+    return ours;
+}
+
+} // namespace pcs
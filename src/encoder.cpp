@@ -1,23 +1,750 @@
-#include "encoder.h"
-#include <iostream>
+#include "encoder.hpp"
+#include "encoder_registry.hpp"
+#include "logger.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <utility>
 
-Encoder::Encoder(int width, int height, int bitrate)
-    : m_width(width), m_height(height), m_bitrate(bitrate)
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/opt.h>
+#include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
+#include <libswscale/swscale.h>
+}
+
+namespace pcs {
+
+namespace {
+
+constexpr AVRational kTimeBase{1, 90000}; // 90 kHz, as used by RTP/MPEG-TS
+
+// Fewest rows worth handing to the pool as one conversion band
+constexpr int kMinBandRows = 64;
+
+const char* codec_name(CodecType codec)
+{
+    return codec == CodecType::MJPEG ? "MJPEG" : "H.264";
+}
+
+// Map a resolved backend name onto a concrete libav encoder.
+const AVCodec* find_codec(CodecType codec, const std::string& backend)
+{
+    if (codec == CodecType::MJPEG) {
+        return avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+    }
+
+    if (backend == "v4l2m2m") {
+        return avcodec_find_encoder_by_name("h264_v4l2m2m");
+    }
+    if (backend == "omx") {
+        return avcodec_find_encoder_by_name("h264_omx");
+    }
+
+    if (const AVCodec* x264 = avcodec_find_encoder_by_name("libx264")) {
+        return x264;
+    }
+    return avcodec_find_encoder(AV_CODEC_ID_H264);
+}
+
+AVPixelFormat to_av_format(PixelFormat format)
+{
+    switch (format) {
+    case PixelFormat::Gray8: return AV_PIX_FMT_GRAY8;
+    case PixelFormat::BGR24: return AV_PIX_FMT_BGR24;
+    case PixelFormat::BGRA:  return AV_PIX_FMT_BGRA;
+    case PixelFormat::YUYV:  return AV_PIX_FMT_YUYV422;
+    case PixelFormat::NV12:  return AV_PIX_FMT_NV12;
+    case PixelFormat::I420:  return AV_PIX_FMT_YUV420P;
+    default:                 return AV_PIX_FMT_NONE;
+    }
+}
+
+// Full-range YUVJ420P (MJPEG) has the layout of YUV420P but not its
+// sample range: I420 frames are limited range (16-235), so copying them into
+// a YUVJ picture would wash it out. It maps to Unknown, and such input goes
+// through swscale, which expands the range for YUVJ targets.
+PixelFormat from_av_format(AVPixelFormat format)
+{
+    switch (format) {
+    case AV_PIX_FMT_GRAY8:   return PixelFormat::Gray8;
+    case AV_PIX_FMT_BGR24:   return PixelFormat::BGR24;
+    case AV_PIX_FMT_BGRA:    return PixelFormat::BGRA;
+    case AV_PIX_FMT_YUYV422: return PixelFormat::YUYV;
+    case AV_PIX_FMT_NV12:    return PixelFormat::NV12;
+    case AV_PIX_FMT_YUV420P: return PixelFormat::I420;
+    default:                 return PixelFormat::Unknown;
+    }
+}
+
+// Codec pixel format for `wanted`, if the codec lists it
+AVPixelFormat native_format(const AVCodec* codec, PixelFormat wanted)
+{
+    if (!codec->pix_fmts || wanted == PixelFormat::Unknown) {
+        return AV_PIX_FMT_NONE;
+    }
+    for (const AVPixelFormat* f = codec->pix_fmts; *f != AV_PIX_FMT_NONE; ++f) {
+        if (from_av_format(*f) == wanted) {
+            return *f;
+        }
+    }
+    return AV_PIX_FMT_NONE;
+}
+
+// Process-wide registry: calibration results are shared by every encoder
+// and persisted across restarts.
+EncoderRegistry& default_registry()
+{
+    static EncoderRegistry registry(
+        [](const EncoderConfig& config) { return Encoder::calibrate(config); },
+        EncoderRegistry::defaultCachePath(),
+        "lavc-" + std::to_string(avcodec_version()));
+
+    static const bool populated = [] {
+        registry.addBackend(CodecType::H264, "v4l2m2m");
+        registry.addBackend(CodecType::H264, "omx");
+        registry.addBackend(CodecType::H264, EncoderRegistry::kSoftwareBackend);
+        registry.addBackend(CodecType::MJPEG, EncoderRegistry::kSoftwareBackend);
+        return true;
+    }();
+    (void)populated;
+
+    return registry;
+}
+
+// Moving gradient: cheap to generate, but not trivially compressible.
+Frame calibration_frame(int width, int height, int index)
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(width) * height * 3);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = pixels.data() + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; ++x) {
+            int sx = x + index * 4;
+            row[x * 3 + 0] = static_cast<uint8_t>(sx + y);
+            row[x * 3 + 1] = static_cast<uint8_t>((sx / 32) % 2 ? 200 : 50);
+            row[x * 3 + 2] = static_cast<uint8_t>(y * 2);
+        }
+    }
+    return Frame(std::move(pixels), static_cast<uint32_t>(width), static_cast<uint32_t>(height), 3);
+}
+
+} // namespace
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+Encoder::Encoder(const EncoderConfig& config)
+    : config_(config)
 {
-    // Initialize encoder resources here
-    std::cout << "Encoder initialized: " << width << "x" << height << "@" << bitrate << "bps\n";
 }
 
 Encoder::~Encoder()
 {
-    // Release encoder resources here
-    std::cout << "Encoder destroyed\n";
+    close();
 }
 
-bool Encoder::encodeFrame(const uint8_t* frameData, size_t dataSize)
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool Encoder::isAvailable(const EncoderConfig& config)
+{
+    const std::string backend = config.hw_accel == "auto" ? EncoderRegistry::kSoftwareBackend
+                                                          : config.hw_accel;
+    return find_codec(config.codec, backend) != nullptr;
+}
+
+std::optional<double> Encoder::calibrate(const EncoderConfig& config, int frames)
 {
-    // Stub: encode the frame data
-    std::cout << "Encoding frame of size: " << dataSize << "\n";
-    // Actual encoding logic would go here
+    Encoder encoder(config);
+    {
+        // No fallback here: a backend that can't open simply isn't a candidate
+        std::lock_guard<std::mutex> lock(encoder.mtx_);
+        if (!encoder.open_backend(config.hw_accel)) {
+            return std::nullopt;
+        }
+    }
+
+    // A handful of distinct pictures, generated outside the timed loop
+    std::vector<Frame> pictures;
+    for (int i = 0; i < 4; ++i) {
+        pictures.push_back(calibration_frame(config.width, config.height, i));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    int encoded = 0;
+    for (int i = 0; i < frames; ++i) {
+        Frame& picture = pictures[i % pictures.size()];
+        picture.setTimestampNow();
+        if (encoder.encode(picture)) {
+            ++encoded;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (encoded == 0 || seconds <= 0.0) {
+        return std::nullopt;
+    }
+    return frames / seconds;
+}
+
+std::vector<PixelFormat> Encoder::inputFormats(const EncoderConfig& config)
+{
+    const std::string backend = config.hw_accel == "auto" ? default_registry().resolve(config)
+                                                          : config.hw_accel;
+    std::vector<PixelFormat> formats;
+    const AVCodec* codec = find_codec(config.codec, backend);
+    if (!codec) {
+        return formats;
+    }
+    if (!codec->pix_fmts) {
+        formats.push_back(PixelFormat::I420); // what configure_codec() falls back to
+        return formats;
+    }
+
+    for (const AVPixelFormat* f = codec->pix_fmts; *f != AV_PIX_FMT_NONE; ++f) {
+        PixelFormat format = from_av_format(*f);
+        if (format != PixelFormat::Unknown &&
+            std::find(formats.begin(), formats.end(), format) == formats.end()) {
+            formats.push_back(format);
+        }
+    }
+    return formats;
+}
+
+bool Encoder::init()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (ctx_) {
+        return true;
+    }
+
+    const std::string backend = default_registry().resolve(config_);
+    if (!open_backend(backend)) {
+        if (backend == EncoderRegistry::kSoftwareBackend) {
+            return false;
+        }
+
+        Logger::warn("Encoder: backend '{}' failed to open, falling back to {}",
+                     backend, EncoderRegistry::kSoftwareBackend);
+        if (config_.hw_accel == "auto") {
+            default_registry().invalidate(config_);
+        }
+        if (!open_backend(EncoderRegistry::kSoftwareBackend)) {
+            return false;
+        }
+    }
+
+    forceKeyframe_ = true;
+    Logger::info("Encoder opened: {} ({}) {}x{} @ {} fps, {} bps, keyint {}",
+                 codec_name(config_.codec), codec_->name, config_.width, config_.height,
+                 config_.fps, config_.bitrate, config_.keyframe_interval);
     return true;
-}
\ No newline at end of file
+}
+
+std::optional<EncodedFrame> Encoder::encode(const Frame& frame, const QualityMap* quality)
+{
+    // Declared before the lock so a retired encoder is torn down after unlocking
+    std::unique_ptr<Encoder> retired;
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (standby_) {
+        retired = std::move(standby_);
+        swap_codec_state(*retired);
+        forceKeyframe_ = true;
+        framesSinceKeyframe_ = 0;
+        Logger::info("Encoder: switched to standby encoder {}x{} @ {} fps",
+                     config_.width, config_.height, config_.fps);
+    }
+
+    if (!ctx_ || frame.empty()) {
+        return std::nullopt;
+    }
+
+    if (!convert_to_yuv(frame)) {
+        return std::nullopt;
+    }
+    havePicture_ = true;
+    attach_quality_map(quality);
+
+    return submit_frame(frame.timestamp());
+}
+
+std::optional<EncodedFrame> Encoder::encodeRepeat(Frame::Timestamp captured)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    // After a standby switch the picture buffer belongs to the new encoder
+    if (!ctx_ || !havePicture_ || standby_) {
+        return std::nullopt;
+    }
+
+    return submit_frame(captured);
+}
+
+bool Encoder::reconfigure(const EncoderConfig& next)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+
+        // Compare against the encoder that will be live after a pending switch
+        Encoder* target = standby_ ? standby_.get() : this;
+
+        if (!target->ctx_) {
+            // Not opened yet: init() will pick up the new settings
+            target->config_ = next;
+            return true;
+        }
+
+        if (!target->requires_restart(next)) {
+            target->apply_rate_control(next);
+            return true;
+        }
+    }
+
+    // Open the replacement without holding the lock so encode() keeps running
+    auto standby = std::make_unique<Encoder>(next);
+    if (!standby->init()) {
+        Logger::error("Encoder: standby encoder failed to open, keeping {}x{}",
+                      config().width, config().height);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mtx_);
+    standby_ = std::move(standby);
+    return true;
+}
+
+void Encoder::requestKeyframe()
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    forceKeyframe_ = true;
+}
+
+EncoderConfig Encoder::config() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return config_;
+}
+
+std::string Encoder::backend() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return backend_;
+}
+
+void Encoder::flush(std::vector<EncodedFrame>& outFrames)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    if (!ctx_) {
+        return;
+    }
+
+    if (avcodec_send_frame(ctx_, nullptr) < 0) {
+        return;
+    }
+
+    while (auto packet = receive_packet()) {
+        outFrames.push_back(std::move(*packet));
+    }
+}
+
+void Encoder::close()
+{
+    std::unique_ptr<Encoder> standby;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        standby = std::move(standby_);
+        release_codec_state();
+    }
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+bool Encoder::open_backend(const std::string& backend)
+{
+    backend_ = backend;
+
+    if (!configure_codec()) {
+        release_codec_state();
+        return false;
+    }
+
+    setup_frame_buffer();
+    if (!avFrame_ || !avPacket_) {
+        Logger::error("Encoder: failed to allocate frame buffers");
+        release_codec_state();
+        return false;
+    }
+
+    return true;
+}
+
+bool Encoder::configure_codec()
+{
+    codec_ = find_codec(config_.codec, backend_);
+    if (!codec_) {
+        Logger::error("Encoder: no {} encoder available for backend '{}'",
+                      codec_name(config_.codec), backend_);
+        return false;
+    }
+
+    ctx_ = avcodec_alloc_context3(codec_);
+    if (!ctx_) {
+        return false;
+    }
+
+    ctx_->width = config_.width;
+    ctx_->height = config_.height;
+    ctx_->time_base = kTimeBase;
+    ctx_->framerate = AVRational{config_.fps, 1};
+    ctx_->gop_size = config_.keyframe_interval;
+    ctx_->max_b_frames = 0;
+    ctx_->flags |= AV_CODEC_FLAG_LOW_DELAY;
+    ctx_->bit_rate = config_.bitrate;
+    ctx_->rc_max_rate = config_.bitrate;
+    ctx_->rc_buffer_size = config_.bitrate;
+    ctx_->thread_count = config_.threads;
+
+    // Take frames in the capture layout when the codec can, so encode()
+    // only has to copy them
+    AVPixelFormat native = native_format(codec_, config_.input_format);
+    if (native != AV_PIX_FMT_NONE) {
+        ctx_->pix_fmt = native;
+    } else if (config_.codec == CodecType::MJPEG) {
+        ctx_->pix_fmt = AV_PIX_FMT_YUVJ420P;
+    } else {
+        ctx_->pix_fmt = AV_PIX_FMT_YUV420P;
+    }
+
+    if (std::string_view(codec_->name) == "libx264") {
+        av_opt_set(ctx_->priv_data, "preset", config_.preset.c_str(), 0);
+        av_opt_set(ctx_->priv_data, "tune", "zerolatency", 0);
+        // Keyframes requested through pict_type must be real IDRs
+        av_opt_set(ctx_->priv_data, "forced-idr", "1", 0);
+        // submit_frame() places the IDRs, so the interval can change live;
+        // x264 would otherwise keep the gop_size it was opened with
+        av_opt_set(ctx_->priv_data, "x264-params", "keyint=infinite", 0);
+    }
+
+    int ret = avcodec_open2(ctx_, codec_, nullptr);
+    if (ret < 0) {
+        Logger::error("Encoder: failed to open {} ({})", codec_->name, ret);
+        return false;
+    }
+
+    return true;
+}
+
+void Encoder::setup_frame_buffer()
+{
+    avPacket_ = av_packet_alloc();
+    avFrame_ = av_frame_alloc();
+    if (!avFrame_) {
+        return;
+    }
+
+    avFrame_->format = ctx_->pix_fmt;
+    avFrame_->width = ctx_->width;
+    avFrame_->height = ctx_->height;
+
+    if (av_frame_get_buffer(avFrame_, 0) < 0) {
+        av_frame_free(&avFrame_);
+    }
+}
+
+bool Encoder::convert_to_yuv(const Frame& src)
+{
+    const AVPixelFormat srcFormat = to_av_format(src.format());
+    if (srcFormat == AV_PIX_FMT_NONE || !src.isValid()) {
+        PCS_LOG_EVERY(spdlog::level::warn, std::chrono::seconds(1), "Encoder: unsupported input {}", src.toString());
+        return false;
+    }
+
+    const int width = static_cast<int>(src.width());
+    const int height = static_cast<int>(src.height());
+    uint8_t* planes[4] = {};
+    int strides[4] = {};
+    if (av_image_fill_arrays(planes, strides, src.dataPtr(), srcFormat, width, height, 1) < 0) {
+        return false;
+    }
+    const uint8_t* srcSlice[4] = {planes[0], planes[1], planes[2], planes[3]};
+
+    // The codec may still reference the previous picture
+    if (av_frame_make_writable(avFrame_) < 0) {
+        return false;
+    }
+
+    const bool direct = from_av_format(ctx_->pix_fmt) == src.format() &&
+                        width == ctx_->width && height == ctx_->height;
+    std::string path = std::string(pixelFormatName(src.format())) +
+                       (direct ? " copied as " : " converted to ") + av_get_pix_fmt_name(ctx_->pix_fmt);
+    if (path != inputPath_) {
+        Logger::info("Encoder: input {}", path);
+        inputPath_ = std::move(path);
+    }
+
+    if (direct) {
+        av_image_copy(avFrame_->data, avFrame_->linesize, srcSlice, strides,
+                      ctx_->pix_fmt, width, height);
+        return true;
+    }
+
+    // Without scaling every row converts on its own, so bands can share the work
+    if (config_.pool && width == ctx_->width && height == ctx_->height &&
+        convert_in_bands(srcSlice, strides, srcFormat, width, height)) {
+        return true;
+    }
+
+    // Reused across frames; only rebuilt when the input geometry changes.
+    // A YUVJ target makes swscale convert limited to full range.
+    swsCtx_ = sws_getCachedContext(swsCtx_, width, height, srcFormat,
+                                   ctx_->width, ctx_->height, ctx_->pix_fmt,
+                                   SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+    if (!swsCtx_) {
+        return false;
+    }
+
+    sws_scale(swsCtx_, srcSlice, strides, 0, height, avFrame_->data, avFrame_->linesize);
+    return true;
+}
+
+// Each band is converted as a picture of its own, with its own cached
+// context. Bands start on even rows so 4:2:0 chroma rows stay in pairs.
+bool Encoder::convert_in_bands(const uint8_t* const src[4], const int strides[4], int srcFormat,
+                               int width, int height)
+{
+    const int bands = std::min(static_cast<int>(config_.pool->size()) + 1, height / kMinBandRows);
+    if (bands < 2) {
+        return false;
+    }
+    const int bandRows = ((height + bands - 1) / bands + 1) & ~1;
+    for (size_t i = static_cast<size_t>(bands); i < bandCtx_.size(); ++i) {
+        sws_freeContext(bandCtx_[i]);
+    }
+    bandCtx_.resize(static_cast<size_t>(bands), nullptr);
+
+    const auto inFormat = static_cast<AVPixelFormat>(srcFormat);
+    const AVPixFmtDescriptor* inDesc = av_pix_fmt_desc_get(inFormat);
+    const AVPixFmtDescriptor* outDesc = av_pix_fmt_desc_get(ctx_->pix_fmt);
+    // Planes 1 and 2 are chroma; 0 and alpha have a row per picture row
+    auto planeRow = [](const AVPixFmtDescriptor* desc, int plane, int row) {
+        return plane == 1 || plane == 2 ? row >> desc->log2_chroma_h : row;
+    };
+
+    std::atomic<bool> ok{true};
+    config_.pool->parallelFor(0, static_cast<size_t>(bands), 1, [&](size_t first, size_t last) {
+        for (size_t band = first; band < last; ++band) {
+            const int top = static_cast<int>(band) * bandRows;
+            const int rows = std::min(bandRows, height - top);
+            if (rows <= 0) {
+                continue;
+            }
+            const uint8_t* in[4] = {};
+            uint8_t* out[4] = {};
+            for (int p = 0; p < 4; ++p) {
+                if (src[p]) {
+                    in[p] = src[p] + static_cast<ptrdiff_t>(planeRow(inDesc, p, top)) * strides[p];
+                }
+                if (avFrame_->data[p]) {
+                    out[p] = avFrame_->data[p] + static_cast<ptrdiff_t>(planeRow(outDesc, p, top)) * avFrame_->linesize[p];
+                }
+            }
+            bandCtx_[band] = sws_getCachedContext(bandCtx_[band], width, rows, inFormat, width, rows, ctx_->pix_fmt,
+                                                  SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+            if (!bandCtx_[band]) {
+                ok = false;
+                continue;
+            }
+            sws_scale(bandCtx_[band], in, strides, 0, rows, out, avFrame_->linesize);
+        }
+    });
+    return ok.load();
+}
+
+// ROI side data in encoder pixels; the map may describe a differently sized
+// source frame, so regions are scaled along with the picture.
+void Encoder::attach_quality_map(const QualityMap* quality)
+{
+    av_frame_remove_side_data(avFrame_, AV_FRAME_DATA_REGIONS_OF_INTEREST);
+
+    if (!quality || quality->isNeutral() || !supports_roi() ||
+        quality->frameWidth() == 0 || quality->frameHeight() == 0) {
+        return;
+    }
+
+    const auto regions = quality->regions();
+    AVFrameSideData* sideData = av_frame_new_side_data(avFrame_, AV_FRAME_DATA_REGIONS_OF_INTEREST,
+                                                       regions.size() * sizeof(AVRegionOfInterest));
+    if (!sideData) {
+        return;
+    }
+
+    const double sx = static_cast<double>(ctx_->width) / quality->frameWidth();
+    const double sy = static_cast<double>(ctx_->height) / quality->frameHeight();
+    auto* roi = reinterpret_cast<AVRegionOfInterest*>(sideData->data);
+    for (size_t i = 0; i < regions.size(); ++i) {
+        const Rect& area = regions[i].area;
+        roi[i].self_size = sizeof(AVRegionOfInterest);
+        roi[i].left = static_cast<int>(area.x * sx);
+        roi[i].top = static_cast<int>(area.y * sy);
+        roi[i].right = static_cast<int>((area.x + area.width) * sx);
+        roi[i].bottom = static_cast<int>((area.y + area.height) * sy);
+        // libx264 scales qoffset (-1..1) by the QP range
+        roi[i].qoffset = AVRational{regions[i].offset, QualityMap::kMaxOffset};
+    }
+}
+
+std::optional<EncodedFrame> Encoder::submit_frame(Frame::Timestamp captured)
+{
+    avFrame_->pts = next_pts(captured);
+
+    if (forceKeyframe_ || framesSinceKeyframe_ >= config_.keyframe_interval) {
+        avFrame_->pict_type = AV_PICTURE_TYPE_I;
+        forceKeyframe_ = false;
+        framesSinceKeyframe_ = 0;
+    } else {
+        avFrame_->pict_type = AV_PICTURE_TYPE_NONE;
+    }
+
+    int ret = avcodec_send_frame(ctx_, avFrame_);
+    if (ret < 0) {
+        PCS_LOG_EVERY(spdlog::level::err, std::chrono::seconds(1), "Encoder: avcodec_send_frame failed ({})", ret);
+        return std::nullopt;
+    }
+
+    // A key packet resets the count; this frame is then the first one after it
+    auto packet = receive_packet();
+    ++framesSinceKeyframe_;
+    return packet;
+}
+
+std::optional<EncodedFrame> Encoder::receive_packet()
+{
+    int ret = avcodec_receive_packet(ctx_, avPacket_);
+    if (ret < 0) {
+        // AVERROR(EAGAIN): codec needs more input, AVERROR_EOF: fully flushed
+        return std::nullopt;
+    }
+
+    EncodedFrame out;
+    out.data.assign(avPacket_->data, avPacket_->data + avPacket_->size);
+    out.pts = avPacket_->pts;
+    out.dts = avPacket_->dts;
+    out.keyframe = (avPacket_->flags & AV_PKT_FLAG_KEY) != 0;
+    av_packet_unref(avPacket_);
+
+    if (out.keyframe) {
+        framesSinceKeyframe_ = 0;
+    }
+    return out;
+}
+
+// Capture-time based pts keeps the timeline continuous across fps changes
+// and encoder switches.
+int64_t Encoder::next_pts(Frame::Timestamp captured)
+{
+    if (!epoch_) {
+        epoch_ = captured;
+    }
+
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(captured - *epoch_).count();
+    int64_t pts = elapsedUs * kTimeBase.den / 1000000;
+    if (pts <= lastPts_) {
+        pts = lastPts_ + 1;
+    }
+    lastPts_ = pts;
+    return pts;
+}
+
+bool Encoder::supports_live_rate_control() const
+{
+    return codec_ && std::string_view(codec_->name) == "libx264";
+}
+
+bool Encoder::supports_roi() const
+{
+    return codec_ && std::string_view(codec_->name) == "libx264";
+}
+
+bool Encoder::requires_restart(const EncoderConfig& next) const
+{
+    if (next.codec != config_.codec || next.width != config_.width ||
+        next.height != config_.height || next.hw_accel != config_.hw_accel ||
+        next.threads != config_.threads || next.preset != config_.preset ||
+        next.input_format != config_.input_format) {
+        return true;
+    }
+
+    // fps only feeds rate control, and libx264 leaves the keyframe interval
+    // to submit_frame(), but other codecs read bitrate and gop_size once at
+    // open time.
+    return (next.bitrate != config_.bitrate || next.keyframe_interval != config_.keyframe_interval) &&
+           !supports_live_rate_control();
+}
+
+void Encoder::apply_rate_control(const EncoderConfig& next)
+{
+    ctx_->bit_rate = next.bitrate;
+    ctx_->rc_max_rate = next.bitrate;
+    ctx_->rc_buffer_size = next.bitrate;
+    ctx_->framerate = AVRational{next.fps, 1};
+
+    config_.bitrate = next.bitrate;
+    config_.fps = next.fps;
+    config_.keyframe_interval = next.keyframe_interval;
+
+    Logger::info("Encoder: rate control updated to {} bps @ {} fps, keyint {}",
+                 config_.bitrate, config_.fps, config_.keyframe_interval);
+}
+
+// Exchange the codec objects and settings, keeping timeline state
+// (epoch_, lastPts_) with this instance.
+void Encoder::swap_codec_state(Encoder& other) noexcept
+{
+    using std::swap;
+    swap(config_, other.config_);
+    swap(backend_, other.backend_);
+    swap(codec_, other.codec_);
+    swap(ctx_, other.ctx_);
+    swap(avFrame_, other.avFrame_);
+    swap(avPacket_, other.avPacket_);
+    swap(swsCtx_, other.swsCtx_);
+    swap(bandCtx_, other.bandCtx_);
+    swap(inputPath_, other.inputPath_);
+    swap(havePicture_, other.havePicture_);
+}
+
+void Encoder::release_codec_state()
+{
+    if (swsCtx_) {
+        sws_freeContext(swsCtx_);
+        swsCtx_ = nullptr;
+    }
+    for (SwsContext* band : bandCtx_) {
+        sws_freeContext(band);
+    }
+    bandCtx_.clear();
+    if (avFrame_) {
+        av_frame_free(&avFrame_);
+    }
+    if (avPacket_) {
+        av_packet_free(&avPacket_);
+    }
+    if (ctx_) {
+        avcodec_free_context(&ctx_);
+    }
+    codec_ = nullptr;
+    havePicture_ = false;
+    inputPath_.clear();
+}
+
+} // namespace pcs
@@ -0,0 +1,189 @@
+#include "encoder_registry.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace pcs {
+
+namespace {
+
+// A backend has to beat the target rate by this margin to count as sustaining
+// it, leaving room for capture, colour conversion and the rest of the pipeline.
+constexpr double kHeadroom = 1.25;
+
+const char* codec_key(CodecType codec)
+{
+    return codec == CodecType::MJPEG ? "mjpeg" : "h264";
+}
+
+} // namespace
+
+// ============================================================================
+// Constructor
+// ============================================================================
+
+EncoderRegistry::EncoderRegistry(CalibrateFn calibrate, std::string cachePath, std::string fingerprint)
+    : calibrate_(std::move(calibrate)),
+      cachePath_(std::move(cachePath)),
+      fingerprint_(std::move(fingerprint))
+{
+    load_cache();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void EncoderRegistry::addBackend(CodecType codec, const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    candidates_[codec].push_back(name);
+}
+
+std::string EncoderRegistry::resolve(const EncoderConfig& config)
+{
+    if (config.hw_accel != "auto") {
+        return config.hw_accel;
+    }
+
+    // Held across calibration: concurrent calibrations would skew each other
+    std::lock_guard<std::mutex> lock(mtx_);
+
+    const std::string key = cache_key(config);
+    auto it = cache_.find(key);
+    if (it != cache_.end() && it->second.fingerprint == fingerprint_) {
+        Logger::info("Encoder backend for {}: {} (cached, {:.1f} fps)",
+                     key, it->second.backend, it->second.fps);
+        return it->second.backend;
+    }
+
+    Entry entry = calibrate_all(config);
+    cache_[key] = entry;
+    save_cache();
+    return entry.backend;
+}
+
+void EncoderRegistry::invalidate(const EncoderConfig& config)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    if (cache_.erase(cache_key(config)) > 0) {
+        save_cache();
+    }
+}
+
+std::string EncoderRegistry::defaultCachePath()
+{
+    std::filesystem::path base;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg && *xdg) {
+        base = xdg;
+    } else if (const char* home = std::getenv("HOME"); home && *home) {
+        base = std::filesystem::path(home) / ".cache";
+    } else {
+        base = std::filesystem::temp_directory_path();
+    }
+    return (base / "pi-camera-streamer" / "encoder-backends.cache").string();
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+std::string EncoderRegistry::cache_key(const EncoderConfig& config)
+{
+    std::ostringstream oss;
+    oss << codec_key(config.codec) << "/" << config.width << "x" << config.height
+        << "@" << config.fps;
+    return oss.str();
+}
+
+EncoderRegistry::Entry EncoderRegistry::calibrate_all(const EncoderConfig& config)
+{
+    std::vector<std::string> backends = candidates_[config.codec];
+    if (std::find(backends.begin(), backends.end(), kSoftwareBackend) == backends.end()) {
+        backends.push_back(kSoftwareBackend);
+    }
+
+    Entry best{kSoftwareBackend, 0.0, fingerprint_};
+    bool anyOpened = false;
+
+    for (const auto& backend : backends) {
+        EncoderConfig probe = config;
+        probe.hw_accel = backend;
+
+        auto fps = calibrate_ ? calibrate_(probe) : std::nullopt;
+        if (!fps) {
+            Logger::info("Encoder backend {}: unavailable", backend);
+            continue;
+        }
+
+        Logger::info("Encoder backend {}: {:.1f} fps at {}x{}", backend, *fps, config.width, config.height);
+        if (!anyOpened || *fps > best.fps) {
+            best.backend = backend;
+            best.fps = *fps;
+            anyOpened = true;
+        }
+    }
+
+    if (!anyOpened) {
+        Logger::warn("Encoder: no backend passed calibration, using {}", kSoftwareBackend);
+    } else if (best.fps < config.fps * kHeadroom) {
+        Logger::warn("Encoder: fastest backend {} ({:.1f} fps) cannot sustain {} fps at {}x{}",
+                     best.backend, best.fps, config.fps, config.width, config.height);
+    } else {
+        Logger::info("Encoder: selected backend {} ({:.1f} fps)", best.backend, best.fps);
+    }
+
+    return best;
+}
+
+// Cache format: one "key backend fps fingerprint" entry per line.
+void EncoderRegistry::load_cache()
+{
+    if (cachePath_.empty()) {
+        return;
+    }
+
+    std::ifstream in(cachePath_);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream iss(line);
+        std::string key;
+        Entry entry;
+        if (iss >> key >> entry.backend >> entry.fps) {
+            iss >> entry.fingerprint;
+            cache_[key] = entry;
+        }
+    }
+}
+
+void EncoderRegistry::save_cache() const
+{
+    if (cachePath_.empty()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::path path(cachePath_);
+    if (path.has_parent_path()) {
+        std::filesystem::create_directories(path.parent_path(), ec);
+    }
+
+    // Write-then-rename so a crash never leaves a truncated cache behind
+    const std::string tmpPath = cachePath_ + ".tmp";
+    {
+        std::ofstream out(tmpPath, std::ios::trunc);
+        if (!out) {
+            Logger::warn("Encoder: cannot write backend cache {}", cachePath_);
+            return;
+        }
+        for (const auto& [key, entry] : cache_) {
+            out << key << " " << entry.backend << " " << entry.fps << " " << entry.fingerprint << "\n";
+        }
+    }
+    std::filesystem::rename(tmpPath, path, ec);
+}
+
+} // namespace pcs
@@ -0,0 +1,102 @@
+#include "format_negotiation.hpp"
+#include <algorithm>
+
+namespace pcs {
+
+namespace {
+
+// Raw layouts ordered by conversion cost into 4:2:0 YUV: planar/semi-planar
+// YUV only reshuffles chroma, packed YUV subsamples it, RGB needs a matrix.
+constexpr PixelFormat kConversionOrder[] = {
+    PixelFormat::NV12, PixelFormat::I420, PixelFormat::YUYV,
+    PixelFormat::BGR24, PixelFormat::BGRA, PixelFormat::Gray8,
+};
+
+void append_unique(std::vector<PixelFormat>& list, PixelFormat format)
+{
+    if (format != PixelFormat::Unknown && std::find(list.begin(), list.end(), format) == list.end()) {
+        list.push_back(format);
+    }
+}
+
+bool contains(const std::vector<PixelFormat>& list, PixelFormat format)
+{
+    return std::find(list.begin(), list.end(), format) != list.end();
+}
+
+} // namespace
+
+std::vector<PixelFormat> capturePreferences(CodecType codec,
+                                            const std::vector<PixelFormat>& encoderFormats)
+{
+    std::vector<PixelFormat> preferences;
+    if (codec == CodecType::MJPEG) {
+        append_unique(preferences, PixelFormat::MJPEG);
+    }
+    for (PixelFormat format : encoderFormats) {
+        if (format != PixelFormat::MJPEG) {
+            append_unique(preferences, format);
+        }
+    }
+    for (PixelFormat format : kConversionOrder) {
+        append_unique(preferences, format);
+    }
+    // Decoding is the most expensive way to get pixels
+    append_unique(preferences, PixelFormat::MJPEG);
+    return preferences;
+}
+
+FormatPlan planFormatPath(PixelFormat captured, CodecType codec,
+                          const std::vector<PixelFormat>& encoderFormats)
+{
+    FormatPlan plan;
+    plan.capture = captured;
+
+    if (captured == PixelFormat::MJPEG) {
+        if (codec == CodecType::MJPEG) {
+            plan.path = FormatPath::Passthrough;
+            return plan;
+        }
+        plan.path = FormatPath::Decode;
+    } else if (contains(encoderFormats, captured)) {
+        plan.path = FormatPath::Direct;
+        plan.encoder_input = captured;
+        return plan;
+    } else {
+        plan.path = FormatPath::Convert;
+    }
+
+    plan.encoder_input = encoderFormats.empty() ? PixelFormat::I420 : encoderFormats.front();
+    return plan;
+}
+
+const char* formatPathName(FormatPath path) noexcept
+{
+    switch (path) {
+        case FormatPath::Passthrough: return "passthrough";
+        case FormatPath::Direct:      return "direct";
+        case FormatPath::Convert:     return "convert";
+        case FormatPath::Decode:      return "decode";
+    }
+    return "unknown";
+}
+
+std::string describeFormatPlan(const FormatPlan& plan)
+{
+    const std::string capture = pixelFormatName(plan.capture);
+    const std::string input = pixelFormatName(plan.encoder_input);
+
+    switch (plan.path) {
+        case FormatPath::Passthrough:
+            return capture + " passthrough (no decode, no encode)";
+        case FormatPath::Direct:
+            return capture + " direct to encoder (no conversion)";
+        case FormatPath::Convert:
+            return capture + " -> " + input + " (one conversion in the encoder)";
+        case FormatPath::Decode:
+            return capture + " -> decode -> " + input + " (decode and conversion)";
+    }
+    return capture;
+}
+
+} // namespace pcs
@@ -6,6 +6,51 @@
 
 using Clock = std::chrono::steady_clock;
 
+namespace {
+
+// Bytes per pixel of the first plane; 0 for compressed data
+uint32_t channels_for(PixelFormat format, uint32_t fallback) noexcept
+{
+    switch (format) {
+        case PixelFormat::Gray8: return 1;
+        case PixelFormat::BGR24: return 3;
+        case PixelFormat::BGRA:  return 4;
+        case PixelFormat::YUYV:  return 2;
+        case PixelFormat::NV12:
+        case PixelFormat::I420:  return 1;
+        case PixelFormat::MJPEG: return 0;
+        case PixelFormat::Unknown: break;
+    }
+    return fallback;
+}
+
+PixelFormat format_for(uint32_t channels) noexcept
+{
+    switch (channels) {
+        case 1: return PixelFormat::Gray8;
+        case 3: return PixelFormat::BGR24;
+        case 4: return PixelFormat::BGRA;
+        default: return PixelFormat::Unknown;
+    }
+}
+
+} // namespace
+
+const char* pixelFormatName(PixelFormat format) noexcept
+{
+    switch (format) {
+        case PixelFormat::Gray8: return "GRAY8";
+        case PixelFormat::BGR24: return "BGR24";
+        case PixelFormat::BGRA:  return "BGRA";
+        case PixelFormat::YUYV:  return "YUYV";
+        case PixelFormat::NV12:  return "NV12";
+        case PixelFormat::I420:  return "I420";
+        case PixelFormat::MJPEG: return "MJPEG";
+        case PixelFormat::Unknown: break;
+    }
+    return "unknown";
+}
+
 // ============================================================================
 // Constructors (Rule of 5)
 // ============================================================================
@@ -24,15 +69,40 @@ Frame::Frame(std::vector<uint8_t> data, uint32_t width, uint32_t height, uint32_
       m_width(width),
       m_height(height),
       m_channels(channels),
+      m_format(format_for(channels)),
+      m_timestamp(Clock::now()) {}
+
+// Construct a frame in an explicit pixel format
+Frame::Frame(std::vector<uint8_t> data, uint32_t width, uint32_t height, PixelFormat format) noexcept
+    : m_data(std::move(data)),
+      m_width(width),
+      m_height(height),
+      m_channels(channels_for(format, 0)),
+      m_format(format),
       m_timestamp(Clock::now()) {}
 
-// Copy constructor (deep copy)
+// View memory owned elsewhere (capture buffer, mapped file)
+Frame::Frame(std::shared_ptr<const uint8_t> data, size_t size,
+             uint32_t width, uint32_t height, PixelFormat format) noexcept
+    : m_data(),
+      m_width(width),
+      m_height(height),
+      m_channels(channels_for(format, 0)),
+      m_format(format),
+      m_timestamp(Clock::now()),
+      m_external(std::move(data)),
+      m_externalSize(m_external ? size : 0) {}
+
+// Copy constructor (deep copy; external views are read-only and shared)
 Frame::Frame(const Frame& other)
     : m_data(other.m_data),
       m_width(other.m_width),
       m_height(other.m_height),
       m_channels(other.m_channels),
-      m_timestamp(other.m_timestamp) {}
+      m_format(other.m_format),
+      m_timestamp(other.m_timestamp),
+      m_external(other.m_external),
+      m_externalSize(other.m_externalSize) {}
 
 // Move constructor (zero-copy, noexcept for optimization)
 Frame::Frame(Frame&& other) noexcept
@@ -40,12 +110,17 @@ Frame::Frame(Frame&& other) noexcept
       m_width(other.m_width),
       m_height(other.m_height),
       m_channels(other.m_channels),
-      m_timestamp(other.m_timestamp)
+      m_format(other.m_format),
+      m_timestamp(other.m_timestamp),
+      m_external(std::move(other.m_external)),
+      m_externalSize(other.m_externalSize)
 {
     // Reset moved-from object to valid state
     other.m_width = 0;
     other.m_height = 0;
     other.m_channels = 0;
+    other.m_format = PixelFormat::Unknown;
+    other.m_externalSize = 0;
 }
 
 // Copy assignment
@@ -56,7 +131,10 @@ Frame& Frame::operator=(const Frame& other)
         m_width = other.m_width;
         m_height = other.m_height;
         m_channels = other.m_channels;
+        m_format = other.m_format;
         m_timestamp = other.m_timestamp;
+        m_external = other.m_external;
+        m_externalSize = other.m_externalSize;
     }
     return *this;
 }
@@ -69,12 +147,17 @@ Frame& Frame::operator=(Frame&& other) noexcept
         m_width = other.m_width;
         m_height = other.m_height;
         m_channels = other.m_channels;
+        m_format = other.m_format;
         m_timestamp = other.m_timestamp;
+        m_external = std::move(other.m_external);
+        m_externalSize = other.m_externalSize;
 
         // Reset moved-from object
         other.m_width = 0;
         other.m_height = 0;
         other.m_channels = 0;
+        other.m_format = PixelFormat::Unknown;
+        other.m_externalSize = 0;
     }
     return *this;
 }
@@ -87,6 +170,8 @@ Frame& Frame::operator=(Frame&& other) noexcept
 void Frame::setData(std::vector<uint8_t> data) noexcept
 {
     m_data = std::move(data);
+    m_external.reset();
+    m_externalSize = 0;
     m_timestamp = Clock::now();
 }
 
@@ -96,12 +181,39 @@ void Frame::setTimestampNow() noexcept
     m_timestamp = Clock::now();
 }
 
+// Use an externally provided capture time (same steady/monotonic clock)
+void Frame::setTimestamp(Timestamp timestamp) noexcept
+{
+    m_timestamp = timestamp;
+}
+
 // Update frame dimensions
 void Frame::setDimensions(uint32_t width, uint32_t height, uint32_t channels) noexcept
 {
     m_width = width;
     m_height = height;
     m_channels = channels;
+    m_format = format_for(channels);
+}
+
+// Update frame dimensions with an explicit pixel format
+void Frame::setDimensions(uint32_t width, uint32_t height, PixelFormat format) noexcept
+{
+    m_width = width;
+    m_height = height;
+    m_channels = channels_for(format, 0);
+    m_format = format;
+}
+
+// Take a private copy of an external view before mutating it
+void Frame::detach()
+{
+    if (!m_external) {
+        return;
+    }
+    m_data.assign(m_external.get(), m_external.get() + m_externalSize);
+    m_external.reset();
+    m_externalSize = 0;
 }
 
 // Pre-allocate buffer to avoid reallocations during capture
@@ -114,14 +226,30 @@ void Frame::reserve(size_t capacity)
 // Utilities
 // ============================================================================
 
+// Expected byte count for the dimensions and format
+size_t Frame::expectedSize() const noexcept
+{
+    const size_t pixels = static_cast<size_t>(m_width) * m_height;
+    switch (m_format) {
+        case PixelFormat::NV12:
+        case PixelFormat::I420:
+            return pixels + 2 * (static_cast<size_t>((m_width + 1) / 2) * ((m_height + 1) / 2));
+        case PixelFormat::MJPEG:
+            return 0;
+        default:
+            return pixels * m_channels;
+    }
+}
+
 // Deep copy clone (used when encoder/sender need ownership)
 Frame Frame::clone() const
 {
     Frame copy;
-    copy.m_data = m_data;
+    copy.m_data.assign(dataPtr(), dataPtr() + size());
     copy.m_width = m_width;
     copy.m_height = m_height;
     copy.m_channels = m_channels;
+    copy.m_format = m_format;
     copy.m_timestamp = m_timestamp;
     return copy;
 }
@@ -146,7 +274,8 @@ std::string Frame::toString() const
     std::ostringstream oss;
     oss << "Frame(" << m_width << "x" << m_height
         << "x" << m_channels
-        << ", bytes=" << m_data.size()
+        << ", format=" << pixelFormatName(m_format)
+        << ", bytes=" << size()
         << ", expected=" << expectedSize()
         << ", valid=" << (isValid() ? "yes" : "no")
         << ", age=" << ageMs() << "ms)";
@@ -161,5 +290,8 @@ void Frame::swap(Frame& other) noexcept
     swap(m_width, other.m_width);
     swap(m_height, other.m_height);
     swap(m_channels, other.m_channels);
+    swap(m_format, other.m_format);
     swap(m_timestamp, other.m_timestamp);
+    swap(m_external, other.m_external);
+    swap(m_externalSize, other.m_externalSize);
 }
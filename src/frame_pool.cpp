@@ -0,0 +1,92 @@
+#include "frame_pool.hpp"
+#include "logger.hpp"
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace pcs {
+
+struct FramePool::Shared {
+    struct AlignedDelete {
+        void operator()(uint8_t* p) const noexcept
+        {
+            ::operator delete(p, std::align_val_t(kAlignment));
+        }
+    };
+
+    size_t bufferSize{0};
+    std::vector<MemoryCharge> charges; // one per buffer in `storage`, released after it
+    std::vector<std::unique_ptr<uint8_t, AlignedDelete>> storage;
+    std::vector<uint8_t*> free;
+    mutable std::mutex mtx;
+    std::atomic<uint64_t> exhausted{0};
+
+    void release(uint8_t* buffer)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        free.push_back(buffer);
+    }
+};
+
+FramePool::FramePool(size_t bufferSize, size_t count, MemoryAccount* account)
+    : shared_(std::make_shared<Shared>())
+{
+    shared_->bufferSize = bufferSize;
+    shared_->storage.reserve(count);
+    shared_->free.reserve(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        MemoryCharge charge = MemoryCharge::take(account, bufferSize, MemoryPriority::Required);
+        if (!charge) {
+            Logger::warn("Frame pool: memory budget covers {} of {} buffers of {} bytes", i, count, bufferSize);
+            break;
+        }
+        shared_->charges.push_back(std::move(charge));
+
+        auto* buffer = static_cast<uint8_t*>(
+            ::operator new(bufferSize ? bufferSize : 1, std::align_val_t(kAlignment)));
+        std::memset(buffer, 0, bufferSize); // prefault every page now, not on first capture
+        shared_->storage.emplace_back(buffer);
+        shared_->free.push_back(buffer);
+    }
+}
+
+std::shared_ptr<uint8_t> FramePool::acquire()
+{
+    uint8_t* buffer = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(shared_->mtx);
+        if (shared_->free.empty()) {
+            shared_->exhausted.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        buffer = shared_->free.back();
+        shared_->free.pop_back();
+    }
+
+    return std::shared_ptr<uint8_t>(buffer, [shared = shared_](uint8_t* p) { shared->release(p); });
+}
+
+size_t FramePool::bufferSize() const noexcept
+{
+    return shared_->bufferSize;
+}
+
+size_t FramePool::capacity() const noexcept
+{
+    return shared_->storage.size();
+}
+
+size_t FramePool::available() const
+{
+    std::lock_guard<std::mutex> lock(shared_->mtx);
+    return shared_->free.size();
+}
+
+uint64_t FramePool::exhausted() const noexcept
+{
+    return shared_->exhausted.load(std::memory_order_relaxed);
+}
+
+} // namespace pcs
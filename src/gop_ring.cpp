@@ -0,0 +1,270 @@
+#include "gop_ring.hpp"
+#include "logger.hpp"
+#include "ts_muxer.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <optional>
+#include <set>
+
+namespace pcs {
+
+namespace {
+
+constexpr int64_t kTicksPerMs = 90;
+
+} // namespace
+
+// Shared with every clip's pin, so clips can outlive the ring
+struct GopRing::State {
+    struct Slot {
+        uint64_t sequence;
+        size_t offset;
+        size_t size;
+        int64_t pts;
+        int64_t dts;
+        bool keyframe;
+    };
+
+    explicit State(size_t budgetBytes)
+        : budget(budgetBytes)
+        , arena(std::make_unique<uint8_t[]>(budgetBytes))
+    {
+    }
+
+    const size_t budget;
+    const std::unique_ptr<uint8_t[]> arena;
+
+    mutable std::mutex mtx;
+    std::deque<Slot> slots;          // oldest first; sequences are consecutive
+    std::deque<uint64_t> keyframes;  // sequences of the keyframes in `slots`
+    std::multiset<std::pair<uint64_t, uint64_t>> pins; // [first, last] sequences held by clips
+    size_t head{0};                  // where the next packet goes, unless it wraps
+    size_t bytes{0};
+    uint64_t nextSequence{0};
+    bool waitingForKeyframe{true};
+    GopRingStats stats;
+
+    // Where `size` contiguous bytes are free, if anywhere: after the newest
+    // packet, or at the start of the arena when the end is too short
+    std::optional<size_t> find_space(size_t size) const
+    {
+        if (slots.empty()) {
+            return size <= budget ? std::optional<size_t>(0) : std::nullopt;
+        }
+        const size_t tail = slots.front().offset;
+        if (tail < head) {
+            if (head + size <= budget) {
+                return head;
+            }
+            if (size <= tail) {
+                return 0;
+            }
+            return std::nullopt;
+        }
+        // Wrapped: the free space is the gap between newest and oldest
+        if (head + size <= tail) {
+            return head;
+        }
+        return std::nullopt;
+    }
+
+    bool pinned(uint64_t sequence) const
+    {
+        return std::any_of(pins.begin(), pins.end(), [&](const auto& pin) {
+            return pin.first <= sequence && sequence <= pin.second;
+        });
+    }
+
+    void evict_front()
+    {
+        const Slot& slot = slots.front();
+        if (slot.keyframe) {
+            keyframes.pop_front();
+        }
+        bytes -= slot.size;
+        slots.pop_front();
+        stats.evicted++;
+    }
+
+    // Evict the oldest GOP, or what is left of it
+    bool evict_gop()
+    {
+        if (pinned(slots.front().sequence)) {
+            return false;
+        }
+        evict_front();
+        while (!slots.empty() && !slots.front().keyframe) {
+            evict_front();
+        }
+        return true;
+    }
+
+    GopClip clip_from(const std::shared_ptr<State>& self, int64_t pts)
+    {
+        GopClip clip;
+        if (keyframes.empty()) {
+            return clip;
+        }
+
+        const uint64_t firstSequence = slots.front().sequence;
+        uint64_t start = keyframes.front();
+        for (auto it = keyframes.rbegin(); it != keyframes.rend(); ++it) {
+            if (slots[*it - firstSequence].pts <= pts) {
+                start = *it;
+                break;
+            }
+        }
+
+        clip.packets_.reserve(static_cast<size_t>(nextSequence - start));
+        for (size_t i = start - firstSequence; i < slots.size(); ++i) {
+            const Slot& slot = slots[i];
+            clip.packets_.push_back(PacketView{{arena.get() + slot.offset, slot.size}, slot.pts, slot.dts,
+                                               slot.keyframe, slot.sequence});
+        }
+
+        auto pin = pins.emplace(start, slots.back().sequence);
+        clip.pin_ = std::shared_ptr<void>(nullptr, [self, pin](void*) {
+            std::lock_guard<std::mutex> lock(self->mtx);
+            self->pins.erase(pin);
+        });
+        return clip;
+    }
+};
+
+// ============================================================================
+// GopClip
+// ============================================================================
+
+size_t GopClip::bytes() const noexcept
+{
+    size_t total = 0;
+    for (const PacketView& packet : packets_) {
+        total += packet.data.size();
+    }
+    return total;
+}
+
+int64_t GopClip::durationTicks() const noexcept
+{
+    if (packets_.empty()) {
+        return 0;
+    }
+    return packets_.back().pts - packets_.front().pts;
+}
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+GopRing::GopRing(const GopRingConfig& config)
+    : state_(std::make_shared<State>(config.budget_bytes))
+{
+    state_->stats.budget = config.budget_bytes;
+}
+
+GopRing::~GopRing() = default;
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool GopRing::append(const EncodedFrame& frame)
+{
+    State& s = *state_;
+    std::lock_guard<std::mutex> lock(s.mtx);
+    const size_t size = frame.data.size();
+    if (size == 0 || size > s.budget) {
+        s.stats.droppedOversize++;
+        s.waitingForKeyframe = true;
+        return false;
+    }
+    if (s.waitingForKeyframe && !frame.keyframe) {
+        s.stats.droppedNoKeyframe++;
+        return false;
+    }
+
+    std::optional<size_t> start;
+    while (!(start = s.find_space(size))) {
+        if (!s.evict_gop()) {
+            // A clip holds the oldest packets; this GOP can't be completed
+            s.stats.droppedPinned++;
+            s.waitingForKeyframe = true;
+            return false;
+        }
+    }
+    if (!frame.keyframe && s.keyframes.empty()) {
+        // Making room evicted this packet's own keyframe: ring smaller than a GOP
+        s.stats.droppedNoKeyframe++;
+        s.waitingForKeyframe = true;
+        return false;
+    }
+
+    std::memcpy(s.arena.get() + *start, frame.data.data(), size);
+    const uint64_t sequence = s.nextSequence++;
+    s.slots.push_back({sequence, *start, size, frame.pts, frame.dts, frame.keyframe});
+    if (frame.keyframe) {
+        s.keyframes.push_back(sequence);
+    }
+    s.head = *start + size;
+    s.bytes += size;
+    s.waitingForKeyframe = false;
+    s.stats.appended++;
+    return true;
+}
+
+GopClip GopRing::clipFrom(int64_t pts) const
+{
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return state_->clip_from(state_, pts);
+}
+
+GopClip GopRing::clipLast(std::chrono::milliseconds preEvent) const
+{
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    if (state_->slots.empty()) {
+        return {};
+    }
+    return state_->clip_from(state_, state_->slots.back().pts - preEvent.count() * kTicksPerMs);
+}
+
+GopRingStats GopRing::stats() const
+{
+    const State& s = *state_;
+    std::lock_guard<std::mutex> lock(s.mtx);
+    GopRingStats stats = s.stats;
+    stats.packets = s.slots.size();
+    stats.keyframes = s.keyframes.size();
+    stats.bytes = s.bytes;
+    if (!s.slots.empty()) {
+        stats.oldestPts = s.slots.front().pts;
+        stats.newestPts = s.slots.back().pts;
+    }
+    return stats;
+}
+
+bool saveClip(const GopClip& clip, const std::string& path)
+{
+    if (clip.empty()) {
+        Logger::warn("No packets to save to {}", path);
+        return false;
+    }
+
+    TsMuxer muxer;
+    std::vector<uint8_t> ts;
+    for (const PacketView& packet : clip.packets()) {
+        muxer.writePacket(packet.data, packet.pts, packet.dts, packet.keyframe, ts);
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.write(reinterpret_cast<const char*>(ts.data()), static_cast<std::streamsize>(ts.size()))) {
+        Logger::error("Cannot write clip {}: {}", path, std::strerror(errno));
+        return false;
+    }
+    Logger::info("Saved clip {}: {} packets, {:.1f} s, {} bytes", path, clip.packets().size(),
+                 clip.durationTicks() / 90000.0, ts.size());
+    return true;
+}
+
+} // namespace pcs
@@ -0,0 +1,130 @@
+#include "histogram.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace pcs {
+
+namespace {
+
+constexpr uint64_t kEmptyMin = std::numeric_limits<uint64_t>::max();
+
+void atomic_min(std::atomic<uint64_t>& target, uint64_t value) noexcept
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value < current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+void atomic_max(std::atomic<uint64_t>& target, uint64_t value) noexcept
+{
+    uint64_t current = target.load(std::memory_order_relaxed);
+    while (value > current &&
+           !target.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+    }
+}
+
+} // namespace
+
+Histogram::Histogram() noexcept
+    : min_(kEmptyMin)
+{
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+// Values below 2 * kSubBuckets map to themselves; above that, the top
+// kSubBucketBits + 1 bits select the bucket.
+int Histogram::bucketIndex(uint64_t value) noexcept
+{
+    if (value < static_cast<uint64_t>(kSubBuckets)) {
+        return static_cast<int>(value);
+    }
+    const int msb = 63 - std::countl_zero(value);
+    const int shift = msb - kSubBucketBits;
+    const int mantissa = static_cast<int>(value >> shift); // in [kSubBuckets, 2 * kSubBuckets)
+    return (shift + 1) * kSubBuckets + (mantissa - kSubBuckets);
+}
+
+uint64_t Histogram::bucketUpperBound(int index) noexcept
+{
+    if (index < 2 * kSubBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = index / kSubBuckets - 1;
+    const uint64_t mantissa = kSubBuckets + index % kSubBuckets;
+    const uint64_t next = (mantissa + 1) << shift;
+    return next == 0 ? std::numeric_limits<uint64_t>::max() : next - 1;
+}
+
+void Histogram::record(uint64_t value) noexcept
+{
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+    atomic_min(min_, value);
+    atomic_max(max_, value);
+}
+
+uint64_t Histogram::min() const noexcept
+{
+    uint64_t value = min_.load(std::memory_order_relaxed);
+    return value == kEmptyMin ? 0 : value;
+}
+
+double Histogram::mean() const noexcept
+{
+    uint64_t n = count();
+    return n ? static_cast<double>(sum_.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+}
+
+uint64_t Histogram::percentile(double p) const noexcept
+{
+    const uint64_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+
+    const double clamped = std::clamp(p, 0.0, 100.0);
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped / 100.0 * n)));
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperBound(i), max());
+        }
+    }
+    return max();
+}
+
+void Histogram::merge(const Histogram& other) noexcept
+{
+    for (int i = 0; i < kBucketCount; ++i) {
+        if (uint64_t n = other.buckets_[i].load(std::memory_order_relaxed)) {
+            buckets_[i].fetch_add(n, std::memory_order_relaxed);
+        }
+    }
+    count_.fetch_add(other.count(), std::memory_order_relaxed);
+    sum_.fetch_add(other.sum_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    if (other.count()) {
+        atomic_min(min_, other.min());
+        atomic_max(max_, other.max());
+    }
+}
+
+void Histogram::reset() noexcept
+{
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    min_.store(kEmptyMin, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+} // namespace pcs
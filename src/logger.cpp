@@ -1,13 +1,43 @@
 #include "logger.hpp"
+#include <spdlog/async.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/sinks/rotating_file_sink.h>
+#include <algorithm>
+#include <limits>
 #include <vector>
 
+namespace {
+
+spdlog::level::level_enum parseLevel(const std::string& level)
+{
+    if (level == "trace") {
+        return spdlog::level::trace;
+    } else if (level == "debug") {
+        return spdlog::level::debug;
+    } else if (level == "info") {
+        return spdlog::level::info;
+    } else if (level == "warn") {
+        return spdlog::level::warn;
+    } else if (level == "error") {
+        return spdlog::level::err;
+    } else if (level == "critical") {
+        return spdlog::level::critical;
+    } else if (level == "off") {
+        return spdlog::level::off;
+    }
+    return spdlog::level::info;
+}
+
+} // namespace
+
 // Initialize static members
 std::shared_ptr<spdlog::logger> Logger::s_logger = nullptr;
+std::shared_ptr<spdlog::details::thread_pool> Logger::s_threadPool = nullptr;
+std::atomic<spdlog::logger*> Logger::s_current{nullptr};
+std::atomic<int> Logger::s_level{spdlog::level::info};
 std::mutex Logger::s_mutex;
 
-void Logger::init(const std::string& filename, const std::string& level)
+void Logger::init(const std::string& filename, const std::string& level, const LogOptions& options)
 {
     std::lock_guard<std::mutex> lock(s_mutex);
 
@@ -16,24 +46,40 @@ void Logger::init(const std::string& filename, const std::string& level)
     }
 
     try {
+        std::vector<spdlog::sink_ptr> sinks;
+
         // Create console sink with color
-        auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
-        console_sink->set_level(spdlog::level::trace);
+        if (options.console) {
+            auto console_sink = std::make_shared<spdlog::sinks::stdout_color_sink_mt>();
+            console_sink->set_level(spdlog::level::trace);
+            sinks.push_back(console_sink);
+        }
 
         // Create rotating file sink (5MB per file, 3 files max)
         auto file_sink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(
             filename, 5 * 1024 * 1024, 3);
         file_sink->set_level(spdlog::level::trace);
-
-        // Combine sinks
-        std::vector<spdlog::sink_ptr> sinks{console_sink, file_sink};
-        s_logger = std::make_shared<spdlog::logger>("pi-camera", sinks.begin(), sinks.end());
+        sinks.push_back(file_sink);
+
+        if (options.async) {
+            // One writer thread keeps the sinks' order; the queue is
+            // allocated here, not per message
+            const size_t queueSize = std::max<size_t>(options.queue_size, 1);
+            s_threadPool = std::make_shared<spdlog::details::thread_pool>(queueSize, 1);
+            const auto policy = options.overflow == LogOverflow::OverrunOldest
+                                    ? spdlog::async_overflow_policy::overrun_oldest
+                                    : spdlog::async_overflow_policy::block;
+            s_logger = std::make_shared<spdlog::async_logger>("pi-camera", sinks.begin(), sinks.end(),
+                                                              s_threadPool, policy);
+        } else {
+            s_logger = std::make_shared<spdlog::logger>("pi-camera", sinks.begin(), sinks.end());
+        }
 
         // Set pattern: [timestamp] [level] message
         s_logger->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%^%l%$] %v");
 
-        // Set log level
-        setLevel(level);
+        // Set log level (s_mutex is already held, so don't go through setLevel)
+        s_logger->set_level(parseLevel(level));
 
         // Register with spdlog
         spdlog::register_logger(s_logger);
@@ -43,18 +89,19 @@ void Logger::init(const std::string& filename, const std::string& level)
         s_logger = spdlog::stdout_color_mt("pi-camera");
         s_logger->warn("Logger init failed: {}. Using console only.", ex.what());
     }
+    s_level.store(s_logger->level(), std::memory_order_relaxed);
+    s_current.store(s_logger.get(), std::memory_order_release);
 }
 
-std::shared_ptr<spdlog::logger> Logger::get()
+spdlog::logger* Logger::get()
 {
-    std::lock_guard<std::mutex> lock(s_mutex);
-
-    if (!s_logger) {
-        // Auto-initialize with defaults if not yet initialized
-        init();
+    if (spdlog::logger* logger = s_current.load(std::memory_order_acquire)) {
+        return logger;
     }
 
-    return s_logger;
+    // Auto-initialize with defaults if not yet initialized (init() takes the lock)
+    init();
+    return s_current.load(std::memory_order_acquire);
 }
 
 void Logger::setLevel(const std::string& level)
@@ -65,23 +112,8 @@ void Logger::setLevel(const std::string& level)
         return;
     }
 
-    if (level == "trace") {
-        s_logger->set_level(spdlog::level::trace);
-    } else if (level == "debug") {
-        s_logger->set_level(spdlog::level::debug);
-    } else if (level == "info") {
-        s_logger->set_level(spdlog::level::info);
-    } else if (level == "warn") {
-        s_logger->set_level(spdlog::level::warn);
-    } else if (level == "error") {
-        s_logger->set_level(spdlog::level::err);
-    } else if (level == "critical") {
-        s_logger->set_level(spdlog::level::critical);
-    } else if (level == "off") {
-        s_logger->set_level(spdlog::level::off);
-    } else {
-        s_logger->set_level(spdlog::level::info);
-    }
+    s_logger->set_level(parseLevel(level));
+    s_level.store(s_logger->level(), std::memory_order_relaxed);
 }
 
 void Logger::shutdown()
@@ -89,8 +121,49 @@ void Logger::shutdown()
     std::lock_guard<std::mutex> lock(s_mutex);
 
     if (s_logger) {
+        s_current.store(nullptr, std::memory_order_release);
         s_logger->flush();
         spdlog::drop("pi-camera");
         s_logger.reset();
+        // Joins the writer once everything queued, the flush included, is written
+        s_threadPool.reset();
+    }
+}
+
+// ============================================================================
+// Rate limiting
+// ============================================================================
+
+LogRateLimiter::LogRateLimiter(std::chrono::steady_clock::duration interval) noexcept
+    : intervalTicks_(interval.count())
+    , nextDue_(std::numeric_limits<int64_t>::min())
+{
+}
+
+bool LogRateLimiter::admit(uint64_t& suppressed) noexcept
+{
+    const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+    int64_t due = nextDue_.load(std::memory_order_relaxed);
+    // Of the callers that find the interval over, only one moves it on
+    if (now < due || !nextDue_.compare_exchange_strong(due, now + intervalTicks_, std::memory_order_relaxed)) {
+        suppressed_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+LogSampler::LogSampler(uint64_t every) noexcept
+    : every_(std::max<uint64_t>(every, 1))
+{
+}
+
+bool LogSampler::admit(uint64_t& suppressed) noexcept
+{
+    const uint64_t n = count_.fetch_add(1, std::memory_order_relaxed);
+    if (n % every_ != 0) {
+        return false;
     }
+    suppressed = n == 0 ? 0 : every_ - 1;
+    return true;
 }
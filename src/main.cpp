@@ -1,6 +1,793 @@
-#include <iostream>
+#include "config.hpp"
+#include "config_watcher.hpp"
+#include "encoder.hpp"
+#include "encoder_registry.hpp"
+#include "format_negotiation.hpp"
+#include "gop_ring.hpp"
+#include "logger.hpp"
+#include "memory_budget.hpp"
+#include "mjpeg.hpp"
+#include "mjpeg_decoder.hpp"
+#include "multi_camera.hpp"
+#include "pipeline.hpp"
+#include "recorder.hpp"
+#include "roi.hpp"
+#include "scene_filter.hpp"
+#include "sender.hpp"
+#include "slo_controller.hpp"
+#include "snapshot.hpp"
+#include "thread_config.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
-int main() {
-    std::cout << "Hello, Pi Camera Streamer!" << std::endl;
-    return 0;
-}
\ No newline at end of file
+using namespace pcs;
+
+namespace {
+
+// Stack each real-time stage thread touches before its first frame
+constexpr size_t kPrefaultStackBytes = 256 * 1024;
+
+// How often the multi-camera loop checks for a stop request
+constexpr auto kPollInterval = std::chrono::milliseconds(100);
+
+std::atomic<bool> g_stopRequested{false};
+std::atomic<bool> g_clipRequested{false};
+std::atomic<bool> g_snapshotRequested{false};
+static_assert(std::atomic<bool>::is_always_lock_free, "flag is set from a signal handler");
+
+extern "C" void on_signal(int)
+{
+    g_stopRequested.store(true);
+}
+
+extern "C" void on_clip_signal(int)
+{
+    g_clipRequested.store(true);
+}
+
+extern "C" void on_snapshot_signal(int)
+{
+    g_snapshotRequested.store(true);
+}
+
+void install_signal_handlers()
+{
+    struct sigaction action{};
+    action.sa_handler = on_signal;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    action.sa_handler = on_clip_signal;
+    sigaction(SIGUSR1, &action, nullptr);
+    action.sa_handler = on_snapshot_signal;
+    sigaction(SIGUSR2, &action, nullptr);
+    // A receiver hanging up must not kill the process
+    std::signal(SIGPIPE, SIG_IGN);
+}
+
+void print_usage(const char* argv0)
+{
+    Logger::info("usage: {} [--config FILE] [--dest-ip IP] [--port N] "
+                 "[--device PATH|synthetic[:pattern]] [--codec h264|mjpeg] [--width N] [--height N] "
+                 "[--fps N] [--capture-cpus LIST] [--encode-cpus LIST] [--send-cpus LIST] "
+                 "[--record DIR] [--realtime] [--lock-memory]", argv0);
+}
+
+// Stage threads, queues and drop settings from the [pipeline] section
+PipelineConfig make_pipeline_config(const config::Config& settings)
+{
+    PipelineConfig pipeline;
+    pipeline.capture_queue = static_cast<size_t>(settings.pipeline.capture_queue);
+    pipeline.send_queue = static_cast<size_t>(settings.pipeline.send_queue);
+    pipeline.fps_cap = settings.pipeline.fps_cap;
+    pipeline.capture_budget = std::chrono::milliseconds(settings.pipeline.capture_budget_ms);
+    pipeline.drop_policy = settings.pipeline.drop_policy == "oldest" ? DropPolicy::Oldest : DropPolicy::Newest;
+    pipeline.stats_interval = std::chrono::milliseconds(settings.pipeline.stats_interval_ms);
+    // Lists were validated when the config or flags were parsed
+    pipeline.capture_thread.cpus = parseCpuList(settings.pipeline.capture_cpus).value_or(std::vector<int>{});
+    pipeline.encode_thread.cpus = parseCpuList(settings.pipeline.encode_cpus).value_or(std::vector<int>{});
+    pipeline.send_thread.cpus = parseCpuList(settings.pipeline.send_cpus).value_or(std::vector<int>{});
+
+    if (settings.pipeline.realtime) {
+        // Capture must never miss a buffer; encode and send can absorb a little jitter
+        pipeline.capture_thread.policy = SchedPolicy::Fifo;
+        pipeline.capture_thread.priority = 50;
+        pipeline.encode_thread.policy = SchedPolicy::Fifo;
+        pipeline.encode_thread.priority = 40;
+        pipeline.send_thread.policy = SchedPolicy::Fifo;
+        pipeline.send_thread.priority = 30;
+        for (ThreadConfig* thread : {&pipeline.capture_thread, &pipeline.encode_thread, &pipeline.send_thread}) {
+            thread->prefault_stack = kPrefaultStackBytes;
+        }
+    }
+    return pipeline;
+}
+
+EncoderConfig make_encoder_config(const config::Config& settings)
+{
+    EncoderConfig encoder;
+    encoder.codec = settings.encoder.codec == "mjpeg" ? CodecType::MJPEG : CodecType::H264;
+    encoder.width = settings.camera.width;
+    encoder.height = settings.camera.height;
+    encoder.fps = settings.camera.fps;
+    encoder.bitrate = settings.encoder.bitrate;
+    encoder.keyframe_interval = settings.encoder.keyframe_interval;
+    encoder.threads = settings.encoder.threads;
+    encoder.preset = settings.encoder.preset;
+    encoder.hw_accel = settings.encoder.hw_accel;
+    return encoder;
+}
+
+SloConfig make_slo_config(const config::Config& settings)
+{
+    SloConfig slo;
+    slo.targets.latency_p99_us = static_cast<uint64_t>(settings.slo.latency_ms) * 1000;
+    slo.targets.queue_fill = settings.slo.queue_fill;
+    slo.targets.cpu_load = settings.slo.cpu_load;
+    slo.targets.sender_backlog_bytes = static_cast<size_t>(settings.slo.sender_backlog_kb) * 1024;
+    slo.bitrate_steps = settings.slo.bitrate_steps;
+    slo.fps_steps = settings.slo.fps_steps;
+    slo.resolution_steps = settings.slo.resolution_steps;
+    slo.degrade_after = settings.slo.degrade_after;
+    slo.recover_after = settings.slo.recover_after;
+    slo.headroom = settings.slo.headroom;
+    return slo;
+}
+
+RecorderConfig make_recorder_config(const config::Config& settings)
+{
+    RecorderConfig recorder;
+    recorder.directory = settings.recorder.directory;
+    recorder.segment_duration = std::chrono::seconds(settings.recorder.segment_seconds);
+    recorder.queue_bytes = static_cast<size_t>(settings.recorder.queue_kb) * 1024;
+    recorder.write_batch = static_cast<size_t>(settings.recorder.write_kb) * 1024;
+    recorder.preallocate_bytes = static_cast<size_t>(settings.recorder.preallocate_mb) * 1024 * 1024;
+    recorder.sync_interval = std::chrono::milliseconds(settings.recorder.sync_ms);
+    recorder.direct_io = settings.recorder.direct_io;
+    recorder.writer_thread.cpus = parseCpuList(settings.pipeline.send_cpus).value_or(std::vector<int>{});
+    return recorder;
+}
+
+// <directory>/event-YYYYmmdd-HHMMSS.ts, local time
+std::string event_clip_path(const std::string& directory)
+{
+    const std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char name[32];
+    std::strftime(name, sizeof(name), "event-%Y%m%d-%H%M%S.ts", &local);
+    return directory + "/" + name;
+}
+
+// JPEG stills for the snapshot service: one MJPEG encoder per size, opened
+// on first use; camera JPEGs are decoded first
+SnapshotService::EncodeFn make_snapshot_encoder()
+{
+    struct State {
+        std::mutex mtx;
+        MjpegDecoder decoder{PixelFormat::I420};
+        std::map<std::pair<uint32_t, uint32_t>, std::unique_ptr<Encoder>> encoders;
+    };
+    auto state = std::make_shared<State>();
+    return [state](const Frame& frame, uint32_t width, uint32_t height) -> std::optional<std::vector<uint8_t>> {
+        std::lock_guard<std::mutex> lock(state->mtx);
+        std::optional<Frame> decoded;
+        if (frame.isCompressed() && !(decoded = state->decoder.decode(frame))) {
+            return std::nullopt;
+        }
+        const Frame& pixels = decoded ? *decoded : frame;
+
+        std::unique_ptr<Encoder>& encoder = state->encoders[{width, height}];
+        if (!encoder) {
+            EncoderConfig config;
+            config.codec = CodecType::MJPEG;
+            config.width = static_cast<int>(width);
+            config.height = static_cast<int>(height);
+            config.fps = 1;
+            config.bitrate = static_cast<int>(width * height * 2); // ~2 bits per pixel
+            config.hw_accel = EncoderRegistry::kSoftwareBackend;
+            config.input_format = pixels.format();
+            encoder = std::make_unique<Encoder>(config);
+            if (!encoder->init()) {
+                encoder.reset();
+                return std::nullopt;
+            }
+        }
+        std::optional<EncodedFrame> encoded = encoder->encode(pixels);
+        if (!encoded) {
+            return std::nullopt;
+        }
+        return std::move(encoded->data);
+    };
+}
+
+// Replace `path` whole, so a reader never sees half a JPEG
+bool write_snapshot(const Snapshot& snapshot, const std::string& path)
+{
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        if (!file.write(reinterpret_cast<const char*>(snapshot.jpeg->data()),
+                        static_cast<std::streamsize>(snapshot.jpeg->size()))) {
+            Logger::error("Cannot write snapshot {}", temporary);
+            return false;
+        }
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        Logger::error("Cannot replace snapshot {}", path);
+        return false;
+    }
+    Logger::info("Saved snapshot {}: {}x{}, {} bytes", path, snapshot.width, snapshot.height,
+                 snapshot.jpeg->size());
+    return true;
+}
+
+// The [pipeline] tunables with the SLO controller's frame-rate step on top
+PipelineConfig make_pipeline_config(const config::Config& settings, const QualityLevel& quality)
+{
+    PipelineConfig pipeline = make_pipeline_config(settings);
+    pipeline.fps_cap = scaledFpsCap(quality, settings.camera.fps, pipeline.fps_cap);
+    return pipeline;
+}
+
+// Scaled frame size, kept even for 4:2:0 chroma
+int scaled_dimension(int size, double scale)
+{
+    return std::max(16, static_cast<int>(size * scale) & ~1);
+}
+
+StaticSceneConfig make_scene_config(const config::Config& settings)
+{
+    StaticSceneConfig scene;
+    scene.threshold = settings.scene.threshold;
+    scene.mode = settings.scene.mode == "repeat" ? SkipMode::Repeat : SkipMode::Drop;
+    scene.refresh_interval = std::chrono::milliseconds(settings.scene.refresh_ms);
+    return scene;
+}
+
+// What runs on each frame before the encoder, from [scene] and [roi]; owned
+// by the thread that encodes
+struct EncodeSteps {
+    std::unique_ptr<StaticSceneFilter> scene;
+    std::unique_ptr<MotionRoiDetector> motion;
+    FixedZones zones;
+};
+
+// Quality maps only reach libx264, so [roi] is left out for other codecs
+EncodeSteps make_encode_steps(const config::Config& settings, ThreadPool* pool)
+{
+    EncodeSteps steps;
+    if (settings.scene.enabled) {
+        steps.scene = std::make_unique<StaticSceneFilter>(make_scene_config(settings));
+    }
+
+    const bool roi = settings.roi.motion || !settings.roi.privacy_zones.empty();
+    if (roi && settings.encoder.codec != "h264") {
+        Logger::warn("Region-of-interest quality needs the h264 codec; ignoring [roi]");
+        return steps;
+    }
+    if (settings.roi.motion) {
+        MotionRoiConfig motion;
+        motion.threshold = settings.roi.motion_threshold;
+        motion.motion_offset = settings.roi.motion_offset;
+        motion.static_offset = settings.roi.static_offset;
+        steps.motion = std::make_unique<MotionRoiDetector>(motion, pool);
+    }
+    // Validated when the config was parsed
+    for (const Rect& zone : parseRectList(settings.roi.privacy_zones).value_or(std::vector<Rect>{})) {
+        steps.zones.addPrivacyZone(zone);
+    }
+    return steps;
+}
+
+// Encodes pixels unless the scene filter (if any) finds nothing changed;
+// then the frame is skipped, or the encoder repeats its last picture.
+// Encoded frames carry the [roi] quality map.
+EncodeResult encode_frame(Encoder& encoder, EncodeSteps& steps, const Frame& pixels)
+{
+    if (steps.scene) {
+        switch (steps.scene->evaluate(pixels)) {
+        case SceneDecision::Skip: return EncodeResult::skip();
+        case SceneDecision::Repeat: return encoder.encodeRepeat(pixels.timestamp());
+        case SceneDecision::Encode: break;
+        }
+    }
+    if (!steps.motion && steps.zones.empty()) {
+        return encoder.encode(pixels);
+    }
+
+    QualityMap quality = steps.motion ? steps.motion->update(pixels) : QualityMap(pixels.width(), pixels.height());
+    steps.zones.apply(quality);
+    return encoder.encode(pixels, &quality);
+}
+
+// Workers for intra-frame work, or null when [pool] asks for none. They run
+// encode-path bands, so with realtime they get the encode thread's priority.
+std::unique_ptr<ThreadPool> make_pool(const config::Config& settings)
+{
+    if (settings.pool.workers == 0) {
+        return nullptr;
+    }
+    ThreadPoolConfig pool;
+    pool.workers = static_cast<size_t>(settings.pool.workers);
+    pool.worker_thread.cpus = parseCpuList(settings.pool.cpus).value_or(std::vector<int>{});
+    if (settings.pipeline.realtime) {
+        pool.worker_thread.policy = SchedPolicy::Fifo;
+        pool.worker_thread.priority = 40;
+        pool.worker_thread.prefault_stack = kPrefaultStackBytes;
+    }
+    Logger::info("Thread pool: {} workers{}", pool.workers,
+                 settings.pool.cpus.empty() ? "" : " on CPUs " + settings.pool.cpus);
+    return std::make_unique<ThreadPool>(pool);
+}
+
+// One camera's encoder and link when [cameras] lists several devices
+struct CameraStream {
+    EncoderConfig encoderConfig;
+    std::vector<PixelFormat> encoderFormats;
+    std::optional<FormatPlan> plan; // settled by the camera's first frame
+    std::unique_ptr<Encoder> encoder;
+    std::unique_ptr<Sender> sender;
+    MjpegPassthrough passthrough;
+    MjpegDecoder decoder{PixelFormat::I420};
+    EncodeSteps steps;
+};
+
+// The first frame shows which format the camera settled on, and the
+// encoder is opened for it then. MultiCamera encodes one frame of a camera
+// at a time, so the stream needs no lock.
+EncodeResult encode_camera_frame(uint32_t index, CameraStream& stream, const Frame& frame)
+{
+    if (!stream.plan) {
+        stream.plan = planFormatPath(frame.format(), stream.encoderConfig.codec, stream.encoderFormats);
+        Logger::info("Camera {} format: {}", index, describeFormatPlan(*stream.plan));
+        if (stream.plan->path != FormatPath::Passthrough) {
+            stream.encoderConfig.input_format = stream.plan->encoder_input;
+            stream.encoder = std::make_unique<Encoder>(stream.encoderConfig);
+            if (!stream.encoder->init()) {
+                Logger::error("Cannot open the encoder for camera {}", index);
+                stream.encoder.reset();
+            }
+        }
+    }
+
+    if (stream.plan->path == FormatPath::Passthrough) {
+        return stream.passthrough.process(frame);
+    }
+    if (!stream.encoder) {
+        return std::nullopt;
+    }
+    if (stream.plan->path == FormatPath::Decode) {
+        LazyFrame lazy(frame, [&](const Frame& jpeg) { return stream.decoder.decode(jpeg); });
+        const Frame* pixels = lazy.pixels();
+        return pixels ? encode_frame(*stream.encoder, stream.steps, *pixels) : std::nullopt;
+    }
+    return encode_frame(*stream.encoder, stream.steps, frame);
+}
+
+void log_camera_stats(const MultiCamera& cameras)
+{
+    for (uint32_t i = 0; i < cameras.cameraCount(); ++i) {
+        const CameraStats s = cameras.stats(i);
+        Logger::info("camera {} ({}): {:.1f} fps, {} captured, {} dropped, {} read failures, {} encoded, "
+                     "{} failed, {} skipped, latency p50 {:.1f} ms p99 {:.1f} ms",
+                     i, s.name, s.fps, s.captured, s.dropped, s.readFailures, s.encoded, s.encodeFailures, s.skipped,
+                     s.latencyP50Us / 1000.0, s.latencyP99Us / 1000.0);
+    }
+}
+
+// Several [cameras] devices: one capture thread each, the shared encode
+// workers, and one encoder and Sender per camera, camera i on
+// sender.port + i. Until SIGINT/SIGTERM; returns the exit status.
+int run_cameras(const config::Config& settings, const std::vector<config::CameraConfig>& cameras,
+                MemoryBudget& memory)
+{
+    if (!settings.recorder.directory.empty() || !settings.events.directory.empty() ||
+        !settings.snapshot.path.empty() || settings.slo.enabled) {
+        Logger::warn("Recording, event clips, snapshots and the SLO loop follow a single camera; "
+                     "not running them for {} cameras", cameras.size());
+    }
+
+    const std::unique_ptr<ThreadPool> pool = make_pool(settings);
+    std::vector<std::unique_ptr<CameraStream>> streams;
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        auto stream = std::make_unique<CameraStream>();
+        stream->encoderConfig = make_encoder_config(settings);
+        stream->encoderConfig.pool = pool.get();
+        stream->steps = make_encode_steps(settings, pool.get());
+        stream->encoderFormats = Encoder::inputFormats(stream->encoderConfig);
+        const int port = settings.sender.port + static_cast<int>(i);
+        stream->sender = std::make_unique<Sender>(settings.sender.dest_ip, port, &memory.account("sender-queue"),
+                                                  static_cast<size_t>(settings.sender.queue_kb) * 1024);
+        if (!stream->sender->start()) {
+            Logger::error("Cannot connect to receiver {}:{}", settings.sender.dest_ip, port);
+            return EXIT_FAILURE;
+        }
+        streams.push_back(std::move(stream));
+    }
+
+    MultiCamera multi({
+        .queue_depth = static_cast<size_t>(settings.cameras.queue_depth),
+        .encode_workers = static_cast<size_t>(settings.cameras.encode_workers),
+    }, [&](uint32_t camera, const Frame& frame) {
+        return encode_camera_frame(camera, *streams[camera], frame);
+    }, [&](uint32_t camera, EncodedFrame&& frame) {
+        CameraStream& stream = *streams[camera];
+        if (!stream.sender->enqueueFrame(std::move(frame.data), frame.keyframe) && stream.encoder) {
+            stream.encoder->requestKeyframe();
+        }
+    });
+    for (size_t i = 0; i < cameras.size(); ++i) {
+        const CodecType codec = streams[i]->encoderConfig.codec;
+        auto source = makeCaptureSource(cameras[i], capturePreferences(codec, streams[i]->encoderFormats), &memory);
+        if (!source) {
+            Logger::error("Cannot open capture device {}", cameras[i].device);
+            return EXIT_FAILURE;
+        }
+        multi.addCamera(std::move(source), cameras[i].capture_cpu);
+    }
+    if (!multi.start()) {
+        return EXIT_FAILURE;
+    }
+
+    const auto statsInterval = std::chrono::milliseconds(settings.pipeline.stats_interval_ms);
+    auto nextReport = std::chrono::steady_clock::now() + statsInterval;
+    while (!g_stopRequested.load()) {
+        std::this_thread::sleep_for(kPollInterval);
+        if (statsInterval.count() > 0 && std::chrono::steady_clock::now() >= nextReport) {
+            log_camera_stats(multi);
+            nextReport += statsInterval;
+        }
+    }
+
+    multi.stop();
+    if (statsInterval.count() > 0) {
+        log_camera_stats(multi);
+    }
+    for (auto& stream : streams) {
+        stream->sender->stop();
+    }
+    return EXIT_SUCCESS;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Logger::init("pi-camera-streamer.log");
+    install_signal_handlers();
+
+    // The config file comes first so flags given with it override it
+    std::string configPath;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (std::string(argv[i]) == "--config") {
+            configPath = argv[i + 1];
+        }
+    }
+    config::Config settings;
+    if (!configPath.empty()) {
+        auto loaded = config::read_config(configPath);
+        if (!loaded) {
+            return EXIT_FAILURE;
+        }
+        settings = *loaded;
+        Logger::setLevel(settings.log.level);
+        if (settings.log.async) {
+            // No other thread logs yet, so the logger can be swapped here
+            Logger::shutdown();
+            Logger::init("pi-camera-streamer.log", settings.log.level, {
+                .async = true,
+                .queue_size = static_cast<size_t>(settings.log.queue_size),
+                .overflow = settings.log.overflow == "overrun" ? LogOverflow::OverrunOldest : LogOverflow::Block,
+            });
+        }
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return EXIT_SUCCESS;
+        }
+        if (arg == "--realtime") {
+            settings.pipeline.realtime = true;
+            continue;
+        }
+        if (arg == "--lock-memory") {
+            settings.pipeline.lock_memory = true;
+            continue;
+        }
+        if (!value) {
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+
+        if (arg == "--config") { /* read above */ }
+        else if (arg == "--dest-ip") settings.sender.dest_ip = value;
+        else if (arg == "--port") settings.sender.port = std::atoi(value);
+        else if (arg == "--device") settings.camera.device = value;
+        else if (arg == "--codec") settings.encoder.codec = std::string(value) == "mjpeg" ? "mjpeg" : "h264";
+        else if (arg == "--width") settings.camera.width = std::atoi(value);
+        else if (arg == "--height") settings.camera.height = std::atoi(value);
+        else if (arg == "--fps") settings.camera.fps = std::atoi(value);
+        else if (arg == "--record") settings.recorder.directory = value;
+        else if (arg == "--capture-cpus" || arg == "--encode-cpus" || arg == "--send-cpus") {
+            if (!parseCpuList(value)) {
+                Logger::error("Bad CPU list '{}' for {}", value, arg);
+                return EXIT_FAILURE;
+            }
+            std::string& cpus = arg == "--capture-cpus" ? settings.pipeline.capture_cpus
+                              : arg == "--encode-cpus"  ? settings.pipeline.encode_cpus
+                                                        : settings.pipeline.send_cpus;
+            cpus = value;
+        }
+        else {
+            Logger::error("Unknown option {}", arg);
+            print_usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        ++i;
+    }
+
+    if (settings.pipeline.lock_memory || settings.pipeline.realtime) {
+        lockProcessMemory();
+    }
+
+    // Every frame queue and pool charges this, so memory is bounded in
+    // bytes whatever the resolution; declared first, it outlives them all
+    MemoryBudget memory({
+        .limit_bytes = static_cast<size_t>(settings.memory.limit_mb) * 1024 * 1024,
+        .defer_at = settings.memory.defer_at,
+        .shed_at = settings.memory.shed_at,
+    });
+
+    // Several [cameras] devices share encode workers instead of one pipeline
+    const std::vector<config::CameraConfig> cameras = config::camera_list(settings);
+    if (cameras.size() > 1) {
+        const int status = run_cameras(settings, cameras, memory);
+        if (status == EXIT_SUCCESS) {
+            Logger::info("Shut down cleanly");
+        }
+        Logger::shutdown();
+        return status;
+    }
+    settings.camera = cameras.front();
+
+    const config::CameraConfig& camera = settings.camera;
+    EncoderConfig encoderConfig = make_encoder_config(settings);
+    const CodecType codec = encoderConfig.codec;
+
+    // Startup steps that don't depend on each other run side by side: the
+    // receiver connection and the encoder open on their own threads while
+    // this one opens the camera. The encoder is opened for the format the
+    // camera is asked for first, and reopened if it settles on another.
+    const auto startupBegin = std::chrono::steady_clock::now();
+    const std::vector<PixelFormat> encoderFormats = Encoder::inputFormats(encoderConfig);
+    const std::vector<PixelFormat> preferences = capturePreferences(codec, encoderFormats);
+    const FormatPlan expected =
+        planFormatPath(preferences.empty() ? PixelFormat::Unknown : preferences.front(), codec, encoderFormats);
+
+    const std::string& destIp = settings.sender.dest_ip;
+    const int port = settings.sender.port;
+    Sender sender(destIp, port, &memory.account("sender-queue"),
+                  static_cast<size_t>(settings.sender.queue_kb) * 1024);
+
+    // Declared before the encoder, which converts on it
+    const std::unique_ptr<ThreadPool> pool = make_pool(settings);
+    encoderConfig.pool = pool.get();
+    encoderConfig.input_format = expected.encoder_input;
+    Encoder encoder(encoderConfig);
+
+    std::future<bool> connected = std::async(std::launch::async, [&] { return sender.start(); });
+    std::future<bool> encoderOpened;
+    if (expected.path != FormatPath::Passthrough) {
+        encoderOpened = std::async(std::launch::async, [&] { return encoder.init(); });
+    }
+
+    auto source = makeCaptureSource(camera, preferences, &memory);
+    const bool captureStarted = source && source->start();
+    const bool receiverConnected = connected.get();
+    bool encoderReady = encoderOpened.valid() && encoderOpened.get();
+    if (!captureStarted) {
+        Logger::error("Cannot open capture device {}", camera.device);
+        return EXIT_FAILURE;
+    }
+    if (!receiverConnected) {
+        Logger::error("Cannot connect to receiver {}:{}", destIp, port);
+        return EXIT_FAILURE;
+    }
+
+    const CaptureFormat format = source->captureFormat();
+    const FormatPlan plan = planFormatPath(format.pixel_format, codec, encoderFormats);
+    Logger::info("Capture format: {}", describeFormatPlan(plan));
+
+    if (plan.path != FormatPath::Passthrough) {
+        if (plan.encoder_input != encoderConfig.input_format) {
+            // An open encoder switches to the reopened one at the first
+            // frame, as an IDR; an unopened one just takes the new format
+            encoderConfig.input_format = plan.encoder_input;
+            encoderReady = encoder.reconfigure(encoderConfig) && encoderReady;
+        }
+        if (!encoderReady && !encoder.init()) {
+            Logger::error("Cannot open the encoder");
+            return EXIT_FAILURE;
+        }
+    } else if (encoderReady) {
+        encoder.close(); // the camera's JPEGs go out as they are
+    }
+
+    // Local recording runs alongside the live stream and never holds it up
+    std::unique_ptr<Recorder> recorder;
+    if (!settings.recorder.directory.empty()) {
+        if (codec != CodecType::H264) {
+            Logger::warn("Recording needs the h264 codec; not recording");
+        } else {
+            RecorderConfig recorderConfig = make_recorder_config(settings);
+            recorderConfig.memory = &memory.account("recorder-queue");
+            recorder = std::make_unique<Recorder>(recorderConfig);
+            if (!recorder->start()) {
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // The last few seconds of packets, saved as a clip on SIGUSR1
+    std::unique_ptr<GopRing> preEvent;
+    MemoryCharge preEventCharge;
+    if (!settings.events.directory.empty()) {
+        const size_t ringBytes = static_cast<size_t>(settings.events.buffer_kb) * 1024;
+        if (codec != CodecType::H264) {
+            Logger::warn("Event clips need the h264 codec; not buffering");
+        } else if (!(preEventCharge = MemoryCharge::take(&memory.account("pre-event"), ringBytes,
+                                                         MemoryPriority::Required))) {
+            Logger::warn("Event buffer of {} KiB exceeds the memory budget; not buffering",
+                         settings.events.buffer_kb);
+        } else {
+            preEvent = std::make_unique<GopRing>(GopRingConfig{.budget_bytes = ringBytes});
+        }
+    }
+
+    MjpegPassthrough passthrough;
+    MjpegDecoder decoder(PixelFormat::I420);
+    Pipeline::EncodeFn encode;
+
+    // Scene filter and quality map; only the encode thread touches them
+    EncodeSteps steps;
+    if (plan.path != FormatPath::Passthrough) {
+        steps = make_encode_steps(settings, pool.get());
+    }
+
+    if (plan.path == FormatPath::Passthrough) {
+        encode = [&](const Frame& frame) { return passthrough.process(frame); };
+    } else if (plan.path == FormatPath::Decode) {
+        encode = [&](const Frame& frame) -> EncodeResult {
+            LazyFrame lazy(frame, [&](const Frame& jpeg) { return decoder.decode(jpeg); });
+            const Frame* pixels = lazy.pixels();
+            return pixels ? encode_frame(encoder, steps, *pixels) : std::nullopt;
+        };
+    } else {
+        encode = [&](const Frame& frame) { return encode_frame(encoder, steps, frame); };
+    }
+
+    // The latest frame is kept for stills; JPEGs are only made on SIGUSR2
+    std::unique_ptr<SnapshotService> snapshots;
+    if (!settings.snapshot.path.empty()) {
+        snapshots = std::make_unique<SnapshotService>(make_snapshot_encoder());
+    }
+
+    PipelineConfig pipelineConfig = make_pipeline_config(settings);
+    pipelineConfig.control_interval = std::chrono::milliseconds(settings.slo.interval_ms);
+    pipelineConfig.memory = &memory;
+    Pipeline pipeline(std::move(source), std::move(encode), [&](EncodedFrame&& frame) {
+        if (recorder) {
+            recorder->push(frame);
+        }
+        if (preEvent) {
+            preEvent->append(frame);
+        }
+        return sender.enqueueFrame(std::move(frame.data), frame.keyframe);
+    }, pipelineConfig);
+    if (plan.path != FormatPath::Passthrough) {
+        pipeline.setKeyframeRequest([&] { encoder.requestKeyframe(); });
+    }
+    if (snapshots) {
+        pipeline.setFrameTap([&](Frame&& frame) { snapshots->publish(std::move(frame)); });
+    }
+    if (!pipeline.start()) {
+        return EXIT_FAILURE;
+    }
+    Logger::info("Started in {} ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+                                         std::chrono::steady_clock::now() - startupBegin).count());
+
+    // The running settings are the config file's hot keys with the SLO
+    // controller's quality level on top; either can change them, from the
+    // watcher thread and the control loop respectively
+    std::mutex tuningMtx;
+    config::Config live = settings;
+    QualityLevel quality;
+    const bool encoding = plan.path != FormatPath::Passthrough;
+    auto retune = [&] {
+        pipeline.reconfigure(make_pipeline_config(live, quality));
+        if (encoding) {
+            EncoderConfig retuned = encoder.config();
+            retuned.bitrate = static_cast<int>(live.encoder.bitrate * quality.bitrate_scale);
+            retuned.width = scaled_dimension(settings.camera.width, quality.resolution_scale);
+            retuned.height = scaled_dimension(settings.camera.height, quality.resolution_scale);
+            encoder.reconfigure(retuned);
+        }
+    };
+
+    // Tuning changes in the config file apply without interrupting the stream
+    std::unique_ptr<ConfigWatcher> watcher;
+    if (!configPath.empty()) {
+        watcher = std::make_unique<ConfigWatcher>(configPath, settings, [&](const config::Config& next) {
+            std::lock_guard<std::mutex> lock(tuningMtx);
+            Logger::setLevel(next.log.level);
+            live = next;
+            retune();
+        });
+        watcher->start();
+    }
+
+    // Step quality down when latency, queues, CPU or the link fall behind
+    std::function<void()> control;
+    std::unique_ptr<SloController> slo;
+    ProcessCpuMeter cpu;
+    if (settings.slo.enabled) {
+        SloConfig sloConfig = make_slo_config(settings);
+        if (!encoding) {
+            // Passthrough forwards the camera's JPEGs: only the frame rate can give
+            sloConfig.bitrate_steps = {1.0};
+            sloConfig.resolution_steps = {1.0};
+        }
+        slo = std::make_unique<SloController>(sloConfig, [&](const QualityLevel& level) {
+            std::lock_guard<std::mutex> lock(tuningMtx);
+            quality = level;
+            retune();
+        });
+    }
+    if (slo || preEvent || snapshots) {
+        control = [&] {
+            if (slo) {
+                const PipelineLoad load = pipeline.load();
+                slo->update({load.latencyP99Us, load.queueFill, cpu.sample(), sender.backlogBytes()});
+            }
+            if (preEvent && g_clipRequested.exchange(false)) {
+                // Written here on the main thread: while the clip is pinned
+                // only the ring waits, capture and send carry on
+                saveClip(preEvent->clipLast(std::chrono::seconds(settings.events.pre_event_seconds)),
+                         event_clip_path(settings.events.directory));
+            }
+            if (snapshots && g_snapshotRequested.exchange(false)) {
+                const auto snapshot = snapshots->take(static_cast<uint32_t>(settings.snapshot.width),
+                                                      static_cast<uint32_t>(settings.snapshot.height));
+                if (snapshot) {
+                    write_snapshot(*snapshot, settings.snapshot.path);
+                }
+            }
+        };
+    }
+
+    pipeline.run(g_stopRequested, control);
+    watcher.reset();
+    recorder.reset();
+    preEvent.reset();
+    sender.stop();
+    Logger::info("Shut down cleanly");
+    Logger::shutdown();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,201 @@
+#include "memory_budget.hpp"
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <spdlog/fmt/fmt.h>
+
+namespace pcs {
+
+namespace {
+
+constexpr double kMiB = 1024.0 * 1024.0;
+
+} // namespace
+
+const char* memoryPressureName(MemoryPressure pressure) noexcept
+{
+    switch (pressure) {
+        case MemoryPressure::Normal: return "normal";
+        case MemoryPressure::Deferring: return "deferring";
+        case MemoryPressure::Shedding: return "shedding";
+        case MemoryPressure::Exhausted: return "exhausted";
+    }
+    return "unknown";
+}
+
+// ============================================================================
+// MemoryAccount
+// ============================================================================
+
+MemoryAccount::MemoryAccount(MemoryBudget& budget, std::string name)
+    : budget_(budget)
+    , name_(std::move(name))
+{
+}
+
+bool MemoryAccount::tryCharge(size_t bytes, MemoryPriority priority)
+{
+    if (!budget_.reserve(bytes, priority)) {
+        refused_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    const size_t used = used_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t peak = peak_.load(std::memory_order_relaxed);
+    while (used > peak && !peak_.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+void MemoryAccount::release(size_t bytes) noexcept
+{
+    used_.fetch_sub(bytes, std::memory_order_relaxed);
+    budget_.unreserve(bytes);
+}
+
+// ============================================================================
+// MemoryCharge
+// ============================================================================
+
+MemoryCharge MemoryCharge::take(MemoryAccount* account, size_t bytes, MemoryPriority priority)
+{
+    MemoryCharge charge;
+    if (!account) {
+        charge.granted_ = true;
+    } else if (account->tryCharge(bytes, priority)) {
+        charge.account_ = account;
+        charge.bytes_ = bytes;
+        charge.granted_ = true;
+    }
+    return charge;
+}
+
+MemoryCharge::MemoryCharge(MemoryCharge&& other) noexcept
+    : account_(std::exchange(other.account_, nullptr))
+    , bytes_(std::exchange(other.bytes_, 0))
+    , granted_(std::exchange(other.granted_, false))
+{
+}
+
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        account_ = std::exchange(other.account_, nullptr);
+        bytes_ = std::exchange(other.bytes_, 0);
+        granted_ = std::exchange(other.granted_, false);
+    }
+    return *this;
+}
+
+void MemoryCharge::reset() noexcept
+{
+    if (account_) {
+        account_->release(bytes_);
+    }
+    account_ = nullptr;
+    bytes_ = 0;
+    granted_ = false;
+}
+
+// ============================================================================
+// MemoryBudget
+// ============================================================================
+
+MemoryBudget::MemoryBudget(const MemoryBudgetConfig& config)
+    : config_(config)
+{
+}
+
+MemoryAccount& MemoryBudget::account(const std::string& name)
+{
+    std::lock_guard<std::mutex> lock(accountsMtx_);
+    for (const auto& account : accounts_) {
+        if (account->name() == name) {
+            return *account;
+        }
+    }
+    accounts_.push_back(std::unique_ptr<MemoryAccount>(new MemoryAccount(*this, name)));
+    return *accounts_.back();
+}
+
+MemoryPressure MemoryBudget::pressure() noexcept
+{
+    if (exhausted_.exchange(false, std::memory_order_relaxed)) {
+        return MemoryPressure::Exhausted;
+    }
+    const size_t current = used();
+    if (current > ceiling(MemoryPriority::Droppable)) {
+        return MemoryPressure::Shedding;
+    }
+    if (current > ceiling(MemoryPriority::Deferrable)) {
+        return MemoryPressure::Deferring;
+    }
+    return MemoryPressure::Normal;
+}
+
+std::vector<MemoryUsage> MemoryBudget::usage() const
+{
+    std::lock_guard<std::mutex> lock(accountsMtx_);
+    std::vector<MemoryUsage> usage;
+    usage.reserve(accounts_.size());
+    for (const auto& account : accounts_) {
+        usage.push_back({account->name(), account->used(), account->peak(), account->refused()});
+    }
+    return usage;
+}
+
+// Highest total a charge at `priority` may bring usage to
+size_t MemoryBudget::ceiling(MemoryPriority priority) const noexcept
+{
+    if (config_.limit_bytes == 0) {
+        return std::numeric_limits<size_t>::max();
+    }
+    const auto fraction = [&](double share) {
+        return static_cast<size_t>(static_cast<double>(config_.limit_bytes) * std::clamp(share, 0.0, 1.0));
+    };
+    switch (priority) {
+        case MemoryPriority::Deferrable: return fraction(config_.defer_at);
+        case MemoryPriority::Droppable: return fraction(config_.shed_at);
+        case MemoryPriority::Required: break;
+    }
+    return config_.limit_bytes;
+}
+
+bool MemoryBudget::reserve(size_t bytes, MemoryPriority priority) noexcept
+{
+    const size_t limit = ceiling(priority);
+    size_t current = used_.load(std::memory_order_relaxed);
+    do {
+        if (bytes > limit || current > limit - bytes) {
+            if (priority == MemoryPriority::Required) {
+                exhausted_.store(true, std::memory_order_relaxed);
+            }
+            return false;
+        }
+    } while (!used_.compare_exchange_weak(current, current + bytes, std::memory_order_relaxed));
+    return true;
+}
+
+void MemoryBudget::unreserve(size_t bytes) noexcept
+{
+    used_.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+std::string describeMemoryUsage(const MemoryBudget& budget, MemoryPressure pressure)
+{
+    std::string text = budget.limit() > 0
+                           ? fmt::format("{:.1f}/{:.1f} MiB", budget.used() / kMiB, budget.limit() / kMiB)
+                           : fmt::format("{:.1f} MiB, no limit", budget.used() / kMiB);
+    text += fmt::format(" ({})", memoryPressureName(pressure));
+    const char* separator = ": ";
+    for (const MemoryUsage& account : budget.usage()) {
+        text += fmt::format("{}{} {:.1f} MiB", separator, account.name, account.used / kMiB);
+        if (account.refused > 0) {
+            text += fmt::format(" ({} refused)", account.refused);
+        }
+        separator = ", ";
+    }
+    return text;
+}
+
+} // namespace pcs
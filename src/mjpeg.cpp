@@ -0,0 +1,109 @@
+#include "mjpeg.hpp"
+#include "logger.hpp"
+#include <chrono>
+
+namespace pcs {
+
+namespace {
+
+constexpr int64_t kClockRate = 90000; // matches the Encoder's time base
+
+} // namespace
+
+size_t jpegImageLength(std::span<const uint8_t> data) noexcept
+{
+    // SOI followed by the first marker of the header
+    if (data.size() < 4 || data[0] != 0xFF || data[1] != 0xD8 || data[2] != 0xFF) {
+        return 0;
+    }
+
+    size_t end = data.size();
+    while (end > 4 && data[end - 1] == 0x00) {
+        --end;
+    }
+    if (data[end - 2] != 0xFF || data[end - 1] != 0xD9) {
+        return 0;
+    }
+    return end;
+}
+
+// ============================================================================
+// MjpegPassthrough
+// ============================================================================
+
+MjpegPassthrough::MjpegPassthrough(size_t maxFrameBytes)
+    : maxFrameBytes_(maxFrameBytes)
+{
+}
+
+std::optional<EncodedFrame> MjpegPassthrough::process(const Frame& frame)
+{
+    if (!frame.isCompressed()) {
+        ++rejected_;
+        return std::nullopt;
+    }
+
+    const std::span<const uint8_t> bytes = frame.bytes();
+    const size_t limit = maxFrameBytes_ ? maxFrameBytes_
+                                        : static_cast<size_t>(frame.width()) * frame.height() * 3;
+    const size_t length = jpegImageLength(bytes);
+    if (length == 0 || (limit != 0 && length > limit)) {
+        ++rejected_;
+        Logger::debug("MJPEG passthrough: dropping corrupt frame ({} bytes)", bytes.size());
+        return std::nullopt;
+    }
+
+    if (!epoch_) {
+        epoch_ = frame.timestamp();
+    }
+    auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+        frame.timestamp() - *epoch_).count();
+    int64_t pts = elapsedUs * kClockRate / 1000000;
+    if (pts <= lastPts_) {
+        pts = lastPts_ + 1;
+    }
+    lastPts_ = pts;
+
+    EncodedFrame out;
+    out.data.assign(bytes.begin(), bytes.begin() + static_cast<std::ptrdiff_t>(length));
+    out.pts = pts;
+    out.dts = pts;
+    out.keyframe = true;
+
+    ++passed_;
+    bytes_ += length;
+    return out;
+}
+
+// ============================================================================
+// LazyFrame
+// ============================================================================
+
+LazyFrame::LazyFrame(Frame captured, Decoder decoder)
+    : captured_(std::move(captured))
+    , decoder_(std::move(decoder))
+{
+}
+
+const Frame* LazyFrame::pixels()
+{
+    if (!captured_.isCompressed()) {
+        return captured_.empty() ? nullptr : &captured_;
+    }
+    if (decoded_) {
+        return &*decoded_;
+    }
+    if (failed_ || !decoder_) {
+        return nullptr;
+    }
+
+    decoded_ = decoder_(captured_);
+    if (!decoded_) {
+        failed_ = true; // don't retry a broken image for every consumer
+        return nullptr;
+    }
+    decoded_->setTimestamp(captured_.timestamp());
+    return &*decoded_;
+}
+
+} // namespace pcs
@@ -0,0 +1,128 @@
+#include "mjpeg_decoder.hpp"
+#include "logger.hpp"
+#include <chrono>
+#include <cstring>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+#include <libswscale/swscale.h>
+}
+
+namespace pcs {
+
+namespace {
+
+AVPixelFormat output_format(PixelFormat format)
+{
+    switch (format) {
+    case PixelFormat::Gray8: return AV_PIX_FMT_GRAY8;
+    case PixelFormat::I420:  return AV_PIX_FMT_YUV420P;
+    case PixelFormat::BGR24: return AV_PIX_FMT_BGR24;
+    default:                 return AV_PIX_FMT_NONE;
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+MjpegDecoder::MjpegDecoder(PixelFormat output)
+    : output_(output)
+{
+}
+
+MjpegDecoder::~MjpegDecoder()
+{
+    if (swsCtx_) {
+        sws_freeContext(swsCtx_);
+    }
+    if (avFrame_) {
+        av_frame_free(&avFrame_);
+    }
+    if (avPacket_) {
+        av_packet_free(&avPacket_);
+    }
+    if (ctx_) {
+        avcodec_free_context(&ctx_);
+    }
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+std::optional<Frame> MjpegDecoder::decode(const Frame& jpeg)
+{
+    const AVPixelFormat dstFormat = output_format(output_);
+    if (!jpeg.isCompressed() || jpeg.size() == 0 || dstFormat == AV_PIX_FMT_NONE) {
+        return std::nullopt;
+    }
+    if (!ctx_ && !open()) {
+        return std::nullopt;
+    }
+
+    packet_.resize(jpeg.size() + AV_INPUT_BUFFER_PADDING_SIZE);
+    std::memcpy(packet_.data(), jpeg.bytes().data(), jpeg.size());
+    std::memset(packet_.data() + jpeg.size(), 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    avPacket_->data = packet_.data();
+    avPacket_->size = static_cast<int>(jpeg.size());
+
+    if (avcodec_send_packet(ctx_, avPacket_) < 0 || avcodec_receive_frame(ctx_, avFrame_) < 0) {
+        PCS_LOG_EVERY(spdlog::level::debug, std::chrono::seconds(1), "MJPEG decoder: corrupt image ({} bytes)",
+                      jpeg.size());
+        return std::nullopt;
+    }
+
+    const int width = avFrame_->width;
+    const int height = avFrame_->height;
+    Frame probe(std::vector<uint8_t>(), static_cast<uint32_t>(width), static_cast<uint32_t>(height), output_);
+    std::vector<uint8_t> pixels(probe.expectedSize());
+
+    uint8_t* planes[4] = {};
+    int strides[4] = {};
+    av_image_fill_arrays(planes, strides, pixels.data(), dstFormat, width, height, 1);
+
+    swsCtx_ = sws_getCachedContext(swsCtx_, width, height, static_cast<AVPixelFormat>(avFrame_->format),
+                                   width, height, dstFormat,
+                                   SWS_FAST_BILINEAR, nullptr, nullptr, nullptr);
+    if (!swsCtx_) {
+        av_frame_unref(avFrame_);
+        return std::nullopt;
+    }
+    sws_scale(swsCtx_, avFrame_->data, avFrame_->linesize, 0, height, planes, strides);
+    av_frame_unref(avFrame_);
+
+    ++decoded_;
+    Frame out(std::move(pixels), static_cast<uint32_t>(width), static_cast<uint32_t>(height), output_);
+    out.setTimestamp(jpeg.timestamp());
+    return out;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+bool MjpegDecoder::open()
+{
+    const AVCodec* codec = avcodec_find_decoder(AV_CODEC_ID_MJPEG);
+    if (!codec) {
+        Logger::error("MJPEG decoder: libavcodec has no MJPEG decoder");
+        return false;
+    }
+
+    ctx_ = avcodec_alloc_context3(codec);
+    avFrame_ = av_frame_alloc();
+    avPacket_ = av_packet_alloc();
+    if (!ctx_ || !avFrame_ || !avPacket_ || avcodec_open2(ctx_, codec, nullptr) < 0) {
+        Logger::error("MJPEG decoder: failed to open");
+        avcodec_free_context(&ctx_);
+        return false;
+    }
+    return true;
+}
+
+} // namespace pcs
@@ -0,0 +1,219 @@
+#include "multi_camera.hpp"
+#include "logger.hpp"
+#include "thread_config.hpp"
+#include <algorithm>
+
+namespace pcs {
+
+namespace {
+
+// Back-off after a failed read, so a finished or unplugged source doesn't spin
+constexpr auto kRetryDelay = std::chrono::milliseconds(10);
+
+} // namespace
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+MultiCamera::MultiCamera(const MultiCameraConfig& config, EncodeFn encode, SinkFn sink)
+    : config_(config)
+    , encode_(std::move(encode))
+    , sink_(std::move(sink))
+{
+}
+
+MultiCamera::~MultiCamera()
+{
+    stop();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+uint32_t MultiCamera::addCamera(std::unique_ptr<CaptureSource> source, int cpu)
+{
+    auto camera = std::make_unique<Camera>();
+    camera->source = std::move(source);
+    camera->cpu = cpu;
+    cameras_.push_back(std::move(camera));
+    return static_cast<uint32_t>(cameras_.size() - 1);
+}
+
+bool MultiCamera::start()
+{
+    if (running_) {
+        return true;
+    }
+    if (cameras_.empty()) {
+        Logger::error("MultiCamera: no cameras configured");
+        return false;
+    }
+
+    for (size_t i = 0; i < cameras_.size(); ++i) {
+        if (!cameras_[i]->source->start()) {
+            Logger::error("MultiCamera: camera {} ({}) failed to start", i, cameras_[i]->source->name());
+            for (size_t j = 0; j < i; ++j) {
+                cameras_[j]->source->stop();
+            }
+            return false;
+        }
+    }
+
+    size_t workers = config_.encode_workers;
+    if (workers == 0) {
+        workers = std::min<size_t>(cameras_.size(), std::max(1u, std::thread::hardware_concurrency()));
+    }
+
+    queue_ = std::make_unique<Buffer<CameraFrame>>(config_.queue_depth);
+    epoch_ = std::chrono::steady_clock::now();
+    running_ = true;
+
+    for (size_t i = 0; i < workers; ++i) {
+        workers_.emplace_back([this, i] {
+            applyThreadConfig({.name = "pcs-enc" + std::to_string(i)});
+            encode_loop();
+        });
+    }
+    for (uint32_t i = 0; i < cameras_.size(); ++i) {
+        Camera& camera = *cameras_[i];
+        camera.nextToEncode = 0;
+        camera.thread = std::thread(&MultiCamera::capture_loop, this, i);
+
+        CaptureFormat format = camera.source->captureFormat();
+        Logger::info("Camera {}: {} {}x{} {} @ {} fps{}", i, camera.source->name(), format.width,
+                     format.height, pixelFormatName(format.pixel_format), format.fps,
+                     camera.cpu >= 0 ? ", capture on CPU " + std::to_string(camera.cpu) : "");
+    }
+    Logger::info("MultiCamera: {} cameras, {} encode workers, queue depth {}",
+                 cameras_.size(), workers, queue_->capacity());
+    return true;
+}
+
+void MultiCamera::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    for (auto& camera : cameras_) {
+        if (camera->thread.joinable()) {
+            camera->thread.join();
+        }
+    }
+
+    // Workers finish the frames already queued, then see the closed queue
+    queue_->close();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    for (auto& camera : cameras_) {
+        camera->source->stop();
+    }
+    stoppedAt_ = std::chrono::steady_clock::now();
+}
+
+CameraStats MultiCamera::stats(uint32_t index) const
+{
+    CameraStats stats;
+    if (index >= cameras_.size()) {
+        return stats;
+    }
+
+    const Camera& camera = *cameras_[index];
+    stats.name = camera.source->name();
+    stats.captured = camera.captured.load();
+    stats.dropped = camera.dropped.load();
+    stats.readFailures = camera.readFailures.load();
+    stats.encoded = camera.encoded.load();
+    stats.encodeFailures = camera.encodeFailures.load();
+    stats.skipped = camera.skipped.load();
+    stats.latencyP50Us = camera.latency.percentile(50);
+    stats.latencyP99Us = camera.latency.percentile(99);
+
+    if (epoch_ != Frame::Timestamp{}) {
+        const auto end = running_ ? std::chrono::steady_clock::now() : stoppedAt_;
+        const double seconds = std::chrono::duration<double>(end - epoch_).count();
+        if (seconds > 0.0) {
+            stats.fps = static_cast<double>(stats.captured) / seconds;
+        }
+    }
+    return stats;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void MultiCamera::capture_loop(uint32_t index)
+{
+    Camera& camera = *cameras_[index];
+    ThreadConfig thread;
+    thread.name = "pcs-cap" + std::to_string(index);
+    if (camera.cpu >= 0) {
+        thread.cpus.push_back(camera.cpu);
+    }
+    ThreadReport report = applyThreadConfig(thread);
+    if (!report.ok()) {
+        Logger::warn("Camera {}: {}", index, describeThreadReport(report));
+    }
+
+    uint64_t sequence = 0;
+    while (running_) {
+        CameraFrame item;
+        if (!camera.source->read(item.frame)) {
+            camera.readFailures.fetch_add(1, std::memory_order_relaxed);
+            std::this_thread::sleep_for(kRetryDelay);
+            continue;
+        }
+        camera.captured.fetch_add(1, std::memory_order_relaxed);
+
+        // A timestamp from the future can only come from a source on another clock
+        const auto now = std::chrono::steady_clock::now();
+        if (item.frame.timestamp() > now) {
+            item.frame.setTimestamp(now);
+        }
+
+        item.camera = index;
+        item.sequence = sequence;
+        if (queue_->tryPush(item)) {
+            ++sequence;
+        } else {
+            camera.dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void MultiCamera::encode_loop()
+{
+    while (auto item = queue_->pop()) {
+        Camera& camera = *cameras_[item->camera];
+
+        // Frames of one camera leave the queue in order; make sure they are
+        // also encoded in order when two workers pick up neighbours.
+        std::unique_lock<std::mutex> lock(camera.encodeMtx);
+        camera.turn.wait(lock, [&] { return camera.nextToEncode == item->sequence; });
+
+        EncodeResult result = encode_(item->camera, item->frame);
+        if (result.skipped) {
+            camera.skipped.fetch_add(1, std::memory_order_relaxed);
+        } else if (auto& encoded = result.frame) {
+            const auto latency = std::chrono::steady_clock::now() - item->frame.timestamp();
+            camera.latency.record(static_cast<uint64_t>(std::max<int64_t>(0,
+                std::chrono::duration_cast<std::chrono::microseconds>(latency).count())));
+            camera.encoded.fetch_add(1, std::memory_order_relaxed);
+            sink_(item->camera, std::move(*encoded));
+        } else {
+            camera.encodeFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        ++camera.nextToEncode;
+        lock.unlock();
+        camera.turn.notify_all();
+    }
+}
+
+} // namespace pcs
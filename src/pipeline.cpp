@@ -0,0 +1,491 @@
+#include "pipeline.hpp"
+#include "logger.hpp"
+#include "synthetic_source.hpp"
+#include "v4l2_capture.hpp"
+#include <algorithm>
+#include <latch>
+
+namespace pcs {
+
+namespace {
+
+// Back-off after a failed read, so a finished or unplugged source doesn't spin
+constexpr auto kRetryDelay = std::chrono::milliseconds(10);
+// How often run() checks for a stop request
+constexpr auto kPollInterval = std::chrono::milliseconds(100);
+
+uint64_t micros_since(Frame::Timestamp then)
+{
+    auto elapsed = std::chrono::steady_clock::now() - then;
+    return static_cast<uint64_t>(std::max<int64_t>(
+        0, std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count()));
+}
+
+// Stamp a stage's first frame; each stage has one thread, so no race
+void mark_first(std::atomic<int64_t>& first)
+{
+    if (first.load(std::memory_order_relaxed) == 0) {
+        first.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+    }
+}
+
+std::optional<std::chrono::steady_clock::time_point> first_time(const std::atomic<int64_t>& first)
+{
+    const int64_t ticks = first.load(std::memory_order_relaxed);
+    if (ticks == 0) {
+        return std::nullopt;
+    }
+    return std::chrono::steady_clock::time_point(std::chrono::steady_clock::duration(ticks));
+}
+
+std::optional<TestPattern> parse_pattern(const std::string& name)
+{
+    if (name.empty() || name == "bars") return TestPattern::ColorBars;
+    if (name == "gradient") return TestPattern::Gradient;
+    if (name == "noise") return TestPattern::Noise;
+    if (name == "timestamp") return TestPattern::Timestamp;
+    return std::nullopt;
+}
+
+} // namespace
+
+std::unique_ptr<CaptureSource> makeCaptureSource(const config::CameraConfig& camera,
+                                                 const std::vector<PixelFormat>& formats,
+                                                 MemoryBudget* memory)
+{
+    const std::string kSynthetic = "synthetic";
+    if (camera.device.compare(0, kSynthetic.size(), kSynthetic) == 0) {
+        const std::string rest = camera.device.substr(kSynthetic.size());
+        auto pattern = parse_pattern(rest.empty() ? rest : rest.substr(1));
+        if (!pattern || (!rest.empty() && rest[0] != ':')) {
+            Logger::error("Unknown synthetic source '{}'", camera.device);
+            return nullptr;
+        }
+
+        SyntheticConfig config;
+        config.width = static_cast<uint32_t>(camera.width);
+        config.height = static_cast<uint32_t>(camera.height);
+        config.fps = static_cast<uint32_t>(camera.fps);
+        config.pattern = *pattern;
+        config.memory = memory ? &memory->account("frame-pool") : nullptr;
+        auto raw = std::find_if(formats.begin(), formats.end(),
+                                [](PixelFormat f) { return f != PixelFormat::MJPEG; });
+        if (raw != formats.end()) {
+            config.format = *raw;
+        }
+        return std::make_unique<SyntheticSource>(config);
+    }
+
+    V4l2Config config;
+    config.device = camera.device;
+    config.width = static_cast<uint32_t>(camera.width);
+    config.height = static_cast<uint32_t>(camera.height);
+    config.fps = static_cast<uint32_t>(camera.fps);
+    if (!formats.empty()) {
+        config.formats = formats;
+    }
+    return std::make_unique<V4l2Capture>(config);
+}
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+Pipeline::Pipeline(std::unique_ptr<CaptureSource> source, EncodeFn encode, SendFn send,
+                   const PipelineConfig& config)
+    : source_(std::move(source))
+    , encode_(std::move(encode))
+    , send_(std::move(send))
+    , config_(config)
+    , captured_(config.capture_queue)
+    , encoded_(config.send_queue)
+    , fpsCap_(config.fps_cap)
+    , dropPolicy_(config.drop_policy)
+{
+    if (config.memory) {
+        captureMemory_ = &config.memory->account("capture-queue");
+        encodedMemory_ = &config.memory->account("encoded-queue");
+    }
+    if (source_) {
+        scheduler_ = std::make_unique<CaptureScheduler>(*source_, pacing_for(config.fps_cap));
+    }
+}
+
+Pipeline::~Pipeline()
+{
+    stop();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool Pipeline::start()
+{
+    if (started_) {
+        return running_;
+    }
+    if (!source_ || !source_->start()) {
+        Logger::error("Pipeline: capture source failed to start");
+        return false;
+    }
+
+    started_ = true;
+    running_ = true;
+    windowStart_ = std::chrono::steady_clock::now();
+
+    // Each thread configures itself, then reports back before doing any work
+    threadReports_.assign(3, ThreadReport{});
+    std::latch configured(3);
+    auto launch = [&](size_t index, const ThreadConfig& config, void (Pipeline::*loop)()) {
+        return std::thread([this, index, &config, &configured, loop] {
+            threadReports_[index] = applyThreadConfig(config);
+            configured.count_down();
+            (this->*loop)();
+        });
+    };
+    sendThread_ = launch(2, config_.send_thread, &Pipeline::send_loop);
+    encodeThread_ = launch(1, config_.encode_thread, &Pipeline::encode_loop);
+    captureThread_ = launch(0, config_.capture_thread, &Pipeline::capture_loop);
+    configured.wait();
+
+    const CaptureFormat format = source_->captureFormat();
+    Logger::info("Pipeline started: {} {}x{} {} @ {} fps, queues {}/{}", source_->name(),
+                 format.width, format.height, pixelFormatName(format.pixel_format), format.fps,
+                 captured_.capacity(), encoded_.capacity());
+    for (const ThreadReport& report : threadReports_) {
+        if (report.ok()) {
+            Logger::info("  thread {}", describeThreadReport(report));
+        } else {
+            Logger::warn("  thread {}", describeThreadReport(report));
+        }
+    }
+    return true;
+}
+
+void Pipeline::stop()
+{
+    if (!running_.exchange(false)) {
+        return;
+    }
+
+    // Front to back: each stage drains its input, then closes its output
+    if (captureThread_.joinable()) {
+        captureThread_.join();
+    }
+    if (encodeThread_.joinable()) {
+        encodeThread_.join();
+    }
+    if (sendThread_.joinable()) {
+        sendThread_.join();
+    }
+    source_->stop();
+    Logger::info("Pipeline stopped");
+}
+
+void Pipeline::reconfigure(const PipelineConfig& config)
+{
+    captured_.setCapacity(config.capture_queue);
+    encoded_.setCapacity(config.send_queue);
+    fpsCap_ = config.fps_cap;
+    dropPolicy_ = config.drop_policy;
+    Logger::info("Pipeline retuned: queues {}/{}, fps cap {}, drop {}", captured_.capacity(),
+                 encoded_.capacity(), config.fps_cap > 0.0 ? std::to_string(config.fps_cap) : "off",
+                 dropPolicyName(config.drop_policy));
+}
+
+void Pipeline::run(const std::atomic<bool>& stopRequested, const std::function<void()>& control)
+{
+    auto nextReport = std::chrono::steady_clock::now() + config_.stats_interval;
+    auto nextControl = std::chrono::steady_clock::now() + config_.control_interval;
+    const auto poll = control ? std::min<std::chrono::milliseconds>(kPollInterval, config_.control_interval)
+                              : kPollInterval;
+    bool firstFrameLogged = false;
+    while (!stopRequested.load() && !captureDone_.load()) {
+        std::this_thread::sleep_for(poll);
+        const auto now = std::chrono::steady_clock::now();
+        if (!firstFrameLogged && firstSent_.load(std::memory_order_relaxed) != 0) {
+            log_first_frame();
+            firstFrameLogged = true;
+        }
+        if (config_.stats_interval.count() > 0 && now >= nextReport) {
+            logStats();
+            nextReport += config_.stats_interval;
+        }
+        if (control && now >= nextControl) {
+            control();
+            nextControl = now + config_.control_interval;
+        }
+    }
+
+    stop();
+    if (!firstFrameLogged && firstSent_.load(std::memory_order_relaxed) != 0) {
+        log_first_frame();
+    }
+    if (config_.stats_interval.count() > 0) {
+        logStats();
+    }
+}
+
+std::vector<StageStats> Pipeline::report()
+{
+    const auto now = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(now - windowStart_).count();
+    windowStart_ = now;
+
+    // The scheduler times every frame it reads, including those it drops
+    if (scheduler_) {
+        captureStage_.latency.merge(scheduler_->latency());
+    }
+
+    std::vector<StageStats> stats;
+    for (Stage* stage : {&captureStage_, &encodeStage_, &sendStage_}) {
+        const uint64_t frames = stage->frames.load();
+        const uint64_t dropped = stage->dropped.load();
+        const uint64_t skipped = stage->skipped.load();
+
+        StageStats s;
+        s.name = stage->name;
+        s.frames = frames - stage->reportedFrames;
+        s.dropped = dropped - stage->reportedDropped;
+        s.skipped = skipped - stage->reportedSkipped;
+        s.fps = seconds > 0.0 ? static_cast<double>(s.frames) / seconds : 0.0;
+        s.latencyP50Us = stage->latency.percentile(50);
+        s.latencyP99Us = stage->latency.percentile(99);
+        s.latencyMaxUs = stage->latency.max();
+        stats.push_back(std::move(s));
+
+        stage->reportedFrames = frames;
+        stage->reportedDropped = dropped;
+        stage->reportedSkipped = skipped;
+        stage->latency.reset();
+    }
+    if (scheduler_) {
+        stats.front().pacing = report_pacing();
+    }
+    return stats;
+}
+
+void Pipeline::logStats()
+{
+    for (const StageStats& s : report()) {
+        Logger::info("{:>7}: {:6.1f} fps, {} frames, {} dropped, {} skipped, latency p50 {:.1f} ms p99 {:.1f} ms max {:.1f} ms",
+                     s.name, s.fps, s.frames, s.dropped, s.skipped, s.latencyP50Us / 1000.0,
+                     s.latencyP99Us / 1000.0, s.latencyMaxUs / 1000.0);
+        if (s.pacing) {
+            const PacingStats& p = *s.pacing;
+            Logger::info("{:>7}: jitter p50 {:.1f} ms p99 {:.1f} ms max {:.1f} ms, {} late, {} early, {} missed deadlines",
+                         "pacing", p.jitterP50Us / 1000.0, p.jitterP99Us / 1000.0, p.jitterMaxUs / 1000.0,
+                         p.late, p.early, p.missed);
+        }
+    }
+    if (config_.memory) {
+        const MemoryPressure pressure = config_.memory->pressure();
+        const std::string usage = describeMemoryUsage(*config_.memory, pressure);
+        if (pressure == MemoryPressure::Normal) {
+            Logger::info("{:>7}: {}", "memory", usage);
+        } else {
+            Logger::warn("{:>7}: {}", "memory", usage);
+        }
+    }
+}
+
+PipelineLoad Pipeline::load()
+{
+    auto fill = [](size_t size, size_t capacity) {
+        return capacity > 0 ? static_cast<double>(size) / static_cast<double>(capacity) : 0.0;
+    };
+
+    PipelineLoad load;
+    load.latencyP99Us = controlLatency_.percentile(99);
+    load.queueFill = std::max(fill(captured_.size(), captured_.capacity()),
+                              fill(encoded_.size(), encoded_.capacity()));
+    controlLatency_.reset();
+    return load;
+}
+
+FirstFrameTimes Pipeline::firstFrame() const
+{
+    return {first_time(firstCaptured_), first_time(firstEncoded_), first_time(firstSent_)};
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void Pipeline::log_first_frame() const
+{
+    const FirstFrameTimes first = firstFrame();
+    const auto origin = processStartTime();
+    auto since = [&](const std::optional<std::chrono::steady_clock::time_point>& time) {
+        return time ? std::chrono::duration<double, std::milli>(*time - origin).count() : 0.0;
+    };
+    Logger::info("Time to first frame: captured {:.0f} ms, encoded {:.0f} ms, sent {:.0f} ms after process start",
+                 since(first.captured), since(first.encoded), since(first.sent));
+}
+
+// Without a cap the scheduler still sheds stale frames and measures jitter
+// against the camera's own rate, but decimates nothing
+PacingConfig Pipeline::pacing_for(double fpsCap) const
+{
+    PacingConfig pacing;
+    pacing.fps = fpsCap;
+    pacing.latency_budget = config_.capture_budget;
+    pacing.decimate = fpsCap > 0.0;
+    return pacing;
+}
+
+// The scheduler's drops, since its previous report, out of the counters it
+// keeps for the whole run
+PacingStats Pipeline::report_pacing()
+{
+    PacingStats now;
+    now.late = scheduler_->droppedLate();
+    now.early = scheduler_->droppedEarly();
+    now.missed = scheduler_->missedDeadlines();
+
+    PacingStats window;
+    window.jitterP50Us = scheduler_->jitter().percentile(50);
+    window.jitterP99Us = scheduler_->jitter().percentile(99);
+    window.jitterMaxUs = scheduler_->jitter().max();
+    window.late = now.late - reportedPacing_.late;
+    window.early = now.early - reportedPacing_.early;
+    window.missed = now.missed - reportedPacing_.missed;
+    reportedPacing_ = now;
+    scheduler_->resetHistograms();
+    return window;
+}
+
+void Pipeline::capture_loop()
+{
+    uint64_t frames = 0;
+    uint64_t skipped = 0;
+    double fpsCap = config_.fps_cap;
+    while (running_ && (config_.max_frames == 0 || frames < config_.max_frames)) {
+        // reconfigure() may have moved the cap; only this thread touches the scheduler
+        const double cap = fpsCap_.load(std::memory_order_relaxed);
+        if (cap != fpsCap) {
+            scheduler_->setPacing(pacing_for(cap));
+            fpsCap = cap;
+        }
+
+        Frame frame;
+        const bool got = scheduler_->read(frame);
+
+        // Frames the scheduler dropped as stale or over the cap were still captured
+        const uint64_t paced = scheduler_->droppedLate() + scheduler_->droppedEarly();
+        if (paced != skipped) {
+            frames += paced - skipped;
+            captureStage_.frames.fetch_add(paced - skipped, std::memory_order_relaxed);
+            captureStage_.dropped.fetch_add(paced - skipped, std::memory_order_relaxed);
+            skipped = paced;
+        }
+        if (!got) {
+            std::this_thread::sleep_for(kRetryDelay);
+            continue;
+        }
+        ++frames;
+        mark_first(firstCaptured_);
+        captureStage_.frames.fetch_add(1, std::memory_order_relaxed);
+
+        // External frames are charged to their pool; only owned bytes count
+        // here. Past shed_at this is refused even for those, and capture
+        // drops the frame before anything downstream has to fail.
+        const size_t owned = frame.isExternal() ? 0 : frame.size();
+        Captured item{std::move(frame), MemoryCharge::take(captureMemory_, owned, MemoryPriority::Droppable)};
+        size_t lost = 1;
+        if (item.charge) {
+            if (dropPolicy_.load(std::memory_order_relaxed) == DropPolicy::Oldest) {
+                lost = captured_.pushEvictOldest(std::move(item));
+            } else {
+                lost = captured_.tryPush(item) ? 0 : 1;
+            }
+        }
+        if (lost > 0) {
+            captureStage_.dropped.fetch_add(lost, std::memory_order_relaxed);
+        }
+    }
+
+    captured_.close();
+    captureDone_ = true;
+}
+
+void Pipeline::encode_loop()
+{
+    bool droppingGop = false; // an encoded frame was lost; skip to a keyframe
+    while (auto item = captured_.pop()) {
+        const auto start = std::chrono::steady_clock::now();
+        EncodeResult result = encode_(item->frame);
+        const uint64_t encodeUs = micros_since(start);
+        encodeStage_.latency.record(encodeUs);
+
+        const Frame::Timestamp captured = item->frame.timestamp();
+        if (tap_) {
+            tap_(std::move(item->frame));
+        }
+        item.reset();
+        if (result.skipped) {
+            encodeStage_.skipped.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        std::optional<EncodedFrame>& encoded = result.frame;
+        if (!encoded) {
+            encodeStage_.dropped.fetch_add(1, std::memory_order_relaxed);
+            PCS_LOG_EVERY(spdlog::level::debug, std::chrono::seconds(1), "Encode: frame dropped after {} us", encodeUs);
+            continue;
+        }
+        PCS_LOG_TRACE("Encode: {} bytes{} in {} us", encoded->data.size(), encoded->keyframe ? " (keyframe)" : "",
+                      encodeUs);
+
+        // Refused only when the budget is exhausted: the last resort
+        MemoryCharge charge;
+        if (!droppingGop || encoded->keyframe) {
+            charge = MemoryCharge::take(encodedMemory_, encoded->data.size(), MemoryPriority::Required);
+        }
+        if (!charge) {
+            encodeStage_.dropped.fetch_add(1, std::memory_order_relaxed);
+            if (!droppingGop && keyframeRequest_) {
+                keyframeRequest_();
+            }
+            droppingGop = true;
+            continue;
+        }
+        droppingGop = false;
+        encodeStage_.frames.fetch_add(1, std::memory_order_relaxed);
+        mark_first(firstEncoded_);
+
+        encoded_.push(Encoded{std::move(*encoded), captured, std::move(charge)});
+    }
+    encoded_.close();
+}
+
+void Pipeline::send_loop()
+{
+    while (auto item = encoded_.pop()) {
+        if (send_(std::move(item->frame))) {
+            sendStage_.frames.fetch_add(1, std::memory_order_relaxed);
+            mark_first(firstSent_);
+            const uint64_t latency = micros_since(item->captured);
+            sendStage_.latency.record(latency);
+            controlLatency_.record(latency);
+        } else {
+            // The sender skips to the next keyframe itself; ask for one now
+            sendStage_.dropped.fetch_add(1, std::memory_order_relaxed);
+            PCS_LOG_EVERY(spdlog::level::debug, std::chrono::seconds(1), "Send: frame refused by the sender");
+            if (keyframeRequest_) {
+                keyframeRequest_();
+            }
+        }
+    }
+}
+
+const char* dropPolicyName(DropPolicy policy) noexcept
+{
+    switch (policy) {
+        case DropPolicy::Newest: return "newest";
+        case DropPolicy::Oldest: return "oldest";
+    }
+    return "unknown";
+}
+
+} // namespace pcs
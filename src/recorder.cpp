@@ -0,0 +1,391 @@
+#include "recorder.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <latch>
+#include <optional>
+#include <unistd.h>
+
+namespace pcs {
+
+namespace {
+
+// O_DIRECT needs buffer address, file offset and length aligned to the
+// logical block size; a page covers every block size in use
+constexpr size_t kAlignment = 4096;
+constexpr int64_t kTicksPerSecond = 90000;
+// How long the writer sleeps when there is nothing to write and no sync due
+constexpr auto kIdleWait = std::chrono::milliseconds(500);
+
+size_t round_up(size_t size, size_t alignment)
+{
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+std::string wall_clock_stamp()
+{
+    const std::time_t now = std::time(nullptr);
+    std::tm local{};
+    localtime_r(&now, &local);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y%m%d-%H%M%S", &local);
+    return text;
+}
+
+} // namespace
+
+void Recorder::AlignedFree::operator()(uint8_t* p) const noexcept
+{
+    std::free(p);
+}
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+Recorder::Recorder(const RecorderConfig& config)
+    : config_(config)
+{
+}
+
+Recorder::~Recorder()
+{
+    stop();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool Recorder::start()
+{
+    if (started_) {
+        return false;
+    }
+    if (::access(config_.directory.c_str(), W_OK) != 0) {
+        Logger::error("Recorder: cannot write to {}: {}", config_.directory, std::strerror(errno));
+        return false;
+    }
+
+    batchCapacity_ = round_up(std::max(config_.write_batch, kAlignment), kAlignment);
+    void* memory = nullptr;
+    if (posix_memalign(&memory, kAlignment, batchCapacity_) != 0) {
+        Logger::error("Recorder: cannot allocate a {} byte write buffer", batchCapacity_);
+        return false;
+    }
+    batch_.reset(static_cast<uint8_t*>(memory));
+    std::memset(batch_.get(), 0, batchCapacity_); // prefault before the first segment
+    direct_ = config_.direct_io;
+    started_ = true;
+
+    std::latch configured(1);
+    writer_ = std::thread([this, &configured] {
+        threadReport_ = applyThreadConfig(config_.writer_thread);
+        configured.count_down();
+        writer_loop();
+    });
+    configured.wait();
+
+    Logger::info("Recording to {}: {} s segments, {} KiB queue, {} KiB writes{}", config_.directory,
+                 config_.segment_duration.count(), config_.queue_bytes / 1024, batchCapacity_ / 1024,
+                 direct_ ? ", O_DIRECT" : "");
+    return true;
+}
+
+void Recorder::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMtx_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    queueCv_.notify_all();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+
+    if (started_) {
+        const RecorderStats s = stats();
+        Logger::info("Recorder stopped: {} frames in {} segments ({} bytes), {} frames / {} GOPs dropped, "
+                     "{} write errors, slowest write {:.1f} ms",
+                     s.framesWritten, s.segments, s.bytesWritten, s.framesDropped, s.gopsDropped,
+                     s.writeErrors, s.maxWriteUs / 1000.0);
+    }
+}
+
+bool Recorder::push(const EncodedFrame& frame)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMtx_);
+        if (stopping_) {
+            return false;
+        }
+
+        // Once a frame is lost, the rest of its GOP references it: skip to
+        // the next keyframe rather than write frames that can't be decoded
+        bool fits = queuedBytes_ + frame.data.size() <= config_.queue_bytes;
+        if (fits && (!droppingGop_ || frame.keyframe) && config_.memory) {
+            // Past defer_at the budget refuses: recording gives way first
+            fits = config_.memory->tryCharge(frame.data.size(), MemoryPriority::Deferrable);
+        }
+        if (!fits || (droppingGop_ && !frame.keyframe)) {
+            std::lock_guard<std::mutex> statsLock(statsMtx_);
+            stats_.framesDropped++;
+            if (!fits && (!droppingGop_ || frame.keyframe)) {
+                stats_.gopsDropped++;
+            }
+            droppingGop_ = true;
+            return false;
+        }
+
+        droppingGop_ = false;
+        queue_.push_back(frame);
+        queuedBytes_ += frame.data.size();
+    }
+    queueCv_.notify_one();
+    return true;
+}
+
+RecorderStats Recorder::stats() const
+{
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    return stats_;
+}
+
+std::string Recorder::currentSegment() const
+{
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    return segmentPath_;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void Recorder::writer_loop()
+{
+    const auto wait = config_.sync_interval.count() > 0 ? std::min<std::chrono::milliseconds>(
+                                                              config_.sync_interval, kIdleWait)
+                                                        : kIdleWait;
+    for (;;) {
+        std::optional<EncodedFrame> frame;
+        {
+            std::unique_lock<std::mutex> lock(queueMtx_);
+            queueCv_.wait_for(lock, wait, [this] { return stopping_ || !queue_.empty(); });
+            if (!queue_.empty()) {
+                frame = std::move(queue_.front());
+                queue_.pop_front();
+            } else if (stopping_) {
+                break;
+            }
+        }
+
+        if (frame) {
+            write_frame(*frame);
+            // Counted until written, so a stalled disk fills the queue
+            std::lock_guard<std::mutex> lock(queueMtx_);
+            queuedBytes_ -= frame->data.size();
+            if (config_.memory) {
+                config_.memory->release(frame->data.size());
+            }
+        }
+
+        if (fd_ >= 0 && config_.sync_interval.count() > 0 &&
+            std::chrono::steady_clock::now() - lastSync_ >= config_.sync_interval) {
+            if (flush_batch(false)) {
+                sync_segment();
+            }
+        }
+    }
+    close_segment();
+}
+
+void Recorder::write_frame(const EncodedFrame& frame)
+{
+    if (frame.keyframe) {
+        const int64_t elapsed = frame.pts - segmentStartPts_;
+        // A pts going backwards means the encoder restarted: start afresh too
+        if (fd_ < 0 || elapsed < 0 || elapsed >= config_.segment_duration.count() * kTicksPerSecond) {
+            close_segment();
+            if (open_segment()) {
+                segmentStartPts_ = frame.pts;
+            }
+        }
+    }
+    if (fd_ < 0) {
+        // No segment (an open or write failed): wait for a keyframe to retry
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.framesDropped++;
+        return;
+    }
+
+    muxed_.clear();
+    muxer_.writeFrame(frame, muxed_);
+    size_t offset = 0;
+    while (offset < muxed_.size() && fd_ >= 0) {
+        const size_t take = std::min(batchCapacity_ - batchSize_, muxed_.size() - offset);
+        std::memcpy(batch_.get() + batchSize_, muxed_.data() + offset, take);
+        batchSize_ += take;
+        offset += take;
+        if (batchSize_ == batchCapacity_) {
+            flush_batch(false);
+        }
+    }
+    if (fd_ >= 0) {
+        segmentBytes_ += muxed_.size();
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.framesWritten++;
+    }
+}
+
+bool Recorder::open_segment()
+{
+    const std::string path = config_.directory + "/" + config_.prefix + "-" + wall_clock_stamp() + "-" +
+                             std::to_string(segmentIndex_++) + ".ts";
+    const int flags = O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC;
+    fd_ = ::open(path.c_str(), flags | (direct_ ? O_DIRECT : 0), 0644);
+    if (fd_ < 0 && direct_ && errno == EINVAL) {
+        // tmpfs and some FUSE filesystems refuse O_DIRECT
+        Logger::warn("Recorder: O_DIRECT not supported in {}; using buffered writes", config_.directory);
+        direct_ = false;
+        fd_ = ::open(path.c_str(), flags, 0644);
+    }
+    if (fd_ < 0) {
+        Logger::error("Recorder: cannot create {}: {}", path, std::strerror(errno));
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.writeErrors++;
+        return false;
+    }
+
+    // Reserve the segment's blocks up front so it stays contiguous; the
+    // file's size only grows as data is written
+    if (config_.preallocate_bytes > 0 &&
+        ::fallocate(fd_, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(config_.preallocate_bytes)) != 0) {
+        Logger::debug("Recorder: fallocate on {} failed: {}", path, std::strerror(errno));
+    }
+
+    muxer_ = TsMuxer{};
+    batchSize_ = 0;
+    segmentBytes_ = 0;
+    lastSync_ = std::chrono::steady_clock::now();
+    {
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        stats_.segments++;
+        segmentPath_ = path;
+    }
+    Logger::info("Recording segment {}", path);
+    return true;
+}
+
+void Recorder::close_segment()
+{
+    if (fd_ < 0) {
+        return;
+    }
+    flush_batch(true);
+    if (fd_ < 0) {
+        return; // the final write failed and dropped the segment
+    }
+
+    // Drop the unused preallocation and any O_DIRECT padding
+    if (::ftruncate(fd_, static_cast<off_t>(segmentBytes_)) != 0) {
+        Logger::warn("Recorder: cannot trim {}: {}", currentSegment(), std::strerror(errno));
+    }
+    sync_segment();
+    ::close(fd_);
+    fd_ = -1;
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    Logger::info("Closed segment {} ({} bytes)", segmentPath_, segmentBytes_);
+    segmentPath_.clear();
+}
+
+// With O_DIRECT only whole blocks can be written: the tail stays in the
+// batch unless `final`, when it is padded out (and trimmed off by close).
+bool Recorder::flush_batch(bool final)
+{
+    if (fd_ < 0 || batchSize_ == 0) {
+        return fd_ >= 0;
+    }
+
+    size_t length = batchSize_;
+    if (direct_) {
+        if (final) {
+            length = round_up(batchSize_, kAlignment);
+            std::memset(batch_.get() + batchSize_, 0, length - batchSize_);
+        } else {
+            length = batchSize_ / kAlignment * kAlignment;
+        }
+    }
+    if (length == 0) {
+        return true;
+    }
+
+    if (!write_fully(batch_.get(), length)) {
+        // Give up on this segment; the next keyframe opens a fresh one
+        ::close(fd_);
+        fd_ = -1;
+        batchSize_ = 0;
+        std::lock_guard<std::mutex> lock(statsMtx_);
+        Logger::error("Recorder: abandoned segment {} after a write error", segmentPath_);
+        segmentPath_.clear();
+        return false;
+    }
+
+    const size_t kept = batchSize_ > length ? batchSize_ - length : 0;
+    std::memmove(batch_.get(), batch_.get() + length, kept);
+    batchSize_ = kept;
+    return true;
+}
+
+bool Recorder::write_fully(const uint8_t* data, size_t size)
+{
+    const auto start = std::chrono::steady_clock::now();
+    size_t done = 0;
+    while (done < size) {
+        const ssize_t n = ::write(fd_, data + done, size - done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::error("Recorder: write failed: {}", std::strerror(errno));
+            std::lock_guard<std::mutex> lock(statsMtx_);
+            stats_.writeErrors++;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    record_io_time(start);
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_.bytesWritten += size;
+    return true;
+}
+
+void Recorder::sync_segment()
+{
+    const auto start = std::chrono::steady_clock::now();
+    if (::fdatasync(fd_) != 0) {
+        Logger::warn("Recorder: fdatasync failed: {}", std::strerror(errno));
+    }
+    record_io_time(start);
+    lastSync_ = std::chrono::steady_clock::now();
+
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_.syncs++;
+}
+
+void Recorder::record_io_time(std::chrono::steady_clock::time_point start)
+{
+    const auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    std::lock_guard<std::mutex> lock(statsMtx_);
+    stats_.maxWriteUs = std::max<uint64_t>(stats_.maxWriteUs, static_cast<uint64_t>(us.count()));
+}
+
+} // namespace pcs
@@ -0,0 +1,306 @@
+#include "replay_source.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+namespace pcs {
+
+namespace {
+
+// Readahead window per MJPEG frame, whose size is not known in advance
+constexpr size_t kMjpegReadaheadBytes = 256 * 1024;
+
+const uint8_t* find_marker(const uint8_t* begin, const uint8_t* end, uint8_t marker)
+{
+    const uint8_t pattern[2] = {0xFF, marker};
+    return static_cast<const uint8_t*>(
+        ::memmem(begin, static_cast<size_t>(end - begin), pattern, sizeof(pattern)));
+}
+
+} // namespace
+
+struct ReplaySource::Mapping {
+    const uint8_t* data{nullptr};
+    size_t size{0};
+
+    ~Mapping()
+    {
+        if (data) {
+            ::munmap(const_cast<uint8_t*>(data), size);
+        }
+    }
+};
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+ReplaySource::ReplaySource(const ReplayConfig& config)
+    : config_(config)
+{
+}
+
+ReplaySource::~ReplaySource()
+{
+    stop();
+}
+
+// ============================================================================
+// CaptureSource
+// ============================================================================
+
+bool ReplaySource::start()
+{
+    if (running_) {
+        return true;
+    }
+
+    Frame probe(std::vector<uint8_t>(), config_.width, config_.height, config_.format);
+    if (config_.format == PixelFormat::Unknown || config_.fps == 0 ||
+        (!probe.isCompressed() && probe.expectedSize() == 0)) {
+        Logger::error("Replay {}: unsupported mode {}x{} {} @ {} fps", config_.path, config_.width,
+                      config_.height, pixelFormatName(config_.format), config_.fps);
+        return false;
+    }
+    frameBytes_ = probe.expectedSize();
+
+    int fd = ::open(config_.path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::error("Replay: cannot open {}: {}", config_.path, std::strerror(errno));
+        return false;
+    }
+
+    struct stat st{};
+    if (::fstat(fd, &st) < 0 || st.st_size == 0) {
+        Logger::error("Replay {}: empty or unreadable file", config_.path);
+        ::close(fd);
+        return false;
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    void* address = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (address == MAP_FAILED) {
+        Logger::error("Replay {}: mmap failed: {}", config_.path, std::strerror(errno));
+        return false;
+    }
+    ::madvise(address, size, MADV_SEQUENTIAL);
+
+    auto mapping = std::make_shared<Mapping>();
+    mapping->data = static_cast<const uint8_t*>(address);
+    mapping->size = size;
+    mapping_ = std::move(mapping);
+
+    if (frameBytes_ != 0) {
+        if (size < frameBytes_) {
+            Logger::error("Replay {}: file smaller than one {}x{} {} frame", config_.path,
+                          config_.width, config_.height, pixelFormatName(config_.format));
+            mapping_.reset();
+            return false;
+        }
+        if (size % frameBytes_ != 0) {
+            Logger::warn("Replay {}: ignoring {} trailing bytes", config_.path, size % frameBytes_);
+        }
+    }
+
+    if (!load_timestamps()) {
+        mapping_.reset();
+        return false;
+    }
+
+    period_ = std::chrono::nanoseconds(1'000'000'000LL / config_.fps);
+    offset_ = 0;
+    advised_ = 0;
+    index_ = 0;
+    loopBase_ = std::chrono::nanoseconds(0);
+    finished_ = false;
+    start_ = std::chrono::steady_clock::now();
+    running_ = true;
+    advise_ahead(0);
+
+    if (frameBytes_ != 0) {
+        Logger::info("Replay {}: {} frames {}x{} {}{}, {}", config_.path, size / frameBytes_,
+                     config_.width, config_.height, pixelFormatName(config_.format),
+                     timestamps_.empty() ? "" : " with recorded timestamps",
+                     config_.pacing == Pacing::RealTime ? "real-time" : "max speed");
+    } else {
+        Logger::info("Replay {}: {} bytes of {}x{} MJPEG{}, {}", config_.path, size,
+                     config_.width, config_.height,
+                     timestamps_.empty() ? "" : " with recorded timestamps",
+                     config_.pacing == Pacing::RealTime ? "real-time" : "max speed");
+    }
+    return true;
+}
+
+void ReplaySource::stop()
+{
+    running_ = false;
+    mapping_.reset(); // frames still viewing the file keep it mapped
+}
+
+bool ReplaySource::read(Frame& frame)
+{
+    if (!running_ || finished_) {
+        return false;
+    }
+
+    size_t begin = 0, length = 0;
+    if (!next_frame(begin, length)) {
+        if (!config_.loop || index_ == 0) {
+            finished_ = true;
+            return false;
+        }
+
+        // Continue the timeline one frame after the last one of this pass
+        loopBase_ += frame_time(index_);
+        offset_ = 0;
+        advised_ = 0;
+        index_ = 0;
+        ++loops_;
+        if (!next_frame(begin, length)) {
+            finished_ = true;
+            return false;
+        }
+    }
+
+    Frame::Timestamp stamp = std::chrono::steady_clock::now();
+    if (config_.pacing == Pacing::RealTime) {
+        Frame::Timestamp due = start_ + loopBase_ + frame_time(index_);
+        if (stamp < due) {
+            std::this_thread::sleep_until(due);
+        }
+        stamp = due;
+    }
+    advise_ahead(offset_);
+
+    frame = Frame(std::shared_ptr<const uint8_t>(mapping_, mapping_->data + begin), length,
+                  config_.width, config_.height, config_.format);
+    frame.setTimestamp(stamp);
+
+    ++index_;
+    ++read_;
+    return true;
+}
+
+CaptureFormat ReplaySource::captureFormat() const
+{
+    return {config_.width, config_.height, config_.fps, config_.format};
+}
+
+std::string ReplaySource::name() const
+{
+    return "replay:" + std::filesystem::path(config_.path).filename().string();
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+bool ReplaySource::load_timestamps()
+{
+    timestamps_.clear();
+    if (config_.timestamps_path.empty()) {
+        return true;
+    }
+
+    std::ifstream in(config_.timestamps_path);
+    if (!in) {
+        Logger::error("Replay: cannot open timestamps {}", config_.timestamps_path);
+        return false;
+    }
+
+    std::string line;
+    double first = 0.0, previous = 0.0;
+    while (std::getline(in, line)) {
+        auto pos = line.find_first_not_of(" \t\r");
+        if (pos == std::string::npos || line[pos] == '#') {
+            continue;
+        }
+
+        char* end = nullptr;
+        double ms = std::strtod(line.c_str() + pos, &end);
+        if (end == line.c_str() + pos) {
+            Logger::error("Replay {}: bad timestamp line '{}'", config_.timestamps_path, line);
+            return false;
+        }
+
+        if (timestamps_.empty()) {
+            first = ms;
+        } else if (ms < previous) {
+            ms = previous; // never let time run backwards
+        }
+        previous = ms;
+        timestamps_.push_back(std::chrono::nanoseconds(static_cast<int64_t>((ms - first) * 1e6)));
+    }
+    return true;
+}
+
+bool ReplaySource::next_frame(size_t& begin, size_t& length)
+{
+    const size_t size = mapping_->size;
+
+    if (frameBytes_ != 0) {
+        if (offset_ + frameBytes_ > size) {
+            return false;
+        }
+        begin = offset_;
+        length = frameBytes_;
+        offset_ += frameBytes_;
+        return true;
+    }
+
+    // MJPEG: one image runs from SOI (FF D8) to the following EOI (FF D9)
+    const uint8_t* data = mapping_->data;
+    const uint8_t* soi = find_marker(data + offset_, data + size, 0xD8);
+    if (!soi) {
+        return false;
+    }
+    const uint8_t* eoi = find_marker(soi + 2, data + size, 0xD9);
+    if (!eoi) {
+        return false; // truncated last image
+    }
+
+    begin = static_cast<size_t>(soi - data);
+    length = static_cast<size_t>(eoi + 2 - soi);
+    offset_ = begin + length;
+    return true;
+}
+
+std::chrono::nanoseconds ReplaySource::frame_time(uint64_t index) const
+{
+    if (index < timestamps_.size()) {
+        return timestamps_[index];
+    }
+    if (!timestamps_.empty()) {
+        return timestamps_.back() + period_ * (index - (timestamps_.size() - 1));
+    }
+    return period_ * index;
+}
+
+// Ask the kernel to start reading the next few frames before we touch them
+void ReplaySource::advise_ahead(size_t position)
+{
+    const size_t size = mapping_->size;
+    const size_t window = config_.readahead_frames * (frameBytes_ ? frameBytes_ : kMjpegReadaheadBytes);
+    const size_t end = std::min(size, position + window);
+    if (end <= advised_) {
+        return;
+    }
+
+    static const size_t kPage = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    const size_t from = std::max(position, advised_) / kPage * kPage;
+    ::madvise(const_cast<uint8_t*>(mapping_->data) + from, end - from, MADV_WILLNEED);
+    advised_ = end;
+}
+
+} // namespace pcs
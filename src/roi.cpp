@@ -0,0 +1,250 @@
+#include "roi.hpp"
+#include "scene_filter.hpp" // sum_abs_diff
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace pcs {
+
+namespace {
+
+// Block rows scored per pool task; a 1080p frame gives about 17 tasks
+constexpr size_t kBlockRowsPerTask = 4;
+
+int8_t clamp_offset(int offset) noexcept
+{
+    return static_cast<int8_t>(std::clamp(offset, -QualityMap::kMaxOffset, QualityMap::kMaxOffset));
+}
+
+} // namespace
+
+std::optional<std::vector<Rect>> parseRectList(const std::string& text)
+{
+    std::vector<Rect> rects;
+    size_t pos = 0;
+    while (text.find_first_not_of(' ', pos) != std::string::npos) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        Rect rect;
+        int used = 0;
+        if (std::sscanf(item.c_str(), " %ux%u+%u+%u %n", &rect.width, &rect.height, &rect.x, &rect.y, &used) != 4 ||
+            static_cast<size_t>(used) != item.size() || rect.width == 0 || rect.height == 0) {
+            return std::nullopt;
+        }
+        rects.push_back(rect);
+    }
+    return rects;
+}
+
+// ============================================================================
+// QualityMap
+// ============================================================================
+
+QualityMap::QualityMap(uint32_t frameWidth, uint32_t frameHeight)
+    : frameWidth_(frameWidth),
+      frameHeight_(frameHeight),
+      cols_((frameWidth + kBlockSize - 1) / kBlockSize),
+      rows_((frameHeight + kBlockSize - 1) / kBlockSize),
+      offsets_(static_cast<size_t>(cols_) * rows_, 0)
+{
+}
+
+void QualityMap::set(uint32_t col, uint32_t row, int offset) noexcept
+{
+    if (col < cols_ && row < rows_) {
+        offsets_[row * cols_ + col] = clamp_offset(offset);
+    }
+}
+
+void QualityMap::fill(int offset) noexcept
+{
+    std::fill(offsets_.begin(), offsets_.end(), clamp_offset(offset));
+}
+
+void QualityMap::fillRect(const Rect& area, int offset) noexcept
+{
+    if (area.width == 0 || area.height == 0) {
+        return;
+    }
+
+    uint32_t col0 = area.x / kBlockSize;
+    uint32_t row0 = area.y / kBlockSize;
+    uint32_t col1 = std::min(cols_, (area.x + area.width + kBlockSize - 1) / kBlockSize);
+    uint32_t row1 = std::min(rows_, (area.y + area.height + kBlockSize - 1) / kBlockSize);
+
+    const int8_t value = clamp_offset(offset);
+    for (uint32_t row = row0; row < row1; ++row) {
+        for (uint32_t col = col0; col < col1; ++col) {
+            offsets_[row * cols_ + col] = value;
+        }
+    }
+}
+
+bool QualityMap::isNeutral() const noexcept
+{
+    return std::all_of(offsets_.begin(), offsets_.end(), [](int8_t v) { return v == 0; });
+}
+
+std::vector<QualityRegion> QualityMap::regions() const
+{
+    struct Run {
+        uint32_t col0, col1, row0, row1;
+        int offset;
+    };
+
+    std::vector<Run> finished;
+    std::vector<Run> open; // runs that reached the previous row
+
+    for (uint32_t row = 0; row < rows_; ++row) {
+        std::vector<Run> current;
+        uint32_t col = 0;
+        while (col < cols_) {
+            int offset = offsets_[row * cols_ + col];
+            uint32_t end = col + 1;
+            while (end < cols_ && offsets_[row * cols_ + end] == offset) {
+                ++end;
+            }
+            if (offset != 0) {
+                current.push_back({col, end, row, row + 1, offset});
+            }
+            col = end;
+        }
+
+        // Extend runs with an identical span from the row above
+        for (auto& run : current) {
+            auto match = std::find_if(open.begin(), open.end(), [&](const Run& o) {
+                return o.col0 == run.col0 && o.col1 == run.col1 && o.offset == run.offset;
+            });
+            if (match != open.end()) {
+                run.row0 = match->row0;
+                open.erase(match);
+            }
+        }
+        finished.insert(finished.end(), open.begin(), open.end());
+        open = std::move(current);
+    }
+    finished.insert(finished.end(), open.begin(), open.end());
+
+    std::vector<QualityRegion> out;
+    out.reserve(finished.size());
+    for (const auto& run : finished) {
+        Rect area;
+        area.x = run.col0 * kBlockSize;
+        area.y = run.row0 * kBlockSize;
+        area.width = std::min(run.col1 * kBlockSize, frameWidth_) - area.x;
+        area.height = std::min(run.row1 * kBlockSize, frameHeight_) - area.y;
+        out.push_back({area, run.offset});
+    }
+    return out;
+}
+
+// ============================================================================
+// MotionRoiDetector
+// ============================================================================
+
+MotionRoiDetector::MotionRoiDetector(const MotionRoiConfig& config, ThreadPool* pool)
+    : config_(config)
+    , pool_(pool)
+{
+    config_.row_step = std::clamp(config_.row_step, 1, static_cast<int>(QualityMap::kBlockSize));
+}
+
+QualityMap MotionRoiDetector::update(const Frame& frame)
+{
+    QualityMap map(frame.width(), frame.height());
+
+    bool comparable = frame.isValid() && !previous_.empty() &&
+                      frame.width() == width_ && frame.height() == height_ &&
+                      frame.channels() == channels_;
+    if (!comparable) {
+        store(frame);
+        return map;
+    }
+
+    const uint32_t bs = QualityMap::kBlockSize;
+    const uint32_t step = static_cast<uint32_t>(config_.row_step);
+    const size_t rowBytes = static_cast<size_t>(frame.width()) * frame.channels();
+    // Every block row but the last stores the same number of sampled rows
+    const size_t sampledPerBlockRow = (bs + step - 1) / step;
+
+    auto scoreBlockRows = [&](size_t firstRow, size_t lastRow) {
+        std::vector<uint64_t> blockSad(map.cols(), 0);
+        std::vector<uint32_t> blockBytes(map.cols(), 0);
+
+        const uint8_t* reference = previous_.data() + firstRow * sampledPerBlockRow * rowBytes;
+        for (uint32_t blockRow = static_cast<uint32_t>(firstRow); blockRow < lastRow; ++blockRow) {
+            std::fill(blockSad.begin(), blockSad.end(), 0);
+            std::fill(blockBytes.begin(), blockBytes.end(), 0);
+
+            uint32_t yEnd = std::min(frame.height(), (blockRow + 1) * bs);
+            for (uint32_t y = blockRow * bs; y < yEnd; y += step) {
+                const uint8_t* current = frame.dataPtr() + y * rowBytes;
+                for (uint32_t col = 0; col < map.cols(); ++col) {
+                    size_t begin = static_cast<size_t>(col) * bs * frame.channels();
+                    size_t length = std::min(rowBytes, begin + bs * frame.channels()) - begin;
+                    blockSad[col] += sum_abs_diff(current + begin, reference + begin, length);
+                    blockBytes[col] += static_cast<uint32_t>(length);
+                }
+                reference += rowBytes;
+            }
+
+            for (uint32_t col = 0; col < map.cols(); ++col) {
+                double mean = blockBytes[col] ? static_cast<double>(blockSad[col]) / blockBytes[col] : 0.0;
+                map.set(col, blockRow, mean >= config_.threshold ? config_.motion_offset
+                                                                  : config_.static_offset);
+            }
+        }
+    };
+
+    // Analytics: yields to encode-path work queued on the same pool
+    if (pool_) {
+        pool_->parallelFor(0, map.rows(), kBlockRowsPerTask, scoreBlockRows, TaskPriority::Background);
+    } else {
+        scoreBlockRows(0, map.rows());
+    }
+
+    store(frame);
+    return map;
+}
+
+// Keeps only the rows update() samples, in the same order it walks them.
+void MotionRoiDetector::store(const Frame& frame)
+{
+    width_ = frame.width();
+    height_ = frame.height();
+    channels_ = frame.channels();
+    previous_.clear();
+
+    if (!frame.isValid()) {
+        return;
+    }
+
+    const uint32_t bs = QualityMap::kBlockSize;
+    const size_t rowBytes = static_cast<size_t>(frame.width()) * frame.channels();
+    for (uint32_t blockY = 0; blockY < frame.height(); blockY += bs) {
+        uint32_t yEnd = std::min(frame.height(), blockY + bs);
+        for (uint32_t y = blockY; y < yEnd; y += config_.row_step) {
+            const uint8_t* row = frame.dataPtr() + y * rowBytes;
+            previous_.insert(previous_.end(), row, row + rowBytes);
+        }
+    }
+}
+
+// ============================================================================
+// FixedZones
+// ============================================================================
+
+void FixedZones::apply(QualityMap& map) const noexcept
+{
+    for (const auto& zone : zones_) {
+        map.fillRect(zone.area, zone.offset);
+    }
+}
+
+} // namespace pcs
@@ -0,0 +1,134 @@
+#include "scene_filter.hpp"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) && defined(__x86_64__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace pcs {
+
+// ============================================================================
+// SIMD Kernel
+// ============================================================================
+
+uint64_t sum_abs_diff(const uint8_t* a, const uint8_t* b, size_t length) noexcept
+{
+    uint64_t total = 0;
+    size_t i = 0;
+
+#if defined(__SSE2__) && defined(__x86_64__)
+    // psadbw: 16 byte differences reduced to two 64-bit partial sums
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    total = static_cast<uint64_t>(_mm_cvtsi128_si64(acc)) +
+            static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+#elif defined(__ARM_NEON)
+    // vabd + pairwise widening adds into 32-bit lanes (no overflow within a row)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u16(acc, vpaddlq_u8(diff));
+    }
+    total = static_cast<uint64_t>(vgetq_lane_u32(acc, 0)) + vgetq_lane_u32(acc, 1) +
+            vgetq_lane_u32(acc, 2) + vgetq_lane_u32(acc, 3);
+#endif
+
+    for (; i < length; ++i) {
+        total += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    }
+    return total;
+}
+
+// ============================================================================
+// StaticSceneFilter
+// ============================================================================
+
+StaticSceneFilter::StaticSceneFilter(const StaticSceneConfig& config)
+    : config_(config)
+{
+    config_.row_step = std::max(1, config_.row_step);
+}
+
+SceneDecision StaticSceneFilter::evaluate(const Frame& frame)
+{
+    bool sameGeometry = !reference_.empty() &&
+                        frame.width() == refWidth_ &&
+                        frame.height() == refHeight_ &&
+                        frame.channels() == refChannels_;
+
+    bool refreshDue = lastEncoded_ &&
+                      frame.timestamp() - *lastEncoded_ >= config_.refresh_interval;
+
+    if (!config_.enabled || !sameGeometry || refreshDue || !frame.isValid() || frame.isCompressed()) {
+        lastScore_ = 0.0;
+        store_reference(frame);
+        ++encoded_;
+        return SceneDecision::Encode;
+    }
+
+    lastScore_ = score(frame);
+    if (lastScore_ >= config_.threshold) {
+        store_reference(frame);
+        ++encoded_;
+        return SceneDecision::Encode;
+    }
+
+    ++skipped_;
+    return config_.mode == SkipMode::Repeat ? SceneDecision::Repeat : SceneDecision::Skip;
+}
+
+void StaticSceneFilter::reset() noexcept
+{
+    reference_.clear();
+    lastEncoded_.reset();
+    lastScore_ = 0.0;
+}
+
+// Mean absolute difference per sampled byte against the reference rows.
+double StaticSceneFilter::score(const Frame& frame) const
+{
+    const size_t rowBytes = static_cast<size_t>(frame.width()) * frame.channels();
+    const uint8_t* current = frame.dataPtr();
+    const uint8_t* reference = reference_.data();
+
+    uint64_t total = 0;
+    size_t sampled = 0;
+    for (uint32_t y = 0; y < frame.height(); y += config_.row_step) {
+        total += sum_abs_diff(current + y * rowBytes, reference + sampled, rowBytes);
+        sampled += rowBytes;
+    }
+
+    return sampled ? static_cast<double>(total) / sampled : 0.0;
+}
+
+void StaticSceneFilter::store_reference(const Frame& frame)
+{
+    lastEncoded_ = frame.timestamp();
+    refWidth_ = frame.width();
+    refHeight_ = frame.height();
+    refChannels_ = frame.channels();
+
+    if (!frame.isValid()) {
+        reference_.clear();
+        return;
+    }
+
+    const size_t rowBytes = static_cast<size_t>(frame.width()) * frame.channels();
+    const size_t rows = (frame.height() + config_.row_step - 1) / config_.row_step;
+    reference_.resize(rows * rowBytes);
+
+    uint8_t* out = reference_.data();
+    for (uint32_t y = 0; y < frame.height(); y += config_.row_step) {
+        std::memcpy(out, frame.dataPtr() + y * rowBytes, rowBytes);
+        out += rowBytes;
+    }
+}
+
+} // namespace pcs
@@ -1,5 +1,7 @@
 #include "sender.hpp"
+#include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <linux/sockios.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
@@ -10,10 +12,13 @@
 // Constructor / Destructor
 // ============================================================================
 
-Sender::Sender(const std::string& dest_ip, int dest_port)
+Sender::Sender(const std::string& dest_ip, int dest_port, pcs::MemoryAccount* memory,
+               size_t max_queue_bytes)
     : m_destIp(dest_ip),
       m_destPort(dest_port),
       m_socketFd(-1),
+      m_memory(memory),
+      m_maxQueueBytes(max_queue_bytes),
       m_running(false)
 {
     // std::cout << "[Sender] Initialized for " << dest_ip << ":" << dest_port << std::endl;
@@ -71,25 +76,71 @@ void Sender::stop()
     {
         std::lock_guard<std::mutex> lock(m_queueMutex);
         m_frameQueue.clear();
+        if (m_memory) {
+            m_memory->release(m_queuedBytes);
+        }
+        m_queuedBytes = 0;
+        m_droppingGop = false;
     }
 }
 
-void Sender::enqueueFrame(const std::vector<uint8_t>& frame)
+bool Sender::enqueueFrame(const std::vector<uint8_t>& frame, bool keyframe)
 {
     if (!m_running.load()) {
-        return;
+        return false;
     }
 
     if (frame.empty()) {
-        return;
+        return false;
     }
 
     {
         std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (!admitFrame(frame.size(), keyframe)) {
+            return false;
+        }
         m_frameQueue.push_back(frame);
+        m_queuedBytes.fetch_add(frame.size(), std::memory_order_relaxed);
+    }
+
+    m_cv.notify_one();
+    return true;
+}
+
+bool Sender::enqueueFrame(std::vector<uint8_t>&& frame, bool keyframe)
+{
+    if (!m_running.load()) {
+        return false;
+    }
+
+    if (frame.empty()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+        if (!admitFrame(frame.size(), keyframe)) {
+            return false;
+        }
+        m_queuedBytes.fetch_add(frame.size(), std::memory_order_relaxed);
+        m_frameQueue.push_back(std::move(frame));
     }
 
     m_cv.notify_one();
+    return true;
+}
+
+size_t Sender::backlogBytes() const
+{
+    size_t backlog = m_queuedBytes.load(std::memory_order_relaxed);
+
+    // Unsent bytes in the socket's send buffer
+    int unsent = 0;
+    const int fd = m_socketFd;
+    if (m_running.load() && fd >= 0 && ioctl(fd, SIOCOUTQ, &unsent) == 0 && unsent > 0) {
+        backlog += static_cast<size_t>(unsent);
+    }
+    return backlog;
 }
 
 // ============================================================================
@@ -130,6 +181,18 @@ bool Sender::connectToReceiver()
     return true;
 }
 
+bool Sender::admitFrame(size_t size, bool keyframe)
+{
+    if (m_droppingGop && !keyframe) {
+        return false;
+    }
+    const size_t queued = m_queuedBytes.load(std::memory_order_relaxed);
+    const bool fits = (m_maxQueueBytes == 0 || queued + size <= m_maxQueueBytes) &&
+                      (!m_memory || m_memory->tryCharge(size, pcs::MemoryPriority::Required));
+    m_droppingGop = !fits;
+    return fits;
+}
+
 void Sender::sendLoop()
 {
     while (m_running.load()) {
@@ -153,6 +216,11 @@ void Sender::sendLoop()
             // Get frame from queue
             frame = std::move(m_frameQueue.front());
             m_frameQueue.erase(m_frameQueue.begin());
+            m_queuedBytes.fetch_sub(frame.size(), std::memory_order_relaxed);
+        }
+        // Only the queue is charged; it is what grows when the link stalls
+        if (m_memory) {
+            m_memory->release(frame.size());
         }
 
         // Send frame size first (4 bytes, network byte order)
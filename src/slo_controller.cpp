@@ -0,0 +1,193 @@
+#include "slo_controller.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <ctime>
+#include <thread>
+
+namespace pcs {
+
+namespace {
+
+size_t rungs(const std::vector<double>& steps)
+{
+    return std::max<size_t>(steps.size(), 1);
+}
+
+double rung(const std::vector<double>& steps, size_t index)
+{
+    return steps.empty() ? 1.0 : steps[std::min(index, steps.size() - 1)];
+}
+
+std::chrono::nanoseconds process_cpu_time()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+std::string percent(double fraction)
+{
+    return std::to_string(static_cast<int>(fraction * 100.0 + 0.5)) + "%";
+}
+
+std::string millis(uint64_t us)
+{
+    return fmt::format("{:.1f} ms", us / 1000.0);
+}
+
+std::string kib(size_t bytes)
+{
+    return std::to_string(bytes / 1024) + " KiB";
+}
+
+} // namespace
+
+// ============================================================================
+// SloController
+// ============================================================================
+
+SloController::SloController(const SloConfig& config, ApplyFn apply)
+    : config_(config)
+    , apply_(std::move(apply))
+{
+    maxStep_ = (rungs(config_.bitrate_steps) - 1) + (rungs(config_.fps_steps) - 1) +
+               (rungs(config_.resolution_steps) - 1);
+    level_ = levelAt(0);
+}
+
+bool SloController::update(const LoadSample& sample)
+{
+    const std::string over = over_target(sample);
+    if (!over.empty()) {
+        headroomCount_ = 0;
+        if (++overCount_ >= config_.degrade_after && level_.step < maxStep_) {
+            change_to(level_.step + 1, over);
+            return true;
+        }
+        return false;
+    }
+
+    overCount_ = 0;
+    if (!has_headroom(sample)) {
+        headroomCount_ = 0; // in the band between headroom and target: hold
+        return false;
+    }
+    if (++headroomCount_ >= config_.recover_after && level_.step > 0) {
+        change_to(level_.step - 1,
+                  "headroom for " + std::to_string(headroomCount_) + " samples (latency p99 " +
+                      millis(sample.latencyP99Us) + ", queues " + percent(sample.queueFill) + ", cpu " +
+                      percent(sample.cpuLoad) + ", backlog " + kib(sample.senderBacklogBytes) + ")");
+        return true;
+    }
+    return false;
+}
+
+QualityLevel SloController::levelAt(size_t step) const
+{
+    step = std::min(step, maxStep_);
+    const size_t bitrateRungs = rungs(config_.bitrate_steps) - 1;
+    const size_t fpsRungs = rungs(config_.fps_steps) - 1;
+
+    // Bitrate first, then fps, then resolution
+    QualityLevel level;
+    level.step = step;
+    const size_t b = std::min(step, bitrateRungs);
+    const size_t f = std::min(step - b, fpsRungs);
+    const size_t r = step - b - f;
+    level.bitrate_scale = rung(config_.bitrate_steps, b);
+    level.fps_scale = rung(config_.fps_steps, f);
+    level.resolution_scale = rung(config_.resolution_steps, r);
+    return level;
+}
+
+std::string SloController::over_target(const LoadSample& sample) const
+{
+    const SloTargets& t = config_.targets;
+    std::string causes;
+    auto add = [&](const std::string& cause) {
+        causes += (causes.empty() ? "" : ", ") + cause;
+    };
+
+    if (sample.latencyP99Us > t.latency_p99_us) {
+        add("latency p99 " + millis(sample.latencyP99Us) + " > " + millis(t.latency_p99_us));
+    }
+    if (sample.queueFill > t.queue_fill) {
+        add("queues " + percent(sample.queueFill) + " > " + percent(t.queue_fill));
+    }
+    if (sample.cpuLoad > t.cpu_load) {
+        add("cpu " + percent(sample.cpuLoad) + " > " + percent(t.cpu_load));
+    }
+    if (sample.senderBacklogBytes > t.sender_backlog_bytes) {
+        add("sender backlog " + kib(sample.senderBacklogBytes) + " > " + kib(t.sender_backlog_bytes));
+    }
+    return causes;
+}
+
+bool SloController::has_headroom(const LoadSample& sample) const
+{
+    const SloTargets& t = config_.targets;
+    const double h = config_.headroom;
+    return sample.latencyP99Us <= t.latency_p99_us * h && sample.queueFill <= t.queue_fill * h &&
+           sample.cpuLoad <= t.cpu_load * h && sample.senderBacklogBytes <= t.sender_backlog_bytes * h;
+}
+
+void SloController::change_to(size_t step, const std::string& cause)
+{
+    const bool down = step > level_.step;
+    level_ = levelAt(step);
+    lastCause_ = cause;
+    overCount_ = 0;
+    headroomCount_ = 0;
+
+    if (down) {
+        Logger::warn("SLO: step down to {}/{} ({}): {}", level_.step, maxStep_, describeQualityLevel(level_), cause);
+    } else {
+        Logger::info("SLO: step up to {}/{} ({}): {}", level_.step, maxStep_, describeQualityLevel(level_), cause);
+    }
+    if (apply_) {
+        apply_(level_);
+    }
+}
+
+std::string describeQualityLevel(const QualityLevel& level)
+{
+    return "bitrate " + percent(level.bitrate_scale) + ", fps " + percent(level.fps_scale) +
+           ", resolution " + percent(level.resolution_scale);
+}
+
+double scaledFpsCap(const QualityLevel& level, double cameraFps, double fpsCap)
+{
+    if (level.fps_scale >= 1.0) {
+        return fpsCap;
+    }
+    // Scale what is delivered, or rungs above the cap would change nothing
+    return (fpsCap > 0.0 ? fpsCap : cameraFps) * level.fps_scale;
+}
+
+// ============================================================================
+// ProcessCpuMeter
+// ============================================================================
+
+ProcessCpuMeter::ProcessCpuMeter()
+    : lastCpu_(process_cpu_time())
+    , lastWall_(std::chrono::steady_clock::now())
+    , cores_(std::max(1u, std::thread::hardware_concurrency()))
+{
+}
+
+double ProcessCpuMeter::sample()
+{
+    const auto cpu = process_cpu_time();
+    const auto wall = std::chrono::steady_clock::now();
+    const double cpuSeconds = std::chrono::duration<double>(cpu - lastCpu_).count();
+    const double wallSeconds = std::chrono::duration<double>(wall - lastWall_).count();
+    lastCpu_ = cpu;
+    lastWall_ = wall;
+
+    if (wallSeconds <= 0.0) {
+        return 0.0;
+    }
+    return std::clamp(cpuSeconds / (wallSeconds * cores_), 0.0, 1.0);
+}
+
+} // namespace pcs
@@ -0,0 +1,164 @@
+#include "snapshot.hpp"
+#include "logger.hpp"
+#include "mjpeg.hpp"
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace pcs {
+
+namespace {
+
+// The size a request resolves to; see SnapshotService::take()
+std::pair<uint32_t, uint32_t> fit_size(const Frame& frame, uint32_t width, uint32_t height)
+{
+    const uint32_t frameWidth = frame.width();
+    const uint32_t frameHeight = frame.height();
+    if (width == 0 && height == 0) {
+        return {frameWidth, frameHeight};
+    }
+    if (width == 0) {
+        width = static_cast<uint32_t>(uint64_t{frameWidth} * height / std::max(frameHeight, 1u));
+    } else if (height == 0) {
+        height = static_cast<uint32_t>(uint64_t{frameHeight} * width / std::max(frameWidth, 1u));
+    }
+    if (width > frameWidth || height > frameHeight || (width == frameWidth && height == frameHeight)) {
+        return {frameWidth, frameHeight};
+    }
+    // Even dimensions, as 4:2:0 JPEG wants
+    return {std::max(width & ~1u, 2u), std::max(height & ~1u, 2u)};
+}
+
+} // namespace
+
+// ============================================================================
+// Constructor
+// ============================================================================
+
+SnapshotService::SnapshotService(EncodeFn encode)
+    : encode_(std::move(encode))
+{
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void SnapshotService::publish(Frame frame)
+{
+    auto next = std::make_shared<const Frame>(std::move(frame));
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        latest_.swap(next);
+        ++sequence_;
+    }
+    published_.fetch_add(1, std::memory_order_relaxed);
+    // `next` now holds the previous frame, released here unless a snapshot
+    // is still being made from it
+}
+
+std::optional<Snapshot> SnapshotService::take(uint32_t width, uint32_t height)
+{
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    std::unique_lock<std::mutex> lock(mtx_);
+    if (!latest_ || latest_->empty()) {
+        return std::nullopt;
+    }
+    std::tie(width, height) = fit_size(*latest_, width, height);
+
+    for (const CacheEntry& entry : cache_) {
+        if (entry.width == width && entry.height == height && entry.sequence == sequence_) {
+            Result result = entry.result;
+            lock.unlock();
+            const bool ready = result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            (ready ? cacheHits_ : coalesced_).fetch_add(1, std::memory_order_relaxed);
+            const std::shared_ptr<const Snapshot> snapshot = result.get();
+            return snapshot ? std::optional<Snapshot>(*snapshot) : std::nullopt;
+        }
+    }
+
+    // First request for this frame at this size: encode it here, and let
+    // requests arriving meanwhile wait for the result
+    std::promise<std::shared_ptr<const Snapshot>> promise;
+    CacheEntry& slot = cache_slot(width, height);
+    slot = CacheEntry{width, height, sequence_, nextId_++, promise.get_future().share()};
+    const uint64_t id = slot.id;
+    std::shared_ptr<const Frame> frame = latest_;
+    const uint64_t sequence = sequence_;
+    lock.unlock();
+
+    std::shared_ptr<const Snapshot> snapshot = make_snapshot(*frame, width, height, sequence);
+    frame.reset();
+    promise.set_value(snapshot);
+    if (!snapshot) {
+        failed_.fetch_add(1, std::memory_order_relaxed);
+        lock.lock();
+        std::erase_if(cache_, [id](const CacheEntry& entry) { return entry.id == id; });
+        return std::nullopt;
+    }
+    return *snapshot;
+}
+
+SnapshotStats SnapshotService::stats() const
+{
+    SnapshotStats stats;
+    stats.published = published_.load(std::memory_order_relaxed);
+    stats.requests = requests_.load(std::memory_order_relaxed);
+    stats.encodes = encodes_.load(std::memory_order_relaxed);
+    stats.cacheHits = cacheHits_.load(std::memory_order_relaxed);
+    stats.coalesced = coalesced_.load(std::memory_order_relaxed);
+    stats.passthrough = passthrough_.load(std::memory_order_relaxed);
+    stats.failed = failed_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+std::shared_ptr<const Snapshot> SnapshotService::make_snapshot(const Frame& frame, uint32_t width,
+                                                               uint32_t height, uint64_t sequence)
+{
+    std::vector<uint8_t> jpeg;
+    if (frame.isCompressed() && width == frame.width() && height == frame.height()) {
+        const size_t length = jpegImageLength(frame.bytes());
+        if (length > 0) {
+            jpeg.assign(frame.dataPtr(), frame.dataPtr() + length);
+            passthrough_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    if (jpeg.empty()) {
+        encodes_.fetch_add(1, std::memory_order_relaxed);
+        std::optional<std::vector<uint8_t>> encoded = encode_(frame, width, height);
+        if (!encoded || encoded->empty()) {
+            Logger::warn("Snapshot: cannot encode frame {} at {}x{}", sequence, width, height);
+            return nullptr;
+        }
+        jpeg = std::move(*encoded);
+    }
+
+    auto snapshot = std::make_shared<Snapshot>();
+    snapshot->jpeg = std::make_shared<const std::vector<uint8_t>>(std::move(jpeg));
+    snapshot->width = width;
+    snapshot->height = height;
+    snapshot->sequence = sequence;
+    snapshot->captured = frame.timestamp();
+    return snapshot;
+}
+
+// The entry for this size, else a free one, else the least recently created
+SnapshotService::CacheEntry& SnapshotService::cache_slot(uint32_t width, uint32_t height)
+{
+    for (CacheEntry& entry : cache_) {
+        if (entry.width == width && entry.height == height) {
+            return entry;
+        }
+    }
+    if (cache_.size() < kMaxCachedSizes) {
+        return cache_.emplace_back();
+    }
+    return *std::min_element(cache_.begin(), cache_.end(),
+                             [](const CacheEntry& a, const CacheEntry& b) { return a.id < b.id; });
+}
+
+} // namespace pcs
@@ -0,0 +1,308 @@
+#include "stage_scheduler.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <latch>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+namespace pcs {
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+
+} // namespace
+
+// ============================================================================
+// Stage
+// ============================================================================
+
+std::suspend_never Stage::promise_type::final_suspend() noexcept
+{
+    scheduler->retire(std::coroutine_handle<promise_type>::from_promise(*this));
+    return {};
+}
+
+// ============================================================================
+// IoAwaiter
+// ============================================================================
+
+Scheduler::IoAwaiter::~IoAwaiter()
+{
+    if (armed_) {
+        scheduler_.disarm(*this); // stage destroyed while waiting
+    }
+}
+
+bool Scheduler::IoAwaiter::await_suspend(std::coroutine_handle<> handle)
+{
+    handle_ = handle;
+    return scheduler_.arm(*this);
+}
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+Scheduler::Scheduler(const SchedulerConfig& config)
+{
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (epollFd_ < 0 || wakeFd_ < 0) {
+        Logger::error("Scheduler: cannot create epoll/eventfd: {}; socket waits will fail",
+                      std::strerror(errno));
+    } else {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr; // the wake-up fd
+        epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &event);
+        poller_ = std::thread([this] {
+            applyThreadConfig({.name = "pcs-stage-io"});
+            poll_loop();
+        });
+    }
+
+    size_t count = config.threads;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadReports_.assign(count, ThreadReport{});
+
+    std::latch configured(static_cast<std::ptrdiff_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        ThreadConfig thread = config.worker_thread;
+        thread.name += std::to_string(i);
+        workers_.emplace_back([this, i, thread, &configured] {
+            threadReports_[i] = applyThreadConfig(thread);
+            configured.count_down();
+            worker_loop();
+        });
+    }
+    configured.wait();
+
+    for (const ThreadReport& report : threadReports_) {
+        if (!report.ok()) {
+            Logger::warn("Scheduler: {}", describeThreadReport(report));
+        }
+    }
+}
+
+Scheduler::~Scheduler()
+{
+    stop();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool Scheduler::spawn(Stage stage)
+{
+    auto handle = std::exchange(stage.handle_, {});
+    if (!handle) {
+        return false;
+    }
+    handle.promise().scheduler = this;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (!stopping_) {
+            live_.insert(handle.address());
+            ready_.push_back(handle);
+            readyCv_.notify_one();
+            return true;
+        }
+    }
+    handle.destroy();
+    return false;
+}
+
+void Scheduler::wait()
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    idleCv_.wait(lock, [this] { return live_.empty(); });
+}
+
+bool Scheduler::wait(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mtx_);
+    return idleCv_.wait_for(lock, timeout, [this] { return live_.empty(); });
+}
+
+void Scheduler::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopping_) {
+            return;
+        }
+        stopping_ = true;
+    }
+    readyCv_.notify_all();
+
+    // Workers finish the step they are in; nothing new is resumed
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    if (poller_.joinable()) {
+        const uint64_t one = 1;
+        [[maybe_unused]] ssize_t n = ::write(wakeFd_, &one, sizeof(one));
+        poller_.join();
+    }
+
+    // Destroying a frame runs its awaiters' destructors, which unlink them
+    // from queues and epoll, so this must happen without mtx_ held
+    std::unordered_set<void*> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        abandoned.swap(live_);
+        ready_.clear();
+    }
+    for (void* frame : abandoned) {
+        std::coroutine_handle<>::from_address(frame).destroy();
+    }
+    if (!abandoned.empty()) {
+        Logger::debug("Scheduler: abandoned {} unfinished stages", abandoned.size());
+    }
+    idleCv_.notify_all();
+
+    if (epollFd_ >= 0) {
+        ::close(epollFd_);
+        epollFd_ = -1;
+    }
+    if (wakeFd_ >= 0) {
+        ::close(wakeFd_);
+        wakeFd_ = -1;
+    }
+}
+
+Scheduler::IoAwaiter Scheduler::readable(int fd) noexcept
+{
+    return IoAwaiter(*this, fd, EPOLLIN);
+}
+
+Scheduler::IoAwaiter Scheduler::writable(int fd) noexcept
+{
+    return IoAwaiter(*this, fd, EPOLLOUT);
+}
+
+void Scheduler::post(std::coroutine_handle<> handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (stopping_) {
+            return; // stop() destroys it with the other unfinished stages
+        }
+        ready_.push_back(handle);
+    }
+    readyCv_.notify_one();
+}
+
+size_t Scheduler::activeStages() const
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    return live_.size();
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void Scheduler::worker_loop()
+{
+    for (;;) {
+        std::coroutine_handle<> handle;
+        {
+            std::unique_lock<std::mutex> lock(mtx_);
+            readyCv_.wait(lock, [this] { return stopping_ || !ready_.empty(); });
+            if (stopping_) {
+                return;
+            }
+            handle = ready_.front();
+            ready_.pop_front();
+        }
+        handle.resume();
+    }
+}
+
+void Scheduler::poll_loop()
+{
+    epoll_event events[kMaxEvents];
+    for (;;) {
+        int count = epoll_wait(epollFd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            Logger::error("Scheduler: epoll_wait failed: {}", std::strerror(errno));
+            return;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            if (events[i].data.ptr == nullptr) {
+                return; // woken by stop()
+            }
+
+            std::lock_guard<std::mutex> lock(ioMtx_);
+            auto* awaiter = static_cast<IoAwaiter*>(events[i].data.ptr);
+            // Its stage may have been destroyed after epoll_wait returned
+            if (!armed_.erase(awaiter)) {
+                continue;
+            }
+            epoll_ctl(epollFd_, EPOLL_CTL_DEL, awaiter->fd_, nullptr);
+            awaiter->armed_ = false;
+            awaiter->ready_ = (events[i].events & EPOLLERR) == 0;
+            post(awaiter->handle_);
+        }
+    }
+}
+
+void Scheduler::retire(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(mtx_);
+    live_.erase(handle.address());
+    if (live_.empty()) {
+        idleCv_.notify_all();
+    }
+}
+
+// Returns whether the stage stays suspended. ioMtx_ is held until the
+// awaiter is fully set up, so the poller can't resume it half-armed.
+bool Scheduler::arm(IoAwaiter& awaiter)
+{
+    std::lock_guard<std::mutex> lock(ioMtx_);
+    {
+        std::lock_guard<std::mutex> state(mtx_);
+        if (stopping_ || epollFd_ < 0) {
+            awaiter.ready_ = false;
+            return false;
+        }
+    }
+
+    epoll_event event{};
+    event.events = awaiter.events_ | EPOLLONESHOT;
+    event.data.ptr = &awaiter;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, awaiter.fd_, &event) != 0) {
+        Logger::warn("Scheduler: cannot watch fd {}: {}", awaiter.fd_, std::strerror(errno));
+        awaiter.ready_ = false;
+        return false;
+    }
+    awaiter.armed_ = true;
+    armed_.insert(&awaiter);
+    return true;
+}
+
+void Scheduler::disarm(IoAwaiter& awaiter)
+{
+    std::lock_guard<std::mutex> lock(ioMtx_);
+    if (armed_.erase(&awaiter) && epollFd_ >= 0) {
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, awaiter.fd_, nullptr);
+    }
+    awaiter.armed_ = false;
+}
+
+} // namespace pcs
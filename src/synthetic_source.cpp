@@ -0,0 +1,314 @@
+#include "synthetic_source.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace pcs {
+
+namespace {
+
+struct Yuv {
+    uint8_t y, u, v;
+};
+
+// BT.601 limited-range values for 75% bars
+constexpr std::array<Yuv, 8> kBars = {{
+    {180, 128, 128}, // white
+    {162, 44, 142},  // yellow
+    {131, 156, 44},  // cyan
+    {112, 72, 58},   // green
+    {84, 184, 198},  // magenta
+    {65, 100, 212},  // red
+    {35, 212, 114},  // blue
+    {16, 128, 128},  // black
+}};
+
+constexpr int kScrollStep = 4; // pixels per frame for the moving patterns
+
+// 3x5 glyphs, one byte per row, bit 2 = left column
+const uint8_t* glyph(char c)
+{
+    static constexpr uint8_t kDigits[10][5] = {
+        {7, 5, 5, 5, 7}, {2, 6, 2, 2, 7}, {7, 1, 7, 4, 7}, {7, 1, 7, 1, 7}, {5, 5, 7, 1, 1},
+        {7, 4, 7, 1, 7}, {7, 4, 7, 5, 7}, {7, 1, 1, 1, 1}, {7, 5, 7, 5, 7}, {7, 5, 7, 1, 7},
+    };
+    static constexpr uint8_t kColon[5] = {0, 2, 0, 2, 0};
+    static constexpr uint8_t kDot[5] = {0, 0, 0, 0, 2};
+    static constexpr uint8_t kHash[5] = {5, 7, 5, 7, 5};
+    static constexpr uint8_t kBlank[5] = {0, 0, 0, 0, 0};
+
+    if (c >= '0' && c <= '9') return kDigits[c - '0'];
+    if (c == ':') return kColon;
+    if (c == '.') return kDot;
+    if (c == '#') return kHash;
+    return kBlank;
+}
+
+uint8_t clamp_u8(int value)
+{
+    return static_cast<uint8_t>(std::clamp(value, 0, 255));
+}
+
+void yuv_to_bgr(Yuv p, uint8_t* out)
+{
+    const int c = p.y - 16, d = p.u - 128, e = p.v - 128;
+    out[0] = clamp_u8((298 * c + 516 * d + 128) >> 8);
+    out[1] = clamp_u8((298 * c - 100 * d - 208 * e + 128) >> 8);
+    out[2] = clamp_u8((298 * c + 409 * e + 128) >> 8);
+}
+
+uint64_t xorshift(uint64_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+// Writes pixel(x, y) in the target layout; chroma is sampled at the
+// top-left pixel of each subsampled block.
+template <typename PixelFn>
+void render_image(uint8_t* out, uint32_t w, uint32_t h, PixelFormat format, PixelFn&& pixel)
+{
+    switch (format) {
+        case PixelFormat::Gray8:
+            for (uint32_t y = 0; y < h; ++y) {
+                for (uint32_t x = 0; x < w; ++x) {
+                    *out++ = pixel(x, y).y;
+                }
+            }
+            break;
+
+        case PixelFormat::BGR24:
+        case PixelFormat::BGRA: {
+            const uint32_t bpp = format == PixelFormat::BGRA ? 4 : 3;
+            for (uint32_t y = 0; y < h; ++y) {
+                for (uint32_t x = 0; x < w; ++x, out += bpp) {
+                    yuv_to_bgr(pixel(x, y), out);
+                    if (bpp == 4) {
+                        out[3] = 255;
+                    }
+                }
+            }
+            break;
+        }
+
+        case PixelFormat::YUYV:
+            for (uint32_t y = 0; y < h; ++y) {
+                for (uint32_t x = 0; x < w; x += 2) {
+                    Yuv a = pixel(x, y);
+                    *out++ = a.y;
+                    *out++ = a.u;
+                    if (x + 1 < w) {
+                        *out++ = pixel(x + 1, y).y;
+                        *out++ = a.v;
+                    }
+                }
+            }
+            break;
+
+        case PixelFormat::NV12:
+        case PixelFormat::I420: {
+            for (uint32_t y = 0; y < h; ++y) {
+                for (uint32_t x = 0; x < w; ++x) {
+                    *out++ = pixel(x, y).y;
+                }
+            }
+            const uint32_t cw = (w + 1) / 2, ch = (h + 1) / 2;
+            uint8_t* u = out;
+            uint8_t* v = format == PixelFormat::NV12 ? out + 1 : out + static_cast<size_t>(cw) * ch;
+            const size_t step = format == PixelFormat::NV12 ? 2 : 1;
+            for (uint32_t cy = 0; cy < ch; ++cy) {
+                for (uint32_t cx = 0; cx < cw; ++cx, u += step, v += step) {
+                    Yuv p = pixel(cx * 2, cy * 2);
+                    *u = p.u;
+                    *v = p.v;
+                }
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+const char* pattern_name(TestPattern pattern)
+{
+    switch (pattern) {
+        case TestPattern::ColorBars: return "bars";
+        case TestPattern::Gradient:  return "gradient";
+        case TestPattern::Noise:     return "noise";
+        case TestPattern::Timestamp: return "timestamp";
+    }
+    return "unknown";
+}
+
+} // namespace
+
+// ============================================================================
+// Constructor
+// ============================================================================
+
+SyntheticSource::SyntheticSource(const SyntheticConfig& config)
+    : config_(config)
+{
+}
+
+// ============================================================================
+// CaptureSource
+// ============================================================================
+
+bool SyntheticSource::start()
+{
+    Frame probe(std::vector<uint8_t>(), config_.width, config_.height, config_.format);
+    if (config_.width == 0 || config_.height == 0 || config_.fps == 0 ||
+        probe.isCompressed() || config_.format == PixelFormat::Unknown) {
+        Logger::error("Synthetic source: unsupported mode {}x{} {} @ {} fps", config_.width,
+                      config_.height, pixelFormatName(config_.format), config_.fps);
+        return false;
+    }
+
+    frameBytes_ = probe.expectedSize();
+    if (!pool_ || pool_->bufferSize() != frameBytes_) {
+        pool_.emplace(frameBytes_, std::max<size_t>(1, config_.pool_size), config_.memory);
+    }
+
+    period_ = std::chrono::nanoseconds(1'000'000'000LL / config_.fps);
+    start_ = std::chrono::steady_clock::now();
+    index_ = 0;
+    rng_ = config_.seed ? config_.seed : 1;
+    running_ = true;
+
+    Logger::info("Synthetic source: {}x{} {} @ {} fps, {} pattern, {}", config_.width,
+                 config_.height, pixelFormatName(config_.format), config_.fps,
+                 pattern_name(config_.pattern),
+                 config_.pacing == Pacing::RealTime ? "real-time" : "max speed");
+    return true;
+}
+
+void SyntheticSource::stop()
+{
+    running_ = false;
+}
+
+bool SyntheticSource::read(Frame& frame)
+{
+    if (!running_) {
+        return false;
+    }
+
+    Frame::Timestamp stamp = std::chrono::steady_clock::now();
+    if (config_.pacing == Pacing::RealTime) {
+        Frame::Timestamp due = start_ + period_ * index_;
+        if (stamp > due + period_) {
+            // The reader is late: frames a camera would have overwritten are lost
+            uint64_t current = static_cast<uint64_t>((stamp - start_) / period_);
+            dropped_ += current - index_;
+            index_ = current;
+            due = start_ + period_ * index_;
+        } else if (stamp < due) {
+            std::this_thread::sleep_until(due);
+        }
+        stamp = due;
+    }
+
+    std::shared_ptr<uint8_t> buffer = pool_->acquire();
+    if (!buffer) {
+        ++index_;
+        ++dropped_;
+        return false;
+    }
+
+    render(buffer.get(), index_);
+    frame = Frame(std::shared_ptr<const uint8_t>(std::move(buffer)), frameBytes_,
+                  config_.width, config_.height, config_.format);
+    frame.setTimestamp(stamp);
+
+    ++index_;
+    ++produced_;
+    return true;
+}
+
+CaptureFormat SyntheticSource::captureFormat() const
+{
+    return {config_.width, config_.height, config_.fps, config_.format};
+}
+
+std::string SyntheticSource::name() const
+{
+    return std::string("synthetic:") + pattern_name(config_.pattern);
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void SyntheticSource::render(uint8_t* out, uint64_t index)
+{
+    const uint32_t w = config_.width;
+    const uint32_t h = config_.height;
+    const uint32_t shift = static_cast<uint32_t>(index * kScrollStep);
+
+    switch (config_.pattern) {
+        case TestPattern::ColorBars: {
+            std::vector<Yuv> row(w);
+            for (uint32_t x = 0; x < w; ++x) {
+                row[x] = kBars[((x + shift) % w) * kBars.size() / w];
+            }
+            render_image(out, w, h, config_.format, [&](uint32_t x, uint32_t) { return row[x]; });
+            break;
+        }
+
+        case TestPattern::Gradient:
+            render_image(out, w, h, config_.format, [&](uint32_t x, uint32_t y) {
+                return Yuv{static_cast<uint8_t>(x + y + shift),
+                           static_cast<uint8_t>(x * 255 / w),
+                           static_cast<uint8_t>(y * 255 / h)};
+            });
+            break;
+
+        case TestPattern::Noise:
+            render_image(out, w, h, config_.format, [&](uint32_t, uint32_t) {
+                uint64_t r = xorshift(rng_);
+                return Yuv{static_cast<uint8_t>(r), static_cast<uint8_t>(r >> 8),
+                           static_cast<uint8_t>(r >> 16)};
+            });
+            break;
+
+        case TestPattern::Timestamp: {
+            const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(period_ * index);
+            const long long ms = elapsed.count();
+            char text[64];
+            std::snprintf(text, sizeof(text), "#%06llu %02lld:%02lld:%02lld.%03lld",
+                          static_cast<unsigned long long>(index), ms / 3'600'000,
+                          ms / 60'000 % 60, ms / 1000 % 60, ms % 1000);
+            const int length = static_cast<int>(std::char_traits<char>::length(text));
+
+            const int scale = std::max<int>(1, static_cast<int>(h) / 48);
+            const int textWidth = length * 4 * scale;
+            const int x0 = static_cast<int>(w) - static_cast<int>(shift % (w + textWidth));
+            const int y0 = (static_cast<int>(h) - 5 * scale) / 2;
+
+            render_image(out, w, h, config_.format, [&](uint32_t x, uint32_t y) {
+                int tx = (static_cast<int>(x) - x0);
+                int ty = (static_cast<int>(y) - y0);
+                if (tx >= 0 && ty >= 0 && tx < textWidth && ty < 5 * scale) {
+                    int cell = tx / scale;
+                    int column = cell % 4;
+                    if (column < 3 && (glyph(text[cell / 4])[ty / scale] >> (2 - column)) & 1) {
+                        return Yuv{235, 128, 128};
+                    }
+                }
+                return Yuv{static_cast<uint8_t>(16 + y * 48 / h), 128, 128};
+            });
+            break;
+        }
+    }
+}
+
+} // namespace pcs
@@ -0,0 +1,268 @@
+#include "thread_config.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <alloca.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace pcs {
+
+namespace {
+
+constexpr size_t kThreadNameMax = 15; // kernel limit, excluding the terminator
+
+int native_policy(SchedPolicy policy)
+{
+    switch (policy) {
+        case SchedPolicy::Fifo:       return SCHED_FIFO;
+        case SchedPolicy::RoundRobin: return SCHED_RR;
+        case SchedPolicy::Other:      break;
+    }
+    return SCHED_OTHER;
+}
+
+std::string describe_request(SchedPolicy policy, int priority)
+{
+    return std::string(schedPolicyName(policy)) + " " + std::to_string(priority);
+}
+
+// Touch the next `bytes` of stack so the pages are mapped before the
+// thread's first real-time frame
+void prefault_stack(size_t bytes)
+{
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(bytes));
+    static const size_t kPage = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t i = 0; i < bytes; i += kPage) {
+        stack[i] = 0;
+    }
+}
+
+void apply_affinity(const ThreadConfig& config, ThreadReport& report)
+{
+    if (config.cpus.empty()) {
+        return;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : config.cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+
+    int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (err != 0) {
+        report.problems.push_back("CPUs " + formatCpuList(config.cpus) + " refused: " + std::strerror(err));
+        return;
+    }
+    report.cpus = config.cpus;
+}
+
+void apply_policy(const ThreadConfig& config, ThreadReport& report)
+{
+    if (config.policy == SchedPolicy::Other) {
+        return;
+    }
+
+    const int policy = native_policy(config.policy);
+    int priority = std::clamp(config.priority, sched_get_priority_min(policy),
+                              sched_get_priority_max(policy));
+    sched_param param{};
+    param.sched_priority = priority;
+    int err = pthread_setschedparam(pthread_self(), policy, &param);
+
+    // Unprivileged processes may still use priorities up to RLIMIT_RTPRIO
+    if (err == EPERM) {
+        rlimit limit{};
+        if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur > 0 &&
+            static_cast<rlim_t>(priority) > limit.rlim_cur) {
+            param.sched_priority = static_cast<int>(limit.rlim_cur);
+            if (pthread_setschedparam(pthread_self(), policy, &param) == 0) {
+                report.problems.push_back(describe_request(config.policy, priority) +
+                                          " capped to " + std::to_string(limit.rlim_cur) +
+                                          " by RLIMIT_RTPRIO");
+                priority = param.sched_priority;
+                err = 0;
+            }
+        }
+    }
+
+    if (err != 0) {
+        report.problems.push_back(describe_request(config.policy, priority) + " refused: " +
+                                  std::strerror(err));
+        return;
+    }
+    report.policy = config.policy;
+    report.priority = priority;
+}
+
+} // namespace
+
+ThreadReport applyThreadConfig(const ThreadConfig& config)
+{
+    ThreadReport report;
+    report.name = config.name;
+
+    if (!config.name.empty()) {
+        const std::string name = config.name.substr(0, kThreadNameMax);
+        pthread_setname_np(pthread_self(), name.c_str());
+    }
+    apply_affinity(config, report);
+    apply_policy(config, report);
+    if (config.prefault_stack > 0) {
+        prefault_stack(config.prefault_stack);
+    }
+    return report;
+}
+
+std::string describeThreadReport(const ThreadReport& report)
+{
+    std::string text = (report.name.empty() ? std::string("thread") : report.name) + ": ";
+    text += report.cpus.empty() ? "any CPU" : "CPUs " + formatCpuList(report.cpus);
+    text += ", ";
+    text += schedPolicyName(report.policy);
+    if (report.policy != SchedPolicy::Other) {
+        text += " " + std::to_string(report.priority);
+    }
+
+    if (!report.problems.empty()) {
+        text += " (";
+        for (size_t i = 0; i < report.problems.size(); ++i) {
+            text += (i ? "; " : "") + report.problems[i];
+        }
+        text += ")";
+    }
+    return text;
+}
+
+bool lockProcessMemory()
+{
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        const int err = errno;
+        rlimit limit{};
+        getrlimit(RLIMIT_MEMLOCK, &limit);
+        Logger::warn("mlockall failed: {} (RLIMIT_MEMLOCK {} bytes); pages may be swapped or faulted in",
+                     std::strerror(err), static_cast<unsigned long long>(limit.rlim_cur));
+        return false;
+    }
+    Logger::info("Process memory locked (mlockall)");
+    return true;
+}
+
+std::chrono::steady_clock::time_point processStartTime()
+{
+    static const std::chrono::steady_clock::time_point start = [] {
+        const auto now = std::chrono::steady_clock::now();
+
+        // Field 22 is the start time in clock ticks since boot; the command
+        // name before it is in parentheses and may contain spaces
+        std::ifstream stat("/proc/self/stat");
+        std::string line;
+        std::getline(stat, line);
+        const size_t close = line.rfind(')');
+        if (close == std::string::npos) {
+            return now;
+        }
+        std::istringstream fields(line.substr(close + 1));
+        std::string field;
+        int index = 2;
+        while (index < 22 && fields >> field) {
+            ++index;
+        }
+        const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+        timespec boot{};
+        if (index != 22 || ticksPerSecond <= 0 || clock_gettime(CLOCK_BOOTTIME, &boot) != 0) {
+            return now;
+        }
+
+        const double started = std::strtod(field.c_str(), nullptr) / static_cast<double>(ticksPerSecond);
+        const double age = static_cast<double>(boot.tv_sec) + static_cast<double>(boot.tv_nsec) / 1e9 - started;
+        if (age < 0.0) {
+            return now;
+        }
+        return now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                         std::chrono::duration<double>(age));
+    }();
+    return start;
+}
+
+std::optional<std::vector<int>> parseCpuList(const std::string& text)
+{
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string item = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        const size_t dash = item.find('-');
+        char* rest = nullptr;
+        const long first = std::strtol(item.c_str(), &rest, 10);
+        if (item.empty() || rest == item.c_str() || first < 0 || first >= CPU_SETSIZE) {
+            return std::nullopt;
+        }
+        long last = first;
+        if (dash != std::string::npos) {
+            const char* from = item.c_str() + dash + 1;
+            last = std::strtol(from, &rest, 10);
+            if (rest == from || last < first || last >= CPU_SETSIZE) {
+                return std::nullopt;
+            }
+        }
+        if (*rest != '\0') {
+            return std::nullopt;
+        }
+        for (long cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string formatCpuList(const std::vector<int>& cpus)
+{
+    std::string text;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) {
+            ++j;
+        }
+        if (!text.empty()) {
+            text += ",";
+        }
+        text += std::to_string(cpus[i]);
+        if (j > i) {
+            text += "-" + std::to_string(cpus[j]);
+        }
+        i = j + 1;
+    }
+    return text;
+}
+
+const char* schedPolicyName(SchedPolicy policy) noexcept
+{
+    switch (policy) {
+        case SchedPolicy::Other:      return "SCHED_OTHER";
+        case SchedPolicy::Fifo:       return "SCHED_FIFO";
+        case SchedPolicy::RoundRobin: return "SCHED_RR";
+    }
+    return "unknown";
+}
+
+} // namespace pcs
@@ -0,0 +1,277 @@
+#include "thread_pool.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <latch>
+
+namespace pcs {
+
+namespace {
+
+constexpr size_t kNoWorker = static_cast<size_t>(-1);
+
+// Bands queued per worker by parallelFor(): enough slack for stealing to
+// even out uneven rows, few enough that queueing stays cheap
+constexpr size_t kBandsPerWorker = 4;
+
+// Which pool (if any) the calling thread works for
+thread_local const ThreadPool* tls_pool = nullptr;
+thread_local size_t tls_index = kNoWorker;
+
+// Completion count shared between parallelFor() and its queued bands;
+// owned jointly so the last band can signal after the caller has returned
+struct ForState {
+    std::mutex mtx;
+    std::condition_variable done;
+    size_t remaining{0};
+};
+
+} // namespace
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+ThreadPool::ThreadPool(const ThreadPoolConfig& config)
+{
+    size_t count = config.workers;
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    workers_.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    threadReports_.assign(count, ThreadReport{});
+    startedAt_ = std::chrono::steady_clock::now();
+
+    // Every worker configures itself before the pool is handed out
+    std::latch configured(static_cast<std::ptrdiff_t>(count));
+    for (size_t i = 0; i < count; ++i) {
+        ThreadConfig thread = config.worker_thread;
+        thread.name += std::to_string(i);
+        if (!thread.cpus.empty()) {
+            thread.cpus = {config.worker_thread.cpus[i % config.worker_thread.cpus.size()]};
+        }
+        workers_[i]->thread = std::thread([this, i, thread, &configured] {
+            threadReports_[i] = applyThreadConfig(thread);
+            configured.count_down();
+            worker_loop(i);
+        });
+    }
+    configured.wait();
+
+    for (const ThreadReport& report : threadReports_) {
+        if (!report.ok()) {
+            Logger::warn("ThreadPool: {}", describeThreadReport(report));
+        }
+    }
+    Logger::debug("ThreadPool: {} workers", count);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMtx_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker->thread.join();
+    }
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void ThreadPool::submit(Task task, TaskPriority priority)
+{
+    size_t index = current_worker();
+    if (index == kNoWorker) {
+        index = nextWorker_.fetch_add(1, std::memory_order_relaxed) % workers_.size();
+    }
+    push(index, std::move(task), priority);
+}
+
+void ThreadPool::parallelFor(size_t begin, size_t end, size_t grain, const RangeFn& body,
+                             TaskPriority priority)
+{
+    if (end <= begin) {
+        return;
+    }
+    grain = std::max<size_t>(grain, 1);
+    const size_t total = end - begin;
+    const size_t bands = std::min((total + grain - 1) / grain, workers_.size() * kBandsPerWorker);
+    if (bands <= 1) {
+        body(begin, end);
+        return;
+    }
+    const size_t bandSize = (total + bands - 1) / bands;
+
+    auto state = std::make_shared<ForState>();
+    state->remaining = bands - 1;
+    for (size_t b = begin + bandSize; b < end; b += bandSize) {
+        const size_t e = std::min(end, b + bandSize);
+        submit([state, &body, b, e] {
+            body(b, e);
+            std::lock_guard<std::mutex> lock(state->mtx);
+            if (--state->remaining == 0) {
+                state->done.notify_all();
+            }
+        }, priority);
+    }
+
+    body(begin, std::min(end, begin + bandSize));
+
+    // Help rather than block: a band may be sitting in our own deque, and
+    // there may be no other worker free to take it. Only tasks at our own
+    // priority or above, so encode-path bands never wait behind analytics.
+    const size_t self = current_worker();
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(state->mtx);
+            if (state->remaining == 0) {
+                return;
+            }
+        }
+        Task task;
+        bool stolen = false;
+        if (!take(self, task, stolen, priority)) {
+            break;
+        }
+        run(self, task, stolen);
+    }
+
+    // Nothing left to take: the remaining bands are running elsewhere
+    std::unique_lock<std::mutex> lock(state->mtx);
+    state->done.wait(lock, [&] { return state->remaining == 0; });
+}
+
+std::vector<WorkerStats> ThreadPool::stats() const
+{
+    const double elapsedNs = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startedAt_)
+            .count());
+
+    std::vector<WorkerStats> result;
+    result.reserve(workers_.size());
+    for (const auto& worker : workers_) {
+        WorkerStats stats;
+        stats.tasks = worker->tasks.load(std::memory_order_relaxed);
+        stats.stolen = worker->stolen.load(std::memory_order_relaxed);
+        stats.busy = std::chrono::nanoseconds(worker->busyNs.load(std::memory_order_relaxed));
+        if (elapsedNs > 0.0) {
+            stats.utilisation = std::min(1.0, static_cast<double>(stats.busy.count()) / elapsedNs);
+        }
+        result.push_back(stats);
+    }
+    return result;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void ThreadPool::worker_loop(size_t index)
+{
+    tls_pool = this;
+    tls_index = index;
+
+    for (;;) {
+        Task task;
+        bool stolen = false;
+        if (take(index, task, stolen)) {
+            run(index, task, stolen);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMtx_);
+        wake_.wait(lock, [this] { return pending_.load() > 0 || !running_; });
+        if (!running_ && pending_.load() == 0) {
+            return;
+        }
+    }
+}
+
+size_t ThreadPool::current_worker() const noexcept
+{
+    return tls_pool == this ? tls_index : kNoWorker;
+}
+
+void ThreadPool::push(size_t index, Task task, TaskPriority priority)
+{
+    Worker& worker = *workers_[index];
+    {
+        std::lock_guard<std::mutex> lock(worker.mtx);
+        worker.queues[static_cast<size_t>(priority)].push_back(std::move(task));
+    }
+    {
+        // Counted under the sleep lock so a worker about to wait can't miss it
+        std::lock_guard<std::mutex> lock(sleepMtx_);
+        pending_.fetch_add(1);
+    }
+    wake_.notify_one();
+}
+
+// Critical work anywhere beats Background work at home. Within a priority,
+// the own deque is popped from the back (newest, cache-warm) and others are
+// robbed from the front (oldest, least likely to be touched by their owner).
+// Nothing below `lowest` is taken.
+bool ThreadPool::take(size_t self, Task& task, bool& stolen, TaskPriority lowest)
+{
+    const size_t count = workers_.size();
+    for (size_t priority = 0; priority <= static_cast<size_t>(lowest); ++priority) {
+        if (self != kNoWorker) {
+            Worker& own = *workers_[self];
+            std::lock_guard<std::mutex> lock(own.mtx);
+            auto& queue = own.queues[priority];
+            if (!queue.empty()) {
+                task = std::move(queue.back());
+                queue.pop_back();
+                pending_.fetch_sub(1);
+                stolen = false;
+                return true;
+            }
+        }
+
+        const size_t first = self == kNoWorker ? 0 : self + 1;
+        for (size_t n = 0; n < count; ++n) {
+            const size_t victim = (first + n) % count;
+            if (victim == self) {
+                continue;
+            }
+            Worker& other = *workers_[victim];
+            std::lock_guard<std::mutex> lock(other.mtx);
+            auto& queue = other.queues[priority];
+            if (!queue.empty()) {
+                task = std::move(queue.front());
+                queue.pop_front();
+                pending_.fetch_sub(1);
+                stolen = true;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::run(size_t self, Task& task, bool stolen)
+{
+    const auto begin = std::chrono::steady_clock::now();
+    task();
+    if (self == kNoWorker) {
+        return; // a helping caller; its time isn't the pool's
+    }
+
+    Worker& worker = *workers_[self];
+    worker.busyNs.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count(),
+        std::memory_order_relaxed);
+    worker.tasks.fetch_add(1, std::memory_order_relaxed);
+    if (stolen) {
+        worker.stolen.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+} // namespace pcs
@@ -0,0 +1,208 @@
+#include "ts_muxer.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace pcs {
+
+namespace {
+
+constexpr uint8_t kSyncByte = 0x47;
+constexpr uint8_t kStreamTypeH264 = 0x1B;
+constexpr uint16_t kProgramNumber = 1;
+// PCR runs this far behind DTS, the decoder's buffering allowance
+constexpr int64_t kPcrDelay = 63000;
+constexpr int64_t kTimestampMask = (int64_t{1} << 33) - 1;
+
+// Access unit delimiter, any slice type
+constexpr uint8_t kAud[] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0};
+
+bool starts_with_aud(std::span<const uint8_t> data)
+{
+    // 3- or 4-byte start code followed by NAL type 9
+    if (data.size() >= 4 && data[0] == 0 && data[1] == 0 && data[2] == 1) {
+        return (data[3] & 0x1F) == 9;
+    }
+    if (data.size() >= 5 && data[0] == 0 && data[1] == 0 && data[2] == 0 && data[3] == 1) {
+        return (data[4] & 0x1F) == 9;
+    }
+    return false;
+}
+
+void put_timestamp(std::vector<uint8_t>& out, uint8_t marker, int64_t ts)
+{
+    ts &= kTimestampMask;
+    out.push_back(static_cast<uint8_t>(marker << 4 | ((ts >> 29) & 0x0E) | 1));
+    out.push_back(static_cast<uint8_t>(ts >> 22));
+    out.push_back(static_cast<uint8_t>(((ts >> 14) & 0xFE) | 1));
+    out.push_back(static_cast<uint8_t>(ts >> 7));
+    out.push_back(static_cast<uint8_t>(((ts << 1) & 0xFE) | 1));
+}
+
+// One 188-byte packet carrying as much of `payload` as fits; returns how
+// much it took. `pcr` < 0 means none.
+size_t write_packet(std::vector<uint8_t>& out, uint16_t pid, uint8_t& counter, bool unitStart,
+                    const uint8_t* payload, size_t size, int64_t pcr, bool randomAccess)
+{
+    uint8_t packet[TsMuxer::kPacketSize];
+    packet[0] = kSyncByte;
+    packet[1] = static_cast<uint8_t>((unitStart ? 0x40 : 0x00) | (pid >> 8));
+    packet[2] = static_cast<uint8_t>(pid);
+
+    // Adaptation field: PCR and random access flag, plus stuffing to fill
+    // the packet when the payload is short
+    uint8_t adaptation[TsMuxer::kPacketSize];
+    size_t adaptationLength = 0; // bytes after the length byte
+    if (pcr >= 0 || randomAccess) {
+        adaptation[adaptationLength++] = static_cast<uint8_t>((randomAccess ? 0x40 : 0) | (pcr >= 0 ? 0x10 : 0));
+        if (pcr >= 0) {
+            const int64_t base = pcr & kTimestampMask;
+            adaptation[adaptationLength++] = static_cast<uint8_t>(base >> 25);
+            adaptation[adaptationLength++] = static_cast<uint8_t>(base >> 17);
+            adaptation[adaptationLength++] = static_cast<uint8_t>(base >> 9);
+            adaptation[adaptationLength++] = static_cast<uint8_t>(base >> 1);
+            adaptation[adaptationLength++] = static_cast<uint8_t>((base & 1) << 7 | 0x7E);
+            adaptation[adaptationLength++] = 0; // 27 MHz extension
+        }
+    }
+    const bool hasAdaptation = adaptationLength > 0;
+    size_t room = TsMuxer::kPacketSize - 4 - (hasAdaptation ? 1 + adaptationLength : 0);
+    if (size < room) {
+        // Stuff: an adaptation field grows to absorb the gap
+        size_t gap = room - size;
+        if (!hasAdaptation) {
+            --gap; // the length byte itself
+            if (gap > 0) {
+                adaptation[adaptationLength++] = 0x00; // flags
+                --gap;
+            }
+        }
+        std::memset(adaptation + adaptationLength, 0xFF, gap);
+        adaptationLength += gap;
+        room = size;
+    }
+
+    const bool anyAdaptation = hasAdaptation || room < TsMuxer::kPacketSize - 4;
+    packet[3] = static_cast<uint8_t>((anyAdaptation ? 0x30 : 0x10) | (counter & 0x0F));
+    counter = static_cast<uint8_t>((counter + 1) & 0x0F);
+
+    size_t pos = 4;
+    if (anyAdaptation) {
+        packet[pos++] = static_cast<uint8_t>(adaptationLength);
+        std::memcpy(packet + pos, adaptation, adaptationLength);
+        pos += adaptationLength;
+    }
+    const size_t taken = std::min(room, size);
+    std::memcpy(packet + pos, payload, taken);
+    out.insert(out.end(), packet, packet + TsMuxer::kPacketSize);
+    return taken;
+}
+
+} // namespace
+
+uint32_t mpegCrc32(const uint8_t* data, size_t size) noexcept
+{
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= static_cast<uint32_t>(data[i]) << 24;
+        for (int bit = 0; bit < 8; ++bit) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+void TsMuxer::writeTables(std::vector<uint8_t>& out)
+{
+    // PAT: program 1 -> PMT
+    std::vector<uint8_t> pat = {
+        0x00,             // table_id
+        0xB0, 0x0D,       // section length 13
+        0x00, 0x01,       // transport_stream_id
+        0xC1, 0x00, 0x00, // version 0, current, section 0 of 0
+        static_cast<uint8_t>(kProgramNumber >> 8), static_cast<uint8_t>(kProgramNumber),
+        static_cast<uint8_t>(0xE0 | kPmtPid >> 8), static_cast<uint8_t>(kPmtPid),
+    };
+    write_section(0x0000, patCounter_, pat, out);
+
+    // PMT: one H.264 stream, which also carries the PCR
+    std::vector<uint8_t> pmt = {
+        0x02,             // table_id
+        0xB0, 0x12,       // section length 18
+        static_cast<uint8_t>(kProgramNumber >> 8), static_cast<uint8_t>(kProgramNumber),
+        0xC1, 0x00, 0x00,
+        static_cast<uint8_t>(0xE0 | kVideoPid >> 8), static_cast<uint8_t>(kVideoPid), // PCR PID
+        0xF0, 0x00,       // no program descriptors
+        kStreamTypeH264,
+        static_cast<uint8_t>(0xE0 | kVideoPid >> 8), static_cast<uint8_t>(kVideoPid),
+        0xF0, 0x00,       // no stream descriptors
+    };
+    write_section(kPmtPid, pmtCounter_, pmt, out);
+}
+
+void TsMuxer::writeFrame(const EncodedFrame& frame, std::vector<uint8_t>& out)
+{
+    writePacket(frame.data, frame.pts, frame.dts, frame.keyframe, out);
+}
+
+void TsMuxer::writePacket(std::span<const uint8_t> data, int64_t framePts, int64_t frameDts, bool keyframe,
+                          std::vector<uint8_t>& out)
+{
+    if (keyframe) {
+        writeTables(out);
+    }
+
+    const int64_t pts = framePts + kTimestampOffset;
+    const int64_t dts = frameDts + kTimestampOffset;
+    const bool withDts = dts != pts;
+
+    std::vector<uint8_t> pes = {0x00, 0x00, 0x01, 0xE0, 0x00, 0x00}; // video stream, unbounded length
+    pes.push_back(0x80);                                            // marker bits
+    pes.push_back(withDts ? 0xC0 : 0x80);
+    pes.push_back(withDts ? 10 : 5);
+    put_timestamp(pes, withDts ? 0x3 : 0x2, pts);
+    if (withDts) {
+        put_timestamp(pes, 0x1, dts);
+    }
+    if (!starts_with_aud(data)) {
+        pes.insert(pes.end(), std::begin(kAud), std::end(kAud));
+    }
+    pes.insert(pes.end(), data.begin(), data.end());
+
+    out.reserve(out.size() + (pes.size() / (kPacketSize - 4) + 2) * kPacketSize);
+    const int64_t pcr = keyframe ? std::max<int64_t>(0, dts - kPcrDelay) : -1;
+    size_t offset = 0;
+    bool first = true;
+    while (offset < pes.size()) {
+        offset += write_packet(out, kVideoPid, videoCounter_, first, pes.data() + offset, pes.size() - offset,
+                               first ? pcr : -1, first && keyframe);
+        first = false;
+    }
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+void TsMuxer::write_section(uint16_t pid, uint8_t& counter, const std::vector<uint8_t>& section,
+                            std::vector<uint8_t>& out)
+{
+    std::vector<uint8_t> payload;
+    payload.reserve(section.size() + 5);
+    payload.push_back(0x00); // pointer field
+    payload.insert(payload.end(), section.begin(), section.end());
+    const uint32_t crc = mpegCrc32(section.data(), section.size());
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        payload.push_back(static_cast<uint8_t>(crc >> shift));
+    }
+
+    // Tables are short; pad the rest of the packet with 0xFF, as PSI expects,
+    // rather than an adaptation field
+    payload.resize(kPacketSize - 4, 0xFF);
+    write_packet(out, pid, counter, true, payload.data(), payload.size(), -1, false);
+}
+
+} // namespace pcs
@@ -0,0 +1,536 @@
+#include "v4l2_capture.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/videodev2.h>
+#include <mutex>
+#include <unistd.h>
+
+namespace pcs {
+
+namespace {
+
+std::string fourcc_name(uint32_t fourcc)
+{
+    std::string name(4, ' ');
+    for (int i = 0; i < 4; ++i) {
+        name[i] = static_cast<char>((fourcc >> (8 * i)) & 0xff);
+    }
+    return name;
+}
+
+Frame::Timestamp buffer_timestamp(const v4l2_buffer& buf)
+{
+    // CLOCK_MONOTONIC is what std::chrono::steady_clock reads on Linux
+    if ((buf.flags & V4L2_BUF_FLAG_TIMESTAMP_MASK) == V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC &&
+        (buf.timestamp.tv_sec != 0 || buf.timestamp.tv_usec != 0)) {
+        return Frame::Timestamp(std::chrono::seconds(buf.timestamp.tv_sec) +
+                                std::chrono::microseconds(buf.timestamp.tv_usec));
+    }
+    return std::chrono::steady_clock::now();
+}
+
+} // namespace
+
+uint32_t toFourcc(PixelFormat format) noexcept
+{
+    switch (format) {
+        case PixelFormat::Gray8: return V4L2_PIX_FMT_GREY;
+        case PixelFormat::BGR24: return V4L2_PIX_FMT_BGR24;
+        case PixelFormat::YUYV:  return V4L2_PIX_FMT_YUYV;
+        case PixelFormat::NV12:  return V4L2_PIX_FMT_NV12;
+        case PixelFormat::I420:  return V4L2_PIX_FMT_YUV420;
+        case PixelFormat::MJPEG: return V4L2_PIX_FMT_MJPEG;
+        default: return 0;
+    }
+}
+
+PixelFormat fromFourcc(uint32_t fourcc) noexcept
+{
+    switch (fourcc) {
+        case V4L2_PIX_FMT_GREY:   return PixelFormat::Gray8;
+        case V4L2_PIX_FMT_BGR24:  return PixelFormat::BGR24;
+        case V4L2_PIX_FMT_YUYV:   return PixelFormat::YUYV;
+        case V4L2_PIX_FMT_NV12:   return PixelFormat::NV12;
+        case V4L2_PIX_FMT_YUV420: return PixelFormat::I420;
+        case V4L2_PIX_FMT_MJPEG:
+        case V4L2_PIX_FMT_JPEG:   return PixelFormat::MJPEG;
+        default: return PixelFormat::Unknown;
+    }
+}
+
+// ============================================================================
+// Shared buffer state
+// ============================================================================
+
+// Owns the device and the mappings. Frames keep it alive through their
+// releasers, so mapped memory outlives close() until the last frame is gone.
+struct V4l2Capture::State {
+    struct Buffer {
+        void* address{nullptr};
+        size_t length{0};
+        int dmabufFd{-1};
+        bool queued{false};   // owned by the driver
+        bool inFlight{false}; // viewed by at least one frame
+    };
+
+    std::unique_ptr<V4l2Device> device;
+    std::vector<Buffer> buffers;
+    std::mutex mtx;
+    bool streaming{false};
+
+    ~State()
+    {
+        for (auto& buffer : buffers) {
+            if (buffer.address) {
+                device->unmap(buffer.address, buffer.length);
+            }
+            if (buffer.dmabufFd >= 0) {
+                ::close(buffer.dmabufFd);
+            }
+        }
+        if (!buffers.empty()) {
+            v4l2_requestbuffers req{};
+            req.count = 0;
+            req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            req.memory = V4L2_MEMORY_MMAP;
+            device->ioctl(VIDIOC_REQBUFS, &req);
+        }
+    }
+
+    // Caller holds mtx
+    bool queue(uint32_t index)
+    {
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = index;
+        if (device->ioctl(VIDIOC_QBUF, &buf) < 0) {
+            PCS_LOG_EVERY(spdlog::level::warn, std::chrono::seconds(1), "V4L2: QBUF {} failed: {}", index,
+                          std::strerror(errno));
+            return false;
+        }
+        buffers[index].queued = true;
+        return true;
+    }
+
+    void release(uint32_t index)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        buffers[index].inFlight = false;
+        if (streaming) {
+            queue(index);
+        }
+    }
+};
+
+// ============================================================================
+// Constructor / Destructor
+// ============================================================================
+
+V4l2Capture::V4l2Capture(const V4l2Config& config, std::unique_ptr<V4l2Device> device)
+    : config_(config),
+      pendingDevice_(std::move(device))
+{
+}
+
+V4l2Capture::~V4l2Capture()
+{
+    close();
+}
+
+// ============================================================================
+// Public Methods
+// ============================================================================
+
+bool V4l2Capture::open()
+{
+    if (state_) {
+        return true;
+    }
+
+    std::unique_ptr<V4l2Device> device = std::move(pendingDevice_);
+    if (!device) {
+        device = SystemV4l2Device::open(config_.device);
+        if (!device) {
+            return false;
+        }
+    }
+
+    v4l2_capability cap{};
+    if (device->ioctl(VIDIOC_QUERYCAP, &cap) < 0) {
+        Logger::error("V4L2 {}: QUERYCAP failed: {}", config_.device, std::strerror(errno));
+        return false;
+    }
+    uint32_t caps = (cap.capabilities & V4L2_CAP_DEVICE_CAPS) ? cap.device_caps : cap.capabilities;
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING)) {
+        Logger::error("V4L2 {}: not a streaming capture device", config_.device);
+        return false;
+    }
+
+    if (!negotiate_format(*device)) {
+        return false;
+    }
+    negotiate_rate(*device);
+
+    state_ = std::make_shared<State>();
+    state_->device = std::move(device);
+    if (!map_buffers()) {
+        state_.reset();
+        return false;
+    }
+
+    Logger::info("V4L2 {}: {}x{} {} @ {} fps, {} buffers{}", config_.device, width_, height_,
+                 pixelFormatName(format_), fps_, state_->buffers.size(),
+                 packed_ ? "" : " (padded rows, copying)");
+    return true;
+}
+
+bool V4l2Capture::start()
+{
+    if (!state_ && !open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    if (state_->streaming) {
+        return true;
+    }
+
+    for (uint32_t i = 0; i < state_->buffers.size(); ++i) {
+        const auto& buffer = state_->buffers[i];
+        if (!buffer.queued && !buffer.inFlight && !state_->queue(i)) {
+            return false;
+        }
+    }
+
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (state_->device->ioctl(VIDIOC_STREAMON, &type) < 0) {
+        Logger::error("V4L2 {}: STREAMON failed: {}", config_.device, std::strerror(errno));
+        return false;
+    }
+    state_->streaming = true;
+    lastSequence_.reset();
+    return true;
+}
+
+void V4l2Capture::stop()
+{
+    if (!state_) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    if (!state_->streaming) {
+        return;
+    }
+
+    // STREAMOFF returns every queued buffer to userspace
+    int type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    state_->device->ioctl(VIDIOC_STREAMOFF, &type);
+    state_->streaming = false;
+    for (auto& buffer : state_->buffers) {
+        buffer.queued = false;
+    }
+}
+
+void V4l2Capture::close()
+{
+    stop();
+    state_.reset();
+}
+
+bool V4l2Capture::read(Frame& frame, std::chrono::milliseconds timeout)
+{
+    if (!isStreaming()) {
+        return false;
+    }
+    if (!state_->device->waitReadable(timeout)) {
+        return false;
+    }
+
+    // Built under the lock but assigned after it: overwriting `frame` may
+    // release the buffer it viewed, which takes the same lock
+    Frame captured;
+    std::unique_lock<std::mutex> lock(state_->mtx);
+    if (!state_->streaming) {
+        return false;
+    }
+
+    v4l2_buffer buf{};
+    buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buf.memory = V4L2_MEMORY_MMAP;
+    if (state_->device->ioctl(VIDIOC_DQBUF, &buf) < 0) {
+        if (errno != EAGAIN) {
+            PCS_LOG_EVERY(spdlog::level::warn, std::chrono::seconds(1), "V4L2 {}: DQBUF failed: {}", config_.device,
+                          std::strerror(errno));
+        }
+        return false;
+    }
+    if (buf.index >= state_->buffers.size()) {
+        return false;
+    }
+
+    auto& buffer = state_->buffers[buf.index];
+    buffer.queued = false;
+
+    if (buf.flags & V4L2_BUF_FLAG_ERROR) {
+        state_->queue(buf.index);
+        return false;
+    }
+
+    if (lastSequence_ && buf.sequence > *lastSequence_ + 1) {
+        dropped_.fetch_add(buf.sequence - *lastSequence_ - 1, std::memory_order_relaxed);
+    }
+    lastSequence_ = buf.sequence;
+
+    const auto* data = static_cast<const uint8_t*>(buffer.address);
+    size_t bytesUsed = buf.bytesused ? buf.bytesused : buffer.length;
+    bytesUsed = std::min(bytesUsed, buffer.length);
+    const Frame::Timestamp timestamp = buffer_timestamp(buf);
+
+    if (!packed_) {
+        captured = repack(data, bytesUsed);
+        state_->queue(buf.index);
+    } else {
+        size_t size = frameBytes_ ? frameBytes_ : bytesUsed;
+        if (size > bytesUsed) {
+            PCS_LOG_EVERY(spdlog::level::warn, std::chrono::seconds(1), "V4L2 {}: short buffer ({} of {} bytes)",
+                          config_.device, bytesUsed, size);
+            state_->queue(buf.index);
+            return false;
+        }
+
+        buffer.inFlight = true;
+        uint32_t index = buf.index;
+        std::shared_ptr<const uint8_t> storage(data, [state = state_, index](const uint8_t*) {
+            state->release(index);
+        });
+        captured = Frame(std::move(storage), size, width_, height_, format_);
+    }
+    lock.unlock();
+
+    captured.setTimestamp(timestamp);
+    frame = std::move(captured);
+    captured_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+bool V4l2Capture::isStreaming() const noexcept
+{
+    if (!state_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return state_->streaming;
+}
+
+size_t V4l2Capture::bufferCount() const noexcept
+{
+    return state_ ? state_->buffers.size() : 0;
+}
+
+size_t V4l2Capture::buffersInFlight() const noexcept
+{
+    if (!state_) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(state_->mtx);
+    return static_cast<size_t>(std::count_if(state_->buffers.begin(), state_->buffers.end(),
+                                             [](const State::Buffer& b) { return b.inFlight; }));
+}
+
+std::optional<int> V4l2Capture::dmabufFd(const Frame& frame) const
+{
+    if (!state_ || !frame.isExternal()) {
+        return std::nullopt;
+    }
+    for (const auto& buffer : state_->buffers) {
+        if (buffer.address == frame.dataPtr() && buffer.dmabufFd >= 0) {
+            return buffer.dmabufFd;
+        }
+    }
+    return std::nullopt;
+}
+
+// ============================================================================
+// Private Methods
+// ============================================================================
+
+bool V4l2Capture::negotiate_format(V4l2Device& device)
+{
+    std::vector<uint32_t> supported;
+    for (uint32_t index = 0;; ++index) {
+        v4l2_fmtdesc desc{};
+        desc.index = index;
+        desc.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        if (device.ioctl(VIDIOC_ENUM_FMT, &desc) < 0) {
+            break;
+        }
+        supported.push_back(desc.pixelformat);
+    }
+
+    uint32_t wanted = 0;
+    for (PixelFormat format : config_.formats) {
+        uint32_t fourcc = toFourcc(format);
+        if (fourcc && std::find(supported.begin(), supported.end(), fourcc) != supported.end()) {
+            wanted = fourcc;
+            break;
+        }
+    }
+    if (!wanted) {
+        std::string names;
+        for (uint32_t fourcc : supported) {
+            names += (names.empty() ? "" : ", ") + fourcc_name(fourcc);
+        }
+        Logger::error("V4L2 {}: none of the requested formats supported (device offers: {})",
+                      config_.device, names.empty() ? "nothing" : names);
+        return false;
+    }
+
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    fmt.fmt.pix.width = config_.width;
+    fmt.fmt.pix.height = config_.height;
+    fmt.fmt.pix.pixelformat = wanted;
+    fmt.fmt.pix.field = V4L2_FIELD_NONE;
+    if (device.ioctl(VIDIOC_S_FMT, &fmt) < 0) {
+        Logger::error("V4L2 {}: S_FMT {} failed: {}", config_.device, fourcc_name(wanted),
+                      std::strerror(errno));
+        return false;
+    }
+    if (fmt.fmt.pix.pixelformat != wanted) {
+        Logger::error("V4L2 {}: driver replaced {} with {}", config_.device,
+                      fourcc_name(wanted), fourcc_name(fmt.fmt.pix.pixelformat));
+        return false;
+    }
+
+    format_ = fromFourcc(wanted);
+    width_ = fmt.fmt.pix.width;
+    height_ = fmt.fmt.pix.height;
+    bytesPerLine_ = fmt.fmt.pix.bytesperline;
+    if (width_ != config_.width || height_ != config_.height) {
+        Logger::warn("V4L2 {}: driver adjusted {}x{} to {}x{}", config_.device,
+                     config_.width, config_.height, width_, height_);
+    }
+
+    Frame probe(nullptr, 0, width_, height_, format_);
+    frameBytes_ = probe.expectedSize();
+    packed_ = probe.isCompressed() || bytesPerLine_ == 0 ||
+              bytesPerLine_ == width_ * probe.channels();
+    return true;
+}
+
+void V4l2Capture::negotiate_rate(V4l2Device& device)
+{
+    fps_ = config_.fps;
+
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    parm.parm.capture.timeperframe.numerator = 1;
+    parm.parm.capture.timeperframe.denominator = config_.fps;
+    if (device.ioctl(VIDIOC_S_PARM, &parm) < 0) {
+        Logger::warn("V4L2 {}: cannot set frame rate: {}", config_.device, std::strerror(errno));
+        return;
+    }
+
+    const auto& tpf = parm.parm.capture.timeperframe;
+    if (tpf.numerator > 0 && tpf.denominator > 0) {
+        fps_ = tpf.denominator / tpf.numerator;
+    }
+}
+
+bool V4l2Capture::map_buffers()
+{
+    V4l2Device& device = *state_->device;
+
+    v4l2_requestbuffers req{};
+    req.count = std::max(2u, config_.buffer_count);
+    req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    req.memory = V4L2_MEMORY_MMAP;
+    if (device.ioctl(VIDIOC_REQBUFS, &req) < 0) {
+        Logger::error("V4L2 {}: REQBUFS failed: {}", config_.device, std::strerror(errno));
+        return false;
+    }
+    if (req.count < 2) {
+        Logger::error("V4L2 {}: driver granted only {} buffer(s)", config_.device, req.count);
+        return false;
+    }
+
+    state_->buffers.resize(req.count);
+    for (uint32_t i = 0; i < req.count; ++i) {
+        v4l2_buffer buf{};
+        buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        buf.memory = V4L2_MEMORY_MMAP;
+        buf.index = i;
+        if (device.ioctl(VIDIOC_QUERYBUF, &buf) < 0) {
+            Logger::error("V4L2 {}: QUERYBUF {} failed: {}", config_.device, i, std::strerror(errno));
+            return false;
+        }
+
+        auto& buffer = state_->buffers[i];
+        buffer.address = device.map(buf.length, buf.m.offset);
+        if (!buffer.address) {
+            Logger::error("V4L2 {}: mmap of buffer {} failed", config_.device, i);
+            return false;
+        }
+        buffer.length = buf.length;
+
+        if (config_.export_dmabuf) {
+            v4l2_exportbuffer expbuf{};
+            expbuf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+            expbuf.index = i;
+            expbuf.flags = O_RDONLY | O_CLOEXEC;
+            if (device.ioctl(VIDIOC_EXPBUF, &expbuf) == 0) {
+                buffer.dmabufFd = expbuf.fd;
+            } else {
+                Logger::warn("V4L2 {}: EXPBUF {} failed: {}", config_.device, i, std::strerror(errno));
+            }
+        }
+    }
+    return true;
+}
+
+// Copy a buffer with padded rows into a tightly packed frame
+Frame V4l2Capture::repack(const uint8_t* data, size_t bytesUsed) const
+{
+    Frame frame(std::vector<uint8_t>(), width_, height_, format_);
+    std::vector<uint8_t> packed(frame.expectedSize());
+
+    struct Plane { uint32_t rowBytes, rows, stride; };
+    std::vector<Plane> planes;
+    const uint32_t chromaRows = (height_ + 1) / 2;
+    switch (format_) {
+        case PixelFormat::NV12:
+            planes = {{width_, height_, bytesPerLine_}, {width_, chromaRows, bytesPerLine_}};
+            break;
+        case PixelFormat::I420:
+            planes = {{width_, height_, bytesPerLine_},
+                      {(width_ + 1) / 2, chromaRows, bytesPerLine_ / 2},
+                      {(width_ + 1) / 2, chromaRows, bytesPerLine_ / 2}};
+            break;
+        default:
+            planes = {{width_ * frame.channels(), height_, bytesPerLine_}};
+            break;
+    }
+
+    uint8_t* out = packed.data();
+    size_t in = 0;
+    for (const auto& plane : planes) {
+        for (uint32_t row = 0; row < plane.rows; ++row) {
+            if (in + plane.rowBytes <= bytesUsed) {
+                std::memcpy(out, data + in, plane.rowBytes);
+            }
+            out += plane.rowBytes;
+            in += plane.stride;
+        }
+    }
+
+    frame.setData(std::move(packed));
+    return frame;
+}
+
+} // namespace pcs
@@ -0,0 +1,61 @@
+#include "v4l2_device.hpp"
+#include "logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace pcs {
+
+std::unique_ptr<SystemV4l2Device> SystemV4l2Device::open(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        Logger::error("V4L2: cannot open {}: {}", path, std::strerror(errno));
+        return nullptr;
+    }
+    return std::unique_ptr<SystemV4l2Device>(new SystemV4l2Device(fd));
+}
+
+SystemV4l2Device::~SystemV4l2Device()
+{
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+int SystemV4l2Device::ioctl(unsigned long request, void* arg)
+{
+    int result;
+    do {
+        result = ::ioctl(fd_, request, arg);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+
+void* SystemV4l2Device::map(size_t length, uint32_t offset)
+{
+    // Populated now, so the first frame in each buffer doesn't page-fault
+    void* address = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, offset);
+    return address == MAP_FAILED ? nullptr : address;
+}
+
+void SystemV4l2Device::unmap(void* address, size_t length)
+{
+    ::munmap(address, length);
+}
+
+bool SystemV4l2Device::waitReadable(std::chrono::milliseconds timeout)
+{
+    pollfd pfd{fd_, POLLIN, 0};
+    int result;
+    do {
+        result = ::poll(&pfd, 1, static_cast<int>(timeout.count()));
+    } while (result < 0 && errno == EINTR);
+    return result > 0 && (pfd.revents & POLLIN);
+}
+
+} // namespace pcs
@@ -0,0 +1,363 @@
+/**
+ * @file benchmark_encoder.cpp
+ * @brief Camera-free encoder benchmark over codecs, resolutions and content.
+ *
+ * Feeds synthetic BGR frames (static scene, slow pan, full-frame noise) through
+ * pcs::Encoder for every available codec, thread count and preset, and reports
+ * throughput, CPU cost, output bitrate and per-frame latency percentiles.
+ *
+ * Usage:
+ *   pi-camera-bench-encoder [--frames N] [--max-height H] [--backend NAME] [--json out.json]
+ */
+
+#include "encoder.hpp"
+#include "logger.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+struct Resolution {
+    const char* name;
+    uint32_t width;
+    uint32_t height;
+};
+
+enum class Content {
+    Static,
+    SlowPan,
+    Noise
+};
+
+struct RunResult {
+    std::string codec;
+    std::string backend;
+    std::string resolution;
+    std::string content;
+    std::string preset;
+    int threads{0};
+    int frames{0};
+    double fps{0.0};
+    double cpu_ms_per_frame{0.0};
+    double bitrate_kbps{0.0};
+    double p50_ms{0.0};
+    double p90_ms{0.0};
+    double p99_ms{0.0};
+    double max_ms{0.0};
+};
+
+constexpr Resolution kResolutions[] = {
+    {"VGA", 640, 480},
+    {"720p", 1280, 720},
+    {"1080p", 1920, 1080},
+    {"4K", 3840, 2160},
+};
+
+const char* contentName(Content content)
+{
+    switch (content) {
+    case Content::Static:  return "static";
+    case Content::SlowPan: return "slow_pan";
+    case Content::Noise:   return "noise";
+    }
+    return "unknown";
+}
+
+// ============================================================================
+// Synthetic Content
+// ============================================================================
+
+// Diagonal gradient with a few hard edges, shifted horizontally by `offset`.
+void fillScene(std::vector<uint8_t>& pixels, uint32_t width, uint32_t height, uint32_t offset)
+{
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* row = pixels.data() + static_cast<size_t>(y) * width * 3;
+        for (uint32_t x = 0; x < width; ++x) {
+            uint32_t sx = x + offset;
+            bool stripe = ((sx / 64) % 2) == 0;
+            row[x * 3 + 0] = static_cast<uint8_t>((sx + y) & 0xFF);
+            row[x * 3 + 1] = static_cast<uint8_t>(stripe ? 200 : 40);
+            row[x * 3 + 2] = static_cast<uint8_t>((sx * 2) & 0xFF);
+        }
+    }
+}
+
+void fillNoise(std::vector<uint8_t>& pixels, uint64_t& state)
+{
+    // xorshift64: fast enough that generation never dominates the run
+    for (size_t i = 0; i + 8 <= pixels.size(); i += 8) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        std::memcpy(pixels.data() + i, &state, 8);
+    }
+}
+
+Frame makeFrame(Content content, const Resolution& res, int index, uint64_t& rng)
+{
+    std::vector<uint8_t> pixels(static_cast<size_t>(res.width) * res.height * 3);
+    switch (content) {
+    case Content::Static:
+        fillScene(pixels, res.width, res.height, 0);
+        break;
+    case Content::SlowPan:
+        fillScene(pixels, res.width, res.height, static_cast<uint32_t>(index) * 2);
+        break;
+    case Content::Noise:
+        fillNoise(pixels, rng);
+        break;
+    }
+    return Frame(std::move(pixels), res.width, res.height, 3);
+}
+
+// ============================================================================
+// Measurement
+// ============================================================================
+
+double processCpuMs()
+{
+    timespec ts{};
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+double percentile(std::vector<double> sorted, double p)
+{
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+bool runOne(const EncoderConfig& config, Content content, const Resolution& res,
+            int frameCount, RunResult& result)
+{
+    Encoder encoder(config);
+    // A backend that fell back to software would be mislabelled in the results
+    if (!encoder.init() || encoder.backend() != config.hw_accel) {
+        return false;
+    }
+
+    // Content is generated up front so only encode() is on the clock
+    constexpr int kDistinctFrames = 30;
+    uint64_t rng = 0x9E3779B97F4A7C15ULL;
+    std::vector<Frame> frames;
+    int distinct = content == Content::Static ? 1 : std::min(frameCount, kDistinctFrames);
+    for (int i = 0; i < distinct; ++i) {
+        frames.push_back(makeFrame(content, res, i, rng));
+    }
+
+    std::vector<double> latencies;
+    latencies.reserve(frameCount);
+    size_t totalBytes = 0;
+
+    double cpuStart = processCpuMs();
+    auto wallStart = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < frameCount; ++i) {
+        Frame& frame = frames[i % frames.size()];
+        frame.setTimestampNow();
+
+        auto t0 = std::chrono::steady_clock::now();
+        auto encoded = encoder.encode(frame);
+        auto t1 = std::chrono::steady_clock::now();
+
+        latencies.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        if (encoded) {
+            totalBytes += encoded->data.size();
+        }
+    }
+
+    std::vector<EncodedFrame> tail;
+    encoder.flush(tail);
+    for (const auto& packet : tail) {
+        totalBytes += packet.data.size();
+    }
+
+    double wallMs = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - wallStart).count();
+    double cpuMs = processCpuMs() - cpuStart;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    result.frames = frameCount;
+    result.fps = frameCount / (wallMs / 1000.0);
+    result.cpu_ms_per_frame = cpuMs / frameCount;
+    // Bitrate at the configured capture rate, not the benchmark's encode rate
+    result.bitrate_kbps = (totalBytes * 8.0 / frameCount) * config.fps / 1000.0;
+    result.p50_ms = percentile(latencies, 0.50);
+    result.p90_ms = percentile(latencies, 0.90);
+    result.p99_ms = percentile(latencies, 0.99);
+    result.max_ms = latencies.back();
+    return true;
+}
+
+// ============================================================================
+// Reporting
+// ============================================================================
+
+void printResult(const RunResult& r)
+{
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "[BENCHMARK] " << std::setw(6) << std::left << r.codec
+              << std::setw(6) << r.resolution
+              << std::setw(9) << r.content
+              << std::setw(10) << r.preset
+              << " thr=" << r.threads
+              << " | " << std::setw(8) << std::right << r.fps << " fps"
+              << " | cpu " << std::setw(7) << r.cpu_ms_per_frame << " ms/f"
+              << " | " << std::setw(9) << r.bitrate_kbps << " kbps"
+              << " | p50 " << r.p50_ms << " p90 " << r.p90_ms
+              << " p99 " << r.p99_ms << " max " << r.max_ms << " ms"
+              << std::endl;
+}
+
+bool writeJson(const std::string& path, const std::vector<RunResult>& results, int frameCount)
+{
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n";
+    out << "  \"benchmark\": \"encoder\",\n";
+    out << "  \"timestamp\": " << std::time(nullptr) << ",\n";
+    out << "  \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"frames_per_run\": " << frameCount << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "    {\"codec\": \"" << r.codec << "\", \"backend\": \"" << r.backend
+            << "\", \"resolution\": \"" << r.resolution
+            << "\", \"content\": \"" << r.content << "\", \"preset\": \"" << r.preset
+            << "\", \"threads\": " << r.threads << ", \"frames\": " << r.frames
+            << ", \"fps\": " << r.fps << ", \"cpu_ms_per_frame\": " << r.cpu_ms_per_frame
+            << ", \"bitrate_kbps\": " << r.bitrate_kbps
+            << ", \"latency_ms\": {\"p50\": " << r.p50_ms << ", \"p90\": " << r.p90_ms
+            << ", \"p99\": " << r.p99_ms << ", \"max\": " << r.max_ms << "}}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return static_cast<bool>(out);
+}
+
+void usage(const char* argv0)
+{
+    std::cerr << "Usage: " << argv0
+              << " [--frames N] [--max-height H] [--backend software|v4l2m2m|omx] [--json PATH]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    int frameCount = 120;
+    uint32_t maxHeight = 2160;
+    std::string backend = "software";
+    std::string jsonPath;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frameCount = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--max-height" && i + 1 < argc) {
+            maxHeight = static_cast<uint32_t>(std::atoi(argv[++i]));
+        } else if (arg == "--backend" && i + 1 < argc) {
+            backend = argv[++i];
+        } else if (arg == "--json" && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    // Keep libav/encoder chatter out of the results
+    Logger::init("benchmark_encoder.log", "warn");
+
+    std::vector<int> threadCounts{1};
+    for (int t = 2; t <= static_cast<int>(std::thread::hardware_concurrency()); t *= 2) {
+        threadCounts.push_back(t);
+    }
+
+    const std::vector<std::pair<CodecType, std::vector<std::string>>> codecs = {
+        {CodecType::MJPEG, {"default"}},
+        {CodecType::H264, {"ultrafast", "veryfast", "medium"}},
+    };
+
+    std::vector<RunResult> results;
+
+    for (const auto& [codec, presets] : codecs) {
+        EncoderConfig probe;
+        probe.codec = codec;
+        probe.hw_accel = backend;
+        if (!Encoder::isAvailable(probe)) {
+            std::cout << "[SKIP] " << (codec == CodecType::MJPEG ? "MJPEG" : "H264")
+                      << " encoder not available" << std::endl;
+            continue;
+        }
+
+        for (const auto& res : kResolutions) {
+            if (res.height > maxHeight) {
+                continue;
+            }
+            for (Content content : {Content::Static, Content::SlowPan, Content::Noise}) {
+                for (const auto& preset : presets) {
+                    for (int threads : threadCounts) {
+                        EncoderConfig config;
+                        config.codec = codec;
+                        config.width = static_cast<int>(res.width);
+                        config.height = static_cast<int>(res.height);
+                        config.threads = threads;
+                        config.hw_accel = backend;
+                        if (preset != "default") {
+                            config.preset = preset;
+                        }
+
+                        RunResult result;
+                        result.codec = codec == CodecType::MJPEG ? "MJPEG" : "H264";
+                        result.backend = backend;
+                        result.resolution = res.name;
+                        result.content = contentName(content);
+                        result.preset = preset;
+                        result.threads = threads;
+
+                        if (!runOne(config, content, res, frameCount, result)) {
+                            std::cout << "[SKIP] " << result.codec << " " << res.name
+                                      << " failed to open" << std::endl;
+                            continue;
+                        }
+                        printResult(result);
+                        results.push_back(result);
+                    }
+                }
+            }
+        }
+    }
+
+    if (!jsonPath.empty()) {
+        if (!writeJson(jsonPath, results, frameCount)) {
+            std::cerr << "Failed to write " << jsonPath << std::endl;
+            return 1;
+        }
+        std::cout << "Results written to " << jsonPath << std::endl;
+    }
+
+    Logger::shutdown();
+    return results.empty() ? 1 : 0;
+}
@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+#include "logger.hpp"
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// ============================================================================
+// Logging Cost Benchmarks
+// ============================================================================
+
+// Per-call cost seen by the logging threads, i.e. what a stage thread pays
+// for a log line; the async writer's own time is not counted
+class LoggerPerformance : public ::testing::Test {
+protected:
+    static constexpr int THREADS = 4;
+    static constexpr int CALLS_PER_THREAD = 10000;
+
+    std::filesystem::path m_path;
+
+    void SetUp() override
+    {
+        m_path = std::filesystem::temp_directory_path() /
+                 ("pcs-logger-bench-" + std::to_string(::getpid()) + ".log");
+        Logger::shutdown();
+    }
+
+    void TearDown() override
+    {
+        Logger::shutdown();
+        std::filesystem::remove(m_path);
+    }
+
+    double measureNsPerCall(const LogOptions& options)
+    {
+        Logger::init(m_path.string(), "info", options);
+        Logger::info("warmup");
+
+        std::vector<double> threadNs(THREADS);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < THREADS; ++t) {
+            threads.emplace_back([t, &threadNs] {
+                const auto start = std::chrono::steady_clock::now();
+                for (int i = 0; i < CALLS_PER_THREAD; ++i) {
+                    Logger::info("stage {} frame {} took {} us", t, i, i % 97);
+                }
+                threadNs[t] = std::chrono::duration<double, std::nano>(
+                                  std::chrono::steady_clock::now() - start).count();
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        Logger::shutdown();
+
+        double totalNs = 0;
+        for (double ns : threadNs) {
+            totalNs += ns;
+        }
+        return totalNs / (THREADS * CALLS_PER_THREAD);
+    }
+
+    static void printBenchmark(const std::string& name, double nsPerCall, int threads = THREADS)
+    {
+        std::cout << std::fixed << std::setprecision(1);
+        std::cout << "[BENCHMARK] " << std::setw(40) << std::left << name
+                  << " Avg: " << std::setw(8) << nsPerCall << " ns/call"
+                  << " (" << threads << (threads == 1 ? " thread)" : " threads)") << std::endl;
+    }
+};
+
+TEST_F(LoggerPerformance, SyncFromFourThreads) {
+    printBenchmark("Sync logging", measureNsPerCall({.async = false, .console = false}));
+}
+
+TEST_F(LoggerPerformance, AsyncBlockingFromFourThreads) {
+    printBenchmark("Async logging, block", measureNsPerCall({.async = true, .console = false}));
+}
+
+TEST_F(LoggerPerformance, AsyncOverrunFromFourThreads) {
+    printBenchmark("Async logging, overrun oldest",
+                   measureNsPerCall({.async = true, .overflow = LogOverflow::OverrunOldest, .console = false}));
+}
+
+TEST_F(LoggerPerformance, DisabledLevel) {
+    // What a filtered-out call costs: the lock-free get() and a level check
+    Logger::init(m_path.string(), "warn", {.console = false});
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS_PER_THREAD; ++i) {
+        Logger::debug("frame {}", i);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printBenchmark("Below the level", ns / CALLS_PER_THREAD, 1);
+}
+
+TEST_F(LoggerPerformance, DisabledMacro) {
+    // A PCS_LOG_* statement below the level: the cost in a frame loop
+    Logger::init(m_path.string(), "warn", {.console = false});
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < CALLS_PER_THREAD; ++i) {
+        PCS_LOG_DEBUG("frame {}", i);
+    }
+    const double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    printBenchmark("PCS_LOG_DEBUG below the level", ns / CALLS_PER_THREAD, 1);
+}
+
+TEST_F(LoggerPerformance, RateLimitedMacroFromFourThreads) {
+    // Enabled but held back by the limit on all but the first call
+    Logger::init(m_path.string(), "info", {.console = false});
+    std::vector<double> threadNs(THREADS);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([t, &threadNs] {
+            const auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < CALLS_PER_THREAD; ++i) {
+                PCS_LOG_EVERY(spdlog::level::info, std::chrono::hours(1), "frame {}", i);
+            }
+            threadNs[t] = std::chrono::duration<double, std::nano>(
+                              std::chrono::steady_clock::now() - start).count();
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double totalNs = 0;
+    for (double ns : threadNs) {
+        totalNs += ns;
+    }
+    printBenchmark("PCS_LOG_EVERY, rate limited", totalNs / (THREADS * CALLS_PER_THREAD));
+}
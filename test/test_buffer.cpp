@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include "buffer.hpp"
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// Basic Queue Tests
+// ============================================================================
+
+TEST(BufferTest, PopsInPushOrder) {
+    Buffer<int> buffer(4);
+    EXPECT_TRUE(buffer.push(1));
+    EXPECT_TRUE(buffer.push(2));
+
+    EXPECT_EQ(buffer.size(), 2u);
+    EXPECT_EQ(buffer.pop(), 1);
+    EXPECT_EQ(buffer.pop(), 2);
+}
+
+TEST(BufferTest, TryPushFailsWhenFull) {
+    Buffer<std::unique_ptr<int>> buffer(1);
+    auto first = std::make_unique<int>(1);
+    auto second = std::make_unique<int>(2);
+
+    EXPECT_TRUE(buffer.tryPush(first));
+    EXPECT_FALSE(buffer.tryPush(second));
+    ASSERT_NE(second, nullptr); // a rejected item stays with the caller
+    EXPECT_EQ(*second, 2);
+}
+
+TEST(BufferTest, PopTimesOutWhenEmpty) {
+    Buffer<int> buffer(2);
+    auto start = std::chrono::steady_clock::now();
+
+    EXPECT_FALSE(buffer.pop(std::chrono::milliseconds(20)).has_value());
+    EXPECT_GE(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(20));
+}
+
+// ============================================================================
+// Shutdown Tests
+// ============================================================================
+
+TEST(BufferTest, CloseWakesBlockedConsumer) {
+    Buffer<int> buffer(2);
+    std::optional<int> result = 42;
+
+    std::thread consumer([&] { result = buffer.pop(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    buffer.close();
+    consumer.join();
+
+    EXPECT_FALSE(result.has_value());
+}
+
+TEST(BufferTest, CloseWakesBlockedProducer) {
+    Buffer<int> buffer(1);
+    ASSERT_TRUE(buffer.push(1));
+    bool pushed = true;
+
+    std::thread producer([&] { pushed = buffer.push(2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    buffer.close();
+    producer.join();
+
+    EXPECT_FALSE(pushed);
+}
+
+TEST(BufferTest, DrainsAfterClose) {
+    Buffer<int> buffer(4);
+    buffer.push(1);
+    buffer.push(2);
+    buffer.close();
+
+    EXPECT_FALSE(buffer.push(3));
+    EXPECT_EQ(buffer.pop(), 1);
+    EXPECT_EQ(buffer.pop(), 2);
+    EXPECT_FALSE(buffer.pop().has_value());
+}
+
+TEST(BufferTest, BlockingPushWaitsForRoom) {
+    Buffer<int> buffer(1);
+    buffer.push(1);
+
+    std::thread producer([&] { buffer.push(2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(buffer.size(), 1u);
+    EXPECT_EQ(buffer.pop(), 1);
+    producer.join();
+    EXPECT_EQ(buffer.pop(), 2);
+}
+
+TEST(BufferTest, PushEvictOldestKeepsNewest) {
+    Buffer<int> buffer(2);
+    EXPECT_EQ(buffer.pushEvictOldest(1), 0u);
+    EXPECT_EQ(buffer.pushEvictOldest(2), 0u);
+    EXPECT_EQ(buffer.pushEvictOldest(3), 1u); // 1 evicted
+
+    EXPECT_EQ(buffer.pop(), 2);
+    EXPECT_EQ(buffer.pop(), 3);
+
+    buffer.close();
+    EXPECT_EQ(buffer.pushEvictOldest(4), 1u); // closed: the item itself is dropped
+}
+
+TEST(BufferTest, PushEvictOldestCountsEveryEviction) {
+    Buffer<int> buffer(4);
+    for (int i = 1; i <= 4; ++i) {
+        EXPECT_EQ(buffer.pushEvictOldest(i), 0u);
+    }
+
+    // After a shrink one push makes room for itself by evicting 1, 2 and 3
+    buffer.setCapacity(2);
+    EXPECT_EQ(buffer.pushEvictOldest(5), 3u);
+    EXPECT_EQ(buffer.pop(), 4);
+    EXPECT_EQ(buffer.pop(), 5);
+}
+
+TEST(BufferTest, SetCapacityWhileInUse) {
+    Buffer<int> buffer(1);
+    int item = 1;
+    ASSERT_TRUE(buffer.tryPush(item));
+
+    // A producer blocked on the old limit proceeds once it grows
+    std::thread producer([&] { buffer.push(2); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    buffer.setCapacity(3);
+    producer.join();
+    EXPECT_EQ(buffer.size(), 2u);
+    EXPECT_EQ(buffer.capacity(), 3u);
+
+    // Shrinking keeps what is queued but refuses more
+    buffer.setCapacity(1);
+    item = 3;
+    EXPECT_FALSE(buffer.tryPush(item));
+    EXPECT_EQ(buffer.size(), 2u);
+}
+
+TEST(BufferTest, ManyProducersOneConsumer) {
+    Buffer<int> buffer(8);
+    constexpr int kPerProducer = 1000;
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&] {
+            for (int i = 0; i < kPerProducer; ++i) {
+                buffer.push(1);
+            }
+        });
+    }
+
+    int total = 0;
+    for (int i = 0; i < 4 * kPerProducer; ++i) {
+        total += *buffer.pop();
+    }
+    for (auto& t : producers) {
+        t.join();
+    }
+    EXPECT_EQ(total, 4 * kPerProducer);
+}
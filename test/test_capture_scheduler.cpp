@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "capture_scheduler.hpp"
+#include <deque>
+#include <vector>
+
+using namespace pcs;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Replays frames with scripted capture times, relative to a base in the past
+class ScriptedSource : public CaptureSource {
+public:
+    ScriptedSource(std::vector<std::chrono::milliseconds> times, uint32_t fps,
+                   std::chrono::milliseconds ageOfLast = 1ms)
+        : fps_(fps)
+    {
+        auto base = std::chrono::steady_clock::now() - times.back() - ageOfLast;
+        for (auto t : times) {
+            times_.push_back(base + t);
+        }
+    }
+
+    void setAge(size_t index, std::chrono::milliseconds age)
+    {
+        times_[index] = std::chrono::steady_clock::now() - age;
+    }
+
+    bool start() override { return true; }
+    void stop() override {}
+    bool read(Frame& frame) override
+    {
+        if (times_.empty()) {
+            return false;
+        }
+        frame = Frame(std::vector<uint8_t>(4, 0), 2, 2, 1);
+        frame.setTimestamp(times_.front());
+        times_.pop_front();
+        return true;
+    }
+    CaptureFormat captureFormat() const override { return {2, 2, fps_, PixelFormat::Gray8}; }
+    std::string name() const override { return "scripted"; }
+
+private:
+    std::deque<Frame::Timestamp> times_;
+    uint32_t fps_;
+};
+
+std::vector<std::chrono::milliseconds> evenly(int count, std::chrono::milliseconds step)
+{
+    std::vector<std::chrono::milliseconds> times;
+    for (int i = 0; i < count; ++i) {
+        times.push_back(step * i);
+    }
+    return times;
+}
+
+PacingConfig noBudget(double fps = 0.0)
+{
+    PacingConfig config;
+    config.fps = fps;
+    config.latency_budget = 0us;
+    return config;
+}
+
+int drain(CaptureScheduler& scheduler)
+{
+    Frame frame;
+    int n = 0;
+    while (scheduler.read(frame)) {
+        ++n;
+    }
+    return n;
+}
+
+} // namespace
+
+// ============================================================================
+// Schedule Tests
+// ============================================================================
+
+TEST(CaptureSchedulerTest, OnScheduleFramesPassThrough) {
+    ScriptedSource source(evenly(10, 20ms), 50);
+    CaptureScheduler scheduler(source, noBudget());
+
+    EXPECT_EQ(drain(scheduler), 10);
+    EXPECT_EQ(scheduler.period(), 20ms);
+    EXPECT_EQ(scheduler.droppedEarly(), 0u);
+    EXPECT_EQ(scheduler.missedDeadlines(), 0u);
+    EXPECT_EQ(scheduler.jitter().count(), 9u);
+    EXPECT_EQ(scheduler.jitter().max(), 0u);
+}
+
+TEST(CaptureSchedulerTest, FasterSourceIsDecimated) {
+    ScriptedSource source(evenly(12, 10ms), 100);  // camera at 100 fps
+    CaptureScheduler scheduler(source, noBudget(50));  // pipeline wants 50
+
+    EXPECT_EQ(drain(scheduler), 6);
+    EXPECT_EQ(scheduler.droppedEarly(), 6u);
+}
+
+TEST(CaptureSchedulerTest, DecimationCanBeDisabled) {
+    ScriptedSource source(evenly(12, 10ms), 100);
+    PacingConfig config = noBudget(50);
+    config.decimate = false;
+    CaptureScheduler scheduler(source, config);
+
+    EXPECT_EQ(drain(scheduler), 12);
+}
+
+TEST(CaptureSchedulerTest, FractionalRates) {
+    ScriptedSource source(evenly(16, 10ms), 100);
+    CaptureScheduler scheduler(source, noBudget(12.5));
+
+    EXPECT_EQ(scheduler.period(), 0ns); // resolved on the first read
+    EXPECT_EQ(drain(scheduler), 3);     // 0, 60 and 140 ms, within the slack
+    EXPECT_EQ(scheduler.period(), 80ms);
+}
+
+TEST(CaptureSchedulerTest, PacingChangesTakeEffectAtOnce) {
+    ScriptedSource source(evenly(20, 10ms), 100);
+    CaptureScheduler scheduler(source, noBudget(20));
+
+    Frame frame;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(scheduler.read(frame)); // 0, 40 and 90 ms
+    }
+    EXPECT_EQ(scheduler.droppedEarly(), 7u);
+
+    scheduler.setPacing(noBudget(100)); // 100 ms is due now, not at 140
+    EXPECT_EQ(drain(scheduler), 10);
+    EXPECT_EQ(scheduler.period(), 10ms);
+    EXPECT_EQ(scheduler.droppedEarly(), 7u);
+}
+
+TEST(CaptureSchedulerTest, SmallJitterIsNotDecimated) {
+    ScriptedSource source({0ms, 18ms, 42ms, 59ms, 81ms}, 50);
+    CaptureScheduler scheduler(source, noBudget());
+
+    EXPECT_EQ(drain(scheduler), 5);
+    EXPECT_EQ(scheduler.droppedEarly(), 0u);
+    EXPECT_NEAR(static_cast<double>(scheduler.jitter().max()), 4000.0, 4000.0 / 16);  // 18 -> 42
+}
+
+TEST(CaptureSchedulerTest, SlowSourceCountsMissedDeadlines) {
+    ScriptedSource source({0ms, 20ms, 85ms, 105ms}, 50);  // 40 and 60 never arrived
+    CaptureScheduler scheduler(source, noBudget());
+
+    EXPECT_EQ(drain(scheduler), 4);
+    EXPECT_EQ(scheduler.missedDeadlines(), 2u);  // 85 fills the 80 slot late
+}
+
+// ============================================================================
+// Latency Budget Tests
+// ============================================================================
+
+TEST(CaptureSchedulerTest, StaleFramesAreDroppedDeliberately) {
+    ScriptedSource source(evenly(4, 20ms), 50);
+    source.setAge(0, 500ms);
+    source.setAge(1, 300ms);
+
+    PacingConfig config;
+    config.latency_budget = 100ms;
+    CaptureScheduler scheduler(source, config);
+
+    EXPECT_EQ(drain(scheduler), 2);
+    EXPECT_EQ(scheduler.droppedLate(), 2u);
+    EXPECT_EQ(scheduler.latency().count(), 4u);
+    EXPECT_GE(scheduler.latency().max(), 480000u);
+}
+
+TEST(CaptureSchedulerTest, ResetClearsStatistics) {
+    ScriptedSource source(evenly(3, 20ms), 50);
+    CaptureScheduler scheduler(source, noBudget());
+    drain(scheduler);
+
+    scheduler.reset();
+    EXPECT_EQ(scheduler.delivered(), 0u);
+    EXPECT_EQ(scheduler.latency().count(), 0u);
+}
@@ -0,0 +1,276 @@
+#include <gtest/gtest.h>
+#include "config.hpp"
+#include <algorithm>
+
+using namespace config;
+
+namespace {
+
+const char* kFullConfig = R"(
+# Kitchen camera
+[camera]
+device = /dev/video2
+width = 1280
+height = 720   ; trailing comment
+fps = 25
+
+[encoder]
+codec = h264
+bitrate = 2500000
+hw_accel = software
+
+[sender]
+dest_ip = 192.168.1.20
+port = 6000
+queue_kb = 2048
+
+[pipeline]
+capture_queue = 2
+fps_cap = 12.5
+capture_budget_ms = 40
+drop_policy = oldest
+capture_cpus = 0-1
+realtime = yes
+
+[log]
+level = debug
+)";
+
+bool has_key(const std::vector<ConfigChange>& changes, const std::string& key)
+{
+    return std::any_of(changes.begin(), changes.end(),
+                       [&](const ConfigChange& c) { return c.key == key; });
+}
+
+} // namespace
+
+// ============================================================================
+// Parsing Tests
+// ============================================================================
+
+TEST(ConfigTest, EmptyTextGivesDefaults) {
+    auto parsed = parse_config("");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(diff_config(Config{}, *parsed).empty());
+}
+
+TEST(ConfigTest, ParsesEverySection) {
+    auto parsed = parse_config(kFullConfig);
+    ASSERT_TRUE(parsed.has_value());
+
+    EXPECT_EQ(parsed->camera.device, "/dev/video2");
+    EXPECT_EQ(parsed->camera.height, 720);
+    EXPECT_EQ(parsed->camera.fps, 25);
+    EXPECT_EQ(parsed->encoder.bitrate, 2500000);
+    EXPECT_EQ(parsed->encoder.hw_accel, "software");
+    EXPECT_EQ(parsed->encoder.keyframe_interval, 60); // not given: default
+    EXPECT_EQ(parsed->sender.dest_ip, "192.168.1.20");
+    EXPECT_EQ(parsed->sender.port, 6000);
+    EXPECT_EQ(parsed->sender.queue_kb, 2048);
+    EXPECT_EQ(parsed->pipeline.capture_queue, 2);
+    EXPECT_DOUBLE_EQ(parsed->pipeline.fps_cap, 12.5);
+    EXPECT_EQ(parsed->pipeline.capture_budget_ms, 40);
+    EXPECT_EQ(parsed->pipeline.drop_policy, "oldest");
+    EXPECT_EQ(parsed->pipeline.capture_cpus, "0-1");
+    EXPECT_TRUE(parsed->pipeline.realtime);
+    EXPECT_EQ(parsed->log.level, "debug");
+}
+
+TEST(ConfigTest, RejectsBadInput) {
+    EXPECT_FALSE(parse_config("[camera]\nwidht = 640\n").has_value());      // unknown key
+    EXPECT_FALSE(parse_config("[audio]\n").has_value());                   // unknown section
+    EXPECT_FALSE(parse_config("width = 640\n").has_value());               // no section
+    EXPECT_FALSE(parse_config("[camera]\nwidth 640\n").has_value());       // no '='
+    EXPECT_FALSE(parse_config("[camera\n").has_value());
+    EXPECT_FALSE(parse_config("[camera]\nwidth = 64O\n").has_value());     // not a number
+    EXPECT_FALSE(parse_config("[camera]\nfps = 0\n").has_value());         // out of range
+    EXPECT_FALSE(parse_config("[pipeline]\ndrop_policy = random\n").has_value());
+    EXPECT_FALSE(parse_config("[pipeline]\nsend_cpus = 3-1\n").has_value());
+    EXPECT_FALSE(parse_config("[sender]\ndest_ip = camera.local\n").has_value());
+    EXPECT_FALSE(parse_config("[pipeline]\nrealtime = maybe\n").has_value());
+}
+
+TEST(ConfigTest, FormatRoundTrips) {
+    auto parsed = parse_config(kFullConfig);
+    ASSERT_TRUE(parsed.has_value());
+
+    auto again = parse_config(format_config(*parsed));
+    ASSERT_TRUE(again.has_value());
+    EXPECT_TRUE(diff_config(*parsed, *again).empty());
+}
+
+TEST(ConfigTest, MissingFileGivesDefaults) {
+    EXPECT_FALSE(read_config("/nonexistent/pi-camera-streamer.conf").has_value());
+    Config loaded = load_config("/nonexistent/pi-camera-streamer.conf");
+    EXPECT_TRUE(diff_config(Config{}, loaded).empty());
+}
+
+// ============================================================================
+// Reload Tests
+// ============================================================================
+
+TEST(ConfigTest, DiffMarksHotKeys) {
+    Config before;
+    Config after;
+    after.encoder.bitrate = 1000000;
+    after.camera.width = 1920;
+
+    auto changes = diff_config(before, after);
+    ASSERT_EQ(changes.size(), 2u);
+    EXPECT_EQ(changes[0].key, "camera.width");
+    EXPECT_FALSE(changes[0].hot);
+    EXPECT_EQ(changes[1].key, "encoder.bitrate");
+    EXPECT_TRUE(changes[1].hot);
+    EXPECT_EQ(changes[1].before, "4000000");
+    EXPECT_EQ(changes[1].after, "1000000");
+}
+
+TEST(ConfigTest, MergeTakesOnlyHotKeys) {
+    Config current;
+    Config next = *parse_config(kFullConfig);
+
+    Config merged = merge_hot(current, next);
+    EXPECT_EQ(merged.encoder.bitrate, 2500000);
+    EXPECT_EQ(merged.pipeline.capture_queue, 2);
+    EXPECT_EQ(merged.pipeline.drop_policy, "oldest");
+    EXPECT_EQ(merged.log.level, "debug");
+    EXPECT_EQ(merged.camera.width, current.camera.width);
+    EXPECT_EQ(merged.sender.port, current.sender.port);
+
+    auto pending = diff_config(merged, next);
+    EXPECT_TRUE(has_key(pending, "camera.width"));
+    EXPECT_FALSE(has_key(pending, "encoder.bitrate"));
+}
+
+TEST(ConfigTest, ParsesSloSection) {
+    auto parsed = parse_config("[slo]\nenabled = yes\nlatency_ms = 150\n"
+                               "bitrate_steps = 1, 0.6,0.3\nfps_steps = 1\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(parsed->slo.enabled);
+    EXPECT_EQ(parsed->slo.latency_ms, 150);
+    EXPECT_EQ(parsed->slo.bitrate_steps, std::vector<double>({1.0, 0.6, 0.3}));
+    EXPECT_EQ(parsed->slo.fps_steps, std::vector<double>({1.0}));
+    EXPECT_EQ(parsed->slo.resolution_steps, SloSettings{}.resolution_steps);
+
+    auto again = parse_config(format_config(*parsed));
+    ASSERT_TRUE(again.has_value());
+    EXPECT_TRUE(diff_config(*parsed, *again).empty());
+
+    EXPECT_FALSE(parse_config("[slo]\nbitrate_steps = 1, 1.5\n").has_value()); // above full quality
+    EXPECT_FALSE(parse_config("[slo]\nfps_steps = 1,,0.5\n").has_value());
+    EXPECT_FALSE(parse_config("[slo]\nresolution_steps =\n").has_value());
+    EXPECT_FALSE(parse_config("[slo]\nheadroom = 0\n").has_value());
+}
+
+TEST(ConfigTest, ParsesRecorderSection) {
+    auto parsed = parse_config("[recorder]\ndirectory = /media/sd/recordings\nsegment_seconds = 300\n"
+                               "direct_io = on\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->recorder.directory, "/media/sd/recordings");
+    EXPECT_EQ(parsed->recorder.segment_seconds, 300);
+    EXPECT_TRUE(parsed->recorder.direct_io);
+    EXPECT_EQ(parsed->recorder.queue_kb, RecorderSettings{}.queue_kb);
+
+    EXPECT_FALSE(parse_config("[recorder]\nsegment_seconds = 0\n").has_value());
+    EXPECT_FALSE(parse_config("[recorder]\nwrite_kb = 1\n").has_value());
+}
+
+TEST(ConfigTest, ParsesEventsSection) {
+    auto parsed = parse_config("[events]\ndirectory = /media/sd/events\npre_event_seconds = 20\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->events.directory, "/media/sd/events");
+    EXPECT_EQ(parsed->events.pre_event_seconds, 20);
+    EXPECT_EQ(parsed->events.buffer_kb, EventSettings{}.buffer_kb);
+
+    EXPECT_FALSE(parse_config("[events]\npre_event_seconds = 0\n").has_value());
+    EXPECT_FALSE(parse_config("[events]\nbuffer_kb = 16\n").has_value());
+}
+
+TEST(ConfigTest, ParsesSnapshotSection) {
+    auto parsed = parse_config("[snapshot]\npath = /run/pi-camera/still.jpg\nwidth = 640\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->snapshot.path, "/run/pi-camera/still.jpg");
+    EXPECT_EQ(parsed->snapshot.width, 640);
+    EXPECT_EQ(parsed->snapshot.height, 0);
+
+    EXPECT_FALSE(parse_config("[snapshot]\nwidth = -1\n").has_value());
+}
+
+TEST(ConfigTest, ParsesAsyncLogging) {
+    auto parsed = parse_config("[log]\nasync = yes\nqueue_size = 1024\noverflow = overrun\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(parsed->log.async);
+    EXPECT_EQ(parsed->log.queue_size, 1024);
+    EXPECT_EQ(parsed->log.overflow, "overrun");
+    EXPECT_EQ(parsed->log.level, "info");
+
+    EXPECT_FALSE(parse_config("[log]\noverflow = drop\n").has_value());
+    EXPECT_FALSE(parse_config("[log]\nqueue_size = 0\n").has_value());
+}
+
+TEST(ConfigTest, ParsesMemorySection) {
+    auto parsed = parse_config("[memory]\nlimit_mb = 384\nshed_at = 0.9\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->memory.limit_mb, 384);
+    EXPECT_DOUBLE_EQ(parsed->memory.shed_at, 0.9);
+    EXPECT_DOUBLE_EQ(parsed->memory.defer_at, MemorySettings{}.defer_at);
+
+    EXPECT_FALSE(parse_config("[memory]\nlimit_mb = -1\n").has_value());
+    EXPECT_FALSE(parse_config("[memory]\ndefer_at = 1.5\n").has_value());
+}
+
+TEST(ConfigTest, ParsesSceneSection) {
+    auto parsed = parse_config("[scene]\nenabled = yes\nthreshold = 2.5\nmode = repeat\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(parsed->scene.enabled);
+    EXPECT_DOUBLE_EQ(parsed->scene.threshold, 2.5);
+    EXPECT_EQ(parsed->scene.mode, "repeat");
+    EXPECT_EQ(parsed->scene.refresh_ms, SceneSettings{}.refresh_ms);
+
+    EXPECT_FALSE(parse_config("[scene]\nmode = skip\n").has_value());
+    EXPECT_FALSE(parse_config("[scene]\nrefresh_ms = 0\n").has_value());
+}
+
+TEST(ConfigTest, ParsesRoiSection) {
+    auto parsed = parse_config("[roi]\nmotion = yes\nmotion_offset = -8\nprivacy_zones = 320x240+0+0\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_TRUE(parsed->roi.motion);
+    EXPECT_EQ(parsed->roi.motion_offset, -8);
+    EXPECT_EQ(parsed->roi.static_offset, RoiSettings{}.static_offset);
+    EXPECT_EQ(parsed->roi.privacy_zones, "320x240+0+0");
+
+    EXPECT_FALSE(parse_config("[roi]\nprivacy_zones = 0,0,320,240\n").has_value());
+    EXPECT_FALSE(parse_config("[roi]\nstatic_offset = 60\n").has_value());
+}
+
+TEST(ConfigTest, ParsesPoolSection) {
+    auto parsed = parse_config("[pool]\nworkers = 3\ncpus = 1-3\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->pool.workers, 3);
+    EXPECT_EQ(parsed->pool.cpus, "1-3");
+    EXPECT_EQ(Config{}.pool.workers, 0);
+
+    EXPECT_FALSE(parse_config("[pool]\nworkers = -1\n").has_value());
+    EXPECT_FALSE(parse_config("[pool]\ncpus = x\n").has_value());
+}
+
+TEST(ConfigTest, ParsesCamerasSection) {
+    auto parsed = parse_config("[camera]\nwidth = 1280\n"
+                               "[cameras]\ndevices = /dev/video0, /dev/video2\ncapture_cpus = 2\n"
+                               "encode_workers = 2\n");
+    ASSERT_TRUE(parsed.has_value());
+    EXPECT_EQ(parsed->cameras.encode_workers, 2);
+    EXPECT_EQ(parsed->cameras.queue_depth, CamerasSettings{}.queue_depth);
+
+    const std::vector<CameraConfig> cameras = camera_list(*parsed);
+    ASSERT_EQ(cameras.size(), 2u);
+    EXPECT_EQ(cameras[0].device, "/dev/video0");
+    EXPECT_EQ(cameras[1].device, "/dev/video2");
+    EXPECT_EQ(cameras[1].width, 1280);     // the [camera] settings apply to each
+    EXPECT_EQ(cameras[0].capture_cpu, 2);
+    EXPECT_EQ(cameras[1].capture_cpu, -1); // more devices than CPUs
+
+    EXPECT_EQ(camera_list(Config{}).size(), 1u);
+    EXPECT_FALSE(parse_config("[cameras]\ndevices = /dev/video0,,/dev/video2\n").has_value());
+    EXPECT_FALSE(parse_config("[cameras]\nqueue_depth = 0\n").has_value());
+}
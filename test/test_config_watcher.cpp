@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+#include "config_watcher.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+#include <unistd.h>
+
+using namespace pcs;
+
+namespace {
+
+// A scratch directory holding one config file
+class ConfigWatcherTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        char pattern[] = "/tmp/pcs-config-XXXXXX";
+        ASSERT_NE(mkdtemp(pattern), nullptr);
+        dir_ = pattern;
+        path_ = dir_ + "/streamer.conf";
+        write(path_, "[encoder]\nbitrate = 4000000\n");
+    }
+
+    void TearDown() override
+    {
+        std::remove(path_.c_str());
+        std::remove((path_ + ".tmp").c_str());
+        ::rmdir(dir_.c_str());
+    }
+
+    static void write(const std::string& path, const std::string& text)
+    {
+        std::ofstream(path) << text;
+    }
+
+    // Wait for the watcher thread to apply something
+    static bool waitFor(const std::atomic<int>& applied, int count)
+    {
+        for (int i = 0; i < 300 && applied.load() < count; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return applied.load() >= count;
+    }
+
+    std::string dir_;
+    std::string path_;
+};
+
+} // namespace
+
+TEST_F(ConfigWatcherTest, AppliesHotChangeWhenFileIsWritten) {
+    std::atomic<int> applied{0};
+    std::atomic<int> bitrate{0};
+    ConfigWatcher watcher(path_, config::load_config(path_), [&](const config::Config& next) {
+        bitrate = next.encoder.bitrate;
+        applied.fetch_add(1);
+    });
+    ASSERT_TRUE(watcher.start());
+
+    write(path_, "[encoder]\nbitrate = 1500000\n");
+    ASSERT_TRUE(waitFor(applied, 1));
+    EXPECT_EQ(bitrate.load(), 1500000);
+    EXPECT_EQ(watcher.current().encoder.bitrate, 1500000);
+    EXPECT_EQ(watcher.reloads(), 1u);
+}
+
+TEST_F(ConfigWatcherTest, SeesRenameOverFile) {
+    std::atomic<int> applied{0};
+    ConfigWatcher watcher(path_, config::load_config(path_), [&](const config::Config&) {
+        applied.fetch_add(1);
+    });
+    ASSERT_TRUE(watcher.start());
+
+    // How editors save: write a new file, rename it over the old one
+    write(path_ + ".tmp", "[log]\nlevel = debug\n");
+    ASSERT_EQ(std::rename((path_ + ".tmp").c_str(), path_.c_str()), 0);
+    ASSERT_TRUE(waitFor(applied, 1));
+    EXPECT_EQ(watcher.current().log.level, "debug");
+}
+
+TEST_F(ConfigWatcherTest, InvalidFileKeepsRunningSettings) {
+    int applied = 0;
+    ConfigWatcher watcher(path_, config::load_config(path_), [&](const config::Config&) { ++applied; });
+
+    write(path_, "[encoder]\nbitrate = lots\n");
+    EXPECT_FALSE(watcher.reload());
+    EXPECT_EQ(applied, 0);
+    EXPECT_EQ(watcher.current().encoder.bitrate, 4000000);
+}
+
+TEST_F(ConfigWatcherTest, RestartOnlyChangesAreNotApplied) {
+    int applied = 0;
+    ConfigWatcher watcher(path_, config::load_config(path_), [&](const config::Config&) { ++applied; });
+
+    write(path_, "[encoder]\nbitrate = 4000000\n[camera]\nwidth = 1920\n");
+    EXPECT_FALSE(watcher.reload());
+    EXPECT_EQ(applied, 0);
+
+    write(path_, "[encoder]\nbitrate = 3000000\n[camera]\nwidth = 1920\n");
+    EXPECT_TRUE(watcher.reload());
+    EXPECT_EQ(applied, 1);
+    EXPECT_EQ(watcher.current().encoder.bitrate, 3000000);
+    EXPECT_EQ(watcher.current().camera.width, 640); // still the running value
+}
+
+TEST_F(ConfigWatcherTest, StartFailsForMissingDirectory) {
+    ConfigWatcher watcher("/nonexistent-dir/streamer.conf", config::Config{}, [](const config::Config&) {});
+    EXPECT_FALSE(watcher.start());
+}
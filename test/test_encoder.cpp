@@ -0,0 +1,329 @@
+#include <gtest/gtest.h>
+
+// The encoder wraps FFmpeg; these tests are only built where libav is available.
+#ifdef PCS_HAVE_LIBAV
+
+#include "encoder.hpp"
+#include "mjpeg_decoder.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+Frame makeBgrFrame(uint32_t width, uint32_t height, uint8_t shade)
+{
+    std::vector<uint8_t> data(static_cast<size_t>(width) * height * 3, shade);
+    return Frame(std::move(data), width, height, 3);
+}
+
+EncoderConfig smallConfig(CodecType codec)
+{
+    EncoderConfig config;
+    config.codec = codec;
+    config.width = 320;
+    config.height = 240;
+    config.fps = 30;
+    config.bitrate = 500000;
+    config.keyframe_interval = 30;
+    config.hw_accel = "software";
+    return config;
+}
+
+} // namespace
+
+// ============================================================================
+// Basic Encoding Tests
+// ============================================================================
+
+TEST(EncoderTest, FirstFrameIsKeyframe) {
+    Encoder encoder(smallConfig(CodecType::MJPEG));
+    ASSERT_TRUE(encoder.init());
+
+    auto encoded = encoder.encode(makeBgrFrame(320, 240, 128));
+
+    ASSERT_TRUE(encoded.has_value());
+    EXPECT_TRUE(encoded->keyframe);
+    EXPECT_FALSE(encoded->data.empty());
+}
+
+TEST(EncoderTest, ScalesInputToConfiguredSize) {
+    Encoder encoder(smallConfig(CodecType::MJPEG));
+    ASSERT_TRUE(encoder.init());
+
+    // 640x480 input is scaled down to 320x240 by swscale
+    auto encoded = encoder.encode(makeBgrFrame(640, 480, 64));
+
+    ASSERT_TRUE(encoded.has_value());
+}
+
+TEST(EncoderTest, EncodesYuvInputLayouts) {
+    Encoder encoder(smallConfig(CodecType::H264));
+    ASSERT_TRUE(encoder.init());
+
+    for (PixelFormat format : {PixelFormat::NV12, PixelFormat::YUYV, PixelFormat::I420}) {
+        Frame probe(std::vector<uint8_t>(), 320, 240, format);
+        Frame frame(std::vector<uint8_t>(probe.expectedSize(), 128), 320, 240, format);
+        EXPECT_TRUE(encoder.encode(frame).has_value()) << pixelFormatName(format);
+    }
+}
+
+TEST(EncoderTest, OpensWithNativeInputFormat) {
+    EncoderConfig config = smallConfig(CodecType::H264);
+    auto formats = Encoder::inputFormats(config);
+    ASSERT_FALSE(formats.empty());
+
+    // Frames in the codec's preferred layout are copied, not converted
+    config.input_format = formats.front();
+    Encoder encoder(config);
+    ASSERT_TRUE(encoder.init());
+    Frame probe(std::vector<uint8_t>(), 320, 240, formats.front());
+    Frame frame(std::vector<uint8_t>(probe.expectedSize(), 100), 320, 240, formats.front());
+    EXPECT_TRUE(encoder.encode(frame).has_value());
+}
+
+TEST(EncoderTest, MjpegKeepsLimitedRangeLevels) {
+    // Limited-range black must come back black, not lifted to gray by a
+    // copy into the full-range JPEG picture
+    EncoderConfig config = smallConfig(CodecType::MJPEG);
+    config.input_format = PixelFormat::I420;
+    Encoder encoder(config);
+    ASSERT_TRUE(encoder.init());
+
+    Frame probe(std::vector<uint8_t>(), 320, 240, PixelFormat::I420);
+    std::vector<uint8_t> pixels(probe.expectedSize(), 128);
+    std::fill(pixels.begin(), pixels.begin() + 320 * 240, 16);
+    auto encoded = encoder.encode(Frame(std::move(pixels), 320, 240, PixelFormat::I420));
+    ASSERT_TRUE(encoded.has_value());
+
+    MjpegDecoder decoder(PixelFormat::I420);
+    auto decoded = decoder.decode(Frame(encoded->data, 320, 240, PixelFormat::MJPEG));
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_NEAR(decoded->bytes()[320 * 120 + 160], 16, 3);
+}
+
+TEST(EncoderTest, PooledConversionMatchesInline) {
+    // Rows differ, so a band converted from the wrong offset would show
+    std::vector<uint8_t> pixels(320 * 240 * 3);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<uint8_t>(i / (320 * 3) + i % 7);
+    }
+    Frame frame(std::move(pixels), 320, 240, 3);
+
+    EncoderConfig config = smallConfig(CodecType::MJPEG);
+    config.threads = 1;
+    Encoder inline_(config);
+    ThreadPool pool({.workers = 2});
+    config.pool = &pool;
+    Encoder pooled(config);
+    ASSERT_TRUE(inline_.init());
+    ASSERT_TRUE(pooled.init());
+
+    auto expected = inline_.encode(frame);
+    auto actual = pooled.encode(frame);
+    ASSERT_TRUE(expected.has_value());
+    ASSERT_TRUE(actual.has_value());
+
+    // Chroma filtering may differ by a level where bands meet
+    MjpegDecoder decoder(PixelFormat::I420);
+    auto a = decoder.decode(Frame(expected->data, 320, 240, PixelFormat::MJPEG));
+    auto b = decoder.decode(Frame(actual->data, 320, 240, PixelFormat::MJPEG));
+    ASSERT_TRUE(a.has_value());
+    ASSERT_TRUE(b.has_value());
+    ASSERT_EQ(a->size(), b->size());
+    for (size_t i = 0; i < a->size(); ++i) {
+        ASSERT_NEAR(a->bytes()[i], b->bytes()[i], 4) << i;
+    }
+}
+
+TEST(EncoderTest, RejectsCompressedInput) {
+    Encoder encoder(smallConfig(CodecType::H264));
+    ASSERT_TRUE(encoder.init());
+
+    Frame jpeg(std::vector<uint8_t>{0xFF, 0xD8, 0xFF, 0xD9}, 320, 240, PixelFormat::MJPEG);
+    EXPECT_FALSE(encoder.encode(jpeg).has_value());
+}
+
+TEST(EncoderTest, PtsIncreaseMonotonically) {
+    Encoder encoder(smallConfig(CodecType::MJPEG));
+    ASSERT_TRUE(encoder.init());
+
+    int64_t last = -1;
+    for (int i = 0; i < 5; ++i) {
+        auto encoded = encoder.encode(makeBgrFrame(320, 240, static_cast<uint8_t>(i * 10)));
+        ASSERT_TRUE(encoded.has_value());
+        EXPECT_GT(encoded->pts, last);
+        last = encoded->pts;
+    }
+}
+
+TEST(EncoderTest, RejectsInvalidFrame) {
+    Encoder encoder(smallConfig(CodecType::MJPEG));
+    ASSERT_TRUE(encoder.init());
+
+    Frame broken(std::vector<uint8_t>(10), 320, 240, 3);
+    EXPECT_FALSE(encoder.encode(broken).has_value());
+}
+
+TEST(EncoderTest, RepeatReusesLastPicture) {
+    Encoder encoder(smallConfig(CodecType::H264));
+    if (!encoder.init()) {
+        GTEST_SKIP() << "No H.264 encoder available";
+    }
+
+    // Nothing to repeat before the first picture
+    EXPECT_FALSE(encoder.encodeRepeat(std::chrono::steady_clock::now()).has_value());
+
+    auto first = encoder.encode(makeBgrFrame(320, 240, 128));
+    ASSERT_TRUE(first.has_value());
+
+    auto repeat = encoder.encodeRepeat(std::chrono::steady_clock::now() + std::chrono::milliseconds(33));
+    ASSERT_TRUE(repeat.has_value());
+    EXPECT_FALSE(repeat->keyframe);
+    EXPECT_GT(repeat->pts, first->pts);
+    EXPECT_LT(repeat->data.size(), first->data.size());
+}
+
+TEST(EncoderTest, AcceptsQualityMap) {
+    Encoder encoder(smallConfig(CodecType::H264));
+    if (!encoder.init()) {
+        GTEST_SKIP() << "No H.264 encoder available";
+    }
+
+    // Map built on a larger source frame; regions are scaled to 320x240
+    QualityMap map(640, 480);
+    map.fill(8);
+    map.fillRect({0, 0, 320, 240}, -8);
+
+    for (int i = 0; i < 3; ++i) {
+        auto encoded = encoder.encode(makeBgrFrame(640, 480, static_cast<uint8_t>(i * 40)), &map);
+        ASSERT_TRUE(encoded.has_value());
+    }
+}
+
+// ============================================================================
+// Live Reconfiguration Tests
+// ============================================================================
+
+TEST(EncoderTest, ReconfigureBeforeInitIsUsedByInit) {
+    Encoder encoder(smallConfig(CodecType::MJPEG));
+
+    auto next = smallConfig(CodecType::MJPEG);
+    next.width = 160;
+    next.height = 120;
+    ASSERT_TRUE(encoder.reconfigure(next));
+    ASSERT_TRUE(encoder.init());
+
+    EXPECT_EQ(encoder.config().width, 160);
+}
+
+TEST(EncoderTest, RateControlChangeAppliesInPlace) {
+    Encoder encoder(smallConfig(CodecType::H264));
+    if (!encoder.init()) {
+        GTEST_SKIP() << "No H.264 encoder available";
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        encoder.encode(makeBgrFrame(320, 240, static_cast<uint8_t>(i)));
+    }
+
+    auto next = encoder.config();
+    next.bitrate = 250000;
+    next.fps = 15;
+    ASSERT_TRUE(encoder.reconfigure(next));
+
+    EXPECT_EQ(encoder.config().bitrate, 250000);
+    EXPECT_EQ(encoder.config().fps, 15);
+
+    // Same codec context keeps going without a forced IDR
+    auto encoded = encoder.encode(makeBgrFrame(320, 240, 3));
+    ASSERT_TRUE(encoded.has_value());
+    EXPECT_FALSE(encoded->keyframe);
+}
+
+TEST(EncoderTest, KeyframeIntervalChangeAppliesInPlace) {
+    auto config = smallConfig(CodecType::H264);
+    config.keyframe_interval = 5;
+    Encoder encoder(config);
+    if (!encoder.init()) {
+        GTEST_SKIP() << "No H.264 encoder available";
+    }
+
+    // Identical pictures, so scene cuts can't add keyframes of their own
+    auto keyframesOver = [&](int frames, int first) {
+        std::vector<int> keyframes;
+        for (int i = first; i < first + frames; ++i) {
+            auto encoded = encoder.encode(makeBgrFrame(320, 240, 128));
+            EXPECT_TRUE(encoded.has_value());
+            if (encoded && encoded->keyframe) {
+                keyframes.push_back(i);
+            }
+        }
+        return keyframes;
+    };
+
+    EXPECT_EQ(keyframesOver(10, 0), (std::vector<int>{0, 5}));
+
+    // Raising the interval counts on from the IDR at frame 5
+    auto next = encoder.config();
+    next.keyframe_interval = 8;
+    ASSERT_TRUE(encoder.reconfigure(next));
+    EXPECT_EQ(keyframesOver(16, 10), (std::vector<int>{13, 21}));
+}
+
+TEST(EncoderTest, ResolutionChangeSwitchesAtKeyframe) {
+    Encoder encoder(smallConfig(CodecType::H264));
+    if (!encoder.init()) {
+        GTEST_SKIP() << "No H.264 encoder available";
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        encoder.encode(makeBgrFrame(320, 240, static_cast<uint8_t>(i)));
+    }
+
+    auto next = encoder.config();
+    next.width = 640;
+    next.height = 480;
+    ASSERT_TRUE(encoder.reconfigure(next));
+
+    // Standby takes over on the next frame, which must be an IDR
+    auto encoded = encoder.encode(makeBgrFrame(320, 240, 9));
+    ASSERT_TRUE(encoded.has_value());
+    EXPECT_TRUE(encoded->keyframe);
+    EXPECT_EQ(encoder.config().width, 640);
+    EXPECT_EQ(encoder.config().height, 480);
+}
+
+TEST(EncoderTest, ReconfigureWhileEncodingFromAnotherThread) {
+    Encoder encoder(smallConfig(CodecType::MJPEG));
+    ASSERT_TRUE(encoder.init());
+
+    std::atomic<bool> running{true};
+    std::atomic<int> encoded_count{0};
+    std::thread producer([&]() {
+        while (running.load()) {
+            if (encoder.encode(makeBgrFrame(320, 240, 50))) {
+                encoded_count++;
+            }
+        }
+    });
+
+    for (int i = 0; i < 5; ++i) {
+        auto next = encoder.config();
+        next.width = (i % 2) ? 320 : 160;
+        next.height = (i % 2) ? 240 : 120;
+        EXPECT_TRUE(encoder.reconfigure(next));
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    running.store(false);
+    producer.join();
+    EXPECT_GT(encoded_count.load(), 0);
+}
+
+#endif // PCS_HAVE_LIBAV
@@ -0,0 +1,191 @@
+#include <gtest/gtest.h>
+#include "encoder_registry.hpp"
+#include <filesystem>
+#include <map>
+#include <string>
+#include <unistd.h>
+
+using namespace pcs;
+
+// ============================================================================
+// Test Fixture
+// ============================================================================
+
+class EncoderRegistryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        m_cachePath = (std::filesystem::temp_directory_path() /
+                       ("pcs-registry-" + std::to_string(::getpid()) + ".cache")).string();
+        std::filesystem::remove(m_cachePath);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(m_cachePath);
+    }
+
+    // Fake calibration: fixed fps per backend, nullopt for unavailable ones
+    EncoderRegistry::CalibrateFn fakeCalibrator() {
+        return [this](const EncoderConfig& config) -> std::optional<double> {
+            m_calls[config.hw_accel]++;
+            auto it = m_fps.find(config.hw_accel);
+            if (it == m_fps.end()) {
+                return std::nullopt;
+            }
+            return it->second;
+        };
+    }
+
+    EncoderConfig autoConfig() {
+        EncoderConfig config;
+        config.codec = CodecType::H264;
+        config.width = 1280;
+        config.height = 720;
+        config.fps = 30;
+        config.hw_accel = "auto";
+        return config;
+    }
+
+    std::string m_cachePath;
+    std::map<std::string, double> m_fps;
+    std::map<std::string, int> m_calls;
+};
+
+// ============================================================================
+// Resolution Tests
+// ============================================================================
+
+TEST_F(EncoderRegistryTest, ExplicitBackendIsNotCalibrated) {
+    EncoderRegistry registry(fakeCalibrator());
+    registry.addBackend(CodecType::H264, "v4l2m2m");
+
+    auto config = autoConfig();
+    config.hw_accel = "omx";
+
+    EXPECT_EQ(registry.resolve(config), "omx");
+    EXPECT_TRUE(m_calls.empty());
+}
+
+TEST_F(EncoderRegistryTest, PicksFastestBackend) {
+    m_fps = {{"v4l2m2m", 120.0}, {"omx", 60.0}, {"software", 45.0}};
+    EncoderRegistry registry(fakeCalibrator());
+    registry.addBackend(CodecType::H264, "v4l2m2m");
+    registry.addBackend(CodecType::H264, "omx");
+
+    EXPECT_EQ(registry.resolve(autoConfig()), "v4l2m2m");
+    EXPECT_EQ(m_calls["v4l2m2m"], 1);
+    EXPECT_EQ(m_calls["omx"], 1);
+    EXPECT_EQ(m_calls["software"], 1);  // always a candidate
+}
+
+TEST_F(EncoderRegistryTest, SkipsUnavailableBackends) {
+    m_fps = {{"software", 40.0}};
+    EncoderRegistry registry(fakeCalibrator());
+    registry.addBackend(CodecType::H264, "v4l2m2m");
+
+    EXPECT_EQ(registry.resolve(autoConfig()), "software");
+}
+
+TEST_F(EncoderRegistryTest, FallsBackToSoftwareWhenNothingOpens) {
+    EncoderRegistry registry(fakeCalibrator());
+    registry.addBackend(CodecType::H264, "v4l2m2m");
+
+    EXPECT_EQ(registry.resolve(autoConfig()), EncoderRegistry::kSoftwareBackend);
+}
+
+TEST_F(EncoderRegistryTest, CandidatesArePerCodec) {
+    m_fps = {{"v4l2m2m", 120.0}, {"software", 45.0}};
+    EncoderRegistry registry(fakeCalibrator());
+    registry.addBackend(CodecType::H264, "v4l2m2m");
+
+    auto config = autoConfig();
+    config.codec = CodecType::MJPEG;
+    EXPECT_EQ(registry.resolve(config), "software");
+    EXPECT_EQ(m_calls.count("v4l2m2m"), 0u);
+}
+
+// ============================================================================
+// Cache Tests
+// ============================================================================
+
+TEST_F(EncoderRegistryTest, SecondResolveUsesMemoryCache) {
+    m_fps = {{"software", 45.0}};
+    EncoderRegistry registry(fakeCalibrator());
+
+    registry.resolve(autoConfig());
+    registry.resolve(autoConfig());
+
+    EXPECT_EQ(m_calls["software"], 1);
+}
+
+TEST_F(EncoderRegistryTest, CacheSurvivesRestart) {
+    m_fps = {{"v4l2m2m", 120.0}, {"software", 45.0}};
+    {
+        EncoderRegistry registry(fakeCalibrator(), m_cachePath, "lavc-1");
+        registry.addBackend(CodecType::H264, "v4l2m2m");
+        EXPECT_EQ(registry.resolve(autoConfig()), "v4l2m2m");
+    }
+    ASSERT_TRUE(std::filesystem::exists(m_cachePath));
+
+    m_calls.clear();
+    EncoderRegistry restarted(fakeCalibrator(), m_cachePath, "lavc-1");
+    restarted.addBackend(CodecType::H264, "v4l2m2m");
+
+    EXPECT_EQ(restarted.resolve(autoConfig()), "v4l2m2m");
+    EXPECT_TRUE(m_calls.empty());
+}
+
+TEST_F(EncoderRegistryTest, DifferentFingerprintRecalibrates) {
+    m_fps = {{"software", 45.0}};
+    {
+        EncoderRegistry registry(fakeCalibrator(), m_cachePath, "lavc-1");
+        registry.resolve(autoConfig());
+    }
+
+    m_calls.clear();
+    EncoderRegistry upgraded(fakeCalibrator(), m_cachePath, "lavc-2");
+    upgraded.resolve(autoConfig());
+
+    EXPECT_EQ(m_calls["software"], 1);
+}
+
+TEST_F(EncoderRegistryTest, CacheIsKeyedByResolutionAndFps) {
+    m_fps = {{"software", 45.0}};
+    EncoderRegistry registry(fakeCalibrator(), m_cachePath);
+
+    auto config = autoConfig();
+    registry.resolve(config);
+    config.width = 1920;
+    config.height = 1080;
+    registry.resolve(config);
+    config.fps = 15;
+    registry.resolve(config);
+
+    EXPECT_EQ(m_calls["software"], 3);
+}
+
+TEST_F(EncoderRegistryTest, InvalidateForcesRecalibration) {
+    m_fps = {{"v4l2m2m", 120.0}, {"software", 45.0}};
+    EncoderRegistry registry(fakeCalibrator(), m_cachePath);
+    registry.addBackend(CodecType::H264, "v4l2m2m");
+    registry.resolve(autoConfig());
+
+    // Hardware encoder disappeared (e.g. driver unloaded)
+    m_fps.erase("v4l2m2m");
+    registry.invalidate(autoConfig());
+
+    EXPECT_EQ(registry.resolve(autoConfig()), "software");
+}
+
+TEST_F(EncoderRegistryTest, DefaultCachePathHonoursXdg) {
+    const char* previous = std::getenv("XDG_CACHE_HOME");
+    std::string saved = previous ? previous : "";
+
+    ::setenv("XDG_CACHE_HOME", "/tmp/pcs-xdg", 1);
+    EXPECT_EQ(EncoderRegistry::defaultCachePath(), "/tmp/pcs-xdg/pi-camera-streamer/encoder-backends.cache");
+
+    if (previous) {
+        ::setenv("XDG_CACHE_HOME", saved.c_str(), 1);
+    } else {
+        ::unsetenv("XDG_CACHE_HOME");
+    }
+}
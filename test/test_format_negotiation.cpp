@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+#include "format_negotiation.hpp"
+#include <algorithm>
+
+using namespace pcs;
+
+namespace {
+
+const std::vector<PixelFormat> kX264 = {PixelFormat::I420, PixelFormat::NV12};
+
+} // namespace
+
+// ============================================================================
+// Capture Preference Tests
+// ============================================================================
+
+TEST(FormatNegotiationTest, EncoderFormatsComeFirst) {
+    auto preferences = capturePreferences(CodecType::H264, kX264);
+
+    ASSERT_GE(preferences.size(), 3u);
+    EXPECT_EQ(preferences[0], PixelFormat::I420);
+    EXPECT_EQ(preferences[1], PixelFormat::NV12);
+    EXPECT_EQ(preferences[2], PixelFormat::YUYV);
+}
+
+TEST(FormatNegotiationTest, MjpegIsLastResortForH264) {
+    auto preferences = capturePreferences(CodecType::H264, kX264);
+
+    EXPECT_EQ(preferences.back(), PixelFormat::MJPEG);
+}
+
+TEST(FormatNegotiationTest, MjpegFirstForMjpegOutput) {
+    auto preferences = capturePreferences(CodecType::MJPEG, {PixelFormat::I420});
+
+    ASSERT_FALSE(preferences.empty());
+    EXPECT_EQ(preferences.front(), PixelFormat::MJPEG);
+    EXPECT_EQ(std::count(preferences.begin(), preferences.end(), PixelFormat::MJPEG), 1);
+}
+
+TEST(FormatNegotiationTest, PreferencesHaveNoDuplicates) {
+    auto preferences = capturePreferences(CodecType::H264, {PixelFormat::NV12, PixelFormat::NV12});
+
+    for (size_t i = 0; i < preferences.size(); ++i) {
+        for (size_t j = i + 1; j < preferences.size(); ++j) {
+            EXPECT_NE(preferences[i], preferences[j]);
+        }
+    }
+}
+
+// ============================================================================
+// Path Planning Tests
+// ============================================================================
+
+TEST(FormatNegotiationTest, NativeFormatIsDirect) {
+    auto plan = planFormatPath(PixelFormat::NV12, CodecType::H264, kX264);
+
+    EXPECT_EQ(plan.path, FormatPath::Direct);
+    EXPECT_EQ(plan.encoder_input, PixelFormat::NV12);
+}
+
+TEST(FormatNegotiationTest, OtherRawFormatConvertsOnce) {
+    auto plan = planFormatPath(PixelFormat::YUYV, CodecType::H264, kX264);
+
+    EXPECT_EQ(plan.path, FormatPath::Convert);
+    EXPECT_EQ(plan.encoder_input, PixelFormat::I420);
+}
+
+TEST(FormatNegotiationTest, MjpegToMjpegIsPassthrough) {
+    auto plan = planFormatPath(PixelFormat::MJPEG, CodecType::MJPEG, {PixelFormat::I420});
+
+    EXPECT_EQ(plan.path, FormatPath::Passthrough);
+    EXPECT_EQ(plan.encoder_input, PixelFormat::Unknown);
+}
+
+TEST(FormatNegotiationTest, MjpegToH264Decodes) {
+    auto plan = planFormatPath(PixelFormat::MJPEG, CodecType::H264, kX264);
+
+    EXPECT_EQ(plan.path, FormatPath::Decode);
+    EXPECT_EQ(plan.encoder_input, PixelFormat::I420);
+}
+
+TEST(FormatNegotiationTest, DescribesPlan) {
+    auto plan = planFormatPath(PixelFormat::YUYV, CodecType::H264, kX264);
+
+    EXPECT_EQ(describeFormatPlan(plan), "YUYV -> I420 (one conversion in the encoder)");
+    EXPECT_STREQ(formatPathName(FormatPath::Passthrough), "passthrough");
+}
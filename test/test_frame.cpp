@@ -481,3 +481,78 @@ TEST(FrameTest, FrameAging) {
     EXPECT_GT(age2, age1);
     EXPECT_GE(age2 - age1, 5);
 }
+
+// ============================================================================
+// Pixel Format Tests
+// ============================================================================
+
+TEST(FrameTest, FormatFromChannels) {
+    EXPECT_EQ(Frame(std::vector<uint8_t>(4), 2, 2, 1).format(), PixelFormat::Gray8);
+    EXPECT_EQ(Frame(std::vector<uint8_t>(12), 2, 2, 3).format(), PixelFormat::BGR24);
+    EXPECT_EQ(Frame(std::vector<uint8_t>(8), 2, 2, 2).format(), PixelFormat::Unknown);
+}
+
+TEST(FrameTest, PlanarYuvExpectedSize) {
+    Frame nv12(std::vector<uint8_t>(64 * 48 * 3 / 2), 64, 48, PixelFormat::NV12);
+    EXPECT_EQ(nv12.channels(), 1u);
+    EXPECT_EQ(nv12.expectedSize(), 64u * 48u * 3u / 2u);
+    EXPECT_TRUE(nv12.isValid());
+
+    // Odd dimensions round the chroma planes up
+    Frame i420(std::vector<uint8_t>(), 5, 3, PixelFormat::I420);
+    EXPECT_EQ(i420.expectedSize(), 15u + 2u * 3u * 2u);
+}
+
+TEST(FrameTest, CompressedFrameAcceptsAnySize) {
+    Frame jpeg(std::vector<uint8_t>(777), 640, 480, PixelFormat::MJPEG);
+    EXPECT_TRUE(jpeg.isCompressed());
+    EXPECT_TRUE(jpeg.isValid());
+    EXPECT_FALSE(Frame(std::vector<uint8_t>(), 640, 480, PixelFormat::MJPEG).isValid());
+}
+
+// ============================================================================
+// External Storage Tests
+// ============================================================================
+
+TEST(FrameTest, ExternalFrameViewsMemory) {
+    static const uint8_t pixels[4] = {1, 2, 3, 4};
+    int releases = 0;
+    {
+        std::shared_ptr<const uint8_t> storage(pixels, [&](const uint8_t*) { ++releases; });
+        Frame frame(std::move(storage), 4, 2, 2, PixelFormat::Gray8);
+
+        EXPECT_TRUE(frame.isExternal());
+        EXPECT_TRUE(frame.isValid());
+        EXPECT_EQ(std::as_const(frame).dataPtr(), pixels);
+        EXPECT_EQ(frame.bytes()[3], 4);
+
+        Frame copy = frame;  // shares the view
+        EXPECT_EQ(copy.bytes().data(), pixels);
+    }
+    EXPECT_EQ(releases, 1);
+}
+
+TEST(FrameTest, MutableAccessDetaches) {
+    static const uint8_t pixels[4] = {1, 2, 3, 4};
+    int releases = 0;
+    std::shared_ptr<const uint8_t> storage(pixels, [&](const uint8_t*) { ++releases; });
+    Frame frame(std::move(storage), 4, 2, 2, PixelFormat::Gray8);
+
+    frame.dataPtr()[0] = 9;
+
+    EXPECT_FALSE(frame.isExternal());
+    EXPECT_EQ(releases, 1);
+    EXPECT_EQ(pixels[0], 1);
+    EXPECT_EQ(frame.bytes()[0], 9);
+    EXPECT_EQ(frame.size(), 4u);
+}
+
+TEST(FrameTest, CloneOfExternalIsOwned) {
+    static const uint8_t pixels[4] = {1, 2, 3, 4};
+    Frame frame(std::shared_ptr<const uint8_t>(pixels, [](const uint8_t*) {}), 4, 2, 2, PixelFormat::Gray8);
+
+    Frame cloned = frame.clone();
+    EXPECT_FALSE(cloned.isExternal());
+    EXPECT_EQ(cloned.format(), PixelFormat::Gray8);
+    EXPECT_EQ(cloned.data(), std::vector<uint8_t>(pixels, pixels + 4));
+}
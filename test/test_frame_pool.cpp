@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "frame_pool.hpp"
+#include "frame.hpp"
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+// ============================================================================
+// FramePool Tests
+// ============================================================================
+
+TEST(FramePoolTest, BuffersAreAlignedAndSized) {
+    FramePool pool(1000, 3);
+
+    EXPECT_EQ(pool.bufferSize(), 1000u);
+    EXPECT_EQ(pool.capacity(), 3u);
+    EXPECT_EQ(pool.available(), 3u);
+
+    auto buffer = pool.acquire();
+    ASSERT_NE(buffer, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(buffer.get()) % FramePool::kAlignment, 0u);
+}
+
+TEST(FramePoolTest, MemoryBudgetLimitsBuffers) {
+    MemoryBudget budget({.limit_bytes = 2500});
+    MemoryAccount& account = budget.account("frame-pool");
+    {
+        FramePool pool(1000, 4, &account);
+        EXPECT_EQ(pool.capacity(), 2u);
+        EXPECT_EQ(pool.available(), 2u);
+        EXPECT_EQ(account.used(), 2000u);
+    }
+    EXPECT_EQ(budget.used(), 0u);
+}
+
+TEST(FramePoolTest, ExhaustedPoolReturnsNull) {
+    FramePool pool(16, 2);
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+
+    EXPECT_EQ(pool.acquire(), nullptr);
+    EXPECT_EQ(pool.exhausted(), 1u);
+    EXPECT_EQ(pool.available(), 0u);
+}
+
+TEST(FramePoolTest, ReleasedBufferIsReused) {
+    FramePool pool(16, 1);
+    uint8_t* first = nullptr;
+    {
+        auto buffer = pool.acquire();
+        first = buffer.get();
+    }
+    EXPECT_EQ(pool.available(), 1u);
+    EXPECT_EQ(pool.acquire().get(), first);
+}
+
+TEST(FramePoolTest, FrameViewReturnsBufferWhenLastCopyDrops) {
+    FramePool pool(4, 1);
+    Frame frame(std::shared_ptr<const uint8_t>(pool.acquire()), 4, 2, 2, PixelFormat::Gray8);
+    Frame copy = frame;
+
+    frame = Frame();
+    EXPECT_EQ(pool.available(), 0u);
+    copy = Frame();
+    EXPECT_EQ(pool.available(), 1u);
+}
+
+TEST(FramePoolTest, BuffersOutlivePool) {
+    std::shared_ptr<uint8_t> buffer;
+    {
+        FramePool pool(64, 2);
+        buffer = pool.acquire();
+    }
+    buffer.get()[63] = 1;  // still valid after the pool object is gone
+    buffer.reset();
+}
+
+TEST(FramePoolTest, ConcurrentAcquireRelease) {
+    FramePool pool(64, 4);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool] {
+            for (int i = 0; i < 1000; ++i) {
+                if (auto buffer = pool.acquire()) {
+                    buffer.get()[0] = static_cast<uint8_t>(i);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(pool.available(), 4u);
+}
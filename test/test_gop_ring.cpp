@@ -0,0 +1,200 @@
+#include <gtest/gtest.h>
+#include "gop_ring.hpp"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unistd.h>
+
+using namespace pcs;
+
+namespace {
+
+constexpr int64_t kFrameTicks = 3000; // 30 fps in 90 kHz units
+
+// Frame `index` of a stream with a keyframe every `gop` frames; the bytes
+// encode the index so views can be checked against what was appended
+EncodedFrame makeFrame(int index, int gop, size_t size = 1000)
+{
+    EncodedFrame frame;
+    frame.data.assign(size, static_cast<uint8_t>(index));
+    frame.pts = index * kFrameTicks;
+    frame.dts = frame.pts;
+    frame.keyframe = index % gop == 0;
+    return frame;
+}
+
+} // namespace
+
+// ============================================================================
+// Append / Eviction Tests
+// ============================================================================
+
+TEST(GopRingTest, HoldsPacketsWithinBudget) {
+    GopRing ring({.budget_bytes = 10 * 1000});
+    for (int i = 0; i < 100; ++i) {
+        ring.append(makeFrame(i, 5));
+        EXPECT_LE(ring.stats().bytes, 10u * 1000u);
+    }
+
+    auto stats = ring.stats();
+    EXPECT_EQ(stats.appended, 100u);
+    EXPECT_EQ(stats.budget, 10u * 1000u);
+    // Whole GOPs are evicted, so the ring starts on a keyframe
+    EXPECT_EQ(stats.oldestPts % (5 * kFrameTicks), 0);
+    EXPECT_EQ(stats.newestPts, 99 * kFrameTicks);
+    EXPECT_EQ(stats.keyframes, (stats.packets + 4) / 5);
+}
+
+TEST(GopRingTest, WaitsForFirstKeyframe) {
+    GopRing ring({.budget_bytes = 100 * 1000});
+    EXPECT_FALSE(ring.append(makeFrame(1, 5)));
+    EXPECT_FALSE(ring.append(makeFrame(2, 5)));
+    EXPECT_TRUE(ring.append(makeFrame(5, 5)));
+    EXPECT_EQ(ring.stats().droppedNoKeyframe, 2u);
+}
+
+TEST(GopRingTest, RefusesOversizedPackets) {
+    GopRing ring({.budget_bytes = 4000});
+    EXPECT_FALSE(ring.append(makeFrame(0, 5, 5000)));
+    EXPECT_EQ(ring.stats().droppedOversize, 1u);
+    EXPECT_TRUE(ring.append(makeFrame(5, 5, 1000)));
+}
+
+TEST(GopRingTest, VariableSizesWrapCorrectly) {
+    GopRing ring({.budget_bytes = 64 * 1024});
+    for (int i = 0; i < 500; ++i) {
+        const size_t size = i % 10 == 0 ? 9000 : 500 + (i * 37) % 2000;
+        ring.append(makeFrame(i, 10, size));
+
+        // Every held packet still has its own bytes
+        GopClip clip = ring.clipFrom(0);
+        for (const PacketView& packet : clip.packets()) {
+            const auto index = static_cast<uint8_t>(packet.pts / kFrameTicks);
+            ASSERT_EQ(packet.data.front(), index);
+            ASSERT_EQ(packet.data.back(), index);
+        }
+    }
+    EXPECT_GT(ring.stats().evicted, 0u);
+    EXPECT_LE(ring.stats().bytes, 64u * 1024u);
+}
+
+// ============================================================================
+// Clip Tests
+// ============================================================================
+
+TEST(GopRingTest, ClipStartsAtEarlierKeyframe) {
+    GopRing ring({.budget_bytes = 1024 * 1024});
+    for (int i = 0; i < 60; ++i) {
+        ring.append(makeFrame(i, 10));
+    }
+
+    GopClip clip = ring.clipFrom(37 * kFrameTicks);
+    ASSERT_FALSE(clip.empty());
+    EXPECT_TRUE(clip.packets().front().keyframe);
+    EXPECT_EQ(clip.packets().front().pts, 30 * kFrameTicks);
+    EXPECT_EQ(clip.packets().back().pts, 59 * kFrameTicks);
+    EXPECT_EQ(clip.packets().size(), 30u);
+    EXPECT_EQ(clip.bytes(), 30u * 1000u);
+
+    // One second before the newest packet (frame 59) is frame 29: keyframe 20
+    GopClip last = ring.clipLast(std::chrono::milliseconds(1000));
+    EXPECT_EQ(last.packets().front().pts, 20 * kFrameTicks);
+    EXPECT_EQ(last.durationTicks(), 39 * kFrameTicks);
+}
+
+TEST(GopRingTest, ClipBeforeOldestStartsAtOldestKeyframe) {
+    GopRing ring({.budget_bytes = 10 * 1000});
+    for (int i = 0; i < 40; ++i) {
+        ring.append(makeFrame(i, 5));
+    }
+    GopClip clip = ring.clipFrom(0);
+    ASSERT_FALSE(clip.empty());
+    EXPECT_EQ(clip.packets().front().pts, ring.stats().oldestPts);
+}
+
+TEST(GopRingTest, ClipPinsItsPackets) {
+    GopRing ring({.budget_bytes = 10 * 1000});
+    for (int i = 0; i < 10; ++i) {
+        ring.append(makeFrame(i, 5));
+    }
+
+    {
+        GopClip clip = ring.clipFrom(0);
+        ASSERT_EQ(clip.packets().size(), 10u);
+        // The ring is full and everything is pinned: new packets are dropped
+        EXPECT_FALSE(ring.append(makeFrame(10, 5)));
+        EXPECT_FALSE(ring.append(makeFrame(11, 5)));
+        EXPECT_EQ(ring.stats().droppedPinned, 1u);
+        EXPECT_EQ(ring.stats().droppedNoKeyframe, 1u); // the rest of the GOP
+        for (const PacketView& packet : clip.packets()) {
+            EXPECT_EQ(packet.data.front(), static_cast<uint8_t>(packet.pts / kFrameTicks));
+        }
+    }
+
+    // Released: the oldest GOP makes way
+    EXPECT_TRUE(ring.append(makeFrame(15, 5)));
+    EXPECT_EQ(ring.stats().oldestPts, 5 * kFrameTicks);
+}
+
+TEST(GopRingTest, ClipOutlivesRing) {
+    GopClip clip;
+    {
+        GopRing ring({.budget_bytes = 10 * 1000});
+        for (int i = 0; i < 5; ++i) {
+            ring.append(makeFrame(i, 5));
+        }
+        clip = ring.clipFrom(0);
+    }
+    ASSERT_EQ(clip.packets().size(), 5u);
+    EXPECT_EQ(clip.packets()[4].data.front(), 4);
+}
+
+TEST(GopRingTest, AppendsWhileClipsAreTaken) {
+    GopRing ring({.budget_bytes = 64 * 1024});
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (int i = 0; i < 3000; ++i) {
+            ring.append(makeFrame(i, 15, 700));
+        }
+        done = true;
+    });
+
+    size_t mismatches = 0;
+    auto check = [&] {
+        GopClip clip = ring.clipLast(std::chrono::milliseconds(500));
+        for (const PacketView& packet : clip.packets()) {
+            mismatches += packet.data.back() != static_cast<uint8_t>(packet.pts / kFrameTicks);
+        }
+        return clip.empty();
+    };
+    do {
+        check();
+    } while (!done);
+    writer.join();
+    EXPECT_FALSE(check());
+    EXPECT_EQ(mismatches, 0u);
+    EXPECT_EQ(ring.stats().appended + ring.stats().droppedPinned + ring.stats().droppedNoKeyframe, 3000u);
+}
+
+TEST(GopRingTest, SavesClipAsTransportStream) {
+    GopRing ring({.budget_bytes = 1024 * 1024});
+    for (int i = 0; i < 20; ++i) {
+        ring.append(makeFrame(i, 10));
+    }
+    char path[] = "/tmp/pcs-clip-XXXXXX";
+    const int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    ::close(fd);
+
+    EXPECT_TRUE(saveClip(ring.clipFrom(15 * kFrameTicks), path));
+    std::ifstream file(path, std::ios::binary);
+    std::vector<uint8_t> ts((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path);
+
+    ASSERT_FALSE(ts.empty());
+    EXPECT_EQ(ts.size() % 188, 0u);
+    EXPECT_EQ(ts[0], 0x47);
+    EXPECT_FALSE(saveClip(GopClip{}, path));
+}
@@ -0,0 +1,97 @@
+#include <gtest/gtest.h>
+#include "histogram.hpp"
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+// ============================================================================
+// Bucketing Tests
+// ============================================================================
+
+TEST(HistogramTest, SmallValuesAreExact) {
+    for (uint64_t v = 0; v < 32; ++v) {
+        EXPECT_EQ(Histogram::bucketUpperBound(Histogram::bucketIndex(v)), v);
+    }
+}
+
+TEST(HistogramTest, BucketsBoundRelativeError) {
+    for (uint64_t v : {100ull, 1000ull, 33333ull, 1234567ull, 1ull << 40}) {
+        uint64_t upper = Histogram::bucketUpperBound(Histogram::bucketIndex(v));
+        EXPECT_GE(upper, v);
+        EXPECT_LE(static_cast<double>(upper - v), v / 16.0);
+    }
+}
+
+TEST(HistogramTest, LargestValueFits) {
+    uint64_t v = ~0ull;
+    EXPECT_EQ(Histogram::bucketIndex(v), Histogram::kBucketCount - 1);
+    EXPECT_EQ(Histogram::bucketUpperBound(Histogram::kBucketCount - 1), v);
+}
+
+// ============================================================================
+// Statistics Tests
+// ============================================================================
+
+TEST(HistogramTest, EmptyHistogram) {
+    Histogram h;
+    EXPECT_EQ(h.count(), 0u);
+    EXPECT_EQ(h.min(), 0u);
+    EXPECT_EQ(h.max(), 0u);
+    EXPECT_EQ(h.percentile(99), 0u);
+    EXPECT_DOUBLE_EQ(h.mean(), 0.0);
+}
+
+TEST(HistogramTest, PercentilesOfUniformValues) {
+    Histogram h;
+    for (uint64_t v = 1; v <= 1000; ++v) {
+        h.record(v);
+    }
+
+    EXPECT_EQ(h.count(), 1000u);
+    EXPECT_EQ(h.min(), 1u);
+    EXPECT_EQ(h.max(), 1000u);
+    EXPECT_DOUBLE_EQ(h.mean(), 500.5);
+    EXPECT_NEAR(static_cast<double>(h.percentile(50)), 500.0, 500.0 / 16);
+    EXPECT_NEAR(static_cast<double>(h.percentile(99)), 990.0, 990.0 / 16);
+    EXPECT_EQ(h.percentile(100), 1000u);
+}
+
+TEST(HistogramTest, PercentileNeverExceedsMax) {
+    Histogram h;
+    h.record(1000);
+    EXPECT_EQ(h.percentile(50), 1000u);
+}
+
+TEST(HistogramTest, MergeAndReset) {
+    Histogram a, b;
+    a.record(10);
+    b.record(20);
+    b.record(5);
+
+    a.merge(b);
+    EXPECT_EQ(a.count(), 3u);
+    EXPECT_EQ(a.min(), 5u);
+    EXPECT_EQ(a.max(), 20u);
+
+    a.reset();
+    EXPECT_EQ(a.count(), 0u);
+    EXPECT_EQ(a.min(), 0u);
+}
+
+TEST(HistogramTest, ConcurrentRecording) {
+    Histogram h;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&h] {
+            for (int i = 0; i < 10000; ++i) {
+                h.record(static_cast<uint64_t>(i));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(h.count(), 40000u);
+    EXPECT_EQ(h.max(), 9999u);
+}
@@ -1,5 +1,13 @@
 #include <gtest/gtest.h>
 #include "logger.hpp"
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
 
 // Simple smoke tests for Logger
 TEST(LoggerTest, BasicUsage) {
@@ -18,4 +26,185 @@ TEST(LoggerTest, FormattedMessages) {
 TEST(LoggerTest, GetLogger) {
     auto logger = Logger::get();
     EXPECT_TRUE(logger != nullptr);
+    EXPECT_EQ(Logger::get(), logger);
+}
+
+// ============================================================================
+// Async Mode Tests
+// ============================================================================
+
+// Logs to a file of its own, to be read back
+class LogFileTest : public ::testing::Test {
+protected:
+    std::filesystem::path m_path;
+
+    void SetUp() override
+    {
+        m_path = std::filesystem::temp_directory_path() /
+                 ("pcs-logger-test-" + std::to_string(::getpid()) + ".log");
+        Logger::shutdown();
+    }
+
+    void TearDown() override
+    {
+        Logger::shutdown();
+        std::filesystem::remove(m_path);
+    }
+
+    std::vector<std::string> readLines() const
+    {
+        std::vector<std::string> lines;
+        std::ifstream in(m_path);
+        for (std::string line; std::getline(in, line);) {
+            lines.push_back(line);
+        }
+        return lines;
+    }
+};
+
+class AsyncLoggerTest : public LogFileTest {};
+
+TEST_F(AsyncLoggerTest, BlockingQueueKeepsEveryMessage) {
+    Logger::init(m_path.string(), "info", {.async = true, .queue_size = 64, .console = false});
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 500; ++i) {
+                Logger::info("thread {} message {}", t, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    Logger::shutdown(); // drains the queue
+
+    EXPECT_EQ(readLines().size(), 2000u);
+}
+
+TEST_F(AsyncLoggerTest, OverrunKeepsTheNewest) {
+    Logger::init(m_path.string(), "info",
+                 {.async = true, .queue_size = 16, .overflow = LogOverflow::OverrunOldest, .console = false});
+    for (int i = 0; i < 5000; ++i) {
+        Logger::info("message {}", i);
+    }
+    Logger::shutdown();
+
+    auto lines = readLines();
+    ASSERT_FALSE(lines.empty());
+    EXPECT_LE(lines.size(), 5000u);
+    EXPECT_TRUE(lines.back().ends_with("message 4999"));
+}
+
+TEST_F(AsyncLoggerTest, LevelStillFilters) {
+    Logger::init(m_path.string(), "warn", {.async = true, .console = false});
+    Logger::info("dropped");
+    Logger::warn("kept");
+    Logger::setLevel("info");
+    Logger::info("kept too");
+    Logger::shutdown();
+
+    auto lines = readLines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_TRUE(lines[0].ends_with("kept"));
+    EXPECT_TRUE(lines[1].ends_with("kept too"));
+}
+
+// ============================================================================
+// Macro Tests
+// ============================================================================
+
+class LogMacroTest : public LogFileTest {};
+
+TEST_F(LogMacroTest, DisabledStatementSkipsArguments) {
+    Logger::init(m_path.string(), "warn", {.console = false});
+    int evaluated = 0;
+    auto argument = [&] { return ++evaluated; };
+
+    PCS_LOG_DEBUG("not written {}", argument());
+    PCS_LOG_EVERY(spdlog::level::info, std::chrono::seconds(0), "not written {}", argument());
+    PCS_LOG_EVERY_N(spdlog::level::trace, 1, "not written {}", argument());
+    EXPECT_EQ(evaluated, 0);
+
+    PCS_LOG_WARN("written {}", argument());
+    EXPECT_EQ(evaluated, 1);
+    Logger::shutdown();
+
+    auto lines = readLines();
+    ASSERT_EQ(lines.size(), 1u);
+    EXPECT_TRUE(lines[0].ends_with("written 1"));
+}
+
+TEST_F(LogMacroTest, FollowsRuntimeLevel) {
+    Logger::init(m_path.string(), "info", {.console = false});
+    EXPECT_FALSE(Logger::enabled(spdlog::level::debug));
+    Logger::setLevel("debug");
+    EXPECT_TRUE(Logger::enabled(spdlog::level::debug));
+    PCS_LOG_DEBUG("now written");
+    Logger::shutdown();
+
+    EXPECT_EQ(readLines().size(), 1u);
+}
+
+TEST_F(LogMacroTest, RateLimitedCountsWhatItHeldBack) {
+    Logger::init(m_path.string(), "info", {.console = false});
+    auto tick = [](int i) { PCS_LOG_EVERY(spdlog::level::warn, std::chrono::milliseconds(200), "tick {}", i); };
+    for (int i = 0; i < 10; ++i) {
+        tick(i);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    tick(10);
+    Logger::shutdown();
+
+    auto lines = readLines();
+    ASSERT_EQ(lines.size(), 2u);
+    EXPECT_TRUE(lines[0].ends_with("tick 0"));
+    EXPECT_TRUE(lines[1].ends_with("tick 10 (9 similar suppressed)"));
+}
+
+TEST_F(LogMacroTest, SampledLogsOneInN) {
+    Logger::init(m_path.string(), "info", {.console = false});
+    for (int i = 0; i < 10; ++i) {
+        PCS_LOG_EVERY_N(spdlog::level::info, 4, "frame {}", i);
+    }
+    Logger::shutdown();
+
+    auto lines = readLines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_TRUE(lines[0].ends_with("frame 0"));
+    EXPECT_TRUE(lines[1].ends_with("frame 4 (3 similar suppressed)"));
+    EXPECT_TRUE(lines[2].ends_with("frame 8 (3 similar suppressed)"));
+}
+
+TEST(LogLimiterTest, SamplerIsExactAcrossThreads) {
+    LogSampler sampler(10);
+    std::atomic<int> admitted{0};
+    std::atomic<uint64_t> suppressed{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 1000; ++i) {
+                uint64_t held = 0;
+                if (sampler.admit(held)) {
+                    admitted++;
+                    suppressed += held;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(admitted, 400);
+    EXPECT_EQ(suppressed, 399u * 9);
+}
+
+TEST(LogLimiterTest, RateLimiterAdmitsOncePerInterval) {
+    LogRateLimiter limiter(std::chrono::hours(1));
+    uint64_t held = 0;
+    EXPECT_TRUE(limiter.admit(held));
+    EXPECT_EQ(held, 0u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_FALSE(limiter.admit(held));
+    }
 }
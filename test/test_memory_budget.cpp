@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "memory_budget.hpp"
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+MemoryBudgetConfig budgetOf(size_t limit)
+{
+    return {.limit_bytes = limit, .defer_at = 0.5, .shed_at = 0.8};
+}
+
+} // namespace
+
+// ============================================================================
+// Charge Tests
+// ============================================================================
+
+TEST(MemoryBudgetTest, ChargesAndReleasesPerAccount) {
+    MemoryBudget budget(budgetOf(1000));
+    MemoryAccount& queue = budget.account("queue");
+    MemoryAccount& pool = budget.account("pool");
+    EXPECT_EQ(&budget.account("queue"), &queue);
+
+    EXPECT_TRUE(queue.tryCharge(300, MemoryPriority::Required));
+    EXPECT_TRUE(pool.tryCharge(200, MemoryPriority::Required));
+    EXPECT_EQ(budget.used(), 500u);
+    EXPECT_EQ(queue.used(), 300u);
+
+    queue.release(300);
+    EXPECT_EQ(budget.used(), 200u);
+    EXPECT_EQ(queue.used(), 0u);
+    EXPECT_EQ(queue.peak(), 300u);
+
+    auto usage = budget.usage();
+    ASSERT_EQ(usage.size(), 2u);
+    EXPECT_EQ(usage[0].name, "queue");
+    EXPECT_EQ(usage[1].name, "pool");
+    EXPECT_EQ(usage[1].used, 200u);
+}
+
+TEST(MemoryBudgetTest, RefusesByPriorityInStages) {
+    MemoryBudget budget(budgetOf(1000));
+    MemoryAccount& account = budget.account("frames");
+
+    ASSERT_TRUE(account.tryCharge(450, MemoryPriority::Required));
+    EXPECT_EQ(budget.pressure(), MemoryPressure::Normal);
+    EXPECT_FALSE(account.tryCharge(100, MemoryPriority::Deferrable)); // would pass 50%
+    EXPECT_TRUE(account.tryCharge(100, MemoryPriority::Droppable));
+    EXPECT_EQ(budget.pressure(), MemoryPressure::Deferring);
+
+    EXPECT_FALSE(account.tryCharge(300, MemoryPriority::Droppable)); // would pass 80%
+    EXPECT_TRUE(account.tryCharge(300, MemoryPriority::Required));
+    EXPECT_EQ(budget.pressure(), MemoryPressure::Shedding);
+    EXPECT_FALSE(account.tryCharge(0, MemoryPriority::Droppable)); // already past shed_at
+
+    EXPECT_FALSE(account.tryCharge(200, MemoryPriority::Required)); // would pass the limit
+    EXPECT_EQ(budget.pressure(), MemoryPressure::Exhausted);
+    EXPECT_EQ(budget.pressure(), MemoryPressure::Shedding); // reported once
+    EXPECT_TRUE(account.tryCharge(150, MemoryPriority::Required));
+
+    EXPECT_EQ(budget.used(), 1000u);
+    EXPECT_EQ(account.refused(), 4u);
+}
+
+TEST(MemoryBudgetTest, ZeroLimitOnlyCounts) {
+    MemoryBudget budget(budgetOf(0));
+    MemoryAccount& account = budget.account("frames");
+    EXPECT_TRUE(account.tryCharge(size_t{1} << 40, MemoryPriority::Deferrable));
+    EXPECT_EQ(budget.pressure(), MemoryPressure::Normal);
+    EXPECT_EQ(budget.used(), size_t{1} << 40);
+}
+
+TEST(MemoryBudgetTest, ChargeReleasesOnDestruction) {
+    MemoryBudget budget(budgetOf(1000));
+    MemoryAccount& account = budget.account("frames");
+    {
+        MemoryCharge charge = MemoryCharge::take(&account, 400, MemoryPriority::Required);
+        ASSERT_TRUE(charge);
+        EXPECT_EQ(charge.bytes(), 400u);
+
+        MemoryCharge moved = std::move(charge);
+        EXPECT_FALSE(charge);
+        EXPECT_EQ(budget.used(), 400u);
+
+        MemoryCharge refused = MemoryCharge::take(&account, 700, MemoryPriority::Required);
+        EXPECT_FALSE(refused);
+    }
+    EXPECT_EQ(budget.used(), 0u);
+
+    // No account: always granted, nothing charged
+    EXPECT_TRUE(MemoryCharge::take(nullptr, 1 << 30, MemoryPriority::Deferrable));
+}
+
+TEST(MemoryBudgetTest, ConcurrentChargesNeverPassLimit) {
+    MemoryBudget budget(budgetOf(10000));
+    MemoryAccount& account = budget.account("frames");
+    std::atomic<bool> overLimit{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20000; ++i) {
+                if (account.tryCharge(700, MemoryPriority::Required)) {
+                    overLimit = overLimit || budget.used() > 10000;
+                    account.release(700);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(overLimit);
+    EXPECT_EQ(budget.used(), 0u);
+}
+
+TEST(MemoryBudgetTest, DescribesUsage) {
+    MemoryBudget budget(budgetOf(4 * 1024 * 1024));
+    budget.account("capture-queue").tryCharge(1024 * 1024, MemoryPriority::Droppable);
+    budget.account("sender-queue").tryCharge(4 * 1024 * 1024, MemoryPriority::Required);
+
+    EXPECT_EQ(describeMemoryUsage(budget, budget.pressure()),
+              "1.0/4.0 MiB (exhausted): capture-queue 1.0 MiB, sender-queue 0.0 MiB (1 refused)");
+}
@@ -0,0 +1,171 @@
+#include <gtest/gtest.h>
+#include "mjpeg.hpp"
+#include <chrono>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+// Smallest byte sequence that passes the marker checks
+std::vector<uint8_t> fakeJpeg(size_t payload, size_t padding = 0)
+{
+    std::vector<uint8_t> bytes = {0xFF, 0xD8, 0xFF, 0xE0};
+    bytes.insert(bytes.end(), payload, 0x55);
+    bytes.push_back(0xFF);
+    bytes.push_back(0xD9);
+    bytes.insert(bytes.end(), padding, 0x00);
+    return bytes;
+}
+
+Frame jpegFrame(std::vector<uint8_t> bytes, uint32_t width = 64, uint32_t height = 48)
+{
+    return Frame(std::move(bytes), width, height, PixelFormat::MJPEG);
+}
+
+} // namespace
+
+// ============================================================================
+// Validation Tests
+// ============================================================================
+
+TEST(MjpegTest, AcceptsCompleteImage) {
+    auto bytes = fakeJpeg(100);
+    EXPECT_EQ(jpegImageLength(bytes), bytes.size());
+}
+
+TEST(MjpegTest, TrimsTrailingPadding) {
+    auto bytes = fakeJpeg(100, 37);
+    EXPECT_EQ(jpegImageLength(bytes), bytes.size() - 37);
+}
+
+TEST(MjpegTest, RejectsMissingMarkers) {
+    auto noSoi = fakeJpeg(100);
+    noSoi[1] = 0x00;
+    auto truncated = fakeJpeg(100);
+    truncated.resize(truncated.size() - 1);
+
+    EXPECT_EQ(jpegImageLength(noSoi), 0u);
+    EXPECT_EQ(jpegImageLength(truncated), 0u);
+    EXPECT_EQ(jpegImageLength({}), 0u);
+}
+
+// ============================================================================
+// Passthrough Tests
+// ============================================================================
+
+TEST(MjpegTest, PassthroughKeepsBytes) {
+    MjpegPassthrough passthrough;
+    auto bytes = fakeJpeg(200, 8);
+
+    auto out = passthrough.process(jpegFrame(bytes));
+
+    ASSERT_TRUE(out.has_value());
+    EXPECT_TRUE(out->keyframe);
+    EXPECT_EQ(out->data, std::vector<uint8_t>(bytes.begin(), bytes.end() - 8));
+    EXPECT_EQ(passthrough.framesPassed(), 1u);
+    EXPECT_EQ(passthrough.bytesPassed(), bytes.size() - 8);
+}
+
+TEST(MjpegTest, PassthroughUsesEncoderClock) {
+    MjpegPassthrough passthrough;
+    auto t0 = std::chrono::steady_clock::now();
+
+    Frame first = jpegFrame(fakeJpeg(10));
+    first.setTimestamp(t0);
+    Frame second = jpegFrame(fakeJpeg(10));
+    second.setTimestamp(t0 + std::chrono::milliseconds(100));
+    Frame stale = jpegFrame(fakeJpeg(10));
+    stale.setTimestamp(t0 + std::chrono::milliseconds(50));
+
+    EXPECT_EQ(passthrough.process(first)->pts, 0);
+    EXPECT_EQ(passthrough.process(second)->pts, 9000);
+    EXPECT_EQ(passthrough.process(stale)->pts, 9001); // never goes backwards
+}
+
+TEST(MjpegTest, PassthroughRejectsBadFrames) {
+    MjpegPassthrough passthrough(64);
+    auto broken = fakeJpeg(10);
+    broken.back() = 0x12;
+
+    EXPECT_FALSE(passthrough.process(jpegFrame(broken)).has_value());
+    EXPECT_FALSE(passthrough.process(jpegFrame(fakeJpeg(100))).has_value()); // over the limit
+    EXPECT_FALSE(passthrough.process(Frame(std::vector<uint8_t>(64 * 48), 64, 48, 1)).has_value());
+    EXPECT_EQ(passthrough.framesRejected(), 3u);
+    EXPECT_EQ(passthrough.framesPassed(), 0u);
+}
+
+// ============================================================================
+// Lazy Decode Tests
+// ============================================================================
+
+TEST(MjpegTest, LazyFrameDecodesOnceOnDemand) {
+    int calls = 0;
+    LazyFrame frame(jpegFrame(fakeJpeg(10)), [&](const Frame& jpeg) -> std::optional<Frame> {
+        ++calls;
+        return Frame(std::vector<uint8_t>(jpeg.width() * jpeg.height(), 7),
+                     jpeg.width(), jpeg.height(), PixelFormat::Gray8);
+    });
+
+    EXPECT_FALSE(frame.decoded());
+    EXPECT_EQ(calls, 0);
+
+    const Frame* pixels = frame.pixels();
+    ASSERT_NE(pixels, nullptr);
+    EXPECT_EQ(pixels->format(), PixelFormat::Gray8);
+    EXPECT_EQ(pixels->timestamp(), frame.captured().timestamp());
+    EXPECT_EQ(frame.pixels(), pixels);
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(MjpegTest, LazyFrameRawFrameIsItsOwnPixels) {
+    int calls = 0;
+    LazyFrame frame(Frame(std::vector<uint8_t>(64 * 48), 64, 48, PixelFormat::Gray8),
+                    [&](const Frame&) -> std::optional<Frame> { ++calls; return std::nullopt; });
+
+    EXPECT_EQ(frame.pixels(), &frame.captured());
+    EXPECT_EQ(calls, 0);
+}
+
+TEST(MjpegTest, LazyFrameDoesNotRetryFailedDecode) {
+    int calls = 0;
+    LazyFrame frame(jpegFrame(fakeJpeg(10)),
+                    [&](const Frame&) -> std::optional<Frame> { ++calls; return std::nullopt; });
+
+    EXPECT_EQ(frame.pixels(), nullptr);
+    EXPECT_EQ(frame.pixels(), nullptr);
+    EXPECT_EQ(calls, 1);
+}
+
+// The decoder wraps FFmpeg; only built where libav is available.
+#ifdef PCS_HAVE_LIBAV
+
+#include "mjpeg_decoder.hpp"
+
+TEST(MjpegDecoderTest, DecodesEncoderOutput) {
+    EncoderConfig config;
+    config.codec = CodecType::MJPEG;
+    config.width = 160;
+    config.height = 120;
+    config.hw_accel = "software";
+    Encoder encoder(config);
+    ASSERT_TRUE(encoder.init());
+    auto encoded = encoder.encode(Frame(std::vector<uint8_t>(160 * 120 * 3, 90), 160, 120, 3));
+    ASSERT_TRUE(encoded.has_value());
+
+    MjpegDecoder decoder(PixelFormat::Gray8);
+    auto decoded = decoder.decode(jpegFrame(encoded->data, 160, 120));
+
+    ASSERT_TRUE(decoded.has_value());
+    EXPECT_EQ(decoded->width(), 160u);
+    EXPECT_EQ(decoded->height(), 120u);
+    EXPECT_EQ(decoded->format(), PixelFormat::Gray8);
+    EXPECT_EQ(decoder.framesDecoded(), 1u);
+}
+
+TEST(MjpegDecoderTest, RejectsCorruptImage) {
+    MjpegDecoder decoder;
+    EXPECT_FALSE(decoder.decode(jpegFrame(fakeJpeg(50))).has_value());
+}
+
+#endif // PCS_HAVE_LIBAV
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+#include "multi_camera.hpp"
+#include "synthetic_source.hpp"
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+std::unique_ptr<CaptureSource> makeSource(uint32_t fps, Pacing pacing = Pacing::RealTime)
+{
+    SyntheticConfig config;
+    config.width = 64;
+    config.height = 48;
+    config.fps = fps;
+    config.format = PixelFormat::Gray8;
+    config.pacing = pacing;
+    config.pool_size = 8;
+    return std::make_unique<SyntheticSource>(config);
+}
+
+// Encodes a frame as its capture time, so the sink can check ordering
+std::optional<EncodedFrame> stampEncode(uint32_t, const Frame& frame)
+{
+    EncodedFrame out;
+    out.pts = frame.timestamp().time_since_epoch().count();
+    out.data.assign(1, 0);
+    return out;
+}
+
+struct Collector {
+    std::mutex mtx;
+    std::map<uint32_t, std::vector<int64_t>> stamps;
+
+    void operator()(uint32_t camera, EncodedFrame&& frame)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        stamps[camera].push_back(frame.pts);
+    }
+};
+
+} // namespace
+
+// ============================================================================
+// Lifecycle Tests
+// ============================================================================
+
+TEST(MultiCameraTest, StartFailsWithoutCameras) {
+    MultiCamera cameras({}, stampEncode, [](uint32_t, EncodedFrame&&) {});
+    EXPECT_FALSE(cameras.start());
+}
+
+TEST(MultiCameraTest, EveryCameraDeliversFrames) {
+    Collector collector;
+    MultiCamera cameras({}, stampEncode, std::ref(collector));
+    for (int i = 0; i < 3; ++i) {
+        cameras.addCamera(makeSource(100));
+    }
+
+    ASSERT_TRUE(cameras.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    cameras.stop();
+
+    ASSERT_EQ(collector.stamps.size(), 3u);
+    for (uint32_t i = 0; i < 3; ++i) {
+        CameraStats stats = cameras.stats(i);
+        EXPECT_GT(stats.captured, 5u) << "camera " << i;
+        EXPECT_EQ(stats.encoded, collector.stamps[i].size());
+        EXPECT_EQ(stats.captured, stats.encoded + stats.dropped);
+        EXPECT_GT(stats.fps, 0.0);
+        EXPECT_EQ(stats.name, "synthetic:bars");
+    }
+}
+
+TEST(MultiCameraTest, SharedPoolKeepsPerCameraOrder) {
+    Collector collector;
+    MultiCameraConfig config;
+    config.encode_workers = 4;
+    config.queue_depth = 64;
+    MultiCamera cameras(config, stampEncode, std::ref(collector));
+    cameras.addCamera(makeSource(1000, Pacing::MaxSpeed));
+    cameras.addCamera(makeSource(1000, Pacing::MaxSpeed));
+
+    ASSERT_TRUE(cameras.start());
+    EXPECT_EQ(cameras.encodeWorkers(), 4u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    cameras.stop();
+
+    for (auto& [camera, stamps] : collector.stamps) {
+        ASSERT_FALSE(stamps.empty());
+        EXPECT_TRUE(std::is_sorted(stamps.begin(), stamps.end())) << "camera " << camera;
+    }
+}
+
+TEST(MultiCameraTest, TimestampsShareOneClock) {
+    Collector collector;
+    MultiCamera cameras({}, stampEncode, std::ref(collector));
+    cameras.addCamera(makeSource(50));
+    cameras.addCamera(makeSource(50));
+
+    ASSERT_TRUE(cameras.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    cameras.stop();
+    const int64_t epoch = cameras.epoch().time_since_epoch().count();
+    const int64_t now = std::chrono::steady_clock::now().time_since_epoch().count();
+
+    // Both cameras' first frames were captured right after start()
+    for (auto& [camera, stamps] : collector.stamps) {
+        ASSERT_FALSE(stamps.empty());
+        EXPECT_GE(stamps.front(), epoch - std::chrono::nanoseconds(std::chrono::milliseconds(50)).count());
+        EXPECT_LE(stamps.back(), now);
+    }
+}
+
+TEST(MultiCameraTest, SlowEncoderDropsInsteadOfBlockingCapture) {
+    MultiCameraConfig config;
+    config.queue_depth = 2;
+    config.encode_workers = 1;
+    auto slowEncode = [](uint32_t camera, const Frame& frame) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return stampEncode(camera, frame);
+    };
+    MultiCamera cameras(config, slowEncode, [](uint32_t, EncodedFrame&&) {});
+    cameras.addCamera(makeSource(200));
+
+    ASSERT_TRUE(cameras.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    cameras.stop();
+
+    CameraStats stats = cameras.stats(0);
+    EXPECT_GT(stats.dropped, 0u);
+    EXPECT_GT(stats.captured, stats.encoded);
+    EXPECT_EQ(stats.captured, stats.encoded + stats.dropped);
+}
+
+TEST(MultiCameraTest, CountsEncodeFailures) {
+    MultiCamera cameras({}, [](uint32_t, const Frame&) { return std::optional<EncodedFrame>(); },
+                        [](uint32_t, EncodedFrame&&) {});
+    cameras.addCamera(makeSource(100));
+
+    ASSERT_TRUE(cameras.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    cameras.stop();
+
+    CameraStats stats = cameras.stats(0);
+    EXPECT_EQ(stats.encoded, 0u);
+    EXPECT_GT(stats.encodeFailures, 0u);
+}
+
+TEST(MultiCameraTest, CountsSkippedFramesApart) {
+    MultiCamera cameras({}, [](uint32_t, const Frame&) { return EncodeResult::skip(); },
+                        [](uint32_t, EncodedFrame&&) {});
+    cameras.addCamera(makeSource(100));
+
+    ASSERT_TRUE(cameras.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    cameras.stop();
+
+    CameraStats stats = cameras.stats(0);
+    EXPECT_GT(stats.skipped, 0u);
+    EXPECT_EQ(stats.encodeFailures, 0u);
+    EXPECT_EQ(stats.captured, stats.skipped + stats.dropped);
+}
+
+TEST(MultiCameraTest, PinnedCaptureThreadRuns) {
+    Collector collector;
+    MultiCamera cameras({}, stampEncode, std::ref(collector));
+    cameras.addCamera(makeSource(100), 0);
+
+    ASSERT_TRUE(cameras.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(60));
+    cameras.stop();
+
+    EXPECT_GT(cameras.stats(0).encoded, 0u);
+}
@@ -0,0 +1,407 @@
+#include <gtest/gtest.h>
+#include "pipeline.hpp"
+#include "synthetic_source.hpp"
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+std::unique_ptr<CaptureSource> makeSource(uint32_t fps, Pacing pacing = Pacing::RealTime)
+{
+    SyntheticConfig config;
+    config.width = 64;
+    config.height = 48;
+    config.fps = fps;
+    config.format = PixelFormat::I420;
+    config.pacing = pacing;
+    config.pool_size = 8;
+    return std::make_unique<SyntheticSource>(config);
+}
+
+// "Encodes" a frame as its capture time so ordering can be checked
+std::optional<EncodedFrame> stampEncode(const Frame& frame)
+{
+    EncodedFrame out;
+    out.pts = frame.timestamp().time_since_epoch().count();
+    out.data.assign(frame.size() / 16, 1);
+    return out;
+}
+
+struct Receiver {
+    std::mutex mtx;
+    std::vector<int64_t> pts;
+
+    bool operator()(EncodedFrame&& frame)
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        pts.push_back(frame.pts);
+        return true;
+    }
+};
+
+PipelineConfig quietConfig()
+{
+    PipelineConfig config;
+    config.stats_interval = std::chrono::milliseconds(0);
+    return config;
+}
+
+} // namespace
+
+// ============================================================================
+// Source Factory Tests
+// ============================================================================
+
+TEST(PipelineTest, SyntheticDeviceNames) {
+    config::CameraConfig camera;
+    camera.device = "synthetic";
+    auto plain = makeCaptureSource(camera, {PixelFormat::MJPEG, PixelFormat::YUYV});
+    ASSERT_NE(plain, nullptr);
+    EXPECT_EQ(plain->name(), "synthetic:bars");
+    EXPECT_EQ(plain->captureFormat().pixel_format, PixelFormat::YUYV); // first raw preference
+
+    camera.device = "synthetic:noise";
+    auto noise = makeCaptureSource(camera, {});
+    ASSERT_NE(noise, nullptr);
+    EXPECT_EQ(noise->name(), "synthetic:noise");
+
+    camera.device = "synthetic:plaid";
+    EXPECT_EQ(makeCaptureSource(camera, {}), nullptr);
+}
+
+TEST(PipelineTest, OtherDevicesAreV4l2) {
+    config::CameraConfig camera;
+    camera.device = "/dev/video-does-not-exist";
+    auto source = makeCaptureSource(camera, {PixelFormat::NV12});
+
+    ASSERT_NE(source, nullptr);
+    EXPECT_FALSE(source->start());
+}
+
+// ============================================================================
+// End-to-End Tests
+// ============================================================================
+
+TEST(PipelineTest, FramesFlowThroughAllStages) {
+    Receiver receiver;
+    PipelineConfig config = quietConfig();
+    config.max_frames = 20;
+    Pipeline pipeline(makeSource(200), stampEncode, std::ref(receiver), config);
+
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop); // returns once max_frames were captured and drained
+
+    EXPECT_TRUE(pipeline.captureDone());
+    auto stats = pipeline.report();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[0].name, "capture");
+    EXPECT_EQ(stats[0].frames, 20u);
+    EXPECT_EQ(stats[2].frames, receiver.pts.size());
+    EXPECT_EQ(stats[0].frames, stats[0].dropped + stats[1].frames);
+    EXPECT_TRUE(std::is_sorted(receiver.pts.begin(), receiver.pts.end()));
+}
+
+TEST(PipelineTest, SkippedFramesAreNotDrops) {
+    Receiver receiver;
+    PipelineConfig config = quietConfig();
+    config.max_frames = 20;
+    int seen = 0; // encode thread only
+    auto encode = [&](const Frame& frame) -> EncodeResult {
+        return seen++ % 2 ? EncodeResult::skip() : EncodeResult(stampEncode(frame));
+    };
+    Pipeline pipeline(makeSource(200), encode, std::ref(receiver), config);
+
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop);
+
+    auto stats = pipeline.report();
+    ASSERT_EQ(stats.size(), 3u);
+    EXPECT_EQ(stats[1].dropped, 0u);
+    EXPECT_GT(stats[1].skipped, 0u);
+    EXPECT_EQ(stats[0].frames, stats[0].dropped + stats[1].frames + stats[1].skipped);
+    EXPECT_EQ(stats[2].frames, receiver.pts.size());
+}
+
+TEST(PipelineTest, StopRequestEndsRun) {
+    Receiver receiver;
+    Pipeline pipeline(makeSource(100), stampEncode, std::ref(receiver), quietConfig());
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+
+    std::thread requester([&] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        stop = true;
+    });
+    auto begin = std::chrono::steady_clock::now();
+    pipeline.run(stop);
+    requester.join();
+
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(2));
+    EXPECT_FALSE(receiver.pts.empty());
+}
+
+TEST(PipelineTest, SlowEncoderDropsAtCapture) {
+    PipelineConfig config = quietConfig();
+    config.capture_queue = 1;
+    Receiver receiver;
+    auto slowEncode = [](const Frame& frame) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        return stampEncode(frame);
+    };
+    Pipeline pipeline(makeSource(200), slowEncode, std::ref(receiver), config);
+
+    ASSERT_TRUE(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pipeline.stop();
+
+    auto stats = pipeline.report();
+    EXPECT_GT(stats[0].dropped, 0u);
+    EXPECT_EQ(stats[1].frames, receiver.pts.size());
+}
+
+TEST(PipelineTest, SlowSenderBacksUpWithoutLosingEncodedFrames) {
+    PipelineConfig config = quietConfig();
+    config.capture_queue = 2;
+    config.send_queue = 2;
+    Receiver receiver;
+    auto slowSend = [&](EncodedFrame&& frame) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        return receiver(std::move(frame));
+    };
+    Pipeline pipeline(makeSource(300), stampEncode, slowSend, config);
+
+    ASSERT_TRUE(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pipeline.stop();
+
+    auto stats = pipeline.report();
+    EXPECT_GT(stats[0].dropped, 0u);                  // capture absorbed the backlog
+    EXPECT_EQ(stats[1].frames, stats[2].frames);      // every encoded frame was sent
+    EXPECT_EQ(stats[2].frames, receiver.pts.size());
+}
+
+TEST(PipelineTest, ReportsPerWindowStats) {
+    Receiver receiver;
+    Pipeline pipeline(makeSource(1000, Pacing::MaxSpeed), stampEncode, std::ref(receiver), quietConfig());
+    ASSERT_TRUE(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto first = pipeline.report();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto second = pipeline.report();
+    pipeline.stop();
+
+    EXPECT_GT(first[0].fps, 0.0);
+    EXPECT_GT(second[0].frames, 0u);
+    EXPECT_GT(first[2].latencyMaxUs, 0u);
+    EXPECT_LE(second[2].latencyP50Us, second[2].latencyP99Us);
+}
+
+TEST(PipelineTest, RunsOnlyOnce) {
+    Receiver receiver;
+    Pipeline pipeline(makeSource(100), stampEncode, std::ref(receiver), quietConfig());
+
+    ASSERT_TRUE(pipeline.start());
+    pipeline.stop();
+    EXPECT_FALSE(pipeline.start());
+}
+
+TEST(PipelineTest, StageThreadsAreConfiguredAndReported) {
+    Receiver receiver;
+    PipelineConfig config = quietConfig();
+    config.capture_thread.cpus = {0};
+    Pipeline pipeline(makeSource(100), stampEncode, std::ref(receiver), config);
+
+    ASSERT_TRUE(pipeline.start());
+    const auto& reports = pipeline.threadReports();
+    ASSERT_EQ(reports.size(), 3u);
+    EXPECT_EQ(reports[0].name, "pcs-capture");
+    EXPECT_EQ(reports[0].cpus, std::vector<int>({0}));
+    EXPECT_EQ(reports[1].name, "pcs-encode");
+    EXPECT_EQ(reports[2].name, "pcs-send");
+    pipeline.stop();
+}
+
+TEST(PipelineTest, FpsCapAppliesLive) {
+    Receiver receiver;
+    PipelineConfig config = quietConfig();
+    config.fps_cap = 20.0;
+    Pipeline pipeline(makeSource(200), stampEncode, std::ref(receiver), config);
+    ASSERT_TRUE(pipeline.start());
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    auto capped = pipeline.report();
+
+    config.fps_cap = 0.0;
+    pipeline.reconfigure(config);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    auto uncapped = pipeline.report();
+    pipeline.stop();
+
+    EXPECT_LT(capped[1].fps, 30.0);
+    EXPECT_GT(capped[0].dropped, 0u); // decimated frames count as capture drops
+    EXPECT_GT(uncapped[1].fps, capped[1].fps * 2);
+}
+
+TEST(PipelineTest, RunCallsControlHookWithLoad) {
+    PipelineConfig config = quietConfig();
+    config.send_queue = 2;
+    config.control_interval = std::chrono::milliseconds(50);
+    Receiver receiver;
+    auto slowSend = [&](EncodedFrame&& frame) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(15));
+        return receiver(std::move(frame));
+    };
+    Pipeline pipeline(makeSource(300), stampEncode, slowSend, config);
+    ASSERT_TRUE(pipeline.start());
+
+    std::atomic<bool> stop{false};
+    std::vector<PipelineLoad> loads;
+    pipeline.run(stop, [&] {
+        loads.push_back(pipeline.load());
+        stop = loads.size() >= 4;
+    });
+
+    ASSERT_EQ(loads.size(), 4u);
+    EXPECT_GT(loads.back().latencyP99Us, 0u);
+    EXPECT_GT(loads.back().queueFill, 0.0); // the slow sender keeps its queue full
+    EXPECT_LE(loads.back().queueFill, 1.0);
+}
+
+TEST(PipelineTest, FrameTapSeesEveryEncodedFrame) {
+    PipelineConfig config = quietConfig();
+    config.max_frames = 20;
+    Receiver receiver;
+    int failed = 0;
+    auto flakyEncode = [&](const Frame& frame) -> std::optional<EncodedFrame> {
+        if (++failed % 4 == 0) {
+            return std::nullopt;
+        }
+        return stampEncode(frame);
+    };
+    Pipeline pipeline(makeSource(200), flakyEncode, std::ref(receiver), config);
+
+    std::vector<Frame::Timestamp> tapped;
+    pipeline.setFrameTap([&](Frame&& frame) {
+        EXPECT_FALSE(frame.empty());
+        tapped.push_back(frame.timestamp());
+    });
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop);
+
+    auto stats = pipeline.report();
+    // Tapped whether or not the encoder produced anything
+    EXPECT_EQ(tapped.size(), stats[1].frames + stats[1].dropped);
+    EXPECT_EQ(receiver.pts.size(), stats[1].frames);
+    EXPECT_TRUE(std::is_sorted(tapped.begin(), tapped.end()));
+}
+
+TEST(PipelineTest, MemoryPressureShedsAtCapture) {
+    MemoryBudget budget({.limit_bytes = 1000, .defer_at = 0.5, .shed_at = 0.8});
+    MemoryCharge elsewhere = MemoryCharge::take(&budget.account("other"), 900, MemoryPriority::Required);
+    ASSERT_TRUE(elsewhere);
+
+    PipelineConfig config = quietConfig();
+    config.max_frames = 10;
+    config.memory = &budget;
+    Receiver receiver;
+    Pipeline pipeline(makeSource(200), stampEncode, std::ref(receiver), config);
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop);
+
+    // Past shed_at every captured frame is dropped before it costs anything
+    auto stats = pipeline.report();
+    EXPECT_EQ(stats[0].dropped, 10u);
+    EXPECT_EQ(stats[1].frames, 0u);
+    EXPECT_EQ(budget.account("capture-queue").refused(), 10u);
+    EXPECT_EQ(budget.used(), 900u);
+}
+
+TEST(PipelineTest, RecordsFirstFrameThroughEachStage) {
+    PipelineConfig config = quietConfig();
+    config.max_frames = 5;
+    Receiver receiver;
+    Pipeline pipeline(makeSource(200), stampEncode, std::ref(receiver), config);
+    EXPECT_FALSE(pipeline.firstFrame().captured.has_value());
+
+    const auto before = std::chrono::steady_clock::now();
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop);
+
+    const FirstFrameTimes first = pipeline.firstFrame();
+    ASSERT_TRUE(first.captured && first.encoded && first.sent);
+    EXPECT_GE(*first.captured, before);
+    EXPECT_LE(*first.captured, *first.encoded);
+    EXPECT_LE(*first.encoded, *first.sent);
+}
+
+TEST(PipelineTest, LostEncodedFrameDropsRestOfGopAndAsksForKeyframe) {
+    // Frame 2 is larger than the whole budget; keyframes every 4 frames
+    MemoryBudget budget({.limit_bytes = 1000});
+    PipelineConfig config = quietConfig();
+    config.max_frames = 12;
+    config.memory = &budget;
+    int index = 0;
+    auto gopEncode = [&](const Frame&) -> std::optional<EncodedFrame> {
+        EncodedFrame out;
+        out.pts = index;
+        out.keyframe = index % 4 == 0;
+        out.data.assign(index == 2 ? 2000 : 10, 1);
+        ++index;
+        return out;
+    };
+    Receiver receiver;
+    Pipeline pipeline(makeSource(100), gopEncode, std::ref(receiver), config);
+    std::atomic<int> keyframeRequests{0};
+    pipeline.setKeyframeRequest([&] { keyframeRequests++; });
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop);
+
+    ASSERT_GE(index, 5);
+    EXPECT_EQ(keyframeRequests, 1);
+    EXPECT_EQ(pipeline.report()[1].dropped, 2u); // frames 2 and 3
+    for (int64_t pts : receiver.pts) {
+        EXPECT_TRUE(pts < 2 || pts >= 4) << pts;
+    }
+}
+
+TEST(PipelineTest, RefusedSendAsksForKeyframe) {
+    PipelineConfig config = quietConfig();
+    config.max_frames = 6;
+    int sent = 0;
+    auto refuseThird = [&](EncodedFrame&&) { return ++sent != 3; };
+    Pipeline pipeline(makeSource(200), stampEncode, refuseThird, config);
+    std::atomic<int> keyframeRequests{0};
+    pipeline.setKeyframeRequest([&] { keyframeRequests++; });
+    std::atomic<bool> stop{false};
+    ASSERT_TRUE(pipeline.start());
+    pipeline.run(stop);
+
+    ASSERT_GE(sent, 3);
+    EXPECT_EQ(keyframeRequests, 1);
+}
+
+TEST(PipelineTest, ReportsCapturePacing) {
+    Receiver receiver;
+    Pipeline pipeline(makeSource(100), stampEncode, std::ref(receiver), quietConfig());
+    ASSERT_TRUE(pipeline.start());
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    pipeline.stop();
+
+    auto stats = pipeline.report();
+    ASSERT_TRUE(stats[0].pacing.has_value());
+    EXPECT_FALSE(stats[1].pacing.has_value());
+    EXPECT_EQ(stats[0].pacing->early, 0u); // no fps_cap, nothing decimated
+    EXPECT_LE(stats[0].pacing->jitterP50Us, stats[0].pacing->jitterMaxUs);
+}
@@ -0,0 +1,352 @@
+#include <gtest/gtest.h>
+#include "recorder.hpp"
+#include "ts_muxer.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+constexpr int64_t kFrameTicks = 3000; // 30 fps in 90 kHz units
+
+EncodedFrame makeFrame(int index, int gop, size_t size = 1000)
+{
+    EncodedFrame frame;
+    frame.data.assign(size, static_cast<uint8_t>(index));
+    // Annex B slice NAL so the muxer has something H.264-shaped to carry
+    frame.data[0] = 0;
+    frame.data[1] = 0;
+    frame.data[2] = 1;
+    frame.data[3] = index % gop == 0 ? 0x65 : 0x41;
+    frame.pts = index * kFrameTicks;
+    frame.dts = frame.pts;
+    frame.keyframe = index % gop == 0;
+    return frame;
+}
+
+struct TsPacket {
+    uint16_t pid;
+    bool unitStart;
+    uint8_t counter;
+    bool hasPcr;
+    bool randomAccess;
+    std::vector<uint8_t> payload;
+};
+
+std::vector<TsPacket> parsePackets(const std::vector<uint8_t>& ts)
+{
+    std::vector<TsPacket> packets;
+    for (size_t pos = 0; pos + TsMuxer::kPacketSize <= ts.size(); pos += TsMuxer::kPacketSize) {
+        const uint8_t* p = ts.data() + pos;
+        EXPECT_EQ(p[0], 0x47);
+        TsPacket packet;
+        packet.pid = static_cast<uint16_t>((p[1] & 0x1F) << 8 | p[2]);
+        packet.unitStart = p[1] & 0x40;
+        packet.counter = p[3] & 0x0F;
+        packet.hasPcr = false;
+        packet.randomAccess = false;
+        size_t start = 4;
+        if (p[3] & 0x20) {
+            const uint8_t length = p[4];
+            if (length > 0) {
+                packet.randomAccess = p[5] & 0x40;
+                packet.hasPcr = p[5] & 0x10;
+            }
+            start = 5 + length;
+        }
+        packet.payload.assign(p + start, p + TsMuxer::kPacketSize);
+        packets.push_back(std::move(packet));
+    }
+    return packets;
+}
+
+int64_t readTimestamp(const uint8_t* p)
+{
+    return (int64_t{p[0]} & 0x0E) << 29 | int64_t{p[1]} << 22 | (int64_t{p[2]} & 0xFE) << 14 |
+           int64_t{p[3]} << 7 | int64_t{p[4]} >> 1;
+}
+
+std::vector<uint8_t> readFile(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// A scratch directory for segment files
+class RecorderTest : public ::testing::Test {
+protected:
+    void SetUp() override
+    {
+        char pattern[] = "/tmp/pcs-record-XXXXXX";
+        ASSERT_NE(mkdtemp(pattern), nullptr);
+        dir_ = pattern;
+    }
+
+    void TearDown() override
+    {
+        for (const std::string& file : segments()) {
+            std::remove(file.c_str());
+        }
+        ::rmdir(dir_.c_str());
+    }
+
+    std::vector<std::string> segments() const
+    {
+        std::vector<std::string> files;
+        if (DIR* dir = ::opendir(dir_.c_str())) {
+            while (dirent* entry = ::readdir(dir)) {
+                const std::string name = entry->d_name;
+                if (name != "." && name != "..") {
+                    files.push_back(dir_ + "/" + name);
+                }
+            }
+            ::closedir(dir);
+        }
+        std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+            // Sequence number is the last field; the timestamp may tie
+            auto seq = [](const std::string& s) {
+                return std::stoi(s.substr(s.rfind('-') + 1));
+            };
+            return seq(a) < seq(b);
+        });
+        return files;
+    }
+
+    RecorderConfig config() const
+    {
+        RecorderConfig config;
+        config.directory = dir_;
+        config.segment_duration = std::chrono::seconds(1);
+        config.write_batch = 8192;
+        config.preallocate_bytes = 1024 * 1024;
+        return config;
+    }
+
+    std::string dir_;
+};
+
+} // namespace
+
+// ============================================================================
+// TsMuxer Tests
+// ============================================================================
+
+TEST(TsMuxerTest, TablesAreValidSections) {
+    TsMuxer muxer;
+    std::vector<uint8_t> ts;
+    muxer.writeTables(ts);
+    auto packets = parsePackets(ts);
+    ASSERT_EQ(packets.size(), 2u);
+
+    EXPECT_EQ(packets[0].pid, 0x0000);
+    EXPECT_EQ(packets[1].pid, TsMuxer::kPmtPid);
+    for (const TsPacket& packet : packets) {
+        ASSERT_TRUE(packet.unitStart);
+        ASSERT_EQ(packet.payload[0], 0); // pointer field
+        const uint8_t* section = packet.payload.data() + 1;
+        const size_t length = 3 + ((section[1] & 0x0F) << 8 | section[2]);
+        EXPECT_EQ(mpegCrc32(section, length), 0u); // CRC over data and CRC is zero
+    }
+    // PMT lists one H.264 stream on the video PID
+    const uint8_t* pmt = packets[1].payload.data() + 1;
+    EXPECT_EQ(pmt[12], 0x1B);
+    EXPECT_EQ((pmt[13] & 0x1F) << 8 | pmt[14], TsMuxer::kVideoPid);
+}
+
+TEST(TsMuxerTest, KeyframeCarriesTablesPcrAndTimestamps) {
+    TsMuxer muxer;
+    EncodedFrame frame = makeFrame(0, 30, 1000);
+    frame.pts = 9000;
+    frame.dts = 6000;
+    std::vector<uint8_t> ts;
+    muxer.writeFrame(frame, ts);
+
+    ASSERT_EQ(ts.size() % TsMuxer::kPacketSize, 0u);
+    auto packets = parsePackets(ts);
+    ASSERT_GE(packets.size(), 3u);
+    EXPECT_EQ(packets[0].pid, 0x0000);
+    EXPECT_EQ(packets[1].pid, TsMuxer::kPmtPid);
+
+    const TsPacket& first = packets[2];
+    EXPECT_EQ(first.pid, TsMuxer::kVideoPid);
+    EXPECT_TRUE(first.unitStart);
+    EXPECT_TRUE(first.hasPcr);
+    EXPECT_TRUE(first.randomAccess);
+
+    const uint8_t* pes = first.payload.data();
+    EXPECT_EQ(pes[0], 0);
+    EXPECT_EQ(pes[2], 1);
+    EXPECT_EQ(pes[3], 0xE0);
+    EXPECT_EQ(pes[7], 0xC0); // PTS and DTS
+    EXPECT_EQ(readTimestamp(pes + 9), 9000 + TsMuxer::kTimestampOffset);
+    EXPECT_EQ(readTimestamp(pes + 14), 6000 + TsMuxer::kTimestampOffset);
+}
+
+TEST(TsMuxerTest, PayloadSurvivesPacketisation) {
+    TsMuxer muxer;
+    std::vector<uint8_t> ts;
+    std::vector<EncodedFrame> frames;
+    for (int i = 0; i < 5; ++i) {
+        frames.push_back(makeFrame(i, 3, 100 + 700 * i)); // short, and spanning many packets
+        muxer.writeFrame(frames.back(), ts);
+    }
+
+    // Reassemble each PES and check continuity on the video PID
+    std::vector<std::vector<uint8_t>> pes;
+    int expectedCounter = -1;
+    for (const TsPacket& packet : parsePackets(ts)) {
+        if (packet.pid != TsMuxer::kVideoPid) {
+            continue;
+        }
+        if (expectedCounter >= 0) {
+            EXPECT_EQ(packet.counter, expectedCounter);
+        }
+        expectedCounter = (packet.counter + 1) & 0x0F;
+        if (packet.unitStart) {
+            pes.emplace_back();
+        }
+        pes.back().insert(pes.back().end(), packet.payload.begin(), packet.payload.end());
+    }
+
+    ASSERT_EQ(pes.size(), frames.size());
+    const std::vector<uint8_t> aud = {0, 0, 0, 1, 0x09, 0xF0};
+    for (size_t i = 0; i < frames.size(); ++i) {
+        const size_t header = 9 + pes[i][8];
+        std::vector<uint8_t> body(pes[i].begin() + header, pes[i].end());
+        std::vector<uint8_t> expected = aud;
+        expected.insert(expected.end(), frames[i].data.begin(), frames[i].data.end());
+        EXPECT_EQ(body, expected) << "frame " << i;
+    }
+}
+
+// ============================================================================
+// Recorder Tests
+// ============================================================================
+
+TEST_F(RecorderTest, RotatesSegmentsOnKeyframes) {
+    Recorder recorder(config());
+    ASSERT_TRUE(recorder.start());
+    for (int i = 0; i < 90; ++i) { // 3 s of stream, a keyframe every 0.5 s
+        ASSERT_TRUE(recorder.push(makeFrame(i, 15)));
+    }
+    recorder.stop();
+
+    const RecorderStats stats = recorder.stats();
+    EXPECT_EQ(stats.framesWritten, 90u);
+    EXPECT_EQ(stats.framesDropped, 0u);
+    EXPECT_EQ(stats.segments, 3u);
+    EXPECT_GE(stats.syncs, 3u); // at least one per segment close
+
+    auto files = segments();
+    ASSERT_EQ(files.size(), 3u);
+    uint64_t total = 0;
+    for (const std::string& file : files) {
+        auto ts = readFile(file);
+        ASSERT_FALSE(ts.empty());
+        EXPECT_EQ(ts.size() % TsMuxer::kPacketSize, 0u) << file; // preallocation trimmed
+        auto packets = parsePackets(ts);
+        EXPECT_EQ(packets[0].pid, 0x0000) << file;               // each segment starts with the tables
+        EXPECT_TRUE(packets[2].randomAccess) << file;            // and a keyframe
+        total += ts.size();
+    }
+    EXPECT_EQ(total, stats.bytesWritten);
+    EXPECT_TRUE(recorder.currentSegment().empty());
+}
+
+TEST_F(RecorderTest, FullQueueDropsRestOfGop) {
+    RecorderConfig cfg = config();
+    cfg.queue_bytes = 10 * 1000;
+    Recorder recorder(cfg);
+
+    // Not started yet: frames wait in the queue until it is full
+    int accepted = 0;
+    for (int i = 0; i < 30; ++i) {
+        accepted += recorder.push(makeFrame(i, 5)) ? 1 : 0;
+    }
+    EXPECT_EQ(accepted, 10);
+    RecorderStats stats = recorder.stats();
+    EXPECT_EQ(stats.framesDropped, 20u);
+    EXPECT_EQ(stats.gopsDropped, 4u);
+
+    ASSERT_TRUE(recorder.start());
+    for (int i = 0; i < 200 && recorder.stats().framesWritten < 10; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    // Room again, but mid-GOP: still skipped until the next keyframe
+    EXPECT_FALSE(recorder.push(makeFrame(31, 5)));
+    EXPECT_TRUE(recorder.push(makeFrame(35, 5)));
+    recorder.stop();
+
+    stats = recorder.stats();
+    EXPECT_EQ(stats.framesWritten, 11u);
+    EXPECT_EQ(stats.gopsDropped, 4u);
+}
+
+TEST_F(RecorderTest, MemoryBudgetDefersRecording) {
+    MemoryBudget budget({.limit_bytes = 10 * 1000, .defer_at = 0.5});
+    RecorderConfig cfg = config();
+    cfg.memory = &budget.account("recorder-queue");
+    Recorder recorder(cfg);
+
+    // The budget stops Deferrable charges at half its limit, well before
+    // the queue's own limit
+    int accepted = 0;
+    for (int i = 0; i < 30; ++i) {
+        accepted += recorder.push(makeFrame(i, 5)) ? 1 : 0;
+    }
+    EXPECT_EQ(accepted, 5);
+    EXPECT_EQ(recorder.stats().gopsDropped, 5u);
+    EXPECT_EQ(budget.used(), 5u * 1000u);
+
+    ASSERT_TRUE(recorder.start());
+    recorder.stop();
+    EXPECT_EQ(recorder.stats().framesWritten, 5u);
+    EXPECT_EQ(budget.used(), 0u);
+}
+
+TEST_F(RecorderTest, SkipsFramesBeforeFirstKeyframe) {
+    Recorder recorder(config());
+    ASSERT_TRUE(recorder.start());
+    EXPECT_FALSE(recorder.push(makeFrame(1, 30)));
+    EXPECT_FALSE(recorder.push(makeFrame(2, 30)));
+    EXPECT_TRUE(recorder.push(makeFrame(30, 30)));
+    recorder.stop();
+
+    EXPECT_EQ(recorder.stats().framesWritten, 1u);
+    EXPECT_EQ(recorder.stats().framesDropped, 2u);
+    EXPECT_EQ(recorder.stats().gopsDropped, 0u);
+}
+
+TEST_F(RecorderTest, DirectIoKeepsExactSize) {
+    RecorderConfig cfg = config();
+    cfg.direct_io = true; // buffered fallback where the filesystem refuses it
+    Recorder recorder(cfg);
+    ASSERT_TRUE(recorder.start());
+    for (int i = 0; i < 20; ++i) {
+        recorder.push(makeFrame(i, 30, 1500));
+    }
+    recorder.stop();
+
+    auto files = segments();
+    ASSERT_EQ(files.size(), 1u);
+    auto ts = readFile(files[0]);
+    EXPECT_EQ(ts.size() % TsMuxer::kPacketSize, 0u);
+    EXPECT_EQ(parsePackets(ts).back().pid, TsMuxer::kVideoPid); // no padding left at the end
+    EXPECT_EQ(recorder.stats().framesWritten, 20u);
+}
+
+TEST_F(RecorderTest, StartFailsForMissingDirectory) {
+    RecorderConfig cfg = config();
+    cfg.directory = "/nonexistent-dir/recordings";
+    Recorder recorder(cfg);
+    EXPECT_FALSE(recorder.start());
+}
@@ -0,0 +1,223 @@
+#include <gtest/gtest.h>
+#include "replay_source.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+#include <vector>
+
+using namespace pcs;
+using namespace std::chrono_literals;
+
+class ReplaySourceTest : public ::testing::Test {
+protected:
+    std::filesystem::path m_dir;
+
+    void SetUp() override
+    {
+        m_dir = std::filesystem::temp_directory_path() /
+                ("pcs-replay-test-" + std::to_string(::getpid()));
+        std::filesystem::create_directories(m_dir);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove_all(m_dir);
+    }
+
+    std::string writeFile(const std::string& name, const std::vector<uint8_t>& bytes)
+    {
+        auto path = m_dir / name;
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        return path.string();
+    }
+
+    std::string writeText(const std::string& name, const std::string& text)
+    {
+        auto path = m_dir / name;
+        std::ofstream(path) << text;
+        return path.string();
+    }
+
+    // `count` NV12 frames of 16x8, frame i filled with byte i
+    std::string writeRaw(int count, size_t trailing = 0)
+    {
+        std::vector<uint8_t> bytes;
+        for (int i = 0; i < count; ++i) {
+            bytes.insert(bytes.end(), kFrameBytes, static_cast<uint8_t>(i));
+        }
+        bytes.insert(bytes.end(), trailing, 0xEE);
+        return writeFile("clip.nv12", bytes);
+    }
+
+    ReplayConfig rawConfig(const std::string& path)
+    {
+        ReplayConfig config;
+        config.path = path;
+        config.width = 16;
+        config.height = 8;
+        config.format = PixelFormat::NV12;
+        config.pacing = Pacing::MaxSpeed;
+        return config;
+    }
+
+    static constexpr size_t kFrameBytes = 16 * 8 * 3 / 2;
+};
+
+// ============================================================================
+// Raw Replay Tests
+// ============================================================================
+
+TEST_F(ReplaySourceTest, ReplaysRawFramesZeroCopy) {
+    ReplaySource source(rawConfig(writeRaw(3)));
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(source.read(frame));
+        EXPECT_TRUE(frame.isExternal());
+        EXPECT_TRUE(frame.isValid());
+        EXPECT_EQ(frame.bytes()[0], i);
+        EXPECT_EQ(frame.bytes()[kFrameBytes - 1], i);
+    }
+
+    EXPECT_FALSE(source.read(frame));
+    EXPECT_TRUE(source.finished());
+    EXPECT_EQ(source.framesRead(), 3u);
+}
+
+TEST_F(ReplaySourceTest, IgnoresTrailingPartialFrame) {
+    ReplaySource source(rawConfig(writeRaw(2, 10)));
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    EXPECT_TRUE(source.read(frame));
+    EXPECT_TRUE(source.read(frame));
+    EXPECT_FALSE(source.read(frame));
+}
+
+TEST_F(ReplaySourceTest, LoopsBackToStart) {
+    auto config = rawConfig(writeRaw(2));
+    config.loop = true;
+    ReplaySource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    std::vector<int> seen;
+    for (int i = 0; i < 5; ++i) {
+        ASSERT_TRUE(source.read(frame));
+        seen.push_back(frame.bytes()[0]);
+    }
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 0, 1, 0}));
+    EXPECT_EQ(source.loops(), 2u);
+    EXPECT_FALSE(source.finished());
+}
+
+TEST_F(ReplaySourceTest, FramesOutliveStop) {
+    ReplaySource source(rawConfig(writeRaw(1)));
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    ASSERT_TRUE(source.read(frame));
+    source.stop();
+
+    EXPECT_EQ(frame.bytes()[0], 0);
+}
+
+TEST_F(ReplaySourceTest, RejectsMissingAndTooSmallFiles) {
+    ReplaySource missing(rawConfig((m_dir / "missing.nv12").string()));
+    EXPECT_FALSE(missing.start());
+
+    ReplaySource tiny(rawConfig(writeFile("tiny.nv12", std::vector<uint8_t>(10))));
+    EXPECT_FALSE(tiny.start());
+}
+
+// ============================================================================
+// MJPEG Replay Tests
+// ============================================================================
+
+TEST_F(ReplaySourceTest, SplitsMjpegOnMarkers) {
+    std::vector<uint8_t> bytes = {
+        0xFF, 0xD8, 0x01, 0x02, 0xFF, 0xD9,              // 6-byte image
+        0x00, 0x00,                                      // padding between images
+        0xFF, 0xD8, 0x03, 0xFF, 0x00, 0x04, 0xFF, 0xD9,  // 8 bytes, stuffed FF00
+        0xFF, 0xD8, 0x05                                 // truncated, never delivered
+    };
+    auto config = rawConfig(writeFile("clip.mjpeg", bytes));
+    config.format = PixelFormat::MJPEG;
+    ReplaySource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    ASSERT_TRUE(source.read(frame));
+    EXPECT_EQ(frame.size(), 6u);
+    EXPECT_TRUE(frame.isCompressed());
+
+    ASSERT_TRUE(source.read(frame));
+    EXPECT_EQ(frame.size(), 8u);
+    EXPECT_EQ(frame.bytes()[2], 0x03);
+
+    EXPECT_FALSE(source.read(frame));
+    EXPECT_TRUE(source.finished());
+}
+
+// ============================================================================
+// Pacing Tests
+// ============================================================================
+
+TEST_F(ReplaySourceTest, RealTimeFollowsRecordedTimestamps) {
+    auto config = rawConfig(writeRaw(3));
+    config.pacing = Pacing::RealTime;
+    config.timestamps_path = writeText("clip.ts", "# timecode format v2\n1000\n1020\n1060\n");
+    ReplaySource source(config);
+    ASSERT_TRUE(source.start());
+
+    auto begin = std::chrono::steady_clock::now();
+    Frame a, b, c;
+    ASSERT_TRUE(source.read(a));
+    ASSERT_TRUE(source.read(b));
+    ASSERT_TRUE(source.read(c));
+
+    EXPECT_EQ(b.timestamp() - a.timestamp(), 20ms);
+    EXPECT_EQ(c.timestamp() - b.timestamp(), 40ms);
+    EXPECT_GE(std::chrono::steady_clock::now() - begin, 59ms);
+}
+
+TEST_F(ReplaySourceTest, LoopedTimelineKeepsIncreasing) {
+    auto config = rawConfig(writeRaw(2));
+    config.pacing = Pacing::RealTime;
+    config.fps = 100;
+    config.loop = true;
+    ReplaySource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame previous, frame;
+    ASSERT_TRUE(source.read(previous));
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(source.read(frame));
+        EXPECT_EQ(frame.timestamp() - previous.timestamp(), 10ms);
+        previous = frame;
+    }
+}
+
+TEST_F(ReplaySourceTest, MaxSpeedIgnoresTimestamps) {
+    auto config = rawConfig(writeRaw(3));
+    config.timestamps_path = writeText("slow.ts", "0\n1000\n2000\n");
+    ReplaySource source(config);
+    ASSERT_TRUE(source.start());
+
+    auto begin = std::chrono::steady_clock::now();
+    Frame frame;
+    while (source.read(frame)) {
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 500ms);
+    EXPECT_EQ(source.framesRead(), 3u);
+}
+
+TEST_F(ReplaySourceTest, RejectsMalformedTimestamps) {
+    auto config = rawConfig(writeRaw(1));
+    config.timestamps_path = writeText("bad.ts", "0\nsoon\n");
+    ReplaySource source(config);
+    EXPECT_FALSE(source.start());
+}
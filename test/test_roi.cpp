@@ -0,0 +1,213 @@
+#include <gtest/gtest.h>
+#include "roi.hpp"
+#include "thread_pool.hpp"
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+Frame makeGrayFrame(uint32_t width, uint32_t height, uint8_t value)
+{
+    return Frame(std::vector<uint8_t>(static_cast<size_t>(width) * height, value), width, height, 1);
+}
+
+void paintBlock(Frame& frame, uint32_t col, uint32_t row, uint8_t value)
+{
+    for (uint32_t y = row * 16; y < (row + 1) * 16 && y < frame.height(); ++y) {
+        for (uint32_t x = col * 16; x < (col + 1) * 16 && x < frame.width(); ++x) {
+            frame.dataPtr()[y * frame.width() + x] = value;
+        }
+    }
+}
+
+} // namespace
+
+// ============================================================================
+// QualityMap Tests
+// ============================================================================
+
+TEST(QualityMapTest, GridCoversPartialBlocks) {
+    QualityMap map(100, 50);
+
+    EXPECT_EQ(map.cols(), 7u);  // 100 / 16 rounded up
+    EXPECT_EQ(map.rows(), 4u);
+    EXPECT_TRUE(map.isNeutral());
+}
+
+TEST(QualityMapTest, OffsetsAreClampedToQpRange) {
+    QualityMap map(32, 32);
+    map.set(0, 0, 200);
+    map.set(1, 0, -200);
+
+    EXPECT_EQ(map.at(0, 0), QualityMap::kMaxOffset);
+    EXPECT_EQ(map.at(1, 0), -QualityMap::kMaxOffset);
+}
+
+TEST(QualityMapTest, FillRectTouchesAllOverlappingBlocks) {
+    QualityMap map(64, 64);
+    map.fillRect({10, 10, 10, 10}, -5);  // straddles blocks (0,0),(1,0),(0,1),(1,1)
+
+    EXPECT_EQ(map.at(0, 0), -5);
+    EXPECT_EQ(map.at(1, 1), -5);
+    EXPECT_EQ(map.at(2, 0), 0);
+    EXPECT_EQ(map.at(0, 2), 0);
+}
+
+TEST(QualityMapTest, NeutralMapHasNoRegions) {
+    QualityMap map(64, 64);
+    EXPECT_TRUE(map.regions().empty());
+}
+
+TEST(QualityMapTest, RegionsMergeRowsAndColumns) {
+    QualityMap map(128, 128);
+    map.fillRect({16, 16, 48, 32}, -4);  // 3x2 blocks
+
+    auto regions = map.regions();
+    ASSERT_EQ(regions.size(), 1u);
+    EXPECT_EQ(regions[0].area.x, 16u);
+    EXPECT_EQ(regions[0].area.y, 16u);
+    EXPECT_EQ(regions[0].area.width, 48u);
+    EXPECT_EQ(regions[0].area.height, 32u);
+    EXPECT_EQ(regions[0].offset, -4);
+}
+
+TEST(QualityMapTest, RegionsAreClippedToFrame) {
+    QualityMap map(40, 20);
+    map.fill(3);
+
+    auto regions = map.regions();
+    ASSERT_EQ(regions.size(), 1u);
+    EXPECT_EQ(regions[0].area.width, 40u);
+    EXPECT_EQ(regions[0].area.height, 20u);
+}
+
+TEST(QualityMapTest, DifferentOffsetsStaySeparate) {
+    QualityMap map(64, 16);
+    map.set(0, 0, -2);
+    map.set(1, 0, -2);
+    map.set(2, 0, 5);
+
+    auto regions = map.regions();
+    ASSERT_EQ(regions.size(), 2u);
+
+    int covered = 0;
+    for (const auto& region : regions) {
+        covered += static_cast<int>(region.area.width / 16);
+    }
+    EXPECT_EQ(covered, 3);
+}
+
+// ============================================================================
+// MotionRoiDetector Tests
+// ============================================================================
+
+TEST(MotionRoiDetectorTest, FirstFrameIsNeutral) {
+    MotionRoiDetector detector;
+    EXPECT_TRUE(detector.update(makeGrayFrame(64, 48, 10)).isNeutral());
+}
+
+TEST(MotionRoiDetectorTest, MovingBlocksGetMotionOffset) {
+    MotionRoiConfig config;
+    MotionRoiDetector detector(config);
+    detector.update(makeGrayFrame(64, 48, 10));
+
+    Frame next = makeGrayFrame(64, 48, 10);
+    paintBlock(next, 2, 1, 200);
+    QualityMap map = detector.update(next);
+
+    EXPECT_EQ(map.at(2, 1), config.motion_offset);
+    EXPECT_EQ(map.at(0, 0), config.static_offset);
+    EXPECT_EQ(map.at(3, 2), config.static_offset);
+}
+
+TEST(MotionRoiDetectorTest, ComparesAgainstPreviousFrame) {
+    MotionRoiConfig config;
+    MotionRoiDetector detector(config);
+
+    Frame moved = makeGrayFrame(64, 48, 10);
+    paintBlock(moved, 0, 0, 200);
+    detector.update(makeGrayFrame(64, 48, 10));
+    detector.update(moved);
+
+    // Same content again: nothing moved since the previous frame
+    QualityMap map = detector.update(moved);
+    EXPECT_EQ(map.at(0, 0), config.static_offset);
+}
+
+TEST(MotionRoiDetectorTest, GeometryChangeResets) {
+    MotionRoiDetector detector;
+    detector.update(makeGrayFrame(64, 48, 10));
+
+    EXPECT_TRUE(detector.update(makeGrayFrame(32, 32, 200)).isNeutral());
+}
+
+TEST(MotionRoiDetectorTest, PoolMatchesSingleThread) {
+    MotionRoiConfig config;
+    config.row_step = 3; // last block row is short and samples fewer rows
+    ThreadPool pool({.workers = 3});
+    MotionRoiDetector serial(config);
+    MotionRoiDetector parallel(config, &pool);
+
+    Frame first = makeGrayFrame(64, 200, 10);
+    Frame second = makeGrayFrame(64, 200, 10);
+    for (uint32_t row = 0; row < 13; row += 2) {
+        paintBlock(second, row % 4, row, 200);
+    }
+    serial.update(first);
+    parallel.update(first);
+    QualityMap expected = serial.update(second);
+    QualityMap actual = parallel.update(second);
+
+    ASSERT_EQ(actual.rows(), 13u);
+    for (uint32_t row = 0; row < actual.rows(); ++row) {
+        for (uint32_t col = 0; col < actual.cols(); ++col) {
+            EXPECT_EQ(actual.at(col, row), expected.at(col, row)) << col << "," << row;
+        }
+    }
+}
+
+// ============================================================================
+// FixedZones Tests
+// ============================================================================
+
+TEST(FixedZonesTest, PrivacyZoneOverridesMotion) {
+    QualityMap map(64, 64);
+    map.fill(-6);
+
+    FixedZones zones;
+    zones.addPrivacyZone({0, 0, 32, 16});
+    zones.apply(map);
+
+    EXPECT_EQ(map.at(0, 0), FixedZones::kPrivacyOffset);
+    EXPECT_EQ(map.at(1, 0), FixedZones::kPrivacyOffset);
+    EXPECT_EQ(map.at(2, 0), -6);
+}
+
+TEST(FixedZonesTest, LaterZonesWin) {
+    QualityMap map(64, 64);
+
+    FixedZones zones;
+    zones.addZone({0, 0, 64, 64}, -3);
+    zones.addPrivacyZone({16, 16, 16, 16});
+    zones.apply(map);
+
+    EXPECT_EQ(map.at(0, 0), -3);
+    EXPECT_EQ(map.at(1, 1), FixedZones::kPrivacyOffset);
+}
+
+TEST(FixedZonesTest, ParsesRectLists) {
+    auto rects = parseRectList("320x240+0+0, 64x32+600+400");
+    ASSERT_TRUE(rects.has_value());
+    ASSERT_EQ(rects->size(), 2u);
+    EXPECT_EQ((*rects)[1].x, 600u);
+    EXPECT_EQ((*rects)[1].y, 400u);
+    EXPECT_EQ((*rects)[1].width, 64u);
+    EXPECT_EQ((*rects)[1].height, 32u);
+    EXPECT_TRUE(parseRectList("")->empty());
+
+    EXPECT_FALSE(parseRectList("320x240").has_value());
+    EXPECT_FALSE(parseRectList("0x240+0+0").has_value());
+    EXPECT_FALSE(parseRectList("320x240+0+0,,64x64+0+0").has_value());
+    EXPECT_FALSE(parseRectList("320x240+0+0x").has_value());
+}
@@ -0,0 +1,176 @@
+#include <gtest/gtest.h>
+#include "scene_filter.hpp"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <random>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+Frame makeGrayFrame(uint32_t width, uint32_t height, uint8_t value)
+{
+    return Frame(std::vector<uint8_t>(static_cast<size_t>(width) * height, value), width, height, 1);
+}
+
+} // namespace
+
+// ============================================================================
+// SAD Kernel Tests
+// ============================================================================
+
+TEST(SumAbsDiffTest, IdenticalBuffersAreZero) {
+    std::vector<uint8_t> a(1000, 77);
+    EXPECT_EQ(sum_abs_diff(a.data(), a.data(), a.size()), 0u);
+}
+
+TEST(SumAbsDiffTest, MatchesScalarReference) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 255);
+
+    // Odd length exercises both the vector loop and the scalar tail
+    std::vector<uint8_t> a(1237), b(1237);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = static_cast<uint8_t>(dist(rng));
+        b[i] = static_cast<uint8_t>(dist(rng));
+    }
+
+    uint64_t expected = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        expected += static_cast<uint64_t>(std::abs(int(a[i]) - int(b[i])));
+    }
+
+    EXPECT_EQ(sum_abs_diff(a.data(), b.data(), a.size()), expected);
+}
+
+TEST(SumAbsDiffTest, HandlesFullRangeDifferences) {
+    std::vector<uint8_t> black(4096, 0);
+    std::vector<uint8_t> white(4096, 255);
+    EXPECT_EQ(sum_abs_diff(black.data(), white.data(), black.size()), 4096u * 255u);
+}
+
+// ============================================================================
+// StaticSceneFilter Tests
+// ============================================================================
+
+TEST(StaticSceneFilterTest, FirstFrameIsEncoded) {
+    StaticSceneFilter filter;
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 10)), SceneDecision::Encode);
+    EXPECT_EQ(filter.encodedFrames(), 1u);
+}
+
+TEST(StaticSceneFilterTest, UnchangedFrameIsSkipped) {
+    StaticSceneFilter filter;
+    filter.evaluate(makeGrayFrame(64, 48, 10));
+
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 10)), SceneDecision::Skip);
+    EXPECT_EQ(filter.skippedFrames(), 1u);
+    EXPECT_DOUBLE_EQ(filter.lastScore(), 0.0);
+}
+
+TEST(StaticSceneFilterTest, ChangedFrameIsEncoded) {
+    StaticSceneFilter filter;
+    filter.evaluate(makeGrayFrame(64, 48, 10));
+
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 60)), SceneDecision::Encode);
+    EXPECT_DOUBLE_EQ(filter.lastScore(), 50.0);
+}
+
+TEST(StaticSceneFilterTest, RepeatModeRequestsRepeat) {
+    StaticSceneConfig config;
+    config.mode = SkipMode::Repeat;
+    StaticSceneFilter filter(config);
+    filter.evaluate(makeGrayFrame(64, 48, 10));
+
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 11)), SceneDecision::Repeat);
+}
+
+TEST(StaticSceneFilterTest, SlowDriftAccumulatesAgainstLastEncoded) {
+    StaticSceneConfig config;
+    config.threshold = 2.0;
+    StaticSceneFilter filter(config);
+    filter.evaluate(makeGrayFrame(64, 48, 100));
+
+    // Each step is below threshold, but the reference stays at 100
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 101)), SceneDecision::Skip);
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 102)), SceneDecision::Encode);
+}
+
+TEST(StaticSceneFilterTest, RefreshIntervalForcesEncode) {
+    StaticSceneConfig config;
+    config.refresh_interval = std::chrono::milliseconds(500);
+    StaticSceneFilter filter(config);
+
+    Frame first = makeGrayFrame(64, 48, 10);
+    filter.evaluate(first);
+
+    Frame second = makeGrayFrame(64, 48, 10);
+    second.setTimestamp(first.timestamp() + std::chrono::milliseconds(100));
+    EXPECT_EQ(filter.evaluate(second), SceneDecision::Skip);
+
+    Frame third = makeGrayFrame(64, 48, 10);
+    third.setTimestamp(first.timestamp() + std::chrono::milliseconds(600));
+    EXPECT_EQ(filter.evaluate(third), SceneDecision::Encode);
+}
+
+TEST(StaticSceneFilterTest, GeometryChangeForcesEncode) {
+    StaticSceneFilter filter;
+    filter.evaluate(makeGrayFrame(64, 48, 10));
+
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(32, 24, 10)), SceneDecision::Encode);
+}
+
+TEST(StaticSceneFilterTest, DisabledAlwaysEncodes) {
+    StaticSceneConfig config;
+    config.enabled = false;
+    StaticSceneFilter filter(config);
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 10)), SceneDecision::Encode);
+    }
+    EXPECT_EQ(filter.skippedFrames(), 0u);
+}
+
+TEST(StaticSceneFilterTest, SubsampledRowsIgnoreUnsampledChanges) {
+    StaticSceneConfig config;
+    config.row_step = 4;
+    StaticSceneFilter filter(config);
+    filter.evaluate(makeGrayFrame(64, 48, 10));
+
+    // Row 1 is never sampled with row_step 4
+    Frame changed = makeGrayFrame(64, 48, 10);
+    std::fill_n(changed.dataPtr() + 64, 64, 255);
+    EXPECT_EQ(filter.evaluate(changed), SceneDecision::Skip);
+}
+
+TEST(StaticSceneFilterTest, ResetForcesNextEncode) {
+    StaticSceneFilter filter;
+    filter.evaluate(makeGrayFrame(64, 48, 10));
+    filter.reset();
+
+    EXPECT_EQ(filter.evaluate(makeGrayFrame(64, 48, 10)), SceneDecision::Encode);
+}
+
+TEST(StaticSceneFilterTest, PlanarFramesCompareLuma) {
+    StaticSceneFilter filter;
+    Frame probe(std::vector<uint8_t>(), 64, 48, PixelFormat::I420);
+    std::vector<uint8_t> pixels(probe.expectedSize(), 128);
+    filter.evaluate(Frame(pixels, 64, 48, PixelFormat::I420));
+
+    std::vector<uint8_t> chroma = pixels;
+    std::fill(chroma.begin() + 64 * 48, chroma.end(), 200);
+    EXPECT_EQ(filter.evaluate(Frame(chroma, 64, 48, PixelFormat::I420)), SceneDecision::Skip);
+
+    std::vector<uint8_t> luma = pixels;
+    std::fill(luma.begin(), luma.begin() + 64 * 48, 160);
+    EXPECT_EQ(filter.evaluate(Frame(luma, 64, 48, PixelFormat::I420)), SceneDecision::Encode);
+}
+
+TEST(StaticSceneFilterTest, CompressedFramesAreAlwaysEncoded) {
+    StaticSceneFilter filter;
+    Frame jpeg(std::vector<uint8_t>{0xFF, 0xD8, 0xFF, 0xD9}, 64, 48, PixelFormat::MJPEG);
+    EXPECT_EQ(filter.evaluate(jpeg), SceneDecision::Encode);
+    EXPECT_EQ(filter.evaluate(jpeg), SceneDecision::Encode);
+}
@@ -243,6 +243,79 @@ TEST_F(SenderTest, SendSingleFrame) {
     sender.stop();
 }
 
+TEST_F(SenderTest, SendMovedFrame) {
+    Sender sender(TEST_IP, TEST_PORT);
+    ASSERT_TRUE(sender.start());
+    ASSERT_TRUE(m_server->waitForConnection());
+
+    std::vector<uint8_t> expected = {0xFF, 0xD8, 0xFF, 0xD9};
+    std::vector<uint8_t> test_frame = expected;
+    sender.enqueueFrame(std::move(test_frame));
+
+    auto received = m_server->receiveFrame(2000);
+    EXPECT_EQ(received, expected);
+
+    sender.stop();
+}
+
+TEST_F(SenderTest, BacklogDrainsOnceSent) {
+    Sender sender(TEST_IP, TEST_PORT);
+    EXPECT_EQ(sender.backlogBytes(), 0u);
+    ASSERT_TRUE(sender.start());
+    ASSERT_TRUE(m_server->waitForConnection());
+
+    sender.enqueueFrame(std::vector<uint8_t>(4096, 0x42));
+    auto received = m_server->receiveFrame(2000);
+    ASSERT_EQ(received.size(), 4096u);
+
+    // The kernel may still report the last segment as unacknowledged briefly
+    for (int i = 0; i < 100 && sender.backlogBytes() > 0; ++i) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(sender.backlogBytes(), 0u);
+
+    sender.stop();
+}
+
+TEST_F(SenderTest, MemoryBudgetBoundsQueue) {
+    pcs::MemoryBudget budget({.limit_bytes = 10000});
+    pcs::MemoryAccount& account = budget.account("sender-queue");
+    Sender sender(TEST_IP, TEST_PORT, &account);
+    ASSERT_TRUE(sender.start());
+    ASSERT_TRUE(m_server->waitForConnection());
+
+    EXPECT_FALSE(sender.enqueueFrame(std::vector<uint8_t>(20000, 0x01)));
+    EXPECT_EQ(account.refused(), 1u);
+    EXPECT_TRUE(sender.enqueueFrame(std::vector<uint8_t>(4096, 0x42)));
+    auto received = m_server->receiveFrame(2000);
+    ASSERT_EQ(received.size(), 4096u);
+
+    sender.stop();
+    EXPECT_EQ(account.peak(), 4096u);
+    EXPECT_EQ(budget.used(), 0u);
+}
+
+TEST_F(SenderTest, QueueCapDropsToNextKeyframe) {
+    pcs::MemoryBudget budget({.limit_bytes = 1 << 20});
+    pcs::MemoryAccount& account = budget.account("sender-queue");
+    Sender sender(TEST_IP, TEST_PORT, &account, 8192);
+    ASSERT_TRUE(sender.start());
+    ASSERT_TRUE(m_server->waitForConnection());
+
+    EXPECT_TRUE(sender.enqueueFrame(std::vector<uint8_t>(100, 0x01), true));
+    EXPECT_FALSE(sender.enqueueFrame(std::vector<uint8_t>(10000, 0x02), false)); // over the cap
+    EXPECT_FALSE(sender.enqueueFrame(std::vector<uint8_t>(100, 0x03), false));   // rest of the GOP
+    EXPECT_TRUE(sender.enqueueFrame(std::vector<uint8_t>(100, 0x04), true));     // next keyframe
+    EXPECT_TRUE(sender.enqueueFrame(std::vector<uint8_t>(100, 0x05), false));
+
+    EXPECT_EQ(m_server->receiveFrame(2000), std::vector<uint8_t>(100, 0x01));
+    EXPECT_EQ(m_server->receiveFrame(2000), std::vector<uint8_t>(100, 0x04));
+    EXPECT_EQ(m_server->receiveFrame(2000), std::vector<uint8_t>(100, 0x05));
+    EXPECT_EQ(account.refused(), 0u); // the cap refused it before the budget was asked
+
+    sender.stop();
+}
+
 TEST_F(SenderTest, SendMultipleFrames) {
     Sender sender(TEST_IP, TEST_PORT);
     ASSERT_TRUE(sender.start());
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "slo_controller.hpp"
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+// Everything comfortably inside the default targets
+LoadSample calm()
+{
+    return LoadSample{50000, 0.1, 0.2, 0};
+}
+
+LoadSample slow()
+{
+    LoadSample sample = calm();
+    sample.latencyP99Us = 400000;
+    return sample;
+}
+
+SloConfig quickConfig()
+{
+    SloConfig config;
+    config.degrade_after = 1;
+    config.recover_after = 3;
+    return config;
+}
+
+} // namespace
+
+// ============================================================================
+// Ladder Tests
+// ============================================================================
+
+TEST(SloControllerTest, LadderLowersBitrateThenFpsThenResolution) {
+    SloController controller(SloConfig{}, nullptr);
+    ASSERT_EQ(controller.maxStep(), 3u + 2u + 2u);
+
+    EXPECT_EQ(controller.levelAt(0), (QualityLevel{0, 1.0, 1.0, 1.0}));
+    EXPECT_EQ(controller.levelAt(3), (QualityLevel{3, 0.35, 1.0, 1.0}));
+    EXPECT_EQ(controller.levelAt(4), (QualityLevel{4, 0.35, 0.67, 1.0}));
+    EXPECT_EQ(controller.levelAt(6), (QualityLevel{6, 0.35, 0.5, 0.75}));
+    EXPECT_EQ(controller.levelAt(99), controller.levelAt(7));
+}
+
+TEST(SloControllerTest, CustomStepsShapeTheLadder) {
+    SloConfig config;
+    config.bitrate_steps = {1.0, 0.5};
+    config.fps_steps = {1.0};
+    config.resolution_steps = {};
+    SloController controller(config, nullptr);
+
+    EXPECT_EQ(controller.maxStep(), 1u);
+    EXPECT_EQ(controller.levelAt(1), (QualityLevel{1, 0.5, 1.0, 1.0}));
+}
+
+// ============================================================================
+// Control Tests
+// ============================================================================
+
+TEST(SloControllerTest, FpsStepsScaleTheCappedRate) {
+    QualityLevel level;
+    EXPECT_DOUBLE_EQ(scaledFpsCap(level, 30.0, 0.0), 0.0);   // full quality: no cap
+    EXPECT_DOUBLE_EQ(scaledFpsCap(level, 30.0, 15.0), 15.0);
+
+    level.fps_scale = 0.5;
+    EXPECT_DOUBLE_EQ(scaledFpsCap(level, 30.0, 0.0), 15.0);
+    EXPECT_DOUBLE_EQ(scaledFpsCap(level, 30.0, 15.0), 7.5); // below the cap, not clamped to it
+
+    level.fps_scale = 0.67;
+    EXPECT_LT(scaledFpsCap(level, 30.0, 15.0), 15.0);
+}
+
+TEST(SloControllerTest, StepsDownAfterSustainedOverload) {
+    std::vector<QualityLevel> applied;
+    SloController controller(SloConfig{}, [&](const QualityLevel& level) { applied.push_back(level); });
+
+    EXPECT_FALSE(controller.update(slow())); // one bad sample is not enough
+    EXPECT_TRUE(controller.update(slow()));
+    ASSERT_EQ(applied.size(), 1u);
+    EXPECT_EQ(applied[0].step, 1u);
+    EXPECT_DOUBLE_EQ(applied[0].bitrate_scale, 0.75);
+
+    // The counter starts over after a step, so the next one needs two more samples
+    EXPECT_FALSE(controller.update(slow()));
+    EXPECT_TRUE(controller.update(slow()));
+    EXPECT_EQ(controller.level().step, 2u);
+}
+
+TEST(SloControllerTest, StopsAtTheLastStep) {
+    SloController controller(quickConfig(), nullptr);
+    for (int i = 0; i < 20; ++i) {
+        controller.update(slow());
+    }
+    EXPECT_EQ(controller.level().step, controller.maxStep());
+    EXPECT_FALSE(controller.update(slow()));
+}
+
+TEST(SloControllerTest, NamesEveryCauseOverTarget) {
+    SloController controller(quickConfig(), nullptr);
+    LoadSample sample = slow();
+    sample.cpuLoad = 0.97;
+    sample.senderBacklogBytes = 4 * 1024 * 1024;
+    ASSERT_TRUE(controller.update(sample));
+
+    EXPECT_EQ(controller.lastCause(),
+              "latency p99 400.0 ms > 250.0 ms, cpu 97% > 90%, sender backlog 4096 KiB > 2048 KiB");
+}
+
+TEST(SloControllerTest, QueueFillAloneTriggersStepDown) {
+    SloController controller(quickConfig(), nullptr);
+    LoadSample sample = calm();
+    sample.queueFill = 1.0;
+    EXPECT_TRUE(controller.update(sample));
+    EXPECT_EQ(controller.lastCause(), "queues 100% > 75%");
+}
+
+TEST(SloControllerTest, RecoversOnlyWithSustainedHeadroom) {
+    std::vector<QualityLevel> applied;
+    SloController controller(quickConfig(), [&](const QualityLevel& level) { applied.push_back(level); });
+    controller.update(slow());
+    controller.update(slow());
+    ASSERT_EQ(controller.level().step, 2u);
+
+    controller.update(calm());
+    controller.update(calm());
+    EXPECT_EQ(controller.level().step, 2u); // not yet recover_after samples
+    EXPECT_TRUE(controller.update(calm()));
+    EXPECT_EQ(controller.level().step, 1u);
+    EXPECT_EQ(controller.lastCause().rfind("headroom for 3 samples", 0), 0u);
+
+    for (int i = 0; i < 3; ++i) {
+        controller.update(calm());
+    }
+    EXPECT_EQ(controller.level().step, 0u);
+    EXPECT_EQ(applied.size(), 4u);
+}
+
+TEST(SloControllerTest, HoldsBetweenHeadroomAndTarget) {
+    SloController controller(quickConfig(), nullptr);
+    controller.update(slow());
+    ASSERT_EQ(controller.level().step, 1u);
+
+    // Under the target but above 60% of it: neither step down nor up
+    LoadSample marginal = calm();
+    marginal.latencyP99Us = 200000;
+    for (int i = 0; i < 10; ++i) {
+        EXPECT_FALSE(controller.update(marginal));
+    }
+    EXPECT_EQ(controller.level().step, 1u);
+
+    // A marginal sample also restarts the count towards recovery
+    controller.update(calm());
+    controller.update(calm());
+    controller.update(marginal);
+    controller.update(calm());
+    controller.update(calm());
+    EXPECT_EQ(controller.level().step, 1u);
+    controller.update(calm());
+    EXPECT_EQ(controller.level().step, 0u);
+}
+
+TEST(SloControllerTest, AlternatingLoadDoesNotOscillate) {
+    int changes = 0;
+    SloConfig config;
+    config.degrade_after = 2;
+    config.recover_after = 3;
+    SloController controller(config, [&](const QualityLevel&) { ++changes; });
+
+    for (int i = 0; i < 40; ++i) {
+        controller.update(i % 2 == 0 ? slow() : calm());
+    }
+    EXPECT_EQ(changes, 0);
+}
+
+// ============================================================================
+// ProcessCpuMeter Tests
+// ============================================================================
+
+TEST(ProcessCpuMeterTest, SeesBusyThread) {
+    ProcessCpuMeter meter;
+    const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(100);
+    volatile uint64_t spin = 0;
+    while (std::chrono::steady_clock::now() < until) {
+        spin = spin + 1;
+    }
+    const double busy = meter.sample();
+
+    EXPECT_GT(busy, 0.5 / std::max(1u, std::thread::hardware_concurrency()));
+    EXPECT_LE(busy, 1.0);
+}
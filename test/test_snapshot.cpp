@@ -0,0 +1,203 @@
+#include <gtest/gtest.h>
+#include "snapshot.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+Frame grayFrame(uint8_t value, uint32_t width = 64, uint32_t height = 48)
+{
+    Frame frame(std::vector<uint8_t>(size_t{width} * height, value), width, height, PixelFormat::Gray8);
+    frame.setTimestampNow();
+    return frame;
+}
+
+// "JPEG" of the first pixel value and the size asked for
+struct FakeEncoder {
+    std::atomic<int> calls{0};
+    std::chrono::milliseconds delay{0};
+    bool fail{false};
+
+    std::optional<std::vector<uint8_t>> operator()(const Frame& frame, uint32_t width, uint32_t height)
+    {
+        calls++;
+        std::this_thread::sleep_for(delay);
+        if (fail) {
+            return std::nullopt;
+        }
+        return std::vector<uint8_t>{frame.bytes()[0], static_cast<uint8_t>(width), static_cast<uint8_t>(height)};
+    }
+};
+
+} // namespace
+
+// ============================================================================
+// Encode On Demand Tests
+// ============================================================================
+
+TEST(SnapshotTest, NothingBeforeFirstFrame) {
+    FakeEncoder encoder;
+    SnapshotService service(std::ref(encoder));
+    EXPECT_FALSE(service.take().has_value());
+    EXPECT_EQ(encoder.calls, 0);
+}
+
+TEST(SnapshotTest, PublishingAloneNeverEncodes) {
+    FakeEncoder encoder;
+    SnapshotService service(std::ref(encoder));
+    for (int i = 0; i < 100; ++i) {
+        service.publish(grayFrame(static_cast<uint8_t>(i)));
+    }
+    EXPECT_EQ(encoder.calls, 0);
+    EXPECT_EQ(service.stats().published, 100u);
+
+    auto snapshot = service.take();
+    ASSERT_TRUE(snapshot.has_value());
+    EXPECT_EQ(snapshot->jpeg->front(), 99); // the latest frame
+    EXPECT_EQ(snapshot->sequence, 100u);
+    EXPECT_EQ(encoder.calls, 1);
+}
+
+TEST(SnapshotTest, CachedUntilNewerFrame) {
+    FakeEncoder encoder;
+    SnapshotService service(std::ref(encoder));
+    service.publish(grayFrame(1));
+
+    auto first = service.take();
+    auto second = service.take();
+    ASSERT_TRUE(first && second);
+    EXPECT_EQ(first->jpeg, second->jpeg); // the same bytes, not a copy
+    EXPECT_EQ(encoder.calls, 1);
+    EXPECT_EQ(service.stats().cacheHits, 1u);
+
+    service.publish(grayFrame(2));
+    auto third = service.take();
+    ASSERT_TRUE(third);
+    EXPECT_EQ(third->jpeg->front(), 2);
+    EXPECT_EQ(encoder.calls, 2);
+}
+
+TEST(SnapshotTest, EachSizeIsCachedSeparately) {
+    FakeEncoder encoder;
+    SnapshotService service(std::ref(encoder));
+    service.publish(grayFrame(7, 640, 480));
+
+    auto full = service.take();
+    auto thumb = service.take(160);
+    auto thumbAgain = service.take(160, 120);
+    ASSERT_TRUE(full && thumb && thumbAgain);
+    EXPECT_EQ(full->width, 640u);
+    EXPECT_EQ(thumb->width, 160u);
+    EXPECT_EQ(thumb->height, 120u); // aspect ratio kept
+    EXPECT_EQ(thumb->jpeg, thumbAgain->jpeg);
+    EXPECT_EQ(encoder.calls, 2);
+}
+
+TEST(SnapshotTest, NeverUpscalesAndRoundsToEven) {
+    FakeEncoder encoder;
+    SnapshotService service(std::ref(encoder));
+    service.publish(grayFrame(7, 640, 480));
+
+    auto large = service.take(1920, 1080);
+    ASSERT_TRUE(large);
+    EXPECT_EQ(large->width, 640u);
+    EXPECT_EQ(large->height, 480u);
+
+    auto odd = service.take(101, 75);
+    ASSERT_TRUE(odd);
+    EXPECT_EQ(odd->width, 100u);
+    EXPECT_EQ(odd->height, 74u);
+}
+
+TEST(SnapshotTest, CameraJpegAtNativeSizeIsNotEncoded) {
+    FakeEncoder encoder;
+    SnapshotService service(std::ref(encoder));
+    const std::vector<uint8_t> jpeg = {0xFF, 0xD8, 0xFF, 0xE0, 0x55, 0x55, 0xFF, 0xD9};
+    std::vector<uint8_t> padded = jpeg;
+    padded.resize(jpeg.size() + 16, 0x00);
+    service.publish(Frame(padded, 64, 48, PixelFormat::MJPEG));
+
+    auto native = service.take();
+    ASSERT_TRUE(native);
+    EXPECT_EQ(*native->jpeg, jpeg);
+    EXPECT_EQ(encoder.calls, 0);
+    EXPECT_EQ(service.stats().passthrough, 1u);
+
+    // Other sizes go through the encoder
+    EXPECT_TRUE(service.take(32));
+    EXPECT_EQ(encoder.calls, 1);
+}
+
+TEST(SnapshotTest, FailedEncodeIsRetried) {
+    FakeEncoder encoder;
+    encoder.fail = true;
+    SnapshotService service(std::ref(encoder));
+    service.publish(grayFrame(1));
+
+    EXPECT_FALSE(service.take().has_value());
+    encoder.fail = false;
+    EXPECT_TRUE(service.take().has_value());
+    EXPECT_EQ(encoder.calls, 2);
+    EXPECT_EQ(service.stats().failed, 1u);
+}
+
+// ============================================================================
+// Concurrency Tests
+// ============================================================================
+
+TEST(SnapshotTest, ConcurrentRequestsShareOneEncode) {
+    FakeEncoder encoder;
+    encoder.delay = std::chrono::milliseconds(50);
+    SnapshotService service(std::ref(encoder));
+    service.publish(grayFrame(3));
+
+    std::vector<std::thread> clients;
+    std::atomic<int> answered{0};
+    for (int i = 0; i < 8; ++i) {
+        clients.emplace_back([&] {
+            auto snapshot = service.take();
+            answered += snapshot && snapshot->jpeg->front() == 3;
+        });
+    }
+    for (auto& client : clients) {
+        client.join();
+    }
+
+    EXPECT_EQ(answered, 8);
+    EXPECT_EQ(encoder.calls, 1);
+    auto stats = service.stats();
+    EXPECT_EQ(stats.cacheHits + stats.coalesced, 7u);
+}
+
+TEST(SnapshotTest, PublishDoesNotWaitForEncode) {
+    std::atomic<bool> published{false};
+    SnapshotService service([&](const Frame& frame, uint32_t, uint32_t) -> std::optional<std::vector<uint8_t>> {
+        // Hold the encode until capture has moved on (bounded, so a
+        // regression fails instead of hanging)
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while (!published && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return std::vector<uint8_t>{frame.bytes()[0]};
+    });
+    service.publish(grayFrame(1));
+
+    std::thread client([&] {
+        auto snapshot = service.take();
+        EXPECT_TRUE(snapshot && snapshot->jpeg->front() == 1); // the frame it started on
+    });
+    while (service.stats().encodes == 0) {
+        std::this_thread::yield();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 2; i < 50; ++i) {
+        service.publish(grayFrame(static_cast<uint8_t>(i)));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+    published = true;
+    client.join();
+}
@@ -0,0 +1,234 @@
+#include <gtest/gtest.h>
+#include "async_queue.hpp"
+#include "stage_scheduler.hpp"
+#include <atomic>
+#include <chrono>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace pcs;
+
+namespace {
+
+constexpr auto kTimeout = std::chrono::seconds(5);
+
+Stage count(Scheduler& scheduler, std::atomic<int>& counter)
+{
+    co_await scheduler.yield();
+    counter.fetch_add(1);
+}
+
+Stage produce(AsyncQueue<int>& out, int first, int n)
+{
+    for (int i = first; i < first + n; ++i) {
+        if (!co_await out.push(i)) {
+            co_return;
+        }
+    }
+    out.close();
+}
+
+Stage consume(AsyncQueue<int>& in, std::vector<int>& received)
+{
+    while (auto item = co_await in.pop()) {
+        received.push_back(*item);
+    }
+}
+
+Stage pushOnce(AsyncQueue<int>& out, int value, int& result)
+{
+    result = (co_await out.push(value)) ? 1 : 0;
+}
+
+Stage readOnce(Scheduler& scheduler, int fd, std::atomic<char>& received)
+{
+    if (co_await scheduler.readable(fd)) {
+        char c = 0;
+        if (::read(fd, &c, 1) == 1) {
+            received = c;
+        }
+    }
+}
+
+// Sets a flag when destroyed, to see what stop() tears down
+struct Sentinel {
+    std::atomic<bool>& destroyed;
+    ~Sentinel() { destroyed = true; }
+};
+
+Stage waitForever(AsyncQueue<int>& in, std::atomic<bool>& destroyed)
+{
+    Sentinel sentinel{destroyed};
+    co_await in.pop();
+    ADD_FAILURE() << "resumed after stop";
+}
+
+Stage waitForSocket(Scheduler& scheduler, int fd, std::atomic<bool>& destroyed)
+{
+    Sentinel sentinel{destroyed};
+    co_await scheduler.readable(fd);
+}
+
+} // namespace
+
+// ============================================================================
+// Scheduler Tests
+// ============================================================================
+
+TEST(StageSchedulerTest, RunsManyStagesOnFewThreads) {
+    Scheduler scheduler({.threads = 2});
+    std::atomic<int> counter{0};
+    for (int i = 0; i < 200; ++i) {
+        ASSERT_TRUE(scheduler.spawn(count(scheduler, counter)));
+    }
+
+    ASSERT_TRUE(scheduler.wait(kTimeout));
+    EXPECT_EQ(counter.load(), 200);
+    EXPECT_EQ(scheduler.activeStages(), 0u);
+    EXPECT_EQ(scheduler.threads(), 2u);
+}
+
+TEST(StageSchedulerTest, NamesWorkers) {
+    Scheduler scheduler({.threads = 2});
+    ASSERT_EQ(scheduler.threadReports().size(), 2u);
+    EXPECT_EQ(scheduler.threadReports()[1].name, "pcs-stage1");
+}
+
+TEST(StageSchedulerTest, SpawnAfterStopIsRefused) {
+    Scheduler scheduler({.threads = 1});
+    std::atomic<int> counter{0};
+    scheduler.stop();
+
+    EXPECT_FALSE(scheduler.spawn(count(scheduler, counter)));
+    EXPECT_EQ(counter.load(), 0);
+}
+
+TEST(StageSchedulerTest, AwaitsSocketReadiness) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Scheduler scheduler({.threads = 1});
+    std::atomic<char> received{0};
+
+    scheduler.spawn(readOnce(scheduler, fds[0], received));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(scheduler.activeStages(), 1u); // parked in epoll, not holding the thread
+
+    ASSERT_EQ(::write(fds[1], "x", 1), 1);
+    ASSERT_TRUE(scheduler.wait(kTimeout));
+    EXPECT_EQ(received.load(), 'x');
+
+    scheduler.stop();
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+TEST(StageSchedulerTest, StopAbandonsSuspendedStages) {
+    int fds[2];
+    ASSERT_EQ(socketpair(AF_UNIX, SOCK_STREAM, 0, fds), 0);
+    Scheduler scheduler({.threads = 1});
+    AsyncQueue<int> queue(scheduler, 1);
+    std::atomic<bool> queueStage{false};
+    std::atomic<bool> socketStage{false};
+
+    scheduler.spawn(waitForever(queue, queueStage));
+    scheduler.spawn(waitForSocket(scheduler, fds[0], socketStage));
+    EXPECT_FALSE(scheduler.wait(std::chrono::milliseconds(50)));
+
+    scheduler.stop();
+    EXPECT_TRUE(queueStage.load());
+    EXPECT_TRUE(socketStage.load());
+    EXPECT_EQ(scheduler.activeStages(), 0u);
+
+    // The abandoned popper no longer takes items
+    int item = 7;
+    EXPECT_TRUE(queue.tryPush(item));
+    EXPECT_EQ(queue.size(), 1u);
+
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+// ============================================================================
+// AsyncQueue Tests
+// ============================================================================
+
+TEST(AsyncQueueTest, ProducerAndConsumerShareOneThread) {
+    Scheduler scheduler({.threads = 1});
+    AsyncQueue<int> queue(scheduler, 2);
+    std::vector<int> received;
+
+    scheduler.spawn(consume(queue, received));
+    scheduler.spawn(produce(queue, 0, 1000));
+    ASSERT_TRUE(scheduler.wait(kTimeout));
+
+    ASSERT_EQ(received.size(), 1000u);
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(received[i], i);
+    }
+}
+
+TEST(AsyncQueueTest, ManyPipelinesOverTwoThreads) {
+    Scheduler scheduler({.threads = 2});
+    constexpr int kPipelines = 16;
+    std::vector<std::unique_ptr<AsyncQueue<int>>> queues;
+    std::vector<std::vector<int>> received(kPipelines);
+    for (int p = 0; p < kPipelines; ++p) {
+        queues.push_back(std::make_unique<AsyncQueue<int>>(scheduler, 4));
+        scheduler.spawn(consume(*queues[p], received[p]));
+        scheduler.spawn(produce(*queues[p], p * 1000, 200));
+    }
+    ASSERT_TRUE(scheduler.wait(kTimeout));
+
+    for (int p = 0; p < kPipelines; ++p) {
+        ASSERT_EQ(received[p].size(), 200u);
+        EXPECT_EQ(received[p].front(), p * 1000);
+        EXPECT_EQ(received[p].back(), p * 1000 + 199);
+    }
+}
+
+TEST(AsyncQueueTest, TryPushFromPlainThreadWakesStage) {
+    Scheduler scheduler({.threads = 1});
+    AsyncQueue<int> queue(scheduler, 1);
+    std::vector<int> received;
+    scheduler.spawn(consume(queue, received));
+
+    // A capture-style thread that never waits
+    std::thread capture([&] {
+        for (int i = 0; i < 50; ++i) {
+            int item = i;
+            while (!queue.tryPush(item)) {
+                std::this_thread::yield();
+            }
+        }
+        queue.close();
+    });
+    capture.join();
+    ASSERT_TRUE(scheduler.wait(kTimeout));
+
+    ASSERT_EQ(received.size(), 50u);
+    EXPECT_EQ(received.back(), 49);
+}
+
+TEST(AsyncQueueTest, CloseWakesWaiters) {
+    Scheduler scheduler({.threads = 1});
+    AsyncQueue<int> empty(scheduler, 1);
+    AsyncQueue<int> full(scheduler, 1);
+    int filler = 0;
+    ASSERT_TRUE(full.tryPush(filler));
+
+    std::vector<int> received;
+    int pushed = -1;
+    scheduler.spawn(consume(empty, received));
+    scheduler.spawn(pushOnce(full, 1, pushed));
+    EXPECT_FALSE(scheduler.wait(std::chrono::milliseconds(20)));
+
+    empty.close();
+    full.close();
+    ASSERT_TRUE(scheduler.wait(kTimeout));
+    EXPECT_TRUE(received.empty());
+    EXPECT_EQ(pushed, 0);
+    EXPECT_EQ(full.tryPop(), 0); // queued items survive close
+    EXPECT_FALSE(full.tryPop().has_value());
+}
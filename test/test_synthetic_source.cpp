@@ -0,0 +1,197 @@
+#include <gtest/gtest.h>
+#include "synthetic_source.hpp"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+using namespace std::chrono_literals;
+
+namespace {
+
+SyntheticConfig fastConfig(PixelFormat format, TestPattern pattern = TestPattern::ColorBars)
+{
+    SyntheticConfig config;
+    config.width = 64;
+    config.height = 48;
+    config.format = format;
+    config.pattern = pattern;
+    config.pacing = Pacing::MaxSpeed;
+    return config;
+}
+
+} // namespace
+
+// ============================================================================
+// Format Tests
+// ============================================================================
+
+TEST(SyntheticSourceTest, ProducesValidFramesInEveryRawFormat) {
+    for (auto format : {PixelFormat::Gray8, PixelFormat::BGR24, PixelFormat::BGRA,
+                        PixelFormat::YUYV, PixelFormat::NV12, PixelFormat::I420}) {
+        for (auto pattern : {TestPattern::ColorBars, TestPattern::Gradient,
+                             TestPattern::Noise, TestPattern::Timestamp}) {
+            SyntheticSource source(fastConfig(format, pattern));
+            ASSERT_TRUE(source.start());
+
+            Frame frame;
+            ASSERT_TRUE(source.read(frame)) << pixelFormatName(format);
+            EXPECT_TRUE(frame.isValid()) << pixelFormatName(format);
+            EXPECT_EQ(frame.format(), format);
+            EXPECT_TRUE(frame.isExternal());
+        }
+    }
+}
+
+TEST(SyntheticSourceTest, OddDimensionsStayInBounds) {
+    SyntheticConfig config = fastConfig(PixelFormat::NV12, TestPattern::Timestamp);
+    config.width = 33;
+    config.height = 17;
+    SyntheticSource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    ASSERT_TRUE(source.read(frame));
+    EXPECT_EQ(frame.size(), 33u * 17u + 2u * 17u * 9u);
+}
+
+TEST(SyntheticSourceTest, RejectsMjpeg) {
+    SyntheticSource source(fastConfig(PixelFormat::MJPEG));
+    EXPECT_FALSE(source.start());
+
+    Frame frame;
+    EXPECT_FALSE(source.read(frame));
+}
+
+TEST(SyntheticSourceTest, ReportsCaptureFormat) {
+    SyntheticSource source(fastConfig(PixelFormat::YUYV, TestPattern::Noise));
+    auto format = source.captureFormat();
+
+    EXPECT_EQ(format.width, 64u);
+    EXPECT_EQ(format.height, 48u);
+    EXPECT_EQ(format.pixel_format, PixelFormat::YUYV);
+    EXPECT_EQ(source.name(), "synthetic:noise");
+}
+
+// ============================================================================
+// Content Tests
+// ============================================================================
+
+TEST(SyntheticSourceTest, BarsScrollBetweenFrames) {
+    SyntheticSource source(fastConfig(PixelFormat::Gray8));
+    ASSERT_TRUE(source.start());
+
+    Frame first, second;
+    ASSERT_TRUE(source.read(first));
+    std::vector<uint8_t> firstBytes(first.bytes().begin(), first.bytes().end());
+    ASSERT_TRUE(source.read(second));
+
+    EXPECT_NE(firstBytes, std::vector<uint8_t>(second.bytes().begin(), second.bytes().end()));
+}
+
+TEST(SyntheticSourceTest, NoiseIsReproducibleForSeed) {
+    SyntheticSource a(fastConfig(PixelFormat::Gray8, TestPattern::Noise));
+    SyntheticSource b(fastConfig(PixelFormat::Gray8, TestPattern::Noise));
+    ASSERT_TRUE(a.start());
+    ASSERT_TRUE(b.start());
+
+    Frame fa, fb;
+    ASSERT_TRUE(a.read(fa));
+    ASSERT_TRUE(b.read(fb));
+    EXPECT_TRUE(std::equal(fa.bytes().begin(), fa.bytes().end(), fb.bytes().begin()));
+}
+
+// ============================================================================
+// Pooling and Pacing Tests
+// ============================================================================
+
+TEST(SyntheticSourceTest, FramesComeFromPool) {
+    SyntheticConfig config = fastConfig(PixelFormat::NV12);
+    config.pool_size = 2;
+    SyntheticSource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame a, b, c;
+    ASSERT_TRUE(source.read(a));
+    ASSERT_TRUE(source.read(b));
+    EXPECT_FALSE(source.read(c));  // both buffers held
+    EXPECT_EQ(source.framesDropped(), 1u);
+
+    const uint8_t* reused = a.bytes().data();
+    a = Frame();
+    ASSERT_TRUE(source.read(c));
+    EXPECT_EQ(c.bytes().data(), reused);
+}
+
+TEST(SyntheticSourceTest, RealTimePacingHoldsFrameRate) {
+    SyntheticConfig config = fastConfig(PixelFormat::Gray8);
+    config.pacing = Pacing::RealTime;
+    config.fps = 100;
+    SyntheticSource source(config);
+    ASSERT_TRUE(source.start());
+
+    auto begin = std::chrono::steady_clock::now();
+    Frame frame;
+    for (int i = 0; i < 6; ++i) {
+        ASSERT_TRUE(source.read(frame));
+    }
+    auto elapsed = std::chrono::steady_clock::now() - begin;
+
+    // Frame 0 is due immediately, frame 5 at 50 ms
+    EXPECT_GE(elapsed, 49ms);
+    EXPECT_LT(elapsed, 500ms);
+}
+
+TEST(SyntheticSourceTest, RealTimeStampsAreEvenlySpaced) {
+    SyntheticConfig config = fastConfig(PixelFormat::Gray8);
+    config.pacing = Pacing::RealTime;
+    config.fps = 200;
+    SyntheticSource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame a, b;
+    ASSERT_TRUE(source.read(a));
+    ASSERT_TRUE(source.read(b));
+    EXPECT_EQ(b.timestamp() - a.timestamp(), 5ms);
+}
+
+TEST(SyntheticSourceTest, LateReaderSkipsFrames) {
+    SyntheticConfig config = fastConfig(PixelFormat::Gray8);
+    config.pacing = Pacing::RealTime;
+    config.fps = 100;
+    SyntheticSource source(config);
+    ASSERT_TRUE(source.start());
+
+    Frame frame;
+    ASSERT_TRUE(source.read(frame));
+    std::this_thread::sleep_for(55ms);
+    ASSERT_TRUE(source.read(frame));
+
+    EXPECT_GE(source.framesDropped(), 3u);
+    EXPECT_EQ(source.framesProduced(), 2u);
+}
+
+TEST(SyntheticSourceTest, MaxSpeedDoesNotSleep) {
+    SyntheticConfig config = fastConfig(PixelFormat::Gray8);
+    config.fps = 1;
+    SyntheticSource source(config);
+    ASSERT_TRUE(source.start());
+
+    auto begin = std::chrono::steady_clock::now();
+    Frame frame;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(source.read(frame));
+    }
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, 500ms);
+}
+
+TEST(SyntheticSourceTest, UsableThroughInterface) {
+    std::unique_ptr<CaptureSource> source =
+        std::make_unique<SyntheticSource>(fastConfig(PixelFormat::I420, TestPattern::Gradient));
+    ASSERT_TRUE(source->start());
+
+    Frame frame;
+    EXPECT_TRUE(source->read(frame));
+    source->stop();
+    EXPECT_FALSE(source->read(frame));
+}
@@ -0,0 +1,122 @@
+#include <gtest/gtest.h>
+#include "thread_config.hpp"
+#include <chrono>
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+
+using namespace pcs;
+
+namespace {
+
+// Run `fn` on a fresh thread so settings don't leak into the test runner
+template <typename Fn>
+void on_thread(Fn&& fn)
+{
+    std::thread(std::forward<Fn>(fn)).join();
+}
+
+} // namespace
+
+// ============================================================================
+// CPU List Tests
+// ============================================================================
+
+TEST(ThreadConfigTest, ParsesCpuLists) {
+    EXPECT_EQ(parseCpuList("0"), std::vector<int>({0}));
+    EXPECT_EQ(parseCpuList("2-3,0"), std::vector<int>({0, 2, 3}));
+    EXPECT_EQ(parseCpuList("1,1-2"), std::vector<int>({1, 2}));
+    EXPECT_EQ(parseCpuList(""), std::vector<int>());
+}
+
+TEST(ThreadConfigTest, RejectsMalformedCpuLists) {
+    EXPECT_FALSE(parseCpuList("a").has_value());
+    EXPECT_FALSE(parseCpuList("3-1").has_value());
+    EXPECT_FALSE(parseCpuList("1-").has_value());
+    EXPECT_FALSE(parseCpuList(",1").has_value());
+    EXPECT_FALSE(parseCpuList("-1").has_value());
+    EXPECT_FALSE(parseCpuList("1x").has_value());
+}
+
+TEST(ThreadConfigTest, FormatsCpuRanges) {
+    EXPECT_EQ(formatCpuList({0, 2, 3, 4, 7}), "0,2-4,7");
+    EXPECT_EQ(formatCpuList({}), "");
+}
+
+// ============================================================================
+// Apply Tests
+// ============================================================================
+
+TEST(ThreadConfigTest, NamesThread) {
+    on_thread([] {
+        ThreadReport report = applyThreadConfig({.name = "pcs-a-very-long-thread-name"});
+        char name[16] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+
+        EXPECT_STREQ(name, "pcs-a-very-long");
+        EXPECT_TRUE(report.ok());
+    });
+}
+
+TEST(ThreadConfigTest, PinsToCpu) {
+    on_thread([] {
+        ThreadReport report = applyThreadConfig({.name = "pin", .cpus = {0}});
+
+        EXPECT_TRUE(report.ok());
+        EXPECT_EQ(report.cpus, std::vector<int>({0}));
+        EXPECT_EQ(sched_getcpu(), 0);
+    });
+}
+
+TEST(ThreadConfigTest, ReportsRefusedAffinity) {
+    on_thread([] {
+        // No machine this runs on has CPU 1000
+        ThreadReport report = applyThreadConfig({.name = "nowhere", .cpus = {1000}});
+
+        EXPECT_FALSE(report.ok());
+        EXPECT_TRUE(report.cpus.empty());
+        EXPECT_NE(describeThreadReport(report).find("refused"), std::string::npos);
+    });
+}
+
+TEST(ThreadConfigTest, RealtimeAppliesOrFallsBack) {
+    on_thread([] {
+        ThreadReport report = applyThreadConfig(
+            {.name = "rt", .policy = SchedPolicy::Fifo, .priority = 10, .prefault_stack = 64 * 1024});
+
+        int policy = 0;
+        sched_param param{};
+        pthread_getschedparam(pthread_self(), &policy, &param);
+        if (report.policy == SchedPolicy::Fifo) {
+            EXPECT_EQ(policy, SCHED_FIFO);
+            EXPECT_EQ(param.sched_priority, report.priority);
+        } else {
+            // Unprivileged: keeps running under the default policy and says why
+            EXPECT_EQ(policy, SCHED_OTHER);
+            EXPECT_FALSE(report.ok());
+        }
+    });
+}
+
+TEST(ThreadConfigTest, DescribesReport) {
+    ThreadReport report;
+    report.name = "capture";
+    report.cpus = {1};
+    report.policy = SchedPolicy::Fifo;
+    report.priority = 50;
+    EXPECT_EQ(describeThreadReport(report), "capture: CPUs 1, SCHED_FIFO 50");
+
+    report = ThreadReport{};
+    report.name = "encode";
+    report.problems.push_back("SCHED_RR 40 refused: Operation not permitted");
+    EXPECT_EQ(describeThreadReport(report),
+              "encode: any CPU, SCHED_OTHER (SCHED_RR 40 refused: Operation not permitted)");
+}
+
+TEST(ThreadConfigTest, ProcessStartTimePrecedesNow) {
+    const auto started = processStartTime();
+    const auto now = std::chrono::steady_clock::now();
+    EXPECT_LE(started, now);
+    EXPECT_LT(now - started, std::chrono::hours(24 * 365)); // a real time, not the clock's epoch
+    EXPECT_EQ(processStartTime(), started);                 // read once
+}
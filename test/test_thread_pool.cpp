@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include "thread_pool.hpp"
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace pcs;
+
+// ============================================================================
+// Construction Tests
+// ============================================================================
+
+TEST(ThreadPoolTest, SizedToCoreCount) {
+    ThreadPool pool;
+    EXPECT_EQ(pool.size(), std::max(1u, std::thread::hardware_concurrency()));
+}
+
+TEST(ThreadPoolTest, NamesAndPinsWorkers) {
+    ThreadPoolConfig config;
+    config.workers = 2;
+    config.worker_thread.cpus = {0};
+    ThreadPool pool(config);
+
+    const auto& reports = pool.threadReports();
+    ASSERT_EQ(reports.size(), 2u);
+    EXPECT_EQ(reports[0].name, "pcs-pool0");
+    EXPECT_EQ(reports[1].name, "pcs-pool1");
+    for (const auto& report : reports) {
+        EXPECT_EQ(report.cpus, std::vector<int>({0}));
+    }
+}
+
+// ============================================================================
+// Task Tests
+// ============================================================================
+
+TEST(ThreadPoolTest, DestructorRunsQueuedTasks) {
+    std::atomic<int> count{0};
+    {
+        ThreadPool pool({.workers = 2});
+        for (int i = 0; i < 100; ++i) {
+            pool.submit([&] { count.fetch_add(1); });
+        }
+    }
+    EXPECT_EQ(count.load(), 100);
+}
+
+TEST(ThreadPoolTest, CriticalRunsBeforeBackground) {
+    std::mutex mtx;
+    std::vector<TaskPriority> order;
+    auto record = [&](TaskPriority priority) {
+        return [&, priority] {
+            std::lock_guard<std::mutex> lock(mtx);
+            order.push_back(priority);
+        };
+    };
+
+    {
+        ThreadPool pool({.workers = 1});
+        std::promise<void> release;
+        std::shared_future<void> released = release.get_future().share();
+        std::promise<void> blocked;
+        pool.submit([&] {
+            blocked.set_value();
+            released.wait();
+        });
+        blocked.get_future().wait();
+
+        // Queued behind the busy worker, lower priority first
+        for (int i = 0; i < 3; ++i) {
+            pool.submit(record(TaskPriority::Background), TaskPriority::Background);
+        }
+        for (int i = 0; i < 3; ++i) {
+            pool.submit(record(TaskPriority::Critical), TaskPriority::Critical);
+        }
+        release.set_value();
+    } // the destructor runs everything queued
+
+    ASSERT_EQ(order.size(), 6u);
+    for (size_t i = 0; i < 3; ++i) {
+        EXPECT_EQ(order[i], TaskPriority::Critical) << i;
+    }
+}
+
+TEST(ThreadPoolTest, CriticalCallerHelpsOnlyWithCriticalWork) {
+    const auto caller = std::this_thread::get_id();
+    std::thread::id analyticsThread;
+    {
+        ThreadPool pool({.workers = 1});
+        pool.parallelFor(0, 4, 1, [&](size_t begin, size_t) {
+            if (begin == 0) {
+                // Queued while the caller still has bands to wait for
+                pool.submit([&] { analyticsThread = std::this_thread::get_id(); }, TaskPriority::Background);
+            } else if (std::this_thread::get_id() != caller) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            }
+        });
+    } // the destructor runs the analytics task if nobody has yet
+
+    EXPECT_NE(analyticsThread, caller);
+}
+
+TEST(ThreadPoolTest, IdleWorkersSteal) {
+    ThreadPool pool({.workers = 2});
+    std::atomic<int> count{0};
+    std::promise<void> queued;
+
+    // Everything lands in one worker's deque while that worker is busy
+    pool.submit([&] {
+        for (int i = 0; i < 20; ++i) {
+            pool.submit([&] {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                count.fetch_add(1);
+            });
+        }
+        queued.set_value();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    });
+    queued.get_future().wait();
+    while (count.load() < 20) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    uint64_t stolen = 0;
+    for (const auto& stats : pool.stats()) {
+        stolen += stats.stolen;
+    }
+    EXPECT_GT(stolen, 0u);
+}
+
+TEST(ThreadPoolTest, CountsUtilisation) {
+    ThreadPool pool({.workers = 2});
+    for (int i = 0; i < 4; ++i) {
+        pool.submit([] { std::this_thread::sleep_for(std::chrono::milliseconds(10)); });
+    }
+    pool.parallelFor(0, 2, 1, [](size_t, size_t) {}); // helping drains what is left
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    uint64_t tasks = 0;
+    for (const auto& stats : pool.stats()) {
+        tasks += stats.tasks;
+        EXPECT_GE(stats.utilisation, 0.0);
+        EXPECT_LE(stats.utilisation, 1.0);
+        if (stats.tasks > 0) {
+            EXPECT_GT(stats.busy.count(), 0);
+        }
+    }
+    EXPECT_GE(tasks, 1u);
+    EXPECT_LE(tasks, 5u);
+}
+
+// ============================================================================
+// parallelFor Tests
+// ============================================================================
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+    ThreadPool pool({.workers = 3});
+    std::vector<std::atomic<int>> hits(1000);
+
+    pool.parallelFor(0, hits.size(), 7, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            hits[i].fetch_add(1);
+        }
+    });
+
+    for (size_t i = 0; i < hits.size(); ++i) {
+        ASSERT_EQ(hits[i].load(), 1) << i;
+    }
+}
+
+TEST(ThreadPoolTest, SmallRangesRunInline) {
+    ThreadPool pool({.workers = 2});
+    const auto caller = std::this_thread::get_id();
+    int calls = 0;
+
+    pool.parallelFor(5, 5, 1, [&](size_t, size_t) { ++calls; });
+    EXPECT_EQ(calls, 0);
+
+    pool.parallelFor(0, 8, 16, [&](size_t begin, size_t end) {
+        EXPECT_EQ(std::this_thread::get_id(), caller);
+        EXPECT_EQ(begin, 0u);
+        EXPECT_EQ(end, 8u);
+        ++calls;
+    });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(ThreadPoolTest, NestedParallelForCompletes) {
+    ThreadPool pool({.workers = 2});
+    std::atomic<size_t> total{0};
+
+    pool.parallelFor(0, 4, 1, [&](size_t begin, size_t end) {
+        for (size_t outer = begin; outer < end; ++outer) {
+            pool.parallelFor(0, 100, 10, [&](size_t b, size_t e) { total.fetch_add(e - b); });
+        }
+    });
+    EXPECT_EQ(total.load(), 400u);
+}
@@ -0,0 +1,415 @@
+#include <gtest/gtest.h>
+#include "v4l2_capture.hpp"
+#include <cerrno>
+#include <deque>
+#include <linux/videodev2.h>
+#include <mutex>
+#include <sys/eventfd.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace pcs;
+using namespace std::chrono_literals;
+
+namespace {
+
+// Driver-side state of the fake device; tests keep a handle to inspect it
+struct FakeDriver {
+    std::vector<uint32_t> formats{V4L2_PIX_FMT_YUYV, V4L2_PIX_FMT_MJPEG};
+    uint32_t rowPadding{0};
+    uint32_t maxBuffers{8};
+    uint32_t sequenceStep{1};
+    uint32_t mjpegBytes{1234};
+
+    std::mutex mtx;
+    v4l2_pix_format pix{};
+    std::vector<std::vector<uint8_t>> buffers;
+    std::deque<uint32_t> incoming; // queued by userspace
+    std::deque<uint32_t> done;     // filled, ready to dequeue
+    bool streaming{false};
+    uint32_t sequence{0};
+    int unmaps{0};
+    std::vector<int> exported;
+};
+
+uint32_t bytes_per_pixel(uint32_t fourcc)
+{
+    return fourcc == V4L2_PIX_FMT_YUYV ? 2 : 1;
+}
+
+class FakeV4l2Device : public V4l2Device {
+public:
+    explicit FakeV4l2Device(std::shared_ptr<FakeDriver> driver) : d_(std::move(driver)) {}
+
+    int ioctl(unsigned long request, void* arg) override
+    {
+        std::lock_guard<std::mutex> lock(d_->mtx);
+        switch (request) {
+            case VIDIOC_QUERYCAP: {
+                auto* cap = static_cast<v4l2_capability*>(arg);
+                cap->capabilities = V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+                return 0;
+            }
+            case VIDIOC_ENUM_FMT: {
+                auto* desc = static_cast<v4l2_fmtdesc*>(arg);
+                if (desc->index >= d_->formats.size()) {
+                    return fail(EINVAL);
+                }
+                desc->pixelformat = d_->formats[desc->index];
+                return 0;
+            }
+            case VIDIOC_S_FMT: {
+                auto& pix = static_cast<v4l2_format*>(arg)->fmt.pix;
+                if (std::find(d_->formats.begin(), d_->formats.end(), pix.pixelformat) == d_->formats.end()) {
+                    pix.pixelformat = d_->formats.front();
+                }
+                if (pix.pixelformat == V4L2_PIX_FMT_MJPEG) {
+                    pix.bytesperline = 0;
+                    pix.sizeimage = pix.width * pix.height;
+                } else {
+                    pix.bytesperline = pix.width * bytes_per_pixel(pix.pixelformat) + d_->rowPadding;
+                    pix.sizeimage = pix.bytesperline * pix.height;
+                    if (pix.pixelformat == V4L2_PIX_FMT_NV12) {
+                        pix.sizeimage += pix.sizeimage / 2;
+                    }
+                }
+                d_->pix = pix;
+                return 0;
+            }
+            case VIDIOC_S_PARM:
+                return 0;
+            case VIDIOC_REQBUFS: {
+                auto* req = static_cast<v4l2_requestbuffers*>(arg);
+                req->count = std::min(req->count, d_->maxBuffers);
+                d_->buffers.assign(req->count, std::vector<uint8_t>(d_->pix.sizeimage));
+                return 0;
+            }
+            case VIDIOC_QUERYBUF: {
+                auto* buf = static_cast<v4l2_buffer*>(arg);
+                buf->length = d_->pix.sizeimage;
+                buf->m.offset = buf->index << 12;
+                return 0;
+            }
+            case VIDIOC_EXPBUF: {
+                auto* exp = static_cast<v4l2_exportbuffer*>(arg);
+                exp->fd = ::eventfd(0, EFD_CLOEXEC);
+                d_->exported.push_back(exp->fd);
+                return 0;
+            }
+            case VIDIOC_QBUF: {
+                auto index = static_cast<v4l2_buffer*>(arg)->index;
+                if (std::find(d_->incoming.begin(), d_->incoming.end(), index) != d_->incoming.end()) {
+                    return fail(EINVAL);
+                }
+                d_->incoming.push_back(index);
+                return 0;
+            }
+            case VIDIOC_DQBUF: {
+                if (d_->done.empty()) {
+                    return fail(EAGAIN);
+                }
+                auto* buf = static_cast<v4l2_buffer*>(arg);
+                buf->index = d_->done.front();
+                d_->done.pop_front();
+                fill(*buf);
+                return 0;
+            }
+            case VIDIOC_STREAMON:
+                d_->streaming = true;
+                return 0;
+            case VIDIOC_STREAMOFF:
+                d_->streaming = false;
+                d_->incoming.clear();
+                d_->done.clear();
+                return 0;
+            default:
+                return fail(ENOTTY);
+        }
+    }
+
+    void* map(size_t length, uint32_t offset) override
+    {
+        std::lock_guard<std::mutex> lock(d_->mtx);
+        auto& buffer = d_->buffers.at(offset >> 12);
+        return length <= buffer.size() ? buffer.data() : nullptr;
+    }
+
+    void unmap(void*, size_t) override
+    {
+        std::lock_guard<std::mutex> lock(d_->mtx);
+        ++d_->unmaps;
+    }
+
+    // "Captures" into the oldest queued buffer
+    bool waitReadable(std::chrono::milliseconds) override
+    {
+        std::lock_guard<std::mutex> lock(d_->mtx);
+        if (d_->streaming && !d_->incoming.empty()) {
+            d_->done.push_back(d_->incoming.front());
+            d_->incoming.pop_front();
+        }
+        return !d_->done.empty();
+    }
+
+private:
+    std::shared_ptr<FakeDriver> d_;
+
+    static int fail(int error)
+    {
+        errno = error;
+        return -1;
+    }
+
+    void fill(v4l2_buffer& buf)
+    {
+        auto& data = d_->buffers[buf.index];
+        std::fill(data.begin(), data.end(), static_cast<uint8_t>(d_->sequence));
+
+        buf.sequence = d_->sequence;
+        d_->sequence += d_->sequenceStep;
+        buf.bytesused = d_->pix.pixelformat == V4L2_PIX_FMT_MJPEG ? d_->mjpegBytes : d_->pix.sizeimage;
+        buf.flags = V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC;
+        buf.timestamp.tv_sec = 100 + buf.sequence;
+        buf.timestamp.tv_usec = 0;
+    }
+};
+
+} // namespace
+
+class V4l2CaptureTest : public ::testing::Test {
+protected:
+    std::shared_ptr<FakeDriver> driver = std::make_shared<FakeDriver>();
+    V4l2Config config;
+
+    void SetUp() override
+    {
+        config.width = 64;
+        config.height = 48;
+        config.buffer_count = 3;
+        config.formats = {PixelFormat::NV12, PixelFormat::YUYV};
+    }
+
+    std::unique_ptr<V4l2Capture> makeCapture()
+    {
+        return std::make_unique<V4l2Capture>(config, std::make_unique<FakeV4l2Device>(driver));
+    }
+};
+
+// ============================================================================
+// Negotiation Tests
+// ============================================================================
+
+TEST_F(V4l2CaptureTest, NegotiatesFirstSupportedFormat) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+
+    EXPECT_EQ(capture->format(), PixelFormat::YUYV);
+    EXPECT_EQ(capture->width(), 64u);
+    EXPECT_EQ(capture->height(), 48u);
+    EXPECT_EQ(capture->bufferCount(), 3u);
+}
+
+TEST_F(V4l2CaptureTest, FailsWithoutCommonFormat) {
+    config.formats = {PixelFormat::NV12, PixelFormat::I420};
+    auto capture = makeCapture();
+
+    EXPECT_FALSE(capture->open());
+    EXPECT_FALSE(capture->isOpened());
+}
+
+TEST_F(V4l2CaptureTest, FourccRoundTrip) {
+    for (auto format : {PixelFormat::YUYV, PixelFormat::NV12, PixelFormat::I420, PixelFormat::MJPEG}) {
+        EXPECT_EQ(fromFourcc(toFourcc(format)), format);
+    }
+    EXPECT_EQ(toFourcc(PixelFormat::BGRA), 0u);
+}
+
+// ============================================================================
+// Streaming Tests
+// ============================================================================
+
+TEST_F(V4l2CaptureTest, ReadReturnsZeroCopyFrame) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+
+    EXPECT_TRUE(frame.isExternal());
+    EXPECT_TRUE(frame.isValid());
+    EXPECT_EQ(frame.format(), PixelFormat::YUYV);
+    EXPECT_EQ(frame.size(), 64u * 48u * 2u);
+    EXPECT_EQ(frame.bytes().data(), driver->buffers[0].data());
+    EXPECT_EQ(capture->framesCaptured(), 1u);
+}
+
+TEST_F(V4l2CaptureTest, UsesKernelTimestamp) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+    EXPECT_EQ(frame.timestamp().time_since_epoch(), std::chrono::seconds(100));
+}
+
+TEST_F(V4l2CaptureTest, BufferRequeuedWhenFrameReleased) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    std::vector<Frame> held(3);
+    for (auto& frame : held) {
+        ASSERT_TRUE(capture->read(frame));
+    }
+    EXPECT_EQ(capture->buffersInFlight(), 3u);
+
+    // Every buffer is held: the driver has nothing to fill
+    Frame extra;
+    EXPECT_FALSE(capture->read(extra, 0ms));
+
+    held[1] = Frame();
+    EXPECT_EQ(capture->buffersInFlight(), 2u);
+    ASSERT_TRUE(capture->read(extra, 0ms));
+    EXPECT_EQ(extra.bytes().data(), driver->buffers[1].data());
+}
+
+TEST_F(V4l2CaptureTest, ReadOverwritingHeldFrameDoesNotDeadlock) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    for (int i = 0; i < 10; ++i) {
+        ASSERT_TRUE(capture->read(frame));
+    }
+    EXPECT_EQ(capture->buffersInFlight(), 1u);
+}
+
+TEST_F(V4l2CaptureTest, CopiesShareBufferUntilDetached) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+    Frame copy = frame;
+    EXPECT_EQ(copy.bytes().data(), frame.bytes().data());
+
+    frame = Frame();
+    EXPECT_EQ(capture->buffersInFlight(), 1u);
+
+    uint8_t first = copy.bytes()[0];
+    copy.detach();
+    EXPECT_FALSE(copy.isExternal());
+    EXPECT_EQ(copy.bytes()[0], first);
+    EXPECT_EQ(capture->buffersInFlight(), 0u);
+}
+
+TEST_F(V4l2CaptureTest, ReleaseFromAnotherThread) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    for (int i = 0; i < 20; ++i) {
+        Frame frame;
+        ASSERT_TRUE(capture->read(frame));
+        std::thread([f = std::move(frame)]() mutable { f = Frame(); }).join();
+    }
+    EXPECT_EQ(capture->buffersInFlight(), 0u);
+}
+
+TEST_F(V4l2CaptureTest, SequenceGapsCountAsDrops) {
+    driver->sequenceStep = 3;
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_TRUE(capture->read(frame));
+    }
+    EXPECT_EQ(capture->framesDropped(), 4u);
+}
+
+TEST_F(V4l2CaptureTest, PaddedRowsAreRepacked) {
+    driver->rowPadding = 32;
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+    EXPECT_FALSE(frame.isExternal());
+    EXPECT_TRUE(frame.isValid());
+    EXPECT_EQ(capture->buffersInFlight(), 0u);
+}
+
+TEST_F(V4l2CaptureTest, MjpegFrameSizeIsBytesUsed) {
+    config.formats = {PixelFormat::MJPEG};
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+    EXPECT_TRUE(frame.isCompressed());
+    EXPECT_EQ(frame.size(), driver->mjpegBytes);
+    EXPECT_TRUE(frame.isValid());
+}
+
+TEST_F(V4l2CaptureTest, StopAndRestartRequeuesFreeBuffers) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame held;
+    ASSERT_TRUE(capture->read(held));
+    capture->stop();
+    EXPECT_FALSE(capture->isStreaming());
+
+    Frame frame;
+    EXPECT_FALSE(capture->read(frame, 0ms));
+
+    ASSERT_TRUE(capture->start());
+    EXPECT_EQ(driver->incoming.size(), 2u);  // the held buffer stays out
+    held = Frame();
+    EXPECT_EQ(driver->incoming.size(), 3u);
+}
+
+// ============================================================================
+// Lifetime Tests
+// ============================================================================
+
+TEST_F(V4l2CaptureTest, FramesOutliveClose) {
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+    capture.reset();
+
+    EXPECT_EQ(driver->unmaps, 0);
+    EXPECT_EQ(frame.bytes()[0], 0u);  // still mapped
+
+    frame = Frame();
+    EXPECT_EQ(driver->unmaps, 3);
+}
+
+TEST_F(V4l2CaptureTest, ExportsDmabufPerBuffer) {
+    config.export_dmabuf = true;
+    auto capture = makeCapture();
+    ASSERT_TRUE(capture->open());
+    ASSERT_TRUE(capture->start());
+    ASSERT_EQ(driver->exported.size(), 3u);
+
+    Frame frame;
+    ASSERT_TRUE(capture->read(frame));
+    auto fd = capture->dmabufFd(frame);
+    ASSERT_TRUE(fd.has_value());
+    EXPECT_EQ(*fd, driver->exported[0]);
+
+    EXPECT_FALSE(capture->dmabufFd(frame.clone()).has_value());
+}